@@ -472,7 +472,7 @@ public:
         typedef void                     reference;
 
         bulk_insert_iterator() BMNOEXCEPT
-            : bvect_(0), buf_(0), buf_size_(0), sorted_(BM_UNKNOWN) {}
+            : bvect_(0), buf_(0), buf_size_(0), sorted_(BM_UNKNOWN), nb_(0) {}
         
         ~bulk_insert_iterator()
         {
@@ -481,6 +481,13 @@ public:
                 bvect_->blockman_.get_allocator().free_bit_block((bm::word_t*)buf_);
         }
 
+        /*!
+            @param bvect - target vector
+            @param so - sort order of the input; with BM_SORTED ids are
+                   written into a block buffer directly and each block is
+                   compacted (GAP/bit/FULL) and attached as soon as ids
+                   move past it (ids should be non-decreasing)
+        */
         bulk_insert_iterator(bvector<Alloc>& bvect,
                              bm::sort_order so = BM_UNKNOWN) BMNOEXCEPT
             : bvect_(&bvect), sorted_(so)
@@ -488,23 +495,23 @@ public:
             bvect_->init();
             
             buf_ = (value_type*) bvect_->blockman_.get_allocator().alloc_bit_block();
-            buf_size_ = 0;
+            buf_size_ = 0; nb_ = 0;
+            if (sorted_ == BM_SORTED)
+                bm::bit_block_set((bm::word_t*)buf_, 0);
         }
 
         bulk_insert_iterator(const bulk_insert_iterator& iit)
             : bvect_(iit.bvect_)
         {
-            buf_ = bvect_->blockman_.get_allocator().alloc_bit_block();
-            buf_size_ = iit.buf_size_;
-            sorted_ = iit.sorted_;
-            ::memcpy(buf_, iit.buf_, buf_size_ * sizeof(*buf_));
+            buf_ = (value_type*) bvect_->blockman_.get_allocator().alloc_bit_block();
+            copy_buf(iit);
         }
         
         bulk_insert_iterator(const insert_iterator& iit)
             : bvect_(iit.get_bvector())
         {
             buf_ = (value_type*) bvect_->blockman_.get_allocator().alloc_bit_block();
-            buf_size_ = 0;
+            buf_size_ = 0; nb_ = 0;
             sorted_ = BM_UNKNOWN;
         }
 
@@ -512,8 +519,9 @@ public:
             : bvect_(iit.bvect_)
         {
             buf_ = iit.buf_; iit.buf_ = 0;
-            buf_size_ = iit.buf_size_;
+            buf_size_ = iit.buf_size_; iit.buf_size_ = 0;
             sorted_ = iit.sorted_;
+            nb_ = iit.nb_;
         }
         
         bulk_insert_iterator& operator=(const bulk_insert_iterator& ii)
@@ -521,9 +529,7 @@ public:
             bvect_ = ii.bvect_;
             if (!buf_)
                 buf_ = bvect_->allocate_tempblock();
-            buf_size_ = ii.buf_size_;
-            ::memcpy(buf_, ii.buf_, buf_size_ * sizeof(*buf_));
-            sorted_ = ii.sorted_;
+            copy_buf(ii);
             return *this;
         }
         
@@ -533,8 +539,9 @@ public:
             if (buf_)
                 bvect_->free_tempblock(buf_);
             buf_ = ii.buf_; ii.buf_ = 0;
-            buf_size_ = ii.buf_size_;
+            buf_size_ = ii.buf_size_; ii.buf_size_ = 0;
             sorted_ = ii.sorted_;
+            nb_ = ii.nb_;
             return *this;
         }
 
@@ -543,6 +550,18 @@ public:
             BM_ASSERT(n < bm::id_max);
             BM_ASSERT_THROW(n < bm::id_max, BM_ERR_RANGE);
 
+            if (sorted_ == BM_SORTED)
+            {
+                block_idx_type nb = (n >> bm::set_block_shift);
+                if (nb != nb_ && buf_size_)
+                    flush_block();
+                nb_ = nb;
+                unsigned nbit = unsigned(n & bm::set_block_mask);
+                ((bm::word_t*)buf_)[nbit >> bm::set_word_shift] |=
+                                        (1u << (nbit & bm::set_word_mask));
+                ++buf_size_;
+                return *this;
+            }
             if (buf_size_ == buf_size_max())
             {
                 bvect_->import(buf_, buf_size_, sorted_);
@@ -565,7 +584,10 @@ public:
             BM_ASSERT(bvect_);
             if (buf_size_)
             {
-                bvect_->import(buf_, buf_size_, sorted_);
+                if (sorted_ == BM_SORTED)
+                    flush_block();
+                else
+                    bvect_->import(buf_, buf_size_, sorted_);
                 buf_size_ = 0;
             }
             bvect_->sync_size();
@@ -574,6 +596,28 @@ public:
         bvector_type* get_bvector() const BMNOEXCEPT { return bvect_; }
         
     protected:
+        /// Attach the current block (sorted mode) and reset the buffer
+        void flush_block()
+        {
+            bm::word_t* blk = (bm::word_t*)buf_;
+            if (bvect_->import_bit_block(nb_, blk)) // block got adopted
+                buf_ = (value_type*)
+                    bvect_->blockman_.get_allocator().alloc_bit_block();
+            bm::bit_block_set((bm::word_t*)buf_, 0);
+            buf_size_ = 0;
+        }
+
+        void copy_buf(const bulk_insert_iterator& iit)
+        {
+            buf_size_ = iit.buf_size_;
+            sorted_ = iit.sorted_;
+            nb_ = iit.nb_;
+            if (sorted_ == BM_SORTED) // buffer is a bit-block
+                bm::bit_block_copy((bm::word_t*)buf_, (bm::word_t*)iit.buf_);
+            else
+                ::memcpy(buf_, iit.buf_, buf_size_ * sizeof(*buf_));
+        }
+
         static
         size_type buf_size_max() BMNOEXCEPT
         {
@@ -586,9 +630,10 @@ public:
 
     protected:
         bvector_type*         bvect_;    ///< target bvector
-        size_type*            buf_;      ///< bulk insert buffer
+        size_type*            buf_;      ///< bulk insert buffer (bit-block if sorted)
         size_type             buf_size_; ///< current buffer size
         bm::sort_order        sorted_;   ///< sort order hint
+        block_idx_type        nb_;       ///< current block (sorted mode)
     };
     
 
@@ -1443,6 +1488,24 @@ public:
     count_to_test(size_type n, 
                   const rs_index_type&  rs_idx) const BMNOEXCEPT;
 
+    /*!
+       \brief Batch rank: population counts in [0..pos[i]] for an array
+       of positions
+     
+       Queries are grouped by block, so the rank-select index is walked
+       once per block, blocks with many queries get prefix counts
+       decoded once. Works for any order, but sorted (monotonic)
+       positions give the best grouping.
+     
+       \param pos - array of bit positions to rank
+       \param out - [out] array of ranks (same size)
+       \param n - number of positions
+       \param rs_idx - rank-select index (see build_rs_index)
+       \sa build_rs_index, rank, select_batch
+    */
+    void rank_batch(const size_type* pos, size_type* out, size_type n,
+                    const rs_index_type&  rs_idx) const BMNOEXCEPT;
+
 
     /*! Recalculate bitcount (deprecated)
     */
@@ -1670,6 +1733,27 @@ public:
     bool select(size_type rank, size_type& pos,
                 const rs_index_type&  rs_idx) const BMNOEXCEPT;
 
+    /*!
+        \brief Batch select: bit-vector positions for an array of ranks
+     
+        Ranks which fall into the same block reuse the block found by
+        the rank-select index, sorted (monotonic) ranks continue the
+        in-block scan from the previous found position.
+     
+        \param ranks - array of ranks to find (bitcounts, 1-based)
+        \param out  - [out] array of positions,
+                      bm::id_max for ranks which were not found
+        \param n - number of ranks
+        \param rs_idx - rank-select index (see build_rs_index)
+
+        \sa select, rank_batch
+
+        \return number of ranks found
+    */
+    size_type select_batch(const size_type* ranks, size_type* out,
+                           size_type n,
+                           const rs_index_type&  rs_idx) const BMNOEXCEPT;
+
     //@}
 
 
@@ -1962,6 +2046,21 @@ public:
                                       const bm::word_t* arg_blk,
                                       bool arg_gap,
                                       bm::operation opcode);
+
+    /*!
+        \brief Attach a finished bit-block (append-only builders)
+
+        Block is compacted on the fly: empty, FULL or GAP form is picked
+        from the bit-block content, no later optimize() is needed.
+        Content of an already existing block is OR-ed.
+
+        @param nb - block index
+        @param blk - bit-block allocated by this vector's allocator
+        @return true if blk was adopted as is (caller must not reuse it)
+        @internal
+    */
+    bool import_bit_block(block_idx_type nb, bm::word_t* blk);
+
     /**
         \brief get access to memory manager (internal)
         Use only if you are BitMagic library
@@ -2000,6 +2099,33 @@ protected:
     void import_block(const size_type* ids,
                       block_idx_type nblock, size_type start, size_type stop);
 
+    /**
+        Set or clear bits of one block from a sorted run of ids
+        (builds GAP block directly when the run is compact enough)
+        @internal
+    */
+    void import_sorted_block(const size_type* ids, block_idx_type nblock,
+                             size_type start, size_type stop, bool val);
+
+    /**
+        Clear bits from sorted ids, block by block (no temp vector)
+        @internal
+    */
+    void clear_sorted(const size_type* ids, size_type ids_size);
+
+    /**
+        Keep only bits from sorted ids (AND), block by block
+        @internal
+    */
+    void keep_sorted(const size_type* ids, size_type ids_size);
+
+    /**
+        AND one block with a mask built from a sorted run of ids
+        @internal
+    */
+    void keep_sorted_block(const size_type* ids, block_idx_type nblock,
+                           size_type start, size_type stop);
+
 private:
 
     size_type check_or_next(size_type prev) const BMNOEXCEPT;
@@ -2344,7 +2470,8 @@ void bvector<Alloc>::build_rs_index(rs_index_type* rs_idx,
     }
     
     unsigned bcount[bm::set_sub_array_size];
-    unsigned sub_count[bm::set_sub_array_size];
+    bm::gap_word_t
+        sub_count[bm::set_sub_array_size * (bm::rs_sub_blocks-1)];
 
     rs_idx->init();
     if (!blockman_.is_init())
@@ -2396,9 +2523,12 @@ void bvector<Alloc>::build_rs_index(rs_index_type* rs_idx,
         do
         {
             const bm::word_t* block = blk_blk[j];
+            bm::gap_word_t* sub_rcount = &sub_count[j * (bm::rs_sub_blocks-1)];
             if (!block)
             {
-                bcount[j] = sub_count[j] = 0;
+                bcount[j] = 0;
+                for (unsigned k = 0; k < bm::rs_sub_blocks-1; ++k)
+                    sub_rcount[k] = 0;
                 continue;
             }
             
@@ -2409,31 +2539,34 @@ void bvector<Alloc>::build_rs_index(rs_index_type* rs_idx,
                 bv_blocks->set(i * bm::set_sub_array_size + j);
             }
             
-            // TODO: optimize sub-index compute
-            unsigned local_first, local_second;
+            // running counts of sub-blocks
+            unsigned rc = 0;
             if (BM_IS_GAP(block))
             {
                 const bm::gap_word_t* const gap_block = BMGAP_PTR(block);
-                local_first =
-                    bm::gap_bit_count_range(gap_block, 0, bm::rs3_border0);
-                local_second =
-                    bm::gap_bit_count_range(gap_block,
-                                            bm::gap_word_t(bm::rs3_border0+1),
-                                            bm::rs3_border1);
+                for (unsigned k = 0; k < bm::rs_sub_blocks-1; ++k)
+                {
+                    unsigned from = k << bm::rs_sub_block_shift;
+                    rc += bm::gap_bit_count_range(gap_block,
+                                bm::gap_word_t(from),
+                                bm::gap_word_t(from + bm::rs_sub_block_size-1));
+                    sub_rcount[k] = bm::gap_word_t(rc);
+                } // for k
             }
             else
             {
                 block = BLOCK_ADDR_SAN(block); // TODO: optimize FULL
-
-                local_first =
-                    bm::bit_block_calc_count_range(block, 0, bm::rs3_border0);
-                local_second =
-                    bm::bit_block_calc_count_range(block,
-                                                   bm::rs3_border0+1,
-                                                   bm::rs3_border1);
+                const unsigned sub_words =
+                            bm::rs_sub_block_size >> bm::set_word_shift;
+                for (unsigned k = 0; k < bm::rs_sub_blocks-1; ++k)
+                {
+                    const bm::word_t* sub_block = block + (k * sub_words);
+                    rc += bm::bit_count_min_unroll(sub_block,
+                                                   sub_block + sub_words);
+                    sub_rcount[k] = bm::gap_word_t(rc);
+                } // for k
             }
-            BM_ASSERT(cnt >= local_first + local_second);
-            sub_count[j] = local_first | (local_second << 16);
+            BM_ASSERT(cnt >= rc);
 
         } while (++j < bm::set_sub_array_size);
         
@@ -2441,6 +2574,7 @@ void bvector<Alloc>::build_rs_index(rs_index_type* rs_idx,
         
     } // for i
 
+    rs_idx->build_select_samples();
 }
 
 
@@ -2467,106 +2601,29 @@ bvector<Alloc>::block_count_to(const bm::word_t*    block,
                                unsigned             nbit_right,
                                const rs_index_type& rs_idx) BMNOEXCEPT
 {
-    size_type c;
-    unsigned sub_range = rs_idx.find_sub_range(nbit_right);
-
-    unsigned sub_cnt = rs_idx.sub_count(nb);
-    unsigned first = sub_cnt & 0xFFFF;
-    unsigned second = sub_cnt >> 16;
-    
-    BM_ASSERT(first == bm::bit_block_calc_count_to(block, rs3_border0));
-    BM_ASSERT(second == bm::bit_block_calc_count_range(block, rs3_border0+1, rs3_border1));
-
-    // evaluate 3 sub-block intervals
-    // |--------[0]-----------[1]----------|
+    const typename rs_index_type::rs_line* ln = rs_idx.get_line(nb);
+    if (!ln)
+        return bm::bit_block_calc_count_to(block, nbit_right);
 
-    switch(sub_range)  // sub-range rank calc
+    // evaluate the 4096-bit sub-block of the position from the
+    // closest border, so at most a half of the sub-block is counted
+    // |----[k]----x--------[k+1]----|
+    //
+    unsigned k = nbit_right >> bm::rs_sub_block_shift;
+    unsigned sub_from = k << bm::rs_sub_block_shift;
+    unsigned sub_to = sub_from + bm::rs_sub_block_size - 1;
+    size_type c;
+    if (nbit_right - sub_from < (bm::rs_sub_block_size / 2))
     {
-    case 0:
-        // |--x-----[0]-----------[1]----------|
-        if (nbit_right <= rs3_border0/2)
-        {
-            c = bm::bit_block_calc_count_to(block, nbit_right);
-        }
-        else
-        {
-            // |--------[x]-----------[1]----------|
-            if (nbit_right == rs3_border0)
-            {
-                c = first;
-            }
-            else
-            {
-                // |------x-[0]-----------[1]----------|
-                c = bm::bit_block_calc_count_range(block,
-                                                   nbit_right+1,
-                                                   rs3_border0);
-                c = first - c;
-            }
-        }
-    break;
-    case 1:
-        // |--------[0]-x---------[1]----------|
-        if (nbit_right <= (rs3_border0 + rs3_half_span))
-        {
-            c = bm::bit_block_calc_count_range(block,
-                                               rs3_border0 + 1,
-                                               nbit_right);
-            c += first;
-        }
-        else
-        {
-            unsigned bc_second_range = first + second;
-            // |--------[0]-----------[x]----------|
-            if (nbit_right == rs3_border1)
-            {
-                c = bc_second_range;
-            }
-            else
-            {
-                // |--------[0]--------x--[1]----------|
-                c = bm::bit_block_calc_count_range(block,
-                                                   nbit_right+1,
-                                                   rs3_border1);
-                c = bc_second_range - c;
-            }
-        }
-    break;
-    case 2:
+        c = ln->sub_count_to(k);
+        c += bm::bit_block_calc_count_range(block, sub_from, nbit_right);
+    }
+    else
     {
-        unsigned bc_second_range = first + second;
-
-        // |--------[0]-----------[1]-x--------|
-        if (nbit_right <= (rs3_border1 + rs3_half_span))
-        {
-            c = bm::bit_block_calc_count_range(block,
-                                               rs3_border1 + 1,
-                                               nbit_right);
-            c += bc_second_range;
-        }
-        else
-        {
-            // |--------[0]-----------[1]----------x
-            if (nbit_right == bm::gap_max_bits-1)
-            {
-                c = rs_idx.count(nb);
-            }
-            else
-            {
-                // |--------[0]-----------[1]-------x--|
-                c = bm::bit_block_calc_count_range(block,
-                                                   nbit_right+1,
-                                                   bm::gap_max_bits-1);
-                size_type cnt = rs_idx.count(nb);
-                c = cnt - c;
-            }
-        }
+        c = ln->sub_count_to(k + 1);
+        if (nbit_right != sub_to)
+            c -= bm::bit_block_calc_count_range(block, nbit_right+1, sub_to);
     }
-    break;
-    default:
-        BM_ASSERT(0);
-        c = 0;
-    } // switch
     
     BM_ASSERT(c == bm::bit_block_calc_count_to(block, nbit_right));
     return c;
@@ -2594,7 +2651,7 @@ bvector<Alloc>::count_to(size_type right,
         cnt = rs_idx.count();
         return cnt;
     }
-    cnt = nblock_right ? rs_idx.rcount(nblock_right-1) : 0;
+    cnt = rs_idx.rcount_before(nblock_right);
 
     unsigned i, j;
     bm::get_block_coord(nblock_right, i, j);
@@ -2679,7 +2736,7 @@ bvector<Alloc>::count_to_test(size_type right,
             }
         }
     }
-    cnt += nblock_right ? rs_idx.rcount(nblock_right - 1) : 0;
+    cnt += rs_idx.rcount_before(nblock_right);
     return cnt;
 }
 
@@ -2697,7 +2754,7 @@ bvector<Alloc>::rank_corrected(size_type right,
   unsigned nblock_right = unsigned(right >> bm::set_block_shift);
   unsigned nbit_right = unsigned(right & bm::set_block_mask);
 
-  size_type cnt = nblock_right ? rs_idx.rcount(nblock_right - 1) : 0;
+  size_type cnt = rs_idx.rcount_before(nblock_right);
 
   unsigned i, j;
   bm::get_block_coord(nblock_right, i, j);
@@ -2728,6 +2785,97 @@ bvector<Alloc>::rank_corrected(size_type right,
 }
 
 
+// -----------------------------------------------------------------------
+
+template<typename Alloc>
+void bvector<Alloc>::rank_batch(const size_type*     pos,
+                                size_type*           out,
+                                size_type            n,
+                                const rs_index_type& rs_idx) const BMNOEXCEPT
+{
+    BM_ASSERT(pos && out);
+    if (!blockman_.is_init())
+    {
+        for (size_type k = 0; k < n; ++k)
+            out[k] = 0;
+        return;
+    }
+    bm::gap_word_t chunk_rc[bm::set_block_size / 8];
+
+    for (size_type k = 0; k < n; )
+    {
+        BM_ASSERT(pos[k] < bm::id_max);
+        block_idx_type nb = (pos[k] >> bm::set_block_shift);
+
+        // group of queries in the same block
+        size_type k_end = k + 1;
+        while (k_end < n && (pos[k_end] >> bm::set_block_shift) == nb)
+            ++k_end;
+
+        if (nb >= rs_idx.get_total())
+        {
+            size_type cnt = rs_idx.count();
+            for (; k < k_end; ++k)
+                out[k] = cnt;
+            continue;
+        }
+
+        size_type cnt = rs_idx.rcount_before(nb);
+        unsigned i, j;
+        bm::get_block_coord(nb, i, j);
+        const bm::word_t* block = blockman_.get_block_ptr(i, j);
+        if (!block)
+        {
+            for (; k < k_end; ++k)
+                out[k] = cnt;
+            continue;
+        }
+        if (BM_IS_GAP(block))
+        {
+            const bm::gap_word_t* gap_block = BMGAP_PTR(block);
+            unsigned nbit_prev = 0, c = 0;
+            for (bool first = true; k < k_end; ++k, first = false)
+            {
+                unsigned nbit = unsigned(pos[k] & bm::set_block_mask);
+                if (first || nbit < nbit_prev) // non-monotonic: restart
+                    c = bm::gap_bit_count_to(gap_block, (gap_word_t)nbit);
+                else
+                if (nbit > nbit_prev)
+                    c += bm::gap_bit_count_range(gap_block,
+                                          (gap_word_t)(nbit_prev + 1),
+                                          (gap_word_t)nbit);
+                nbit_prev = nbit;
+                out[k] = cnt + c;
+            } // for k
+            continue;
+        }
+        if (block == FULL_BLOCK_FAKE_ADDR)
+        {
+            for (; k < k_end; ++k)
+                out[k] = cnt + (pos[k] & bm::set_block_mask) + 1;
+            continue;
+        }
+        if (k_end - k >= bm::rs_batch_prefix_min) // decode prefix counts
+        {
+            bm::bit_block_chunk_rcount(block, chunk_rc);
+            for (; k < k_end; ++k)
+            {
+                unsigned nbit = unsigned(pos[k] & bm::set_block_mask);
+                out[k] = cnt + bm::bit_block_chunk_count_to(block,
+                                                            chunk_rc, nbit);
+            } // for k
+        }
+        else
+        {
+            for (; k < k_end; ++k)
+            {
+                unsigned nbit = unsigned(pos[k] & bm::set_block_mask);
+                out[k] = cnt + block_count_to(block, nb, nbit, rs_idx);
+            } // for k
+        }
+    } // for k
+}
+
 // -----------------------------------------------------------------------
 
 template<typename Alloc>
@@ -3580,7 +3728,12 @@ void bvector<Alloc>::keep(const size_type* ids, size_type ids_size,
         clear();
         return;
     }
-    bvector<Alloc> bv_tmp; // TODO: better optimize for SORTED case (avoid temp)
+    if (so == bm::BM_SORTED)
+    {
+        keep_sorted(ids, ids_size);
+        return;
+    }
+    bvector<Alloc> bv_tmp;
     bv_tmp.import(ids, ids_size, so);
 
     size_type last;
@@ -3607,7 +3760,12 @@ void bvector<Alloc>::clear(const size_type* ids,
     {
         return;
     }
-    bvector<Alloc> bv_tmp; // TODO: better optimize for SORTED case (avoid temp)
+    if (so == bm::BM_SORTED)
+    {
+        clear_sorted(ids, ids_size);
+        return;
+    }
+    bvector<Alloc> bv_tmp;
     bv_tmp.import(ids, ids_size, so);
 
     size_type last;
@@ -3708,7 +3866,7 @@ void bvector<Alloc>::import(const size_type* ids, size_type size_in,
             if (stop == 1)
                 set_bit_no_check(ids[0]);
             else
-                import_block(ids, nblock, 0, stop);
+                import_sorted_block(ids, nblock, 0, stop, true);
             return;
         }
     }
@@ -3730,6 +3888,9 @@ void bvector<Alloc>::import(const size_type* ids, size_type size_in,
 
         if (stop - start == 1 && n < bm::id_max) // just one bit to set
             set_bit_no_check(n);
+        else
+        if (sorted_idx == bm::BM_SORTED)
+            import_sorted_block(ids, nblock, start, stop, true);
         else
             import_block(ids, nblock, start, stop);
         start = stop;
@@ -3769,6 +3930,235 @@ void bvector<Alloc>::import_block(const size_type* ids,
 
 // -----------------------------------------------------------------------
 
+template<class Alloc>
+void bvector<Alloc>::import_sorted_block(const size_type* ids,
+                                         block_idx_type   nblock,
+                                         size_type        start,
+                                         size_type        stop,
+                                         bool             val)
+{
+    BM_ASSERT(stop > start);
+    unsigned i0, j0;
+    bm::get_block_coord(nblock, i0, j0);
+    bm::word_t* blk = blockman_.get_block_ptr(i0, j0);
+
+    // empty target or GAP target: try to express ids as a GAP block
+    if ((!blk && val) || BM_IS_GAP(blk))
+    {
+        bm::gap_word_t tmp_gap[bm::gap_max_buff_len];
+        unsigned max_len = blockman_.glen(bm::gap_max_level);
+        if (max_len > bm::gap_max_buff_len)
+            max_len = bm::gap_max_buff_len;
+        unsigned len = 0;
+        if (nblock != bm::set_total_blocks-1 && // last bit is reserved
+            bm::gap_sorted_idx_check_fit(ids, start, stop, max_len))
+            len = bm::gap_set_sorted_idx(tmp_gap, ids, start, stop, max_len);
+        if (len)
+        {
+            if (!blk)
+            {
+                int level = bm::gap_calc_level(len, blockman_.glen());
+                if (level >= 0)
+                {
+                    blockman_.set_gap_block(nblock, tmp_gap, level);
+                    return;
+                }
+            }
+            else
+            {
+                gap_word_t tmp_buf[bm::gap_equiv_len * 3];
+                const bm::gap_word_t* res;
+                unsigned res_len;
+                if (val)
+                    res = bm::gap_operation_or(BMGAP_PTR(blk), tmp_gap,
+                                               tmp_buf, res_len);
+                else
+                    res = bm::gap_operation_sub(BMGAP_PTR(blk), tmp_gap,
+                                                tmp_buf, res_len);
+                BM_ASSERT(res == tmp_buf);
+                blockman_.assign_gap_check(i0, j0, res, ++res_len, blk, tmp_buf);
+                return;
+            }
+        }
+    }
+
+    int block_type;
+    blk = blockman_.check_allocate_block(nblock, val, 0, &block_type,
+                                         true/*allow NULL ret*/);
+    if (!IS_VALID_ADDR(blk)) // nothing to clear or all bits already set
+        return;
+    if (BM_IS_GAP(blk))
+        blk = blockman_.deoptimize_block(nblock);
+    if (val)
+    {
+        #ifdef BM64ADDR
+            bm::set_block_bits_u64(blk, ids, start, stop);
+        #else
+            bm::set_block_bits_u32(blk, ids, start, stop);
+        #endif
+        if (nblock == bm::set_total_blocks-1)
+            blk[bm::set_block_size-1] &= ~(1u<<31);
+    }
+    else
+    if (stop - start < bm::gap_equiv_len / 4) // sparse run: clear in place
+    {
+        #ifdef BM64ADDR
+            bm::clear_block_bits_u64(blk, ids, start, stop);
+        #else
+            bm::clear_block_bits_u32(blk, ids, start, stop);
+        #endif
+    }
+    else // dense run: build a mask (SIMD scatter) and subtract
+    {
+        bm::word_t* tb = blockman_.check_allocate_tempblock();
+        bm::bit_block_set(tb, 0);
+        #ifdef BM64ADDR
+            bm::set_block_bits_u64(tb, ids, start, stop);
+        #else
+            bm::set_block_bits_u32(tb, ids, start, stop);
+        #endif
+        bm::bit_block_sub(blk, tb);
+    }
+}
+
+// -----------------------------------------------------------------------
+
+template<class Alloc>
+void bvector<Alloc>::clear_sorted(const size_type* ids, size_type ids_size)
+{
+    BM_ASSERT(ids && ids_size);
+    size_type start = 0, stop;
+    do
+    {
+        block_idx_type nblock = (ids[start] >> bm::set_block_shift);
+        #ifdef BM64ADDR
+            stop = bm::idx_arr_block_lookup_u64(ids, ids_size, nblock, start);
+        #else
+            stop = bm::idx_arr_block_lookup_u32(ids, ids_size, nblock, start);
+        #endif
+        BM_ASSERT(start < stop);
+        import_sorted_block(ids, nblock, start, stop, false);
+        start = stop;
+    } while (start < ids_size);
+}
+
+// -----------------------------------------------------------------------
+
+template<class Alloc>
+void bvector<Alloc>::keep_sorted(const size_type* ids, size_type ids_size)
+{
+    BM_ASSERT(ids && ids_size);
+    size_type start = 0, stop;
+    block_idx_type nblock_next = 0; // first block not yet processed
+    do
+    {
+        block_idx_type nblock = (ids[start] >> bm::set_block_shift);
+        #ifdef BM64ADDR
+            stop = bm::idx_arr_block_lookup_u64(ids, ids_size, nblock, start);
+        #else
+            stop = bm::idx_arr_block_lookup_u32(ids, ids_size, nblock, start);
+        #endif
+        BM_ASSERT(start < stop);
+        if (nblock > nblock_next) // blocks with no ids get cleared
+            clear_range_no_check(size_type(nblock_next) << bm::set_block_shift,
+                                 (size_type(nblock) << bm::set_block_shift) - 1);
+        keep_sorted_block(ids, nblock, start, stop);
+        nblock_next = nblock + 1;
+        start = stop;
+    } while (start < ids_size);
+
+    if (nblock_next < bm::set_total_blocks)
+        clear_range_no_check(size_type(nblock_next) << bm::set_block_shift,
+                             bm::id_max - 1);
+}
+
+// -----------------------------------------------------------------------
+
+template<class Alloc>
+void bvector<Alloc>::keep_sorted_block(const size_type* ids,
+                                       block_idx_type   nblock,
+                                       size_type        start,
+                                       size_type        stop)
+{
+    BM_ASSERT(stop > start);
+    unsigned i0, j0;
+    bm::get_block_coord(nblock, i0, j0);
+    bm::word_t* blk = blockman_.get_block_ptr(i0, j0);
+    if (!blk)
+        return;
+    if (IS_FULL_BLOCK(blk))
+        blockman_.check_alloc_top_subblock(i0); // FULL top level gets split
+
+    // AND mask as GAP (compact runs) or as a bit-block
+    bm::gap_word_t tmp_gap[bm::gap_max_buff_len];
+    unsigned len = 0;
+    if (bm::gap_sorted_idx_check_fit(ids, start, stop, bm::gap_max_buff_len))
+        len = bm::gap_set_sorted_idx(tmp_gap, ids, start, stop,
+                                     bm::gap_max_buff_len);
+    const bm::word_t* arg_blk;
+    if (len)
+    {
+        bm::word_t* gap_arg = (bm::word_t*)tmp_gap;
+        BMSET_PTRGAP(gap_arg);
+        arg_blk = gap_arg;
+    }
+    else
+    {
+        bm::word_t* tb = blockman_.check_allocate_tempblock();
+        bm::bit_block_set(tb, 0);
+        #ifdef BM64ADDR
+            bm::set_block_bits_u64(tb, ids, start, stop);
+        #else
+            bm::set_block_bits_u32(tb, ids, start, stop);
+        #endif
+        arg_blk = tb;
+    }
+    combine_operation_block_and(i0, j0, blk, arg_blk);
+}
+
+// -----------------------------------------------------------------------
+
+template<class Alloc>
+bool bvector<Alloc>::import_bit_block(block_idx_type nb, bm::word_t* blk)
+{
+    BM_ASSERT(blk && IS_VALID_ADDR(blk) && !BM_IS_GAP(blk));
+    if (nb == bm::set_total_blocks-1) // last bit is reserved
+        blk[bm::set_block_size-1] &= ~(1u<<31);
+
+    if (!blockman_.is_init())
+        blockman_.init_tree();
+    unsigned i0, j0;
+    bm::get_block_coord(nb, i0, j0);
+    if (blockman_.get_block_ptr(i0, j0)) // existing content: OR
+    {
+        combine_operation_with_block(nb, blk, false, BM_OR);
+        return false;
+    }
+
+    unsigned gap_count = bm::bit_block_calc_change(blk);
+    if (gap_count == 1) // solid block
+    {
+        if (*blk)
+            blockman_.set_block(nb, FULL_BLOCK_FAKE_ADDR);
+        return false;
+    }
+    unsigned threshold = blockman_.glen(bm::gap_max_level)-4;
+    if (gap_count < threshold) // compressable
+    {
+        bm::gap_word_t tmp_gap_buf[bm::gap_equiv_len * 2];
+        unsigned len = bm::bit_to_gap(tmp_gap_buf, blk, threshold);
+        BM_ASSERT(len);
+        int level = bm::gap_calc_level(len, blockman_.glen());
+        BM_ASSERT(level >= 0);
+        blockman_.set_gap_block(nb, tmp_gap_buf, level);
+        return false;
+    }
+    blockman_.set_block(nb, blk);
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
 template<class Alloc> 
 bool bvector<Alloc>::set_bit_no_check(size_type n, bool val)
 {
@@ -4340,65 +4730,20 @@ bool bvector<Alloc>::find_rank(size_type             rank_in,
 {
     BM_ASSERT_THROW(from < bm::id_max, BM_ERR_RANGE);
 
-    bool ret = false;
-    
     if (!rank_in ||
         !blockman_.is_init() ||
         (rs_idx.count() < rank_in))
-        return ret;
+        return false;
     
-    block_idx_type nb;
+    // convert to the absolute rank, so the index (and select samples)
+    // finds the target block without scanning the blocks after 'from'
     if (from)
-        nb = (from >> bm::set_block_shift);
-    else
     {
-        nb = rs_idx.find(rank_in);
-        BM_ASSERT(rs_idx.rcount(nb) >= rank_in);
-        if (nb)
-            rank_in -= rs_idx.rcount(nb-1);
+        rank_in += rank_corrected(from, rs_idx);
+        if (rs_idx.count() < rank_in)
+            return false;
     }
-    
-    bm::gap_word_t nbit = bm::gap_word_t(from & bm::set_block_mask);
-    unsigned bit_pos = 0;
-
-    for (; nb < rs_idx.get_total(); ++nb)
-    {
-        int no_more_blocks;
-        const bm::word_t* block = blockman_.get_block(nb, &no_more_blocks);
-        if (block)
-        {
-            if (!nbit) // check if the whole block can be skipped
-            {
-                unsigned block_bc = rs_idx.count(nb);
-                if (rank_in <= block_bc) // target block
-                {
-                    nbit = rs_idx.select_sub_range(nb, rank_in);
-                    rank_in = bm::block_find_rank(block, rank_in, nbit, bit_pos);
-                    BM_ASSERT(rank_in == 0);
-                    pos = bit_pos + (nb * bm::set_block_size * 32);
-                    return true;
-                }
-                rank_in -= block_bc;
-                continue;
-            }
-
-            rank_in = bm::block_find_rank(block, rank_in, nbit, bit_pos);
-            if (!rank_in) // target found
-            {
-                pos = bit_pos + (nb * bm::set_block_size * 32);
-                return true;
-            }
-        }
-        else
-        {
-            // TODO: better next block search
-            if (no_more_blocks)
-                break;
-        }
-        nbit ^= nbit; // zero start bit after first scanned block
-    } // for nb
-    
-    return ret;
+    return select(rank_in, pos, rs_idx);
 }
 
 //---------------------------------------------------------------------
@@ -4443,6 +4788,74 @@ bool bvector<Alloc>::select(size_type rank_in, size_type& pos,
 
 //---------------------------------------------------------------------
 
+template<class Alloc>
+typename bvector<Alloc>::size_type
+bvector<Alloc>::select_batch(const size_type*     ranks,
+                             size_type*           out,
+                             size_type            n,
+                             const rs_index_type& rs_idx) const BMNOEXCEPT
+{
+    BM_ASSERT(ranks && out);
+    size_type found_cnt = 0;
+    const size_type total = blockman_.is_init() ? rs_idx.count() : 0;
+
+    for (size_type k = 0; k < n; )
+    {
+        size_type rank = ranks[k];
+        if (!rank || rank > total)
+        {
+            out[k++] = bm::id_max;
+            continue;
+        }
+        block_idx_type nb = rs_idx.find(rank);
+        // rank range of the block: (rc_before, rc_before + count(nb)]
+        const size_type rc_before = rs_idx.rcount_before(nb);
+        const size_type rc_last = rc_before + rs_idx.count(nb);
+        const size_type base_pos = nb * bm::set_block_size * 32;
+
+        unsigned i, j;
+        bm::get_block_coord(nb, i, j);
+        const bm::word_t* block = blockman_.get_block_ptr(i, j);
+        BM_ASSERT(block);
+
+        unsigned  bit_pos = 0;
+        size_type rank_prev = 0; // block relative rank of bit_pos
+        for (; k < n; ++k)
+        {
+            size_type r = ranks[k];
+            if (r <= rc_before || r > rc_last) // next block
+                break;
+            r -= rc_before;
+            if (block == FULL_BLOCK_FAKE_ADDR)
+                bit_pos = unsigned(r - 1);
+            else
+            {
+                size_type r_sub = r;
+                unsigned sub_from = rs_idx.select_sub_range(nb, r_sub);
+                if (rank_prev && r > rank_prev && bit_pos >= sub_from)
+                {
+                    // continue scan from the previous position
+                    size_type rr = bm::block_find_rank(block, r - rank_prev,
+                                                       bit_pos + 1, bit_pos);
+                    BM_ASSERT(rr == 0); (void)rr;
+                }
+                else
+                {
+                    size_type rr = bm::block_find_rank(block, r_sub,
+                                                       sub_from, bit_pos);
+                    BM_ASSERT(rr == 0); (void)rr;
+                }
+            }
+            rank_prev = r;
+            out[k] = base_pos + bit_pos;
+            ++found_cnt;
+        } // for k
+    } // for k
+    return found_cnt;
+}
+
+//---------------------------------------------------------------------
+
 template<class Alloc> 
 typename bvector<Alloc>::size_type 
 bvector<Alloc>::check_or_next(size_type prev) const BMNOEXCEPT
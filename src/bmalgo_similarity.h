@@ -21,6 +21,7 @@ For more information please visit:  http://bitmagic.io
 #include <algorithm>
 #include <functional>
 #include <vector>
+#include <math.h>
 
 #ifndef BM__H__INCLUDED__
 // BitMagic utility headers do not include main "bm.h" declaration 
@@ -33,6 +34,8 @@ For more information please visit:  http://bitmagic.io
 #include "bmdef.h"
 
 #include "bmalgo_impl.h"
+#include "bmalgo.h"
+#include "bmtask.h"
 
 namespace bm
 {
@@ -219,6 +222,843 @@ void build_jaccard_similarity_batch(SIMBATCH& sbatch, const SV& sv)
 
 
 
+/**
+    Builder of all-pairs similarity (Jaccard or cosine) of a collection
+    of bit-vectors as a batch of parallel tasks.
+
+    The collection is split into tiles of vectors, each task computes one
+    pair of tiles (upper triangle): block coordinates are the outer loop,
+    vector pairs are the inner loop, so every block of a tile is fetched
+    once per tile pair. AND population counts use the SIMD block kernels,
+    OR counts are derived from the vector counts (|A|+|B|-|A&B|).
+
+    Results are a dense symmetric matrix or top-K most similar vectors
+    per row (for collections where n*n does not fit in memory).
+
+    Lock - locking type (std::mutex or bm::spin_lock<>) protecting top-K
+    rows updated by different tasks (not used in the dense mode).
+    Vectors and the builder should stay alive until the batch is done.
+
+    \ingroup  distance
+*/
+template<typename BV, typename Lock>
+class similarity_matrix_builder
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef Lock                                      lock_type;
+    typedef bm::dynamic_heap_matrix<float, allocator_type> matrix_type;
+
+    /// Similarity metric
+    enum metric_type
+    {
+        jaccard = 0,  ///< |A & B| / |A | B|
+        cosine        ///< |A & B| / sqrt(|A| * |B|)
+    };
+
+    /// Similar vector descriptor (top-K results)
+    struct neighbor
+    {
+        size_type  idx;         ///< index of the vector in the collection
+        float      similarity;  ///< similarity to the row vector
+    };
+
+    class task_batch : public bm::task_batch<allocator_type>
+    {
+    };
+
+public:
+    similarity_matrix_builder() BMNOEXCEPT
+        : tile_size_(64), metric_(jaccard), top_k_(0),
+          bv_arr_(0), size_(0), tiles_(0), locks_(0)
+    {}
+
+    ~similarity_matrix_builder() { delete[] locks_; }
+
+    /**
+        Set number of vectors per tile (default: 64)
+     */
+    void set_tile_size(unsigned cnt) BMNOEXCEPT
+    {
+        BM_ASSERT(cnt);
+        tile_size_ = cnt ? cnt : 1;
+    }
+
+    /**
+        Set similarity metric (default: jaccard)
+     */
+    void set_metric(metric_type m) BMNOEXCEPT { metric_ = m; }
+
+    /**
+        Keep only K most similar vectors per row (pairs with non-empty
+        intersection), 0 - compute the dense matrix (default)
+     */
+    void set_top_k(unsigned k) BMNOEXCEPT { top_k_ = k; }
+
+    /**
+        Build the batch of tasks for the collection of vectors
+
+        \param batch - [out] batch of tasks
+        \param bv_arr - array of vector pointers (NULL - empty vector)
+        \param size - size of the collection
+     */
+    void build_plan(task_batch&                batch,
+                    const bvector_type* const* bv_arr,
+                    size_type                  size);
+
+    /// Dense similarity matrix (after the batch is done)
+    const matrix_type& get_matrix() const BMNOEXCEPT { return matrix_; }
+
+    /// Similarity of the vectors i and j (dense mode)
+    float get_similarity(size_type i, size_type j) const BMNOEXCEPT
+        { return matrix_.row(size_t(i))[size_t(j)]; }
+
+    /**
+        Get top-K most similar vectors for a row (top-K mode)
+        \param row - index of the vector
+        \param nb - [out] array of neighbors,
+                    sorted by similarity (descending), then by index
+        \param nb_size - capacity of nb (results above it are dropped)
+        \return number of neighbors
+     */
+    unsigned get_top_k(size_type row, neighbor* nb, unsigned nb_size) const;
+
+    /// Compute similarity from the population counts
+    static
+    float similarity(size_type and_cnt, size_type cnt1, size_type cnt2,
+                     metric_type m) BMNOEXCEPT;
+
+protected:
+    /// Task execution Entry Point: one pair of tiles
+    /// @internal
+    static void* task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        similarity_matrix_builder* sb =
+                        static_cast<similarity_matrix_builder*>(tdescr->ctx0);
+        unsigned ti = unsigned(tdescr->param0 >> 32);
+        unsigned tj = unsigned(tdescr->param0 & 0xFFFFFFFFu);
+        sb->compute_tiles(ti, tj);
+        return 0;
+    }
+
+    /// AND counts of all vector pairs of two tiles, store the similarities
+    void compute_tiles(unsigned ti, unsigned tj);
+
+    /// Top-K ordering: a is more similar than b
+    static bool is_better(const neighbor& a, const neighbor& b) BMNOEXCEPT
+    {
+        return (a.similarity > b.similarity) ||
+               (a.similarity == b.similarity && a.idx < b.idx);
+    }
+
+    /// Add candidate to the top-K heap of the row (row lock is held)
+    void add_neighbor(size_type row, size_type idx, float sim);
+
+private:
+    similarity_matrix_builder(const similarity_matrix_builder&);
+    similarity_matrix_builder& operator=(const similarity_matrix_builder&);
+
+protected:
+    typedef bm::heap_vector<size_type, allocator_type, true> count_vector_type;
+    typedef bm::heap_vector<neighbor, allocator_type, true> neighbor_vector_type;
+    typedef bm::heap_vector<unsigned, allocator_type, true> size_vector_type;
+
+    unsigned                   tile_size_;  ///< vectors per tile
+    metric_type                metric_;     ///< similarity metric
+    unsigned                   top_k_;      ///< top-K (0 - dense matrix)
+    const bvector_type* const* bv_arr_;     ///< collection
+    size_type                  size_;       ///< collection size
+    unsigned                   tiles_;      ///< number of tiles
+    count_vector_type          counts_;     ///< population counts
+    matrix_type                matrix_;     ///< dense results
+    neighbor_vector_type       top_;        ///< top-K heaps (size * top_k)
+    size_vector_type           top_cnt_;    ///< size of top-K heaps
+    lock_type*                 locks_;      ///< top-K lock per tile
+};
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+float similarity_matrix_builder<BV, Lock>::similarity(size_type and_cnt,
+                                                      size_type cnt1,
+                                                      size_type cnt2,
+                                                      metric_type m) BMNOEXCEPT
+{
+    if (!and_cnt)
+        return 0.0f;
+    if (m == cosine)
+        return float(double(and_cnt) / ::sqrt(double(cnt1) * double(cnt2)));
+    return float(double(and_cnt) / double(cnt1 + cnt2 - and_cnt));
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_matrix_builder<BV, Lock>::build_plan(
+                                        task_batch&                batch,
+                                        const bvector_type* const* bv_arr,
+                                        size_type                  size)
+{
+    bv_arr_ = bv_arr; size_ = size;
+    tiles_ = unsigned((size + tile_size_ - 1) / tile_size_);
+
+    counts_.resize(size_t(size));
+    for (size_type i = 0; i < size; ++i)
+        counts_[size_t(i)] = bv_arr[i] ? bv_arr[i]->count() : 0;
+
+    if (top_k_)
+    {
+        matrix_.resize(0, 0);
+        top_.resize(size_t(size) * top_k_);
+        top_cnt_.resize(size_t(size));
+        for (size_type i = 0; i < size; ++i)
+            top_cnt_[size_t(i)] = 0;
+        delete[] locks_;
+        locks_ = new lock_type[tiles_ ? tiles_ : 1];
+    }
+    else
+    {
+        matrix_.resize(size_t(size), size_t(size));
+        for (size_type i = 0; i < size; ++i) // diagonal
+        {
+            size_type cnt = counts_[size_t(i)];
+            matrix_.set(size_t(i), size_t(i),
+                        similarity(cnt, cnt, cnt, metric_));
+        }
+    }
+
+    auto& tv = batch.get_task_vector();
+    for (unsigned ti = 0; ti < tiles_; ++ti)
+    {
+        for (unsigned tj = ti; tj < tiles_; ++tj)
+        {
+            bm::task_description& tdescr = tv.add();
+            tdescr.init(task_run, (void*)&tdescr, (void*)this, 0,
+                        (bm::id64_t(ti) << 32) | tj);
+        } // for tj
+    } // for ti
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_matrix_builder<BV, Lock>::compute_tiles(unsigned ti,
+                                                        unsigned tj)
+{
+    const size_type i_from = size_type(ti) * tile_size_;
+    const size_type j_from = size_type(tj) * tile_size_;
+    const unsigned ni = unsigned(bm::min_value(size_type(tile_size_),
+                                               size_ - i_from));
+    const unsigned nj = unsigned(bm::min_value(size_type(tile_size_),
+                                               size_ - j_from));
+    const bool diag = (ti == tj);
+
+    std::vector<size_type> and_cnt(size_t(ni) * nj, 0);
+    std::vector<bm::word_t**> sub_i(ni), sub_j(nj);
+    std::vector<const bm::word_t*> blk_i(ni), blk_j(nj);
+    std::vector<unsigned> idx_i(ni), idx_j(nj);
+
+    unsigned top_size = 0;
+    for (unsigned k = 0; k < ni + nj; ++k)
+    {
+        const bvector_type* bv =
+            bv_arr_[size_t(k < ni ? i_from + k : j_from + (k - ni))];
+        if (bv && bv->get_blocks_manager().is_init())
+        {
+            unsigned ts = bv->get_blocks_manager().top_block_size();
+            if (ts > top_size)
+                top_size = ts;
+        }
+    } // for k
+
+    for (unsigned i0 = 0; i0 < top_size; ++i0)
+    {
+        // sub-arrays of both tiles
+        unsigned cnt_i = 0, cnt_j = 0;
+        for (unsigned k = 0; k < ni + nj; ++k)
+        {
+            const bvector_type* bv =
+                bv_arr_[size_t(k < ni ? i_from + k : j_from + (k - ni))];
+            bm::word_t** sub = 0;
+            if (bv)
+            {
+                const typename bvector_type::blocks_manager_type& bman =
+                                                bv->get_blocks_manager();
+                if (bman.is_init() && i0 < bman.top_block_size())
+                {
+                    sub = bman.top_blocks_root()[i0];
+                    if ((bm::word_t*)sub == FULL_BLOCK_FAKE_ADDR)
+                        sub = FULL_SUB_BLOCK_REAL_ADDR;
+                }
+            }
+            if (k < ni)
+            {
+                sub_i[k] = sub; cnt_i += bool(sub);
+            }
+            else
+            {
+                sub_j[k - ni] = sub; cnt_j += bool(sub);
+            }
+        } // for k
+        if (!cnt_i || !cnt_j)
+            continue;
+
+        for (unsigned j0 = 0; j0 < bm::set_sub_array_size; ++j0)
+        {
+            // blocks of the tiles are fetched once
+            cnt_i = cnt_j = 0;
+            for (unsigned k = 0; k < ni; ++k)
+            {
+                const bm::word_t* blk = sub_i[k] ? sub_i[k][j0] : 0;
+                if (blk)
+                {
+                    blk_i[cnt_i] = BLOCK_ADDR_SAN(blk);
+                    idx_i[cnt_i++] = k;
+                }
+            } // for k
+            if (!cnt_i)
+                continue;
+            for (unsigned k = 0; k < nj; ++k)
+            {
+                const bm::word_t* blk = sub_j[k] ? sub_j[k][j0] : 0;
+                if (blk)
+                {
+                    blk_j[cnt_j] = BLOCK_ADDR_SAN(blk);
+                    idx_j[cnt_j++] = k;
+                }
+            } // for k
+
+            for (unsigned a = 0; a < cnt_i; ++a)
+            {
+                const bm::word_t* blk_a = blk_i[a];
+                size_type* acc = &and_cnt[size_t(idx_i[a]) * nj];
+                for (unsigned b = 0; b < cnt_j; ++b)
+                {
+                    if (diag && idx_j[b] <= idx_i[a])
+                        continue;
+                    acc[idx_j[b]] += bm::combine_count_and_operation_with_block(
+                                                            blk_a, blk_j[b]);
+                } // for b
+            } // for a
+        } // for j0
+    } // for i0
+
+    // similarities
+    if (!top_k_)
+    {
+        for (unsigned a = 0; a < ni; ++a)
+        {
+            size_type ia = i_from + a;
+            for (unsigned b = diag ? a + 1 : 0; b < nj; ++b)
+            {
+                size_type jb = j_from + b;
+                float sim = similarity(and_cnt[size_t(a) * nj + b],
+                                       counts_[size_t(ia)],
+                                       counts_[size_t(jb)], metric_);
+                matrix_.set(size_t(ia), size_t(jb), sim);
+                matrix_.set(size_t(jb), size_t(ia), sim);
+            } // for b
+        } // for a
+        return;
+    }
+    {
+        bm::lock_guard<lock_type> lg(locks_[ti]);
+        for (unsigned a = 0; a < ni; ++a)
+        {
+            size_type ia = i_from + a;
+            for (unsigned b = diag ? a + 1 : 0; b < nj; ++b)
+            {
+                size_type and_c = and_cnt[size_t(a) * nj + b];
+                if (!and_c)
+                    continue;
+                size_type jb = j_from + b;
+                float sim = similarity(and_c, counts_[size_t(ia)],
+                                       counts_[size_t(jb)], metric_);
+                add_neighbor(ia, jb, sim);
+                if (diag)
+                    add_neighbor(jb, ia, sim);
+            } // for b
+        } // for a
+    }
+    if (!diag)
+    {
+        bm::lock_guard<lock_type> lg(locks_[tj]);
+        for (unsigned a = 0; a < ni; ++a)
+        {
+            size_type ia = i_from + a;
+            for (unsigned b = 0; b < nj; ++b)
+            {
+                size_type and_c = and_cnt[size_t(a) * nj + b];
+                if (!and_c)
+                    continue;
+                size_type jb = j_from + b;
+                float sim = similarity(and_c, counts_[size_t(ia)],
+                                       counts_[size_t(jb)], metric_);
+                add_neighbor(jb, ia, sim);
+            } // for b
+        } // for a
+    }
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_matrix_builder<BV, Lock>::add_neighbor(size_type row,
+                                                       size_type idx,
+                                                       float sim)
+{
+    neighbor nb; nb.idx = idx; nb.similarity = sim;
+    neighbor* heap = &top_[size_t(row) * top_k_];
+    unsigned& cnt = top_cnt_[size_t(row)];
+    // min-heap (the least similar on top)
+    if (cnt < top_k_)
+    {
+        heap[cnt++] = nb;
+        std::push_heap(heap, heap + cnt, is_better);
+        return;
+    }
+    if (!is_better(nb, heap[0]))
+        return;
+    std::pop_heap(heap, heap + cnt, is_better);
+    heap[cnt - 1] = nb;
+    std::push_heap(heap, heap + cnt, is_better);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+unsigned similarity_matrix_builder<BV, Lock>::get_top_k(size_type row,
+                                                        neighbor* nb,
+                                                   unsigned nb_size) const
+{
+    BM_ASSERT(top_k_ && row < size_);
+    unsigned cnt = top_cnt_[size_t(row)];
+    const neighbor* heap = &top_[size_t(row) * top_k_];
+    if (cnt <= nb_size)
+    {
+        for (unsigned i = 0; i < cnt; ++i)
+            nb[i] = heap[i];
+        std::sort(nb, nb + cnt, is_better);
+        return cnt;
+    }
+    // caller's buffer is short: keep the best nb_size results
+    neighbor_vector_type tmp;
+    tmp.resize(cnt);
+    for (unsigned i = 0; i < cnt; ++i)
+        tmp[i] = heap[i];
+    std::sort(tmp.data(), tmp.data() + cnt, is_better);
+    for (unsigned i = 0; i < nb_size; ++i)
+        nb[i] = tmp[i];
+    return nb_size;
+}
+
+
+/**
+    Top-K nearest bit-vectors search (Jaccard or Hamming) against
+    a collection.
+
+    Index keeps per-vector population counts and block presence
+    summaries (non-empty blocks with their counts). Search evaluates
+    candidates in the order of cardinality upper bound
+    (|A & B| <= min(|A|, |B|)), candidates are pruned against the
+    current K-th best result first by the cardinality bound, then by
+    the block overlap bound (sum of min block counts of common blocks),
+    only the rest are evaluated with exact count_and().
+
+    Evaluation runs as a batch of tasks (chunks of candidates), results
+    are collected into a bounded heap protected by the Lock
+    (std::mutex or bm::spin_lock<>). Results do not depend on the
+    order of task execution. Collection and the query should stay alive
+    until the batch is done.
+
+    \ingroup  distance
+*/
+template<typename BV, typename Lock>
+class similarity_search
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef typename
+        bvector_type::blocks_manager_type             blocks_manager_type;
+    typedef Lock                                      lock_type;
+
+    /// Similarity metric
+    enum metric_type
+    {
+        jaccard = 0,  ///< max |A & B| / |A | B|
+        hamming       ///< min |A ^ B|
+    };
+
+    /// Search result
+    struct neighbor
+    {
+        size_type  idx;         ///< index of the vector in the collection
+        float      similarity;  ///< Jaccard similarity to the query
+        size_type  distance;    ///< Hamming distance to the query
+    };
+
+    class task_batch : public bm::task_batch<allocator_type>
+    {
+    };
+
+public:
+    similarity_search() BMNOEXCEPT
+        : metric_(jaccard), chunk_size_(1024),
+          bv_arr_(0), size_(0), query_(0), top_k_(0),
+          q_cnt_(0), heap_size_(0), exact_cnt_(0)
+    {}
+
+    /**
+        Set similarity metric (default: jaccard)
+     */
+    void set_metric(metric_type m) BMNOEXCEPT { metric_ = m; }
+
+    /**
+        Set number of candidates per task (default: 1024)
+     */
+    void set_chunk_size(unsigned cnt) BMNOEXCEPT
+    {
+        BM_ASSERT(cnt);
+        chunk_size_ = cnt ? cnt : 1;
+    }
+
+    /**
+        Build index (counts and block summaries) of the collection
+        \param bv_arr - array of vector pointers (NULL - empty vector)
+        \param size - size of the collection
+     */
+    void build_index(const bvector_type* const* bv_arr, size_type size);
+
+    /**
+        Build the batch of search tasks
+        \param batch - [out] batch of tasks
+        \param query - query vector
+        \param k - number of results
+     */
+    void build_plan(task_batch& batch, const bvector_type& query, unsigned k);
+
+    /**
+        Search (sequential)
+        \param query - query vector
+        \param k - number of results
+     */
+    void search(const bvector_type& query, unsigned k);
+
+    /**
+        Get search results (after the batch is done)
+        \param nb - [out] array of (at least k) results sorted
+                    from the most similar (then by index)
+        \return number of results
+     */
+    unsigned get_results(neighbor* nb) const;
+
+    /// Number of candidates evaluated with exact count (not pruned)
+    size_type get_exact_count() const BMNOEXCEPT { return exact_cnt_; }
+
+protected:
+    /// Candidate or result (score: higher is better)
+    struct entry
+    {
+        double     score;
+        size_type  idx;
+        size_type  and_cnt;
+    };
+
+    /// Task execution Entry Point: chunk of candidates
+    /// @internal
+    static void* task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        similarity_search* ss = static_cast<similarity_search*>(tdescr->ctx0);
+        ss->search_chunk(size_type(tdescr->param0));
+        return 0;
+    }
+
+    /// Evaluate chunk of sorted candidates
+    void search_chunk(size_type chunk);
+
+    /// Score of the pair from the AND count (or its upper bound)
+    double score(size_type and_cnt, size_type cnt) const BMNOEXCEPT
+    {
+        if (metric_ == hamming)
+            return -double(q_cnt_ + cnt - 2 * and_cnt);
+        size_type or_cnt = q_cnt_ + cnt - and_cnt;
+        return or_cnt ? double(and_cnt) / double(or_cnt) : 0.0;
+    }
+
+    /// Block overlap upper bound of the AND count with the query
+    size_type block_overlap_bound(size_type idx) const BMNOEXCEPT;
+
+    /// Ordering of results: a is better than b
+    static bool is_better(const entry& a, const entry& b) BMNOEXCEPT
+    {
+        return (a.score > b.score) || (a.score == b.score && a.idx < b.idx);
+    }
+
+    /// Add block summary of a vector
+    void add_summary(const bvector_type* bv,
+                     std::vector<block_idx_type>& blk_idx,
+                     std::vector<unsigned>& blk_cnt);
+
+private:
+    similarity_search(const similarity_search&);
+    similarity_search& operator=(const similarity_search&);
+
+protected:
+    metric_type                  metric_;      ///< similarity metric
+    unsigned                     chunk_size_;  ///< candidates per task
+    const bvector_type* const*   bv_arr_;      ///< collection
+    size_type                    size_;        ///< collection size
+    std::vector<size_type>       counts_;      ///< population counts
+    std::vector<size_t>          blk_off_;     ///< summary offsets (size+1)
+    std::vector<block_idx_type>  blk_idx_;     ///< non-empty blocks
+    std::vector<unsigned>        blk_cnt_;     ///< counts of the blocks
+
+    const bvector_type*          query_;       ///< query vector
+    unsigned                     top_k_;       ///< number of results
+    size_type                    q_cnt_;       ///< query count
+    std::vector<block_idx_type>  q_blk_idx_;   ///< query blocks
+    std::vector<unsigned>        q_blk_cnt_;   ///< query block counts
+    std::vector<entry>           cand_;        ///< sorted candidates
+
+    lock_type                    lock_;        ///< heap lock
+    std::vector<entry>           heap_;        ///< results (min-heap)
+    unsigned                     heap_size_;   ///< results in the heap
+    size_type                    exact_cnt_;   ///< exact evaluations
+};
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_search<BV, Lock>::add_summary(
+                                    const bvector_type* bv,
+                                    std::vector<block_idx_type>& blk_idx,
+                                    std::vector<unsigned>& blk_cnt)
+{
+    if (!bv)
+        return;
+    const blocks_manager_type& bman = bv->get_blocks_manager();
+    if (!bman.is_init())
+        return;
+    bm::word_t*** blk_root = bman.top_blocks_root();
+    unsigned top_size = bman.top_block_size();
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        bm::word_t** blk_blk = blk_root[i];
+        if (!blk_blk)
+            continue;
+        if ((bm::word_t*)blk_blk == FULL_BLOCK_FAKE_ADDR)
+            blk_blk = FULL_SUB_BLOCK_REAL_ADDR;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+        {
+            const bm::word_t* blk = blk_blk[j];
+            if (!blk)
+                continue;
+            blk = BLOCK_ADDR_SAN(blk);
+            unsigned cnt = blocks_manager_type::block_bitcount(blk);
+            if (!cnt)
+                continue;
+            blk_idx.push_back(
+                block_idx_type(i) * bm::set_sub_array_size + j);
+            blk_cnt.push_back(cnt);
+        } // for j
+    } // for i
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_search<BV, Lock>::build_index(
+                                    const bvector_type* const* bv_arr,
+                                    size_type                  size)
+{
+    bv_arr_ = bv_arr; size_ = size;
+    counts_.resize(size_t(size));
+    blk_off_.resize(size_t(size) + 1);
+    blk_idx_.resize(0); blk_cnt_.resize(0);
+    for (size_type i = 0; i < size; ++i)
+    {
+        blk_off_[size_t(i)] = blk_idx_.size();
+        add_summary(bv_arr[i], blk_idx_, blk_cnt_);
+        size_type cnt = 0;
+        for (size_t k = blk_off_[size_t(i)]; k < blk_cnt_.size(); ++k)
+            cnt += blk_cnt_[k];
+        counts_[size_t(i)] = cnt;
+    } // for i
+    blk_off_[size_t(size)] = blk_idx_.size();
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_search<BV, Lock>::build_plan(task_batch& batch,
+                                             const bvector_type& query,
+                                             unsigned k)
+{
+    BM_ASSERT(bv_arr_ || !size_);
+    query_ = &query; top_k_ = k;
+    q_blk_idx_.resize(0); q_blk_cnt_.resize(0);
+    add_summary(&query, q_blk_idx_, q_blk_cnt_);
+    q_cnt_ = 0;
+    for (size_t i = 0; i < q_blk_cnt_.size(); ++i)
+        q_cnt_ += q_blk_cnt_[i];
+
+    heap_.resize(k);
+    heap_size_ = 0; exact_cnt_ = 0;
+    if (!k)
+    {
+        cand_.resize(0);
+        return;
+    }
+
+    // candidates ordered by the cardinality bound
+    cand_.resize(size_t(size_));
+    for (size_type i = 0; i < size_; ++i)
+    {
+        entry& e = cand_[size_t(i)];
+        e.idx = i;
+        e.and_cnt = bm::min_value(q_cnt_, counts_[size_t(i)]);
+        e.score = score(e.and_cnt, counts_[size_t(i)]);
+    } // for i
+    std::sort(cand_.begin(), cand_.end(), is_better);
+
+    size_type chunks = (size_ + chunk_size_ - 1) / chunk_size_;
+    auto& tv = batch.get_task_vector();
+    for (size_type i = 0; i < chunks; ++i)
+    {
+        bm::task_description& tdescr = tv.add();
+        tdescr.init(task_run, (void*)&tdescr, (void*)this, 0, i);
+    } // for i
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_search<BV, Lock>::search(const bvector_type& query,
+                                         unsigned k)
+{
+    task_batch batch;
+    build_plan(batch, query, k);
+    bm::run_task_batch(batch);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+typename similarity_search<BV, Lock>::size_type
+similarity_search<BV, Lock>::block_overlap_bound(size_type idx) const BMNOEXCEPT
+{
+    size_type and_ub = 0;
+    size_t i = 0, i_end = q_blk_idx_.size();
+    size_t j = blk_off_[size_t(idx)], j_end = blk_off_[size_t(idx) + 1];
+    while (i < i_end && j < j_end)
+    {
+        block_idx_type nb_q = q_blk_idx_[i], nb = blk_idx_[j];
+        if (nb_q == nb)
+        {
+            and_ub += bm::min_value(q_blk_cnt_[i], blk_cnt_[j]);
+            ++i; ++j;
+        }
+        else
+        {
+            i += (nb_q < nb);
+            j += (nb < nb_q);
+        }
+    } // while
+    return and_ub;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void similarity_search<BV, Lock>::search_chunk(size_type chunk)
+{
+    size_type from = chunk * chunk_size_;
+    size_type to = bm::min_value(from + chunk_size_, size_);
+    size_type exact_cnt = 0;
+
+    bool full;
+    entry threshold = entry(); // current K-th best (stale copy is safe)
+    {
+        bm::lock_guard<lock_type> lg(lock_);
+        full = (heap_size_ == top_k_);
+        if (full)
+            threshold = heap_[0];
+    }
+    for (size_type i = from; i < to; ++i)
+    {
+        entry e = cand_[size_t(i)];
+        if (full && is_better(threshold, e)) // cardinality bound prune
+            break; // candidates are sorted: the rest of the chunk fails
+        size_type cnt = counts_[size_t(e.idx)];
+        if (full)
+        {
+            e.and_cnt = block_overlap_bound(e.idx);
+            e.score = score(e.and_cnt, cnt);
+            if (is_better(threshold, e))
+                continue;
+        }
+        const bvector_type* bv = bv_arr_[size_t(e.idx)];
+        e.and_cnt = bv ? bm::count_and(*query_, *bv) : 0;
+        e.score = score(e.and_cnt, cnt);
+        ++exact_cnt;
+
+        bm::lock_guard<lock_type> lg(lock_);
+        if (heap_size_ < top_k_)
+        {
+            heap_[heap_size_++] = e;
+            std::push_heap(heap_.begin(), heap_.begin() + heap_size_,
+                           is_better);
+        }
+        else
+        if (is_better(e, heap_[0]))
+        {
+            std::pop_heap(heap_.begin(), heap_.begin() + heap_size_,
+                          is_better);
+            heap_[heap_size_ - 1] = e;
+            std::push_heap(heap_.begin(), heap_.begin() + heap_size_,
+                           is_better);
+        }
+        full = (heap_size_ == top_k_);
+        if (full)
+            threshold = heap_[0];
+    } // for i
+
+    bm::lock_guard<lock_type> lg(lock_);
+    exact_cnt_ += exact_cnt;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+unsigned similarity_search<BV, Lock>::get_results(neighbor* nb) const
+{
+    std::vector<entry> res(heap_.begin(), heap_.begin() + heap_size_);
+    std::sort(res.begin(), res.end(), is_better);
+    for (unsigned i = 0; i < heap_size_; ++i)
+    {
+        const entry& e = res[i];
+        size_type cnt = counts_[size_t(e.idx)];
+        size_type or_cnt = q_cnt_ + cnt - e.and_cnt;
+        nb[i].idx = e.idx;
+        nb[i].similarity =
+            or_cnt ? float(double(e.and_cnt) / double(or_cnt)) : 0.0f;
+        nb[i].distance = or_cnt - e.and_cnt;
+    } // for i
+    return heap_size_;
+}
+
+
 } // namespace bm
 
 
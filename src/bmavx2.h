@@ -1812,7 +1812,8 @@ void avx2_bit_block_calc_xor_change(const __m256i* BMRESTRICT block,
     __m256i cntAcc = _mm256_setzero_si256();
     __m256i cntAcc2 = _mm256_setzero_si256();
 
-    unsigned w0 = *((bm::word_t*)(block));
+    // first word of the XOR product (for carry-in correction)
+    unsigned w0 = *((bm::word_t*)(block)) ^ *((bm::word_t*)(xor_block));
     unsigned bit_count = 0;
     unsigned gap_count = 1;
 
@@ -2736,6 +2737,69 @@ unsigned avx2_lower_bound_scan_u32(const unsigned* BMRESTRICT arr,
     return to + 1;
 }
 
+/**
+    Count equal elements of two u32 arrays (same index)
+    @ingroup AVX2
+    \internal
+*/
+inline
+unsigned avx2_u32_eq_count(const unsigned* BMRESTRICT arr1,
+                           const unsigned* BMRESTRICT arr2,
+                           unsigned size) BMNOEXCEPT
+{
+    unsigned cnt = 0;
+    unsigned size_unr = size - (size % 16);
+    unsigned k = 0;
+    for (; k < size_unr; k += 16)
+    {
+        __m256i cmp0 = _mm256_cmpeq_epi32(
+                        _mm256_loadu_si256((const __m256i*)(arr1 + k)),
+                        _mm256_loadu_si256((const __m256i*)(arr2 + k)));
+        __m256i cmp1 = _mm256_cmpeq_epi32(
+                        _mm256_loadu_si256((const __m256i*)(arr1 + k + 8)),
+                        _mm256_loadu_si256((const __m256i*)(arr2 + k + 8)));
+        unsigned mask =
+            unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(cmp0))) |
+            (unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(cmp1))) << 8);
+        cnt += unsigned(_mm_popcnt_u32(mask));
+    } // for k
+    for (; k < size; ++k)
+        cnt += (arr1[k] == arr2[k]);
+    return cnt;
+}
+
+/**
+    Compare two zero-terminated strings 32 bytes at a time.
+    Both strings must be zero padded to 'size' (multiple of 32) so that
+    reads past the terminator stay inside the buffers.
+    @return <0, 0, >0 (as the first mismatched chars)
+    @ingroup AVX2
+    \internal
+*/
+inline
+int avx2_str_cmp_padded(const char* BMRESTRICT s1,
+                        const char* BMRESTRICT s2,
+                        unsigned size) BMNOEXCEPT
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (unsigned k = 0; k < size; k += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s1 + k));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s2 + k));
+        // stop mask: chars differ or s1 terminator (then s2 is 0 or not)
+        unsigned mask =
+            ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))) |
+            unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero)));
+        if (mask)
+        {
+            unsigned idx = k + unsigned(_tzcnt_u32(mask));
+            char c1 = s1[idx], c2 = s2[idx];
+            return (c1 > c2) - (c1 < c2);
+        }
+    } // for k
+    return 0;
+}
+
 
 /*!
      AVX2 bit block gather-scatter
@@ -3000,6 +3064,167 @@ void avx2_bit_block_xor(bm::word_t*  target_block,
     } // for i
 }
 
+/**
+    Build partial XOR product of 2 bit-blocks using digest mask and
+    compute bit count and number of bit changes of the product in one pass
+
+    @param target_block - target := block ^ xor_block
+    @param block - arg1
+    @param xor_block - arg2
+    @param digest - mask for each block wave to XOR (1) or just copy (0)
+    @param gcount - [out] gap count of the product
+    @param bcount - [out] bit count of the product
+
+    @ingroup AVX2
+    @internal
+*/
+inline
+void avx2_bit_block_xor_change_bc(bm::word_t* BMRESTRICT target_block,
+                                  const bm::word_t* BMRESTRICT block,
+                                  const bm::word_t* BMRESTRICT xor_block,
+                                  bm::id64_t digest,
+                                  unsigned* BMRESTRICT gcount,
+                                  unsigned* BMRESTRICT bcount)
+{
+    BM_AVX2_POPCNT_PROLOG;
+
+    __m256i m1COshft, m2COshft;
+    __m256i mCOidx = _mm256_set_epi32(6, 5, 4, 3, 2, 1, 0, 0);
+    __m256i cntAcc = _mm256_setzero_si256();
+    __m256i cntAcc2 = _mm256_setzero_si256();
+
+    bm::id64_t BM_ALIGN32 cnt_v[4] BM_ALIGN32ATTR;
+
+    unsigned co2, co1 = 0;
+    for (unsigned i = 0; i < bm::block_waves; ++i)
+    {
+        // all 1s mask for XOR filtered sub-block, 0 - just copy
+        const __m256i mMask = _mm256_set1_epi32(-int((digest >> i) & 1u));
+        unsigned off = (i * bm::set_block_digest_wave_size);
+        const __m256i* sub_block = (const __m256i*) (block + off);
+        const __m256i* xor_sub_block = (const __m256i*) (xor_block + off);
+        __m256i* t_sub_block = (__m256i*)(target_block + off);
+
+        for (unsigned k = 0; k < 4; k += 2)
+        {
+            __m256i m1A = _mm256_xor_si256(_mm256_load_si256(sub_block+k),
+                _mm256_and_si256(_mm256_load_si256(xor_sub_block+k), mMask));
+            __m256i m2A = _mm256_xor_si256(_mm256_load_si256(sub_block+k+1),
+                _mm256_and_si256(_mm256_load_si256(xor_sub_block+k+1), mMask));
+            _mm256_store_si256(t_sub_block+k, m1A);
+            _mm256_store_si256(t_sub_block+k+1, m2A);
+            {
+                BM_AVX2_BIT_COUNT(bc, m1A)
+                cntAcc2 = _mm256_add_epi64(cntAcc2, bc);
+                BM_AVX2_BIT_COUNT(bc, m2A)
+                cntAcc2 = _mm256_add_epi64(cntAcc2, bc);
+            }
+
+            __m256i m1CO = _mm256_srli_epi32(m1A, 31);
+            __m256i m2CO = _mm256_srli_epi32(m2A, 31);
+
+            co2 = _mm256_extract_epi32(m1CO, 7);
+
+            __m256i m1As = _mm256_slli_epi32(m1A, 1); // (block[i] << 1u)
+            __m256i m2As = _mm256_slli_epi32(m2A, 1);
+
+            // shift CO flags using +1 permute indexes, add CO to v[0]
+            m1COshft = _mm256_permutevar8x32_epi32(m1CO, mCOidx);
+            m1COshft = _mm256_insert_epi32(m1COshft, co1, 0); // v[0] = co_flag
+
+            co1 = co2;
+
+            co2 = _mm256_extract_epi32(m2CO, 7);
+            m2COshft = _mm256_permutevar8x32_epi32(m2CO, mCOidx);
+            m2COshft = _mm256_insert_epi32(m2COshft, co1, 0);
+
+            m1As = _mm256_or_si256(m1As, m1COshft); // block[i] |= co_flag
+            m2As = _mm256_or_si256(m2As, m2COshft);
+
+            co1 = co2;
+
+            m1A = _mm256_xor_si256(m1A, m1As); // w ^= (w >> 1);
+            m2A = _mm256_xor_si256(m2A, m2As);
+            {
+                BM_AVX2_BIT_COUNT(bc, m1A)
+                cntAcc = _mm256_add_epi64(cntAcc, bc);
+                BM_AVX2_BIT_COUNT(bc, m2A)
+                cntAcc = _mm256_add_epi64(cntAcc, bc);
+            }
+        } // for k
+    } // for i
+
+    // horizontal count sum
+    _mm256_store_si256 ((__m256i*)cnt_v, cntAcc);
+    unsigned gap_count = 1 + (unsigned)(cnt_v[0] + cnt_v[1] + cnt_v[2] + cnt_v[3]);
+    gap_count -= (target_block[0] & 1u); // correct initial carry-in error
+
+    _mm256_store_si256 ((__m256i*)cnt_v, cntAcc2);
+    *gcount = gap_count;
+    *bcount = (unsigned)(cnt_v[0] + cnt_v[1] + cnt_v[2] + cnt_v[3]);
+}
+
+/**
+    Transposition of 32 unsigned values into bit-plane words
+    (8x32 byte-matrix shuffle + movemask)
+
+    Bytes of the values are regrouped so that one register holds
+    byte k of all 32 values, then each bit of it is extracted
+    with a shift and byte movemask (plane word 8*k+b).
+
+    @param arr - source array of 32 values
+    @param w - target plane words (must fit 8*ceil(n/8) words)
+    @param n - number of planes to produce
+
+    @ingroup AVX2
+    @internal
+*/
+inline
+void avx2_bit_planes_encode32(const unsigned* BMRESTRICT arr,
+                              unsigned* BMRESTRICT w,
+                              unsigned n) BMNOEXCEPT
+{
+    const __m256i shuf = _mm256_setr_epi8(0,4,8,12, 1,5,9,13,
+                                          2,6,10,14, 3,7,11,15,
+                                          0,4,8,12, 1,5,9,13,
+                                          2,6,10,14, 3,7,11,15);
+    const __m256i perm = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+
+    // after shuffle and permute: qword k of mX = byte k of 8 values
+    __m256i m0 = _mm256_loadu_si256((const __m256i*)arr);
+    __m256i m1 = _mm256_loadu_si256((const __m256i*)(arr + 8));
+    __m256i m2 = _mm256_loadu_si256((const __m256i*)(arr + 16));
+    __m256i m3 = _mm256_loadu_si256((const __m256i*)(arr + 24));
+    m0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(m0, shuf), perm);
+    m1 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(m1, shuf), perm);
+    m2 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(m2, shuf), perm);
+    m3 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(m3, shuf), perm);
+
+    __m256i lo01 = _mm256_unpacklo_epi64(m0, m1);
+    __m256i hi01 = _mm256_unpackhi_epi64(m0, m1);
+    __m256i lo23 = _mm256_unpacklo_epi64(m2, m3);
+    __m256i hi23 = _mm256_unpackhi_epi64(m2, m3);
+
+    __m256i bt[4]; // byte k of all 32 values
+    bt[0] = _mm256_permute2x128_si256(lo01, lo23, 0x20);
+    bt[1] = _mm256_permute2x128_si256(hi01, hi23, 0x20);
+    bt[2] = _mm256_permute2x128_si256(lo01, lo23, 0x31);
+    bt[3] = _mm256_permute2x128_si256(hi01, hi23, 0x31);
+
+    for (unsigned k = 0; k < 4 && (k * 8) < n; ++k, w += 8)
+    {
+        __m256i b = bt[k];
+        w[0] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 7)));
+        w[1] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 6)));
+        w[2] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 5)));
+        w[3] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 4)));
+        w[4] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 3)));
+        w[5] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 2)));
+        w[6] = unsigned(_mm256_movemask_epi8(_mm256_slli_epi16(b, 1)));
+        w[7] = unsigned(_mm256_movemask_epi8(b));
+    } // for k
+}
+
 
 
 
@@ -3098,6 +3323,12 @@ void avx2_bit_block_xor(bm::word_t*  target_block,
 #define VECT_LOWER_BOUND_SCAN_U32(arr, target, from, to) \
     avx2_lower_bound_scan_u32(arr, target, from, to)
 
+#define VECT_U32_EQ_COUNT(arr1, arr2, size) \
+    avx2_u32_eq_count(arr1, arr2, size)
+
+#define VECT_STR_CMP_PADDED(s1, s2, size) \
+    avx2_str_cmp_padded(s1, s2, size)
+
 #define VECT_SHIFT_L1(b, acc, co) \
     avx2_shift_l1((__m256i*)b, acc, co)
 
@@ -3134,12 +3365,18 @@ void avx2_bit_block_xor(bm::word_t*  target_block,
 #define VECT_BIT_BLOCK_XOR(t, src, src_xor, d) \
     avx2_bit_block_xor(t, src, src_xor, d)
 
+#define VECT_BIT_BLOCK_XOR_CHANGE_BC(t, src, src_xor, d, gc, bc) \
+    avx2_bit_block_xor_change_bc(t, src, src_xor, d, gc, bc)
+
 #define VECT_GAP_BFIND(buf, pos, is_set) \
     avx2_gap_bfind(buf, pos, is_set)
 
 #define VECT_BIT_COUNT_DIGEST(blk, d) \
     avx2_bit_block_count(blk, d)
 
+#define VECT_BIT_PLANES_ENCODE32(arr, w, n) \
+    avx2_bit_planes_encode32(arr, w, n)
+
 
 } // namespace
 
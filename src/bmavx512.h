@@ -1518,6 +1518,228 @@ void avx2_bit_block_gather_scatter(unsigned* BMRESTRICT arr,
 
 }
 
+/**
+    Transposition of 32 unsigned values into bit-plane words
+    (bit test to mask register)
+
+    @param arr - source array of 32 values
+    @param w - target plane words
+    @param n - number of planes to produce
+
+    @ingroup AVX512
+    @internal
+*/
+inline
+void avx512_bit_planes_encode32(const unsigned* BMRESTRICT arr,
+                                unsigned* BMRESTRICT w,
+                                unsigned n)
+{
+    __m512i m0 = _mm512_loadu_si512((const void*)arr);
+    __m512i m1 = _mm512_loadu_si512((const void*)(arr + 16));
+    __m512i mb = _mm512_set1_epi32(1);
+    for (unsigned j = 0; j < n; ++j)
+    {
+        unsigned lo = _mm512_test_epi32_mask(m0, mb);
+        unsigned hi = _mm512_test_epi32_mask(m1, mb);
+        w[j] = lo | (hi << 16);
+        mb = _mm512_slli_epi32(mb, 1);
+    } // for j
+}
+
+/**
+    AVX512 popcount of 512-bit register accumulated into 4x64-bit counters
+    (two 256-bit halves, needs BM_AVX2_POPCNT_PROLOG)
+    @internal
+*/
+#define BM_AVX512_BIT_COUNT_ACC(acc, v) \
+{ \
+    __m256i v0 = _mm512_castsi512_si256(v); \
+    __m256i v1 = _mm512_extracti64x4_epi64(v, 1); \
+    BM_AVX2_BIT_COUNT(bc, v0) \
+    acc = _mm256_add_epi64(acc, bc); \
+    BM_AVX2_BIT_COUNT(bc, v1) \
+    acc = _mm256_add_epi64(acc, bc); \
+}
+
+/**
+    Horizontal sum of 4x64-bit counters
+    @internal
+*/
+inline
+unsigned avx512_sum_cnt256(__m256i acc)
+{
+    bm::id64_t BM_ALIGN32 cnt_v[4] BM_ALIGN32ATTR;
+    _mm256_store_si256((__m256i*)cnt_v, acc);
+    return (unsigned)(cnt_v[0] + cnt_v[1] + cnt_v[2] + cnt_v[3]);
+}
+
+/*!
+    AVX512 calculate number of bit changes from 0 to 1 from a XOR product
+    and bit count of the product
+    @ingroup AVX512
+*/
+inline
+void avx512_bit_block_calc_xor_change(const __m512i* BMRESTRICT block,
+                                      const __m512i* BMRESTRICT xor_block,
+                                      unsigned size,
+                                      unsigned* BMRESTRICT gcount,
+                                      unsigned* BMRESTRICT bcount)
+{
+    BM_ASSERT(size % 32 == 0);
+    BM_AVX2_POPCNT_PROLOG;
+
+    const __m512i* BMRESTRICT block_end =
+        (const __m512i*)((bm::word_t*)(block) + size);
+
+    __m256i cntAcc = _mm256_setzero_si256();
+    __m256i cntAcc2 = _mm256_setzero_si256();
+    __m512i mCOprev = _mm512_setzero_si512();
+
+    unsigned w0 = *((bm::word_t*)(block)) ^ *((bm::word_t*)(xor_block));
+    for (;block < block_end; block+=2, xor_block+=2)
+    {
+        __m512i m1A = _mm512_xor_si512(_mm512_load_si512(block),
+                                       _mm512_load_si512(xor_block));
+        __m512i m2A = _mm512_xor_si512(_mm512_load_si512(block+1),
+                                       _mm512_load_si512(xor_block+1));
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m2A)
+
+        // carry-over flags shifted by one word (v[0] = CO of prev. word)
+        __m512i m1CO = _mm512_srli_epi32(m1A, 31);
+        __m512i m2CO = _mm512_srli_epi32(m2A, 31);
+        __m512i m1COshft = _mm512_alignr_epi32(m1CO, mCOprev, 15);
+        __m512i m2COshft = _mm512_alignr_epi32(m2CO, m1CO, 15);
+        mCOprev = m2CO;
+
+        // w ^= (w << 1) | co_flag
+        m1A = _mm512_xor_si512(m1A,
+                    _mm512_or_si512(_mm512_slli_epi32(m1A, 1), m1COshft));
+        m2A = _mm512_xor_si512(m2A,
+                    _mm512_or_si512(_mm512_slli_epi32(m2A, 1), m2COshft));
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m2A)
+    } // for
+
+    unsigned gap_count = 1 + avx512_sum_cnt256(cntAcc);
+    gap_count -= (w0 & 1u); // correct initial carry-in error
+    *gcount = gap_count;
+    *bcount = avx512_sum_cnt256(cntAcc2);
+}
+
+/*!
+    AVX512 calculate number of bit changes and bit count of a bit-block
+    @ingroup AVX512
+*/
+inline
+void avx512_bit_block_calc_change_bc(const __m512i* BMRESTRICT block,
+                                     unsigned* gcount, unsigned* bcount)
+{
+    BM_AVX2_POPCNT_PROLOG;
+
+    const __m512i* block_end =
+        (const __m512i*)((bm::word_t*)(block) + bm::set_block_size);
+
+    __m256i cntAcc = _mm256_setzero_si256();
+    __m256i cntAcc2 = _mm256_setzero_si256();
+    __m512i mCOprev = _mm512_setzero_si512();
+
+    unsigned w0 = *((bm::word_t*)(block));
+    for (;block < block_end; block+=2)
+    {
+        __m512i m1A = _mm512_load_si512(block);
+        __m512i m2A = _mm512_load_si512(block+1);
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m2A)
+
+        __m512i m1CO = _mm512_srli_epi32(m1A, 31);
+        __m512i m2CO = _mm512_srli_epi32(m2A, 31);
+        __m512i m1COshft = _mm512_alignr_epi32(m1CO, mCOprev, 15);
+        __m512i m2COshft = _mm512_alignr_epi32(m2CO, m1CO, 15);
+        mCOprev = m2CO;
+
+        m1A = _mm512_xor_si512(m1A,
+                    _mm512_or_si512(_mm512_slli_epi32(m1A, 1), m1COshft));
+        m2A = _mm512_xor_si512(m2A,
+                    _mm512_or_si512(_mm512_slli_epi32(m2A, 1), m2COshft));
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m2A)
+    } // for
+
+    unsigned gap_count = 1 + avx512_sum_cnt256(cntAcc);
+    gap_count -= (w0 & 1u); // correct initial carry-in error
+    *gcount = gap_count;
+    *bcount = avx512_sum_cnt256(cntAcc2);
+}
+
+/**
+    Build partial XOR product of 2 bit-blocks using digest mask and
+    compute bit count and number of bit changes of the product in one pass
+
+    @param target_block - target := block ^ xor_block
+    @param block - arg1
+    @param xor_block - arg2
+    @param digest - mask for each block wave to XOR (1) or just copy (0)
+    @param gcount - [out] gap count of the product
+    @param bcount - [out] bit count of the product
+
+    @ingroup AVX512
+    @internal
+*/
+inline
+void avx512_bit_block_xor_change_bc(bm::word_t* BMRESTRICT target_block,
+                                    const bm::word_t* BMRESTRICT block,
+                                    const bm::word_t* BMRESTRICT xor_block,
+                                    bm::id64_t digest,
+                                    unsigned* BMRESTRICT gcount,
+                                    unsigned* BMRESTRICT bcount)
+{
+    BM_AVX2_POPCNT_PROLOG;
+
+    __m256i cntAcc = _mm256_setzero_si256();
+    __m256i cntAcc2 = _mm256_setzero_si256();
+    __m512i mCOprev = _mm512_setzero_si512();
+
+    for (unsigned i = 0; i < bm::block_waves; ++i)
+    {
+        // XOR filtered sub-block (all lanes) or just copy (no lanes)
+        const __mmask16 k = __mmask16(0u - unsigned((digest >> i) & 1u));
+        unsigned off = (i * bm::set_block_digest_wave_size);
+        const __m512i* sub_block = (const __m512i*) (block + off);
+        const __m512i* xor_sub_block = (const __m512i*) (xor_block + off);
+        __m512i* t_sub_block = (__m512i*)(target_block + off);
+
+        __m512i m1A = _mm512_load_si512(sub_block);
+        __m512i m2A = _mm512_load_si512(sub_block+1);
+        m1A = _mm512_mask_xor_epi32(m1A, k, m1A,
+                                    _mm512_load_si512(xor_sub_block));
+        m2A = _mm512_mask_xor_epi32(m2A, k, m2A,
+                                    _mm512_load_si512(xor_sub_block+1));
+        _mm512_store_si512(t_sub_block, m1A);
+        _mm512_store_si512(t_sub_block+1, m2A);
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc2, m2A)
+
+        __m512i m1CO = _mm512_srli_epi32(m1A, 31);
+        __m512i m2CO = _mm512_srli_epi32(m2A, 31);
+        __m512i m1COshft = _mm512_alignr_epi32(m1CO, mCOprev, 15);
+        __m512i m2COshft = _mm512_alignr_epi32(m2CO, m1CO, 15);
+        mCOprev = m2CO;
+
+        m1A = _mm512_xor_si512(m1A,
+                    _mm512_or_si512(_mm512_slli_epi32(m1A, 1), m1COshft));
+        m2A = _mm512_xor_si512(m2A,
+                    _mm512_or_si512(_mm512_slli_epi32(m2A, 1), m2COshft));
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m1A)
+        BM_AVX512_BIT_COUNT_ACC(cntAcc, m2A)
+    } // for i
+
+    unsigned gap_count = 1 + avx512_sum_cnt256(cntAcc);
+    gap_count -= (target_block[0] & 1u); // correct initial carry-in error
+    *gcount = gap_count;
+    *bcount = avx512_sum_cnt256(cntAcc2);
+}
+
 #ifdef __GNUG__
 #pragma GCC diagnostic pop
 #endif
@@ -1598,6 +1820,18 @@ void avx2_bit_block_gather_scatter(unsigned* BMRESTRICT arr,
 #define VECT_ARR_BLOCK_LOOKUP(idx, size, nb, start) \
     avx2_idx_arr_block_lookup(idx, size, nb, start)
 
+#define VECT_BIT_PLANES_ENCODE32(arr, w, n) \
+    avx512_bit_planes_encode32(arr, w, n)
+
+#define VECT_BLOCK_XOR_CHANGE(block, xor_block, size, gc, bc) \
+    avx512_bit_block_calc_xor_change((__m512i*)block, (__m512i*)xor_block, size, gc, bc)
+
+#define VECT_BLOCK_CHANGE_BC(block, gc, bc) \
+    avx512_bit_block_calc_change_bc((__m512i*)block, gc, bc)
+
+#define VECT_BIT_BLOCK_XOR_CHANGE_BC(t, src, src_xor, d, gc, bc) \
+    avx512_bit_block_xor_change_bc(t, src, src_xor, d, gc, bc)
+
 
 
 } // namespace
@@ -1173,6 +1173,23 @@ public:
         return top_blocks_[nblk_blk];
     }
 
+    /**
+        Allocate top sub-blocks for the range of blocks [nb_from..nb_to]
+        so blocks with disjoint indexes can be assigned concurrently
+        (no re-allocation of the top level tree happens later)
+    */
+    void reserve_top_subblocks(block_idx_type nb_from, block_idx_type nb_to)
+    {
+        BM_ASSERT(nb_from <= nb_to);
+        if (!is_init())
+            init_tree();
+        unsigned i_from = unsigned(nb_from >> bm::set_array_shift);
+        unsigned i_to = unsigned(nb_to >> bm::set_array_shift);
+        reserve_top_blocks(i_to + 1);
+        for (unsigned i = i_from; i <= i_to; ++i)
+            check_alloc_top_subblock(i);
+    }
+
     /**
         Places new block into descriptors table, returns old block's address.
         Old block is NOT deleted.
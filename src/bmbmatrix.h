@@ -224,6 +224,13 @@ public:
     */
     void optimize_block(block_idx_type nb);
 
+    /*! Get bit-block of a row for bulk OR assignment:
+        empty block gets allocated, GAP block gets converted to bit-block
+        @return NULL if block is all set (nothing to assign)
+        @internal
+    */
+    bm::word_t* check_allocate_bit_block(size_type row, block_idx_type nb);
+
     ///@}
 
 
@@ -248,6 +255,142 @@ protected:
     size_type                rsize_;
 };
 
+/**
+    Block-interleaved (read-only) bit-matrix.
+
+    Alternative layout of basic_bmatrix planes: all planes of one block
+    coordinate are co-located in a single allocation (block group)
+    with a per-group plane-presence mask. Point gather and find_eq touch
+    one contiguous region per block instead of walking one bit-vector
+    tree per plane. Plane-wise access remains available via get_block().
+
+    Groups are kept in a two-level (top, sub-array) table like
+    blocks_manager: super-blocks without non-empty groups have no
+    sub-array allocated.
+
+    Supports up to 64 planes (value planes of sparse_vector<>).
+    NULL semantics are left to the caller.
+
+    @ingroup bmagic
+    @internal
+*/
+template<typename BV>
+class interleaved_bmatrix
+{
+public:
+    typedef BV                                       bvector_type;
+    typedef typename BV::allocator_type              allocator_type;
+    typedef typename bvector_type::size_type         size_type;
+    typedef typename bvector_type::block_idx_type    block_idx_type;
+
+    /// Block group descriptor
+    struct block_group
+    {
+        bm::word_t*  blocks;     ///< bit-blocks of plane_mask planes (in plane order)
+        bm::id64_t   plane_mask; ///< planes stored as bit-blocks
+        bm::id64_t   full_mask;  ///< planes with all-ones blocks (not stored)
+    };
+    typedef
+    bm::heap_vector<block_group*, allocator_type, true> group_top_vector_type;
+
+public:
+    interleaved_bmatrix(const allocator_type& alloc = allocator_type())
+        : alloc_(alloc), planes_(0), size_(0), nb_cnt_(0)
+    {
+        empty_group_.blocks = 0;
+        empty_group_.plane_mask = empty_group_.full_mask = 0;
+    }
+    ~interleaved_bmatrix() BMNOEXCEPT { free_groups(); }
+
+    /**
+        \brief Build interleaved layout from bit-matrix planes [0..planes)
+        \param bmatr - source bit-matrix
+        \param planes - number of planes to interleave (max 64)
+        \param size - logical size (number of columns)
+    */
+    void build(const bm::basic_bmatrix<BV>& bmatr,
+               unsigned planes, size_type size);
+
+    /// Release all groups
+    void clear() BMNOEXCEPT { free_groups(); planes_ = 0; size_ = 0; }
+
+    /// Number of interleaved planes
+    unsigned planes() const BMNOEXCEPT { return planes_; }
+
+    /// Logical size
+    size_type size() const BMNOEXCEPT { return size_; }
+
+    /// Number of block groups
+    size_type groups() const BMNOEXCEPT { return size_type(nb_cnt_); }
+
+    /// Access to group descriptor (empty group if not stored)
+    const block_group& get_group(block_idx_type nb) const BMNOEXCEPT
+    {
+        const block_group* g = find_group(nb);
+        return g ? *g : empty_group_;
+    }
+
+    /**
+        Plane-wise view: get block of a plane
+        \return bit-block pointer, FULL_BLOCK_FAKE_ADDR or NULL
+    */
+    const bm::word_t* get_block(unsigned plane,
+                                block_idx_type nb) const BMNOEXCEPT;
+
+    /// Get value of element idx
+    template<typename VT>
+    VT get(size_type idx) const BMNOEXCEPT;
+
+    /**
+        \brief Gather elements by index
+        \param arr - destination array
+        \param idx - array of indexes
+        \param size - number of elements
+    */
+    template<typename VT>
+    void gather(VT* BMRESTRICT arr,
+                const size_type* BMRESTRICT idx, size_type size) const BMNOEXCEPT;
+
+    /**
+        \brief Find all elements equal to value (within [0..size))
+        \param value - value to search for
+        \param bv_res - [out] search result (cleared first)
+    */
+    template<typename VT>
+    void find_eq(VT value, bvector_type& bv_res) const;
+
+protected:
+    void free_groups() BMNOEXCEPT;
+
+    /// Group of block nb or NULL (super-block has no groups stored)
+    const block_group* find_group(block_idx_type nb) const BMNOEXCEPT
+    {
+        if (nb >= nb_cnt_)
+            return 0;
+        const block_group* sub = top_[size_type(nb >> bm::set_array_shift)];
+        return sub ? sub + (nb & bm::set_array_mask) : 0;
+    }
+
+    /// Size of a groups sub-array in pointer units (for alloc_ptr())
+    static size_t sub_ptr_size() BMNOEXCEPT
+    {
+        return (sizeof(block_group) * bm::set_sub_array_size +
+                sizeof(void*) - 1) / sizeof(void*);
+    }
+
+private:
+    interleaved_bmatrix(const interleaved_bmatrix&);
+    interleaved_bmatrix& operator=(const interleaved_bmatrix&);
+
+protected:
+    allocator_type        alloc_;
+    group_top_vector_type top_;        ///< sub-arrays of groups (or NULL)
+    block_group           empty_group_;
+    unsigned              planes_;
+    size_type             size_;
+    block_idx_type        nb_cnt_;     ///< number of block groups
+};
+
 /**
     Base class for bit-transposed sparse vector construction
  
@@ -1174,6 +1317,258 @@ void basic_bmatrix<BV>::optimize_block(block_idx_type nb)
 
 }
 
+//---------------------------------------------------------------------
+
+template<typename BV>
+bm::word_t* basic_bmatrix<BV>::check_allocate_bit_block(size_type row,
+                                                        block_idx_type nb)
+{
+    bvector_type* bv = get_row(row);
+    BM_ASSERT(bv);
+    typename bvector_type::blocks_manager_type& bman =
+                                                bv->get_blocks_manager();
+    int block_type;
+    bm::word_t* blk =
+        bman.check_allocate_block(nb, 1, 0, &block_type,
+                                  true/*allow NULL ret*/);
+    if (IS_FULL_BLOCK(blk)) // all bits are already set
+        return 0;
+    if (BM_IS_GAP(blk))
+        blk = bman.deoptimize_block(nb);
+    return blk;
+}
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV>
+void interleaved_bmatrix<BV>::free_groups() BMNOEXCEPT
+{
+    size_type top_sz = top_.size();
+    for (size_type i = 0; i < top_sz; ++i)
+    {
+        block_group* sub = top_[i];
+        if (!sub)
+            continue;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+        {
+            block_group& g = sub[j];
+            if (g.blocks)
+                alloc_.free_bit_block(g.blocks,
+                                      bm::word_bitcount64(g.plane_mask));
+        } // for j
+        alloc_.free_ptr(sub, sub_ptr_size());
+    } // for i
+    top_.resize(0);
+    nb_cnt_ = 0;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void interleaved_bmatrix<BV>::build(const bm::basic_bmatrix<BV>& bmatr,
+                                    unsigned planes, size_type size)
+{
+    BM_ASSERT(planes <= 64);
+    BM_ASSERT(planes <= bmatr.rows());
+
+    free_groups();
+    planes_ = planes; size_ = size;
+    if (!size)
+        return;
+
+    block_idx_type nb_cnt = ((size - 1) >> bm::set_block_shift) + 1;
+    size_type top_sz = size_type((nb_cnt - 1) >> bm::set_array_shift) + 1;
+    top_.resize(top_sz);
+    for (size_type i = 0; i < top_sz; ++i)
+        top_[i] = 0;
+    nb_cnt_ = nb_cnt;
+
+    const bm::word_t* blks[64];
+    for (block_idx_type nb = 0; nb < nb_cnt; ++nb)
+    {
+        unsigned i0 = unsigned(nb >> bm::set_array_shift);
+        unsigned j0 = unsigned(nb &  bm::set_array_mask);
+        bm::id64_t plane_mask = 0, full_mask = 0;
+        unsigned k = 0;
+        for (unsigned p = 0; p < planes; ++p)
+        {
+            const bm::word_t* blk = bmatr.get_block(p, i0, j0);
+            if (!blk)
+                continue;
+            if (IS_FULL_BLOCK(blk))
+            {
+                full_mask |= (1ull << p);
+                continue;
+            }
+            plane_mask |= (1ull << p);
+            blks[k++] = blk;
+        } // for p
+        if (!(plane_mask | full_mask)) // empty group is not stored
+            continue;
+
+        block_group* sub = top_[i0];
+        if (!sub) // first non-empty group of the super-block
+        {
+            sub = (block_group*) alloc_.alloc_ptr(sub_ptr_size());
+            for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+            {
+                sub[j].blocks = 0;
+                sub[j].plane_mask = sub[j].full_mask = 0;
+            }
+            top_[i0] = sub;
+        }
+        block_group& g = sub[j0];
+        g.full_mask = full_mask;
+        if (!k)
+            continue;
+
+        g.blocks = alloc_.alloc_bit_block(k);
+        if (!g.blocks)
+            BV::throw_bad_alloc();
+        g.plane_mask = plane_mask;
+        for (unsigned m = 0; m < k; ++m)
+        {
+            bm::word_t* dst = g.blocks + m * bm::set_block_size;
+            const bm::word_t* blk = blks[m];
+            if (BM_IS_GAP(blk))
+                bm::gap_convert_to_bitset(dst, BMGAP_PTR(blk));
+            else
+                bm::bit_block_copy(dst, blk);
+        } // for m
+    } // for nb
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+const bm::word_t*
+interleaved_bmatrix<BV>::get_block(unsigned plane,
+                                   block_idx_type nb) const BMNOEXCEPT
+{
+    BM_ASSERT(plane < planes_);
+    const block_group* gp = find_group(nb);
+    if (!gp)
+        return 0;
+    const block_group& g = *gp;
+    bm::id64_t pmask = (1ull << plane);
+    if (g.full_mask & pmask)
+        return FULL_BLOCK_FAKE_ADDR;
+    if (!(g.plane_mask & pmask))
+        return 0;
+    unsigned k = bm::word_bitcount64(g.plane_mask & (pmask - 1));
+    return g.blocks + k * bm::set_block_size;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV> template<typename VT>
+VT interleaved_bmatrix<BV>::get(size_type idx) const BMNOEXCEPT
+{
+    const block_group* gp = find_group(idx >> bm::set_block_shift);
+    if (!gp)
+        return 0;
+    const block_group& g = *gp;
+    VT v = VT(g.full_mask);
+    bm::id64_t m = g.plane_mask;
+    if (m)
+    {
+        unsigned nbit = unsigned(idx & bm::set_block_mask);
+        const bm::word_t* w = g.blocks + (nbit >> bm::set_word_shift);
+        bm::word_t mask = (1u << (nbit & bm::set_word_mask));
+        do
+        {
+            if (*w & mask)
+                v |= (VT(1) << bm::count_trailing_zeros_u64(m));
+            w += bm::set_block_size;
+            m &= m - 1;
+        } while (m);
+    }
+    return v;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV> template<typename VT>
+void interleaved_bmatrix<BV>::gather(VT* BMRESTRICT arr,
+                                     const size_type* BMRESTRICT idx,
+                                     size_type size) const BMNOEXCEPT
+{
+    for (size_type i = 0; i < size; ++i)
+        arr[i] = this->template get<VT>(idx[i]);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV> template<typename VT>
+void interleaved_bmatrix<BV>::find_eq(VT value, bvector_type& bv_res) const
+{
+    bv_res.clear(true);
+    bm::id64_t vmask = bm::id64_t(value);
+    if (planes_ < 64 && (vmask >> planes_)) // value is out of planes range
+        return;
+
+    typename bvector_type::blocks_manager_type& bman =
+                                                bv_res.get_blocks_manager();
+    size_type nb_cnt = size_type(nb_cnt_);
+    for (size_type nb = 0; nb < nb_cnt; ++nb)
+    {
+        if (vmask && !top_[nb >> bm::set_array_shift])
+        {
+            nb |= bm::set_array_mask; // skip empty super-block
+            continue;
+        }
+        const block_group& g = get_group(block_idx_type(nb));
+        if (vmask & ~(g.plane_mask | g.full_mask)) // 1 over an empty plane
+            continue;
+        if (~vmask & g.full_mask) // 0 over a full plane
+            continue;
+        bm::id64_t and_mask = vmask & g.plane_mask;
+        bm::id64_t sub_mask = g.plane_mask & ~and_mask;
+        if (!g.plane_mask)
+        {
+            bman.set_block(block_idx_type(nb), FULL_BLOCK_FAKE_ADDR);
+            continue;
+        }
+        bm::word_t* blk = bman.get_allocator().alloc_bit_block();
+        bm::id64_t any = 1;
+        const bm::word_t* src = g.blocks;
+        bool first = true;
+        for (bm::id64_t m = g.plane_mask; m && any;
+                                m &= m - 1, src += bm::set_block_size)
+        {
+            bm::id64_t t = m & (0 - m);
+            if (and_mask & t)
+            {
+                if (first)
+                    bm::bit_block_copy(blk, src);
+                else
+                    any = bm::bit_block_and(blk, src);
+                first = false;
+            }
+        } // for m
+        if (first)
+            bm::bit_block_set(blk, ~0u);
+        src = g.blocks;
+        for (bm::id64_t m = g.plane_mask; m && any;
+                                m &= m - 1, src += bm::set_block_size)
+        {
+            bm::id64_t t = m & (0 - m);
+            if (sub_mask & t)
+                any = bm::bit_block_sub(blk, src);
+        } // for m
+        if (!any)
+        {
+            bman.get_allocator().free_bit_block(blk);
+            continue;
+        }
+        bman.set_block(block_idx_type(nb), blk);
+    } // for nb
+
+    if (size_ < bm::id_max && nb_cnt)
+        bv_res.set_range(size_, bm::id_max - 1, false);
+}
+
 //---------------------------------------------------------------------
 //---------------------------------------------------------------------
 
@@ -47,6 +47,22 @@ unsigned bmi2_select64_pdep(bm::id64_t val, unsigned rank)
 
 #define BMI2_SELECT64 bmi2_select64_pdep
 
+inline
+bm::id64_t bmi2_pdep64(bm::id64_t val, bm::id64_t mask)
+{
+    return _pdep_u64(val, mask);
+}
+
+#define BMI2_PDEP64 bmi2_pdep64
+
+inline
+bm::id64_t bmi2_bzhi64(bm::id64_t val, unsigned idx)
+{
+    return _bzhi_u64(val, idx);
+}
+
+#define BMI2_BZHI64 bmi2_bzhi64
+
 #else // Intel and MSVC
 
 #ifdef __GNUG__
@@ -71,6 +87,32 @@ unsigned bmi2_select64_pdep(bm::id64_t val, unsigned rank)
 
 #define BMI2_SELECT64 bmi2_select64_pdep
 
+inline
+bm::id64_t bmi2_pdep64(bm::id64_t val, bm::id64_t mask)
+{
+    bm::id64_t res;
+    asm("pdep %[mask], %[val], %[res]"
+            : [res] "=r" (res)
+            : [val] "r" (val), [mask] "r" (mask));
+    return res;
+}
+
+#define BMI2_PDEP64 bmi2_pdep64
+
+inline
+bm::id64_t bmi2_bzhi64(bm::id64_t val, unsigned idx)
+{
+    bm::id64_t res;
+    bm::id64_t i = idx;
+    asm("bzhi %[idx], %[val], %[res]"
+            : [res] "=r" (res)
+            : [val] "r" (val), [idx] "r" (i)
+            : "cc");
+    return res;
+}
+
+#define BMI2_BZHI64 bmi2_bzhi64
+
 #endif  // __GNUG__
 
 #endif // compilers
@@ -0,0 +1,244 @@
+#ifndef BMBVIMPORT_PARALLEL__H__INCLUDED__
+#define BMBVIMPORT_PARALLEL__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmbvimport_parallel.h
+    \brief Sorted append-only bit-vector builder with background compaction
+*/
+
+#include <deque>
+#include <atomic>
+
+#include "bmthreadpool.h"
+
+namespace bm
+{
+
+/**
+    Append-only builder of a bit-vector from sorted (non-decreasing) ids.
+
+    Ids are written into a block buffer; as soon as ids move past a block
+    the block gets finalized: compacted into empty/FULL/GAP/bit form and
+    attached to the target vector (bvector<>::import_bit_block()).
+
+    In background mode finished blocks are handed over to a worker thread
+    which does compaction and attachment, so the target vector must not be
+    accessed until flush(). Number of blocks in flight is bounded
+    (max_in_flight), the producer waits for the worker to drain the queue.
+    Background mode needs a thread-safe allocator (no allocator pool
+    attached to the target).
+
+    Out-of-order ids are accepted (their block gets OR-ed) but cost
+    an extra block finalization.
+
+    @ingroup bvector
+*/
+template<typename BV, typename Lock = std::mutex>
+class sorted_import_builder
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef Lock                                      lock_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef bm::thread_pool<bm::task_description*, lock_type> pool_type;
+
+    /// max number of blocks queued for background compaction
+    static const size_t max_in_flight = 64;
+
+public:
+    /**
+        \param bv - target vector (existing content is kept, OR semantics)
+        \param bg_compact - finalize blocks on a background thread
+    */
+    sorted_import_builder(bvector_type& bv, bool bg_compact = false);
+    ~sorted_import_builder();
+
+    /// Add id (set bit)
+    void add(size_type n)
+    {
+        BM_ASSERT(n < bm::id_max);
+        block_idx_type nb = (n >> bm::set_block_shift);
+        if (nb != nb_ && blk_cnt_)
+            submit_block();
+        nb_ = nb;
+        unsigned nbit = unsigned(n & bm::set_block_mask);
+        blk_[nbit >> bm::set_word_shift] |= (1u << (nbit & bm::set_word_mask));
+        ++blk_cnt_;
+    }
+
+    /// Add id (set bit)
+    sorted_import_builder& operator=(size_type n) { add(n); return *this; }
+
+    /**
+        Finalize the current block, wait for background compaction
+        and sync the target vector size. Builder can be used after flush.
+    */
+    void flush();
+
+    /// Number of blocks finalized so far
+    size_type blocks_finalized() const BMNOEXCEPT { return blocks_fin_; }
+
+protected:
+    /// finalize the current block (inline or via background task)
+    void submit_block();
+
+    /// background task: attach one block to the target
+    static void* task_run(void* argp);
+
+    void start_pool();
+    void wait_pool();
+
+private:
+    sorted_import_builder(const sorted_import_builder&);
+    sorted_import_builder& operator=(const sorted_import_builder&);
+
+protected:
+    bvector_type*                      bv_;         ///< target vector
+    allocator_type                     alloc_;      ///< block allocator
+    bm::word_t*                        blk_;        ///< block being filled
+    block_idx_type                     nb_;         ///< current block idx
+    size_type                          blk_cnt_;    ///< ids in the block
+    size_type                          blocks_fin_; ///< finalized blocks
+    bool                               bg_compact_; ///< background mode
+    pool_type*                         pool_;       ///< background thread
+    std::deque<bm::task_description>   tasks_;      ///< submitted tasks
+    std::atomic<size_type>             tasks_done_; ///< completed tasks
+    size_type                          tasks_popped_;///< recycled tasks
+};
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+sorted_import_builder<BV, Lock>::sorted_import_builder(bvector_type& bv,
+                                                       bool bg_compact)
+: bv_(&bv), alloc_(bv.get_allocator()), blk_(0), nb_(0), blk_cnt_(0),
+  blocks_fin_(0), bg_compact_(bg_compact), pool_(0),
+  tasks_done_(0), tasks_popped_(0)
+{
+    blk_ = alloc_.alloc_bit_block();
+    bm::bit_block_set(blk_, 0);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+sorted_import_builder<BV, Lock>::~sorted_import_builder()
+{
+    flush();
+    delete pool_;
+    alloc_.free_bit_block(blk_);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void sorted_import_builder<BV, Lock>::start_pool()
+{
+    if (pool_)
+        return;
+    pool_ = new pool_type();
+    pool_->start(1); // one worker keeps attachment single-threaded
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void sorted_import_builder<BV, Lock>::wait_pool()
+{
+    if (!pool_)
+        return;
+    pool_->set_stop_mode(pool_type::stop_when_done);
+    pool_->join(); // all tasks are done
+    delete pool_; pool_ = 0;
+    tasks_.clear();
+    tasks_done_.store(0, std::memory_order_relaxed);
+    tasks_popped_ = 0;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void sorted_import_builder<BV, Lock>::submit_block()
+{
+    BM_ASSERT(blk_cnt_);
+    ++blocks_fin_;
+    blk_cnt_ = 0;
+    if (!bg_compact_)
+    {
+        if (bv_->import_bit_block(nb_, blk_)) // block adopted
+            blk_ = alloc_.alloc_bit_block();
+        bm::bit_block_set(blk_, 0);
+        return;
+    }
+    start_pool();
+    // bound the blocks in flight: drain the queue, recycle consumed tasks
+    // single worker runs tasks in the order of submission and writes
+    // the task descriptor after its func returns, so a task is safe to
+    // recycle once the func of the next one has completed
+    if (tasks_.size() >= max_in_flight)
+        pool_->wait_empty_queue();
+    size_type done = tasks_done_.load(std::memory_order_acquire);
+    for (; tasks_popped_ + 1 < done; ++tasks_popped_)
+        tasks_.pop_front();
+    tasks_.emplace_back();
+    bm::task_description& tdescr = tasks_.back();
+    tdescr.init(task_run, (void*)&tdescr, this, blk_, nb_);
+    pool_->get_job_queue().push(&tdescr);
+
+    blk_ = alloc_.alloc_bit_block(); // block goes to the worker
+    bm::bit_block_set(blk_, 0);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void* sorted_import_builder<BV, Lock>::task_run(void* argp)
+{
+    bm::task_description* tdescr = (bm::task_description*) argp;
+    sorted_import_builder* builder = (sorted_import_builder*) tdescr->ctx0;
+    bm::word_t* blk = (bm::word_t*) tdescr->ctx1;
+    block_idx_type nb = block_idx_type(tdescr->param0);
+    if (!builder->bv_->import_bit_block(nb, blk))
+        builder->alloc_.free_bit_block(blk);
+    builder->tasks_done_.fetch_add(1, std::memory_order_release);
+    return 0;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV, typename Lock>
+void sorted_import_builder<BV, Lock>::flush()
+{
+    if (blk_cnt_)
+        submit_block();
+    wait_pool();
+    size_type last;
+    if (bv_->find_reverse(last) && last >= bv_->size()) // sync size
+        bv_->resize(last + 1);
+}
+
+//---------------------------------------------------------------------
+
+
+} // namespace bm
+
+#endif
@@ -118,9 +118,15 @@ const unsigned bits_in_array = bm::bits_in_block * bm::set_array_size32;
 const unsigned rs3_border0 = 21824; // 682 words by 32-bits
 const unsigned rs3_border1 = (rs3_border0 * 2); // 43648
 const unsigned rs3_half_span = rs3_border0 / 2;
+const unsigned rs_sub_block_shift = 12; // 4096-bit sub-blocks (128 words)
+const unsigned rs_sub_block_size = 1u << rs_sub_block_shift;
+const unsigned rs_sub_blocks = bm::gap_max_bits / rs_sub_block_size; // 16
+const unsigned rs_line_size = 64; // interleaved index line (bytes)
+const unsigned rs_batch_prefix_min = 32; // batch rank: queries to decode block prefix
 
 // misc parameters for sparse vec algorithms
 const unsigned sub_block3_size = bm::gap_max_bits / 4;
+const unsigned str_cmp_pad = 32; // zero padding of SIMD compared strings
 
 
 #if defined(BM64OPT) || defined(BM64_SSE4)
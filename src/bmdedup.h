@@ -0,0 +1,395 @@
+#ifndef BMDEDUP__H__INCLUDED__
+#define BMDEDUP__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmdedup.h
+    \brief Cross-vector block deduplication (interning) pool
+*/
+
+#ifndef BM__H__INCLUDED__
+// BitMagic utility headers do not include main "bm.h" declaration
+// #include "bm.h" or "bm64.h" explicitly
+# error missing include (bm.h or bm64.h)
+#endif
+
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+
+namespace bm
+{
+
+/**
+    Block deduplication pool: finds identical bit and GAP blocks across
+    a collection of bit-vectors (or sparse vector planes) and makes the
+    vectors share one copy of each block.
+
+    Vectors added to the pool become READ-ONLY: any modification
+    (including optimize()) of a vector with shared blocks is undefined.
+    release() gives the vector private copies of its shared blocks and
+    makes it writable again. Pool destructor releases all vectors, so the
+    pool must not outlive its vectors (declare it after the vectors).
+
+    Intended use: bulk load, then add() (which also optimizes),
+    then read-only access.
+
+    @ingroup bvector
+*/
+template<typename BV>
+class block_dedup_pool
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename
+        bvector_type::blocks_manager_type             blocks_manager_type;
+
+    /// Deduplication statistics
+    struct statistics
+    {
+        size_t blocks_total;   ///< bit and GAP blocks in all vectors
+        size_t blocks_unique;  ///< distinct blocks
+        size_t memory_saved;   ///< bytes saved by sharing
+
+        void reset() BMNOEXCEPT
+            { blocks_total = blocks_unique = memory_saved = 0; }
+    };
+
+public:
+    block_dedup_pool() { stat_.reset(); }
+    ~block_dedup_pool() { release_all(); }
+
+    /**
+        Add vector to the pool and share its duplicate blocks
+        \param bv - vector to add (becomes read-only)
+        \param opt - optimize the vector before deduplication
+    */
+    void add(bvector_type& bv, bool opt = true);
+
+    /**
+        Add all bit-planes of a sparse vector (sparse_vector,
+        str_sparse_vector) to the pool
+        \param sv - sparse vector (becomes read-only)
+        \param opt - optimize the vector before deduplication
+    */
+    template<class SV>
+    void add_planes(SV& sv, bool opt = true);
+
+    /// Detach vector from the pool (restore private blocks)
+    void release(bvector_type& bv);
+
+    /// Detach all vectors
+    void release_all();
+
+    /// Deduplication statistics
+    const statistics& get_statistics() const BMNOEXCEPT { return stat_; }
+
+    /**
+        Memory statistics for all vectors in the pool, shared blocks
+        are accounted once
+    */
+    void calc_stat(bm::bv_statistics* st) const BMNOEXCEPT;
+
+    /// Number of vectors in the pool
+    size_t size() const BMNOEXCEPT { return vectors_.size(); }
+
+protected:
+    /// Pooled block
+    struct block_entry
+    {
+        bm::word_t*  blk;       ///< block pointer (GAP pointers tagged)
+        size_t       refs;      ///< number of references
+        unsigned     capacity;  ///< GAP capacity (0 for bit-blocks)
+    };
+    typedef std::unordered_multimap<bm::id64_t, size_t> hash_map_type;
+    typedef std::unordered_map<const bm::word_t*, size_t> ptr_map_type;
+
+    /// block hash (bit and GAP blocks use different seeds)
+    static
+    bm::id64_t block_hash(const bm::word_t* blk) BMNOEXCEPT;
+
+    /// block content and capacity are the same
+    static
+    bool block_equal(const block_entry& e,
+                     const bm::word_t* blk, unsigned capacity) BMNOEXCEPT;
+
+    static
+    size_t block_mem(const block_entry& e) BMNOEXCEPT;
+
+    void intern_block(blocks_manager_type& bman, unsigned i, unsigned j);
+
+private:
+    block_dedup_pool(const block_dedup_pool&);
+    block_dedup_pool& operator=(const block_dedup_pool&);
+
+protected:
+    std::vector<block_entry>     entries_;  ///< pooled blocks
+    hash_map_type                hash_idx_; ///< hash to entry index
+    ptr_map_type                 ptr_idx_;  ///< block pointer to entry
+    std::vector<bvector_type*>   vectors_;  ///< vectors in the pool
+    statistics                   stat_;
+};
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV>
+bm::id64_t block_dedup_pool<BV>::block_hash(const bm::word_t* blk) BMNOEXCEPT
+{
+    if (!BM_IS_GAP(blk))
+        return bm::bit_block_hash(blk);
+    const bm::gap_word_t* gap_blk = BMGAP_PTR(blk);
+    unsigned len = bm::gap_length(gap_blk);
+    const bm::id64_t k = 0x9E3779B97F4A7C15ULL;
+    bm::id64_t h = 0xC4CEB9FE1A85EC53ULL;
+    for (unsigned i = 0; i < len; ++i)
+    {
+        h = (h ^ gap_blk[i]) * k;
+        h = (h << 31) | (h >> 33);
+    }
+    return h;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+bool block_dedup_pool<BV>::block_equal(const block_entry& e,
+                                       const bm::word_t* blk,
+                                       unsigned capacity) BMNOEXCEPT
+{
+    if (e.capacity != capacity)
+        return false;
+    if (!capacity)
+        return !::memcmp(e.blk, blk, bm::set_block_size * sizeof(bm::word_t));
+    const bm::gap_word_t* gap_e = BMGAP_PTR(e.blk);
+    const bm::gap_word_t* gap_b = BMGAP_PTR(blk);
+    unsigned len = bm::gap_length(gap_e);
+    if (len != bm::gap_length(gap_b))
+        return false;
+    return !::memcmp(gap_e, gap_b, len * sizeof(bm::gap_word_t));
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+size_t block_dedup_pool<BV>::block_mem(const block_entry& e) BMNOEXCEPT
+{
+    return e.capacity ? e.capacity * sizeof(bm::gap_word_t)
+                      : bm::set_block_size * sizeof(bm::word_t);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void block_dedup_pool<BV>::intern_block(blocks_manager_type& bman,
+                                        unsigned i, unsigned j)
+{
+    bm::word_t* blk = bman.get_block_ptr(i, j);
+    if (!blk || IS_FULL_BLOCK(blk))
+        return;
+    ++stat_.blocks_total;
+
+    typename ptr_map_type::iterator pit = ptr_idx_.find(blk);
+    if (pit != ptr_idx_.end()) // already pooled
+    {
+        ++entries_[pit->second].refs;
+        stat_.memory_saved += block_mem(entries_[pit->second]);
+        return;
+    }
+    unsigned capacity = BM_IS_GAP(blk) ?
+                    bm::gap_capacity(BMGAP_PTR(blk), bman.glen()) : 0;
+    bm::id64_t h = block_hash(blk);
+
+    typedef typename hash_map_type::iterator hash_iterator;
+    std::pair<hash_iterator, hash_iterator> range = hash_idx_.equal_range(h);
+    for (hash_iterator it = range.first; it != range.second; ++it)
+    {
+        block_entry& e = entries_[it->second];
+        if (!block_equal(e, blk, capacity))
+            continue;
+        // duplicate: free own copy, reference the pooled block
+        if (capacity)
+            bman.get_allocator().free_gap_block(BMGAP_PTR(blk), bman.glen());
+        else
+            bman.get_allocator().free_bit_block(blk);
+        bman.set_block_ptr(i, j, e.blk);
+        ++e.refs;
+        stat_.memory_saved += block_mem(e);
+        return;
+    } // for it
+
+    block_entry e;
+    e.blk = blk; e.refs = 1; e.capacity = capacity;
+    size_t idx = entries_.size();
+    entries_.push_back(e);
+    hash_idx_.insert(std::make_pair(h, idx));
+    ptr_idx_[blk] = idx;
+    ++stat_.blocks_unique;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void block_dedup_pool<BV>::add(bvector_type& bv, bool opt)
+{
+    BM_ASSERT(std::find(vectors_.begin(), vectors_.end(), &bv) ==
+              vectors_.end());
+    if (opt)
+        bv.optimize();
+    vectors_.push_back(&bv);
+
+    blocks_manager_type& bman = bv.get_blocks_manager();
+    if (!bman.is_init())
+        return;
+    unsigned top_size = bman.top_block_size();
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        bm::word_t** blk_blk = bman.top_blocks_root()[i];
+        if (!blk_blk || blk_blk == (bm::word_t**)FULL_BLOCK_FAKE_ADDR)
+            continue;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+            intern_block(bman, i, j);
+    } // for i
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV> template<class SV>
+void block_dedup_pool<BV>::add_planes(SV& sv, bool opt)
+{
+    if (opt)
+        sv.optimize();
+    typename SV::bmatrix_type& bmatr = sv.get_bmatrix();
+    for (size_type i = 0; i < bmatr.rows(); ++i)
+    {
+        bvector_type* bv = bmatr.get_row(i);
+        if (bv)
+            add(*bv, false);
+    } // for i
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void block_dedup_pool<BV>::release(bvector_type& bv)
+{
+    typename std::vector<bvector_type*>::iterator vit =
+                        std::find(vectors_.begin(), vectors_.end(), &bv);
+    if (vit == vectors_.end())
+        return;
+    vectors_.erase(vit);
+
+    blocks_manager_type& bman = bv.get_blocks_manager();
+    if (!bman.is_init())
+        return;
+    unsigned top_size = bman.top_block_size();
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        bm::word_t** blk_blk = bman.top_blocks_root()[i];
+        if (!blk_blk || blk_blk == (bm::word_t**)FULL_BLOCK_FAKE_ADDR)
+            continue;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+        {
+            bm::word_t* blk = blk_blk[j];
+            if (!blk || IS_FULL_BLOCK(blk))
+                continue;
+            typename ptr_map_type::iterator pit = ptr_idx_.find(blk);
+            if (pit == ptr_idx_.end())
+                continue;
+            size_t idx = pit->second;
+            block_entry& e = entries_[idx];
+            BM_ASSERT(e.refs);
+            --stat_.blocks_total;
+            if (--e.refs) // still shared: take a private copy
+            {
+                stat_.memory_saved -= block_mem(e);
+                bm::word_t* new_blk;
+                if (e.capacity)
+                {
+                    const bm::gap_word_t* gap_blk = BMGAP_PTR(blk);
+                    bm::gap_word_t* new_gap = bman.get_allocator().alloc_gap_block(
+                                    bm::gap_level(gap_blk), bman.glen());
+                    ::memcpy(new_gap, gap_blk,
+                             bm::gap_length(gap_blk) * sizeof(bm::gap_word_t));
+                    new_blk = (bm::word_t*)new_gap;
+                    BMSET_PTRGAP(new_blk);
+                }
+                else
+                {
+                    new_blk = bman.get_allocator().alloc_bit_block();
+                    bm::bit_block_copy(new_blk, blk);
+                }
+                blk_blk[j] = new_blk;
+                continue;
+            }
+            // last reference: vector owns the block again
+            bm::id64_t h = block_hash(blk);
+            typedef typename hash_map_type::iterator hash_iterator;
+            std::pair<hash_iterator, hash_iterator> range =
+                                                hash_idx_.equal_range(h);
+            for (hash_iterator it = range.first; it != range.second; ++it)
+            {
+                if (it->second == idx)
+                {
+                    hash_idx_.erase(it);
+                    break;
+                }
+            } // for it
+            ptr_idx_.erase(pit);
+            e.blk = 0;
+            --stat_.blocks_unique;
+        } // for j
+    } // for i
+    if (vectors_.empty())
+        entries_.resize(0);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void block_dedup_pool<BV>::release_all()
+{
+    while (!vectors_.empty())
+        release(*vectors_.back());
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void block_dedup_pool<BV>::calc_stat(bm::bv_statistics* st) const BMNOEXCEPT
+{
+    BM_ASSERT(st);
+    st->reset();
+    for (size_t i = 0; i < vectors_.size(); ++i)
+    {
+        typename bvector_type::statistics bv_st;
+        vectors_[i]->calc_stat(&bv_st);
+        st->add(bv_st);
+    }
+    st->memory_used -= stat_.memory_saved;
+}
+
+//---------------------------------------------------------------------
+
+
+} // namespace bm
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef BMFINGERPRINT__H__INCLUDED__
+#define BMFINGERPRINT__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmfingerprint.h
+    \brief Block fingerprints and Merkle-style summary of a bit-vector
+*/
+
+#ifndef BM__H__INCLUDED__
+// BitMagic utility headers do not include main "bm.h" declaration
+// #include "bm.h" or "bm64.h" explicitly
+# error missing include (bm.h or bm64.h)
+#endif
+
+#include "bmbuffer.h"
+
+namespace bm
+{
+
+/**
+    Fingerprint index of a bit-vector: 64-bit content hash per block,
+    per top-level sub-array (256 blocks) and one root hash (Merkle-style).
+
+    Block hashes do not depend on block representation (GAP, bit,
+    FULL), so vectors built differently but with the same content get
+    the same fingerprint. Empty blocks hash to 0.
+
+    The index is a snapshot: after modification of the vector it needs
+    to be refreshed for the changed range (update_range()) or rebuilt.
+
+    Equal root hashes mean vectors are equal with high probability,
+    different roots mean vectors are different for sure.
+
+    @ingroup bvector
+*/
+template<typename BV>
+class bvector_fingerprint
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename
+        bvector_type::blocks_manager_type             blocks_manager_type;
+    typedef
+        bm::heap_vector<bm::id64_t, allocator_type, true> hash_vector_type;
+    typedef
+        bm::heap_vector<unsigned, allocator_type, true>   offset_vector_type;
+
+public:
+    bvector_fingerprint();
+    ~bvector_fingerprint();
+
+    /// Build fingerprints for all blocks of the vector
+    void build(const bvector_type& bv);
+
+    /**
+        Refresh fingerprints of blocks covering [from..to] range
+        (use after the range was modified)
+    */
+    void update_range(const bvector_type& bv, size_type from, size_type to);
+
+    /// Root (whole vector) hash
+    bm::id64_t root() const BMNOEXCEPT { return root_; }
+
+    /// Hash of the top-level sub-array i (256 blocks)
+    bm::id64_t top_hash(unsigned i) const BMNOEXCEPT
+        { return (i < top_hash_.size()) ? top_hash_[i] : 0; }
+
+    /// Hash of block nb
+    bm::id64_t block_hash(block_idx_type nb) const BMNOEXCEPT;
+
+    /// Quick (probabilistic) equality check on the root hashes
+    bool equal(const bvector_fingerprint& fp) const BMNOEXCEPT
+        { return root_ == fp.root_; }
+
+    /**
+        Find blocks with different fingerprints. Sub-arrays with equal
+        top hashes are skipped, so cost is proportional to the number
+        of changed sub-arrays.
+        \param fp - fingerprint to compare with
+        \param bv_blocks - [out] vector of different block indexes
+        \return number of different blocks
+    */
+    size_type find_changed_blocks(const bvector_fingerprint& fp,
+                                  bvector_type& bv_blocks) const;
+
+    /// Compute content hash of a block (NULL, FULL, GAP or bit)
+    bm::id64_t block_fingerprint(const bm::word_t* blk) BMNOEXCEPT;
+
+protected:
+    void resize_top(unsigned top_size);
+    void update_block(const blocks_manager_type& bman,
+                      unsigned i, unsigned j);
+    void compute_top_hash(unsigned i) BMNOEXCEPT;
+    void compute_root() BMNOEXCEPT;
+
+    /// position-dependent combine of hashes: mixes seed, index of each
+    /// entry and length (all zero gives 0)
+    static
+    bm::id64_t combine(const bm::id64_t* h, size_t size) BMNOEXCEPT;
+
+private:
+    bvector_fingerprint(const bvector_fingerprint&);
+    bvector_fingerprint& operator=(const bvector_fingerprint&);
+
+protected:
+    allocator_type      alloc_;
+    bm::word_t*         tb_;         ///< temp block for GAP conversion
+    bm::id64_t          full_hash_;  ///< hash of FULL block
+    bm::id64_t          root_;       ///< root hash
+    hash_vector_type    top_hash_;   ///< per sub-array hashes
+    offset_vector_type  blk_off_;    ///< offsets of sub-arrays in blk_hash_
+    hash_vector_type    blk_hash_;   ///< per block hashes
+};
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV>
+bvector_fingerprint<BV>::bvector_fingerprint()
+: tb_(0), root_(0)
+{
+    tb_ = alloc_.alloc_bit_block();
+    full_hash_ = bm::bit_block_hash(FULL_BLOCK_REAL_ADDR);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+bvector_fingerprint<BV>::~bvector_fingerprint()
+{
+    alloc_.free_bit_block(tb_);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+bm::id64_t
+bvector_fingerprint<BV>::block_fingerprint(const bm::word_t* blk) BMNOEXCEPT
+{
+    if (!blk)
+        return 0;
+    if (IS_FULL_BLOCK(blk))
+        return full_hash_;
+    if (BM_IS_GAP(blk))
+    {
+        const bm::gap_word_t* gap_blk = BMGAP_PTR(blk);
+        if (bm::gap_is_all_zero(gap_blk))
+            return 0;
+        if (bm::gap_is_all_one(gap_blk))
+            return full_hash_;
+        bm::gap_convert_to_bitset(tb_, gap_blk);
+        return bm::bit_block_hash(tb_);
+    }
+    return bm::bit_block_hash(blk);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+bm::id64_t bvector_fingerprint<BV>::combine(const bm::id64_t* h,
+                                            size_t size) BMNOEXCEPT
+{
+    const bm::id64_t k = 0x9E3779B97F4A7C15ULL;
+    // non-zero seed and index mixing: leading empty entries (position
+    // of a block) change the result
+    bm::id64_t acc = 0x2545F4914F6CDD1DULL, any = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        any |= h[i];
+        acc = (acc ^ h[i] ^ (bm::id64_t(i) << 32)) * k;
+        acc = (acc << 31) | (acc >> 33);
+    }
+    if (!any)
+        return 0;
+    acc ^= bm::id64_t(size) * k; // total length
+    acc ^= acc >> 33; acc *= 0xC4CEB9FE1A85EC53ULL; acc ^= acc >> 33;
+    return acc | 1;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::resize_top(unsigned top_size)
+{
+    unsigned old_size = unsigned(top_hash_.size());
+    if (top_size <= old_size)
+        return;
+    top_hash_.resize(top_size);
+    blk_off_.resize(top_size);
+    for (unsigned i = old_size; i < top_size; ++i)
+    {
+        top_hash_[i] = 0;
+        blk_off_[i] = ~0u;
+    }
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::update_block(const blocks_manager_type& bman,
+                                           unsigned i, unsigned j)
+{
+    const bm::word_t* blk = 0;
+    if (bman.is_init() && i < bman.top_block_size() && bman.get_topblock(i))
+        blk = bman.get_block_ptr(i, j);
+    bm::id64_t h = block_fingerprint(blk);
+
+    unsigned off = blk_off_[i];
+    if (off == ~0u)
+    {
+        if (!h)
+            return;
+        off = blk_off_[i] = unsigned(blk_hash_.size());
+        blk_hash_.resize(off + bm::set_sub_array_size);
+        ::memset(blk_hash_.data() + off, 0,
+                 bm::set_sub_array_size * sizeof(bm::id64_t));
+    }
+    blk_hash_[off + j] = h;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::compute_top_hash(unsigned i) BMNOEXCEPT
+{
+    unsigned off = blk_off_[i];
+    top_hash_[i] = (off == ~0u) ? 0 :
+            combine(blk_hash_.begin() + off, bm::set_sub_array_size);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::compute_root() BMNOEXCEPT
+{
+    // trailing empty sub-arrays do not change the root
+    size_t top_size = top_hash_.size();
+    while (top_size && !top_hash_[top_size-1])
+        --top_size;
+    root_ = combine(top_hash_.begin(), top_size);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::build(const bvector_type& bv)
+{
+    top_hash_.resize(0); blk_off_.resize(0); blk_hash_.resize(0);
+    root_ = 0;
+
+    const blocks_manager_type& bman = bv.get_blocks_manager();
+    if (!bman.is_init())
+        return;
+    unsigned top_size = bman.top_block_size();
+    resize_top(top_size);
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        if (!bman.get_topblock(i))
+            continue;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+            update_block(bman, i, j);
+        compute_top_hash(i);
+    } // for i
+    compute_root();
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void bvector_fingerprint<BV>::update_range(const bvector_type& bv,
+                                           size_type from, size_type to)
+{
+    BM_ASSERT(from <= to);
+    const blocks_manager_type& bman = bv.get_blocks_manager();
+    block_idx_type nb_from = (from >> bm::set_block_shift);
+    block_idx_type nb_to = (to >> bm::set_block_shift);
+    unsigned i_to = unsigned(nb_to >> bm::set_array_shift);
+    resize_top(i_to + 1);
+    for (block_idx_type nb = nb_from; nb <= nb_to; )
+    {
+        unsigned i = unsigned(nb >> bm::set_array_shift);
+        for (; nb <= nb_to; ++nb)
+        {
+            unsigned i0 = unsigned(nb >> bm::set_array_shift);
+            if (i0 != i)
+                break;
+            update_block(bman, i, unsigned(nb & bm::set_array_mask));
+        }
+        compute_top_hash(i);
+    } // for nb
+    compute_root();
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+bm::id64_t
+bvector_fingerprint<BV>::block_hash(block_idx_type nb) const BMNOEXCEPT
+{
+    unsigned i = unsigned(nb >> bm::set_array_shift);
+    if (i >= blk_off_.size())
+        return 0;
+    unsigned off = blk_off_[i];
+    if (off == ~0u)
+        return 0;
+    return blk_hash_[off + unsigned(nb & bm::set_array_mask)];
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+typename bvector_fingerprint<BV>::size_type
+bvector_fingerprint<BV>::find_changed_blocks(const bvector_fingerprint& fp,
+                                             bvector_type& bv_blocks) const
+{
+    size_type cnt = 0;
+    bv_blocks.clear();
+    if (root_ == fp.root_)
+        return cnt;
+    size_t top_size = top_hash_.size();
+    if (fp.top_hash_.size() > top_size)
+        top_size = fp.top_hash_.size();
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        if (top_hash(i) == fp.top_hash(i))
+            continue;
+        block_idx_type nb = block_idx_type(i) << bm::set_array_shift;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j, ++nb)
+        {
+            if (block_hash(nb) != fp.block_hash(nb))
+            {
+                bv_blocks.set(size_type(nb));
+                ++cnt;
+            }
+        } // for j
+    } // for i
+    return cnt;
+}
+
+//---------------------------------------------------------------------
+
+
+} // namespace bm
+
+#endif
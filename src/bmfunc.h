@@ -1440,6 +1440,31 @@ bool bit_is_all_zero(const bm::word_t* BMRESTRICT start) BMNOEXCEPT
 #endif
 }
 
+/*! @brief Computes 64-bit content hash (fingerprint) of a bit-block.
+    All-zero block always hashes to 0.
+    @ingroup bitfunc
+*/
+inline
+bm::id64_t bit_block_hash(const bm::word_t* BMRESTRICT block) BMNOEXCEPT
+{
+    const bm::id64_t k = 0x9E3779B97F4A7C15ULL;
+    const bm::id64_t* BMRESTRICT w = (const bm::id64_t*) block;
+    const bm::id64_t* BMRESTRICT w_end = w + bm::set_block_size / 2;
+    bm::id64_t h0 = 0, h1 = 1, acc = 0;
+    do
+    {
+        acc |= w[0] | w[1];
+        h0 = (h0 ^ w[0]) * k; h0 = (h0 << 31) | (h0 >> 33);
+        h1 = (h1 ^ w[1]) * k; h1 = (h1 << 31) | (h1 >> 33);
+        w += 2;
+    } while (w < w_end);
+    if (!acc)
+        return 0;
+    h0 ^= h1 * k;
+    h0 ^= h0 >> 33; h0 *= 0xFF51AFD7ED558CCDULL; h0 ^= h0 >> 33;
+    return h0 | 1; // never 0 for a non-empty block
+}
+
 // ----------------------------------------------------------------------
 
 /*!
@@ -8305,6 +8330,21 @@ SIZE_TYPE bit_find_rank(const bm::word_t* const block,
 
     #if defined(BM64OPT) || defined(BM64_SSE4) || defined(BMAVX2OPT) || defined(BMAVX512OPT)
     {
+        // skip 256-bit chunks using 4 independent POPCNTs per step
+        for (; nword + 8 <= bm::set_block_size; nword += 8)
+        {
+            const bm::word_t* wp = block + nword;
+            bm::id64_t w0 = (bm::id64_t(wp[1]) << 32) | bm::id64_t(wp[0]);
+            bm::id64_t w1 = (bm::id64_t(wp[3]) << 32) | bm::id64_t(wp[2]);
+            bm::id64_t w2 = (bm::id64_t(wp[5]) << 32) | bm::id64_t(wp[4]);
+            bm::id64_t w3 = (bm::id64_t(wp[7]) << 32) | bm::id64_t(wp[6]);
+            unsigned bc = bm::word_bitcount64(w0) + bm::word_bitcount64(w1) +
+                          bm::word_bitcount64(w2) + bm::word_bitcount64(w3);
+            if (bc >= rank) // target chunk
+                break;
+            rank -= bc;
+            pos += 256u;
+        } // for nword
         for (; nword < bm::set_block_size-1; nword+=2)
         {
             bm::id64_t w =
@@ -8338,6 +8378,57 @@ SIZE_TYPE bit_find_rank(const bm::word_t* const block,
     return rank;
 }
 
+/*!
+    \brief Build running bit-counts of 256-bit chunks of a bit-block
+    (prefix popcounts) to rank many positions in one block
+
+    \param block - bit block buffer pointer
+    \param rcount - [out] rcount[i] - bit-count of [0, i*256)
+                    (bm::set_block_size/8 elements)
+
+    @ingroup bitfunc
+    @sa bit_block_chunk_count_to
+*/
+inline
+void bit_block_chunk_rcount(const bm::word_t* BMRESTRICT block,
+                            bm::gap_word_t* BMRESTRICT rcount) BMNOEXCEPT
+{
+    BM_ASSERT(block);
+    unsigned rc = 0;
+    for (unsigned i = 0; i < bm::set_block_size / 8; ++i)
+    {
+        rcount[i] = bm::gap_word_t(rc);
+        const bm::word_t* chunk = block + (i * 8);
+        rc += bm::bit_count_min_unroll(chunk, chunk + 8);
+    } // for i
+}
+
+/*!
+    \brief Bit-count in [0..nbit] of a bit-block using running counts
+    of 256-bit chunks
+
+    \param block - bit block buffer pointer
+    \param rcount - chunk running counts (bit_block_chunk_rcount)
+    \param nbit - bit position in block
+
+    @ingroup bitfunc
+    @sa bit_block_chunk_rcount
+*/
+inline
+unsigned bit_block_chunk_count_to(const bm::word_t* BMRESTRICT block,
+                                  const bm::gap_word_t* BMRESTRICT rcount,
+                                  unsigned nbit) BMNOEXCEPT
+{
+    BM_ASSERT(nbit < bm::gap_max_bits);
+    unsigned nword = nbit >> bm::set_word_shift;
+    unsigned cnt = rcount[nword >> 3];
+    for (unsigned i = nword & ~7u; i < nword; ++i)
+        cnt += bm::word_bitcount(block[i]);
+    bm::word_t w = block[nword] & (~0u >> (31 - (nbit & bm::set_word_mask)));
+    cnt += bm::word_bitcount(w);
+    return cnt;
+}
+
 /**
     \brief Find rank in block (GAP or BIT)
  
@@ -9252,6 +9343,154 @@ void set_block_bits_u32(bm::word_t* BMRESTRICT block,
 #endif
 }
 
+/**
+    @brief clear bits in a bit-block using global index
+
+    @param block - block pointer to clear bits
+    @param idx - array to look into
+    @param start - index array start
+    @param stop  - index array stop in a range [start..stop)
+
+    @internal
+    @ingroup bitfunc
+*/
+inline
+void clear_block_bits_u64(bm::word_t* BMRESTRICT block,
+                          const bm::id64_t* BMRESTRICT idx,
+                          bm::id64_t start, bm::id64_t stop) BMNOEXCEPT
+{
+    for (bm::id64_t i = start; i < stop; ++i)
+    {
+        unsigned nbit = unsigned(idx[i] & bm::set_block_mask);
+        block[nbit >> bm::set_word_shift] &= ~(1u << (nbit & bm::set_word_mask));
+    } // for i
+}
+
+/**
+    @brief clear bits in a bit-block using global index
+
+    @param block - block pointer to clear bits
+    @param idx - array to look into
+    @param start - index array start
+    @param stop  - index array stop in a range [start..stop)
+
+    @internal
+    @ingroup bitfunc
+*/
+inline
+void clear_block_bits_u32(bm::word_t* BMRESTRICT block,
+                          const unsigned* BMRESTRICT idx,
+                          unsigned start, unsigned stop) BMNOEXCEPT
+{
+    for (unsigned i = start; i < stop; ++i)
+    {
+        unsigned nbit = unsigned(idx[i] & bm::set_block_mask);
+        block[nbit >> bm::set_word_shift] &= ~(1u << (nbit & bm::set_word_mask));
+    } // for i
+}
+
+/**
+    @brief Check if a sorted run of indexes is compact enough for GAP
+
+    Number of GAP runs is bounded by the number of indexes and by the
+    number of holes in the covered span. When the bound is too loose
+    the run count is extrapolated from a short prefix probe.
+    (GAP construction still verifies the fit).
+
+    @param idx - sorted array of indexes (all in the same block)
+    @param start - index array start
+    @param stop  - index array stop in a range [start..stop)
+    @param max_len - capacity of the GAP buffer (in gap words)
+
+    @internal
+    @ingroup gapfunc
+*/
+template<typename IDX>
+bool gap_sorted_idx_check_fit(const IDX* BMRESTRICT idx,
+                              IDX start, IDX stop,
+                              unsigned max_len) BMNOEXCEPT
+{
+    BM_ASSERT(start < stop);
+    IDX n = stop - start;
+    IDX span = (idx[stop-1] - idx[start]) + 1;
+    IDX runs = (span > n) ? (span - n + 1) : 1;
+    if (runs > n)
+        runs = n;
+    if ((runs * 2 + 4) < max_len)
+        return true;
+    const unsigned probe = 64;
+    if (n <= probe)
+        return false;
+    unsigned breaks = 0;
+    for (IDX i = start + 1; i <= start + probe; ++i)
+        breaks += (idx[i] > idx[i-1] + 1);
+    runs = IDX(breaks + 1) * (n / probe);
+    return (runs * 2 + 4) < max_len;
+}
+
+/**
+    @brief Build GAP block from a sorted run of global indexes
+
+    Consecutive indexes are collapsed into one GAP run (duplicates are
+    allowed). Construction stops as soon as the result would not fit
+    max_len, so sparse-but-scattered runs bail out early.
+
+    @param buf - GAP buffer (level 0 header is assigned)
+    @param idx - sorted array of indexes (all in the same block)
+    @param start - index array start
+    @param stop  - index array stop in a range [start..stop)
+    @param max_len - capacity of the GAP buffer (in gap words)
+
+    @return GAP length (as gap_length()) or 0 if it does not fit
+
+    @internal
+    @ingroup gapfunc
+*/
+template<typename T, typename IDX>
+unsigned gap_set_sorted_idx(T* BMRESTRICT buf,
+                            const IDX* BMRESTRICT idx,
+                            IDX start, IDX stop,
+                            unsigned max_len) BMNOEXCEPT
+{
+    BM_ASSERT(start < stop);
+    BM_ASSERT(max_len > 4);
+
+    *buf = (T)(1u << 3); // gap header setup
+    T* pcurr = buf + 1;
+    const T* plimit = buf + max_len - 4;
+
+    unsigned curr = unsigned(idx[start] & bm::set_block_mask);
+    if (curr) // first gap: (0 to idx[start]-1)
+        *pcurr++ = (T)(curr - 1);
+    else
+        ++(*buf); // GAP starts with 1
+    unsigned acc = curr;
+    for (IDX i = start + 1; i < stop; ++i)
+    {
+        curr = unsigned(idx[i] & bm::set_block_mask);
+        BM_ASSERT(curr >= acc);
+        if (curr <= acc + 1) // consecutive or duplicate
+        {
+            acc = curr;
+            continue;
+        }
+        if (pcurr > plimit)
+            return 0;
+        *pcurr++ = (T)acc;
+        *pcurr++ = (T)(curr - 1);
+        acc = curr;
+    } // for i
+    *pcurr = (T)acc;
+    if (acc != bm::gap_max_bits - 1)
+    {
+        ++pcurr;
+        *pcurr = (T)(bm::gap_max_bits - 1);
+    }
+    unsigned gap_len = unsigned(pcurr - buf);
+    *buf = (T)((*buf & 7) + (gap_len << 3));
+    return gap_len + 1;
+}
+
 
 
 // --------------------------------------------------------------
@@ -9314,6 +9553,85 @@ unsigned lower_bound_linear_u32(const unsigned* arr,  unsigned target,
 #endif
 }
 
+/**
+    Count equal elements (same index) of two unsigned arrays
+    @internal
+*/
+inline
+unsigned u32_eq_count(const unsigned* BMRESTRICT arr1,
+                      const unsigned* BMRESTRICT arr2,
+                      unsigned size) BMNOEXCEPT
+{
+    BM_ASSERT(arr1 && arr2);
+#if defined(VECT_U32_EQ_COUNT)
+    return VECT_U32_EQ_COUNT(arr1, arr2, size);
+#else
+    unsigned cnt = 0;
+    for (unsigned k = 0; k < size; ++k)
+        cnt += (arr1[k] == arr2[k]);
+    return cnt;
+#endif
+}
+
+/**
+    Compare two zero-terminated strings (padded with zeros to 'size')
+    @return <0, 0, >0 (as the first mismatched chars)
+    @internal
+*/
+template<typename VT>
+int str_cmp_padded(const VT* BMRESTRICT s1,
+                   const VT* BMRESTRICT s2,
+                   unsigned size) BMNOEXCEPT
+{
+    BM_ASSERT(s1 && s2);
+    for (unsigned k = 0; k < size; ++k)
+    {
+        VT c1 = s1[k], c2 = s2[k];
+        if (c1 != c2)
+            return (c1 > c2) - (c1 < c2);
+        if (!c1)
+            break;
+    } // for k
+    return 0;
+}
+
+/**
+    Length of the common prefix of two zero-terminated strings
+    (not longer than 'size')
+    @internal
+*/
+template<typename VT>
+unsigned str_common_prefix(const VT* BMRESTRICT s1,
+                           const VT* BMRESTRICT s2,
+                           unsigned size) BMNOEXCEPT
+{
+    BM_ASSERT(s1 && s2);
+    unsigned k = 0;
+    for (; k < size && s1[k] && s1[k] == s2[k]; ++k)
+    {}
+    return k;
+}
+
+/**
+    Compare two zero-terminated char strings (padded with zeros to
+    'size', which is a multiple of bm::str_cmp_pad), SIMD version
+    @return <0, 0, >0 (as the first mismatched chars)
+    @internal
+*/
+inline
+int str_cmp_padded(const char* BMRESTRICT s1,
+                   const char* BMRESTRICT s2,
+                   unsigned size) BMNOEXCEPT
+{
+    BM_ASSERT(s1 && s2);
+    BM_ASSERT(size % bm::str_cmp_pad == 0);
+#if defined(VECT_STR_CMP_PADDED)
+    return VECT_STR_CMP_PADDED(s1, s2, size);
+#else
+    return bm::str_cmp_padded<char>(s1, s2, size);
+#endif
+}
+
 /**
     Linear lower bound search in unsigned LONG array
     @internal
@@ -28,6 +28,8 @@ For more information please visit:  http://bitmagic.io
 # error missing include (bm.h or bm64.h)
 #endif
 
+#include <algorithm>
+
 #include "bmdef.h"
 
 /** \defgroup bvintervals Algorithms for bit intervals
@@ -227,6 +229,303 @@ private:
 
 //----------------------------------------------------------------------------
 
+/*!
+    \brief Run-list (interval) representation of a bit-vector
+
+    Sorted list of non-overlapping, non-adjacent closed intervals
+    [start..end]. Set algebra (AND, OR, SUB) is done by a merge of two
+    lists, without expansion into blocks, so cost depends on the number
+    of runs, not on their length or on block boundaries they cross.
+    Best for coverage-like vectors of long runs.
+
+    Conversion to and from bit-vector is explicit (lazy): runs are
+    expanded only on export.
+
+    \ingroup bvintervals
+*/
+template<typename BV>
+class interval_list
+{
+public:
+    typedef BV                                         bvector_type;
+    typedef typename bvector_type::size_type           size_type;
+    typedef typename bvector_type::allocator_type      allocator_type;
+    typedef
+        bm::heap_vector<size_type, allocator_type, true> run_vector_type;
+
+public:
+    interval_list() {}
+
+    /** Construct from a bit-vector */
+    explicit interval_list(const BV& bv) { import_from(bv); }
+
+    /*! @name Conversion to/from bit-vector */
+    //@{
+
+    /** Import runs of a bit-vector (uses interval_enumerator) */
+    void import_from(const BV& bv);
+
+    /** Export runs into bit-vector (previous content is cleared) */
+    void export_to(BV& bv) const;
+    //@}
+
+    /*! @name Construction and access */
+    //@{
+
+    /**
+        Append interval [from..to], intervals should be added in ascending
+        order of starts (overlapping or adjacent ones are merged)
+    */
+    void add_interval(size_type from, size_type to);
+
+    /// Number of intervals (runs)
+    size_type size() const BMNOEXCEPT { return runs_.size() / 2; }
+
+    /// true if no intervals
+    bool empty() const BMNOEXCEPT { return runs_.empty(); }
+
+    /// Start of interval i
+    size_type start(size_type i) const BMNOEXCEPT { return runs_[i * 2]; }
+
+    /// End of interval i (closed)
+    size_type end(size_type i) const BMNOEXCEPT { return runs_[i * 2 + 1]; }
+
+    /// Number of bits ON
+    size_type count() const BMNOEXCEPT;
+
+    /// Test bit (binary search of the interval)
+    bool test(size_type pos) const BMNOEXCEPT;
+
+    /// Remove all intervals
+    void clear() BMNOEXCEPT { runs_.resize(0); }
+
+    /// Swap content
+    void swap(interval_list<BV>& il) BMNOEXCEPT { runs_.swap(il.runs_); }
+
+    /// Compare content
+    bool equal(const interval_list<BV>& il) const BMNOEXCEPT;
+    //@}
+
+    /*! @name Set algebra (merge of run lists): this = a OP b */
+    //@{
+    void bit_and(const interval_list<BV>& a, const interval_list<BV>& b);
+    void bit_or(const interval_list<BV>& a, const interval_list<BV>& b);
+    void bit_sub(const interval_list<BV>& a, const interval_list<BV>& b);
+    //@}
+
+protected:
+    /// Append run (no merge), grows capacity geometrically
+    void push_run(size_type from, size_type to)
+    {
+        size_type sz = runs_.size();
+        if (sz + 2 > runs_.capacity())
+            runs_.reserve(sz * 2 + 64);
+        runs_.push_back(from);
+        runs_.push_back(to);
+    }
+
+private:
+    run_vector_type   runs_; ///!< start, end pairs
+};
+
+//----------------------------------------------------------------------------
+
+/*!
+    \brief Interval index for stabbing and overlap queries
+
+    Index of closed intervals [from..to] (ids are assigned in the order
+    of addition). Distinct start and end coordinates are kept in two
+    bit-vectors with rank-select indexes (plus cumulative counts when
+    coordinates repeat), so that:
+
+    - stabbing count (intervals containing point p) is
+      rank(starts, p) - rank(ends, p-1)
+    - overlap count for [a..b] is rank(starts, b) - rank(ends, a-1)
+
+    Overlapping intervals starting inside [a..b] form a contiguous range
+    in the start order. Intervals started before a and still open
+    (end >= a) are found by descent over a tree of max ends kept in
+    the start order, O((k + 1) * log(n)) for k found intervals.
+    Start coordinates are not stored, they are recovered from the start
+    bit-vector by select (get_interval(), for_each_overlap()).
+
+    Usage: add() intervals, build(), then query. add() after build()
+    reverts the index into construction state (build() again to query).
+
+    \ingroup bvintervals
+*/
+template<typename BV>
+class interval_index
+{
+public:
+    typedef BV                                         bvector_type;
+    typedef typename bvector_type::size_type           size_type;
+    typedef typename bvector_type::allocator_type      allocator_type;
+    typedef typename bvector_type::rs_index_type       rs_index_type;
+    typedef
+        bm::heap_vector<size_type, allocator_type, true> size_vector_type;
+
+public:
+    interval_index();
+    ~interval_index();
+
+    /*! @name Construction */
+    //@{
+
+    /// Add interval [from..to] (id is the number of added intervals)
+    void add(size_type from, size_type to);
+
+    /// Build the index (should be called after all intervals are added)
+    void build();
+
+    /// true if index is built (ready for queries)
+    bool is_built() const BMNOEXCEPT { return built_; }
+
+    /// Number of intervals
+    size_type size() const BMNOEXCEPT { return ends_.size(); }
+
+    /// Start coordinates (distinct)
+    const bvector_type& get_starts() const BMNOEXCEPT { return bv_start_; }
+
+    /// End coordinates (distinct)
+    const bvector_type& get_ends() const BMNOEXCEPT { return bv_end_; }
+    //@}
+
+    /*! @name Queries */
+    //@{
+
+    /// Number of intervals containing point pos
+    size_type stab_count(size_type pos) const BMNOEXCEPT
+        { return count_start_le(pos) - count_end_lt(pos); }
+
+    /// Number of intervals overlapping [from..to]
+    size_type overlap_count(size_type from, size_type to) const BMNOEXCEPT
+    {
+        BM_ASSERT(from <= to);
+        return count_start_le(to) - count_end_lt(from);
+    }
+
+    /**
+        Find intervals overlapping [from..to]
+        \param from - range start
+        \param to - range end
+        \param bv_ids - [out] ids of intervals (previous content cleared)
+    */
+    void find_overlaps(size_type from, size_type to,
+                       bvector_type& bv_ids) const;
+
+    /**
+        Enumerate intervals overlapping [from..to] in the start order,
+        start coordinates are recovered by select
+        \param from - range start
+        \param to - range end
+        \param func - functor: func(id, start, end)
+    */
+    template<class Func>
+    void for_each_overlap(size_type from, size_type to, Func& func) const;
+
+    /**
+        Stabbing counts for sorted points (batch): ranks are computed
+        by monotone walk over blocks (incremental counts for points
+        in the same block)
+        \param points - points sorted in ascending order
+        \param size - number of points
+        \param counts - [out] stabbing counts
+    */
+    void stab_count_sorted(const size_type* points, size_type size,
+                           size_type* counts) const BMNOEXCEPT;
+
+    /**
+        Get interval by its index in the start order
+        \param idx - index in the start order (0 .. size()-1)
+        \param from - [out] interval start (recovered by select)
+        \param to - [out] interval end
+        \return interval id
+    */
+    size_type get_interval(size_type idx,
+                           size_type& from, size_type& to) const BMNOEXCEPT;
+    //@}
+
+protected:
+    /// Number of intervals with start <= pos
+    size_type count_start_le(size_type pos) const BMNOEXCEPT
+    {
+        size_type r = bv_start_.count_to(pos, *rs_start_);
+        return start_dup_ ? start_cum_[r] : r;
+    }
+
+    /// Number of intervals with end < pos
+    size_type count_end_lt(size_type pos) const BMNOEXCEPT
+    {
+        if (!pos)
+            return 0;
+        size_type r = bv_end_.count_to(pos - 1, *rs_end_);
+        return end_dup_ ? end_cum_[r] : r;
+    }
+
+    /// Visit start order indexes of intervals overlapping [from..to]
+    template<class Func>
+    void visit_overlaps(size_type from, size_type to, Func& func) const;
+
+    /// Visit intervals of max-end subtree [lo..hi) with start index < k_lo
+    /// and end >= from (open at "from")
+    template<class Func>
+    void visit_open(size_type node, size_type lo, size_type hi,
+                    size_type k_lo, size_type from, Func& func) const;
+
+    /// Build max-end tree over ends in the start order
+    void build_max_end();
+
+    /// Revert built index into construction state (starts_, ends_ by id)
+    void reset_build();
+
+    /// Rank of the next point in a sorted sequence (monotone walk)
+    static
+    size_type rank_next(const bvector_type& bv, const rs_index_type& rs,
+                        size_type pos, size_type& prev_pos,
+                        size_type& prev_rank) BMNOEXCEPT;
+
+    /// Order of interval ids by start (then by id)
+    struct start_less
+    {
+        const size_type* starts;
+        bool operator()(size_type a, size_type b) const BMNOEXCEPT
+        {
+            return (starts[a] < starts[b]) ||
+                   (starts[a] == starts[b] && a < b);
+        }
+    };
+
+    /// Distinct coordinates of sorted array, cumulative counts
+    static
+    bool build_coord(const size_vector_type& coord, bvector_type& bv,
+                     size_vector_type& cum);
+
+    void construct_rs_index();
+    void free_rs_index() BMNOEXCEPT;
+
+private:
+    interval_index(const interval_index&);
+    interval_index& operator=(const interval_index&);
+
+private:
+    size_vector_type   starts_;     ///!< starts (input, by id)
+    size_vector_type   ends_;       ///!< ends (by id, start order after build)
+    size_vector_type   ids_;        ///!< interval ids in the start order
+    size_vector_type   max_end_;    ///!< max-end tree (start order)
+    bvector_type       bv_start_;   ///!< distinct starts
+    bvector_type       bv_end_;     ///!< distinct ends
+    size_vector_type   start_cum_;  ///!< intervals per start rank
+    size_vector_type   end_cum_;    ///!< intervals per end rank
+    bool               start_dup_;  ///!< starts repeat (start_cum_ used)
+    bool               end_dup_;    ///!< ends repeat (end_cum_ used)
+    bool               built_;      ///!< index is built
+    rs_index_type*     rs_start_;   ///!< rank-select index of starts
+    rs_index_type*     rs_end_;     ///!< rank-select index of ends
+};
+
+//----------------------------------------------------------------------------
+
 /*!
     \brief Returns true if range is all 1s flanked with 0s
     Function performs the test on a closed range [left, right]
@@ -769,6 +1068,499 @@ void interval_enumerator<BV>::swap(interval_enumerator<BV>& ien) BMNOEXCEPT
     ien.gap_ptr_ = gap_tmp;
 }
 
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::import_from(const BV& bv)
+{
+    runs_.resize(0);
+    bm::interval_enumerator<BV> ien(bv);
+    for (; ien.valid(); ien.advance())
+        push_run(ien.start(), ien.end());
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::export_to(BV& bv) const
+{
+    bv.clear();
+    for (size_type i = 0; i < runs_.size(); i += 2)
+        bv.set_range(runs_[i], runs_[i + 1]);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::add_interval(size_type from, size_type to)
+{
+    BM_ASSERT(from <= to);
+    size_type sz = runs_.size();
+    if (sz)
+    {
+        BM_ASSERT(from >= runs_[sz - 2]);
+        size_type& last_end = runs_[sz - 1];
+        if (from <= last_end + 1) // overlap or adjacent: merge
+        {
+            if (to > last_end)
+                last_end = to;
+            return;
+        }
+    }
+    push_run(from, to);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+typename interval_list<BV>::size_type
+interval_list<BV>::count() const BMNOEXCEPT
+{
+    size_type cnt = 0;
+    for (size_type i = 0; i < runs_.size(); i += 2)
+        cnt += runs_[i + 1] - runs_[i] + 1;
+    return cnt;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+bool interval_list<BV>::test(size_type pos) const BMNOEXCEPT
+{
+    // first interval with end >= pos
+    size_type lo = 0, hi = size();
+    while (lo < hi)
+    {
+        size_type mid = (lo + hi) / 2;
+        if (end(mid) < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < size()) && (start(lo) <= pos);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+bool interval_list<BV>::equal(const interval_list<BV>& il) const BMNOEXCEPT
+{
+    size_type sz = runs_.size();
+    if (sz != il.runs_.size())
+        return false;
+    for (size_type i = 0; i < sz; ++i)
+        if (runs_[i] != il.runs_[i])
+            return false;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::bit_and(const interval_list<BV>& a,
+                                const interval_list<BV>& b)
+{
+    BM_ASSERT(this != &a && this != &b);
+    runs_.resize(0);
+    size_type i = 0, j = 0;
+    const size_type na = a.size(), nb = b.size();
+    while (i < na && j < nb)
+    {
+        size_type ea = a.end(i), eb = b.end(j);
+        size_type sa = a.start(i), sb = b.start(j);
+        size_type lo = (sa > sb) ? sa : sb;
+        size_type hi = bm::min_value(ea, eb);
+        if (lo <= hi)
+            push_run(lo, hi);
+        i += (ea <= eb);
+        j += (eb <= ea);
+    } // while
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::bit_or(const interval_list<BV>& a,
+                               const interval_list<BV>& b)
+{
+    BM_ASSERT(this != &a && this != &b);
+    runs_.resize(0);
+    size_type i = 0, j = 0;
+    const size_type na = a.size(), nb = b.size();
+    while (i < na && j < nb)
+    {
+        if (a.start(i) <= b.start(j))
+        {
+            add_interval(a.start(i), a.end(i)); ++i;
+        }
+        else
+        {
+            add_interval(b.start(j), b.end(j)); ++j;
+        }
+    } // while
+    for (; i < na; ++i)
+        add_interval(a.start(i), a.end(i));
+    for (; j < nb; ++j)
+        add_interval(b.start(j), b.end(j));
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_list<BV>::bit_sub(const interval_list<BV>& a,
+                                const interval_list<BV>& b)
+{
+    BM_ASSERT(this != &a && this != &b);
+    runs_.resize(0);
+    size_type j = 0;
+    const size_type na = a.size(), nb = b.size();
+    for (size_type i = 0; i < na; ++i)
+    {
+        size_type cur = a.start(i), ea = a.end(i);
+        for (; j < nb && b.end(j) < cur; ++j)
+        {}
+        for (; j < nb && b.start(j) <= ea; ++j)
+        {
+            if (b.start(j) > cur)
+                push_run(cur, b.start(j) - 1);
+            cur = b.end(j) + 1;
+            if (b.end(j) > ea) // b-run continues into the next a-run
+                break;
+        } // for j
+        if (cur <= ea)
+            push_run(cur, ea);
+    } // for i
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+interval_index<BV>::interval_index()
+    : bv_start_(bm::BM_GAP), bv_end_(bm::BM_GAP),
+      start_dup_(false), end_dup_(false), built_(false),
+      rs_start_(0), rs_end_(0)
+{
+    construct_rs_index();
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+interval_index<BV>::~interval_index()
+{
+    free_rs_index();
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::construct_rs_index()
+{
+    rs_start_ = (rs_index_type*) bm::aligned_new_malloc(sizeof(rs_index_type));
+    rs_start_ = new(rs_start_) rs_index_type(); // placement new
+    rs_end_ = (rs_index_type*) bm::aligned_new_malloc(sizeof(rs_index_type));
+    rs_end_ = new(rs_end_) rs_index_type();
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::free_rs_index() BMNOEXCEPT
+{
+    if (rs_start_)
+    {
+        rs_start_->~rs_index_type();
+        bm::aligned_free(rs_start_);
+    }
+    if (rs_end_)
+    {
+        rs_end_->~rs_index_type();
+        bm::aligned_free(rs_end_);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::add(size_type from, size_type to)
+{
+    BM_ASSERT(from <= to);
+    BM_ASSERT(to < bm::id_max);
+    if (built_)
+        reset_build();
+    size_type sz = starts_.size();
+    if (sz == starts_.capacity())
+    {
+        starts_.reserve(sz * 2 + 64);
+        ends_.reserve(sz * 2 + 64);
+    }
+    starts_.push_back(from);
+    ends_.push_back(to);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+bool interval_index<BV>::build_coord(const size_vector_type& coord,
+                                     bvector_type& bv,
+                                     size_vector_type& cum)
+{
+    bv.clear(true);
+    cum.resize(0);
+    const size_type sz = coord.size();
+    if (!sz)
+        return false;
+    // distinct coordinates and cumulative counts (cum[rank] = count)
+    size_vector_type dist;
+    dist.reserve(sz);
+    cum.reserve(sz + 1);
+    cum.push_back(0);
+    for (size_type i = 0; i < sz; ++i)
+    {
+        if (i && coord[i] == coord[i - 1])
+        {
+            ++cum[cum.size() - 1];
+            continue;
+        }
+        dist.push_back(coord[i]);
+        cum.push_back(cum[cum.size() - 1] + 1);
+    } // for i
+    bv.set(dist.data(), dist.size(), bm::BM_SORTED);
+    bv.optimize();
+    bool dup = (dist.size() != sz);
+    if (!dup)
+        cum.resize(0);
+    return dup;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::build()
+{
+    if (built_)
+        return;
+    const size_type sz = starts_.size();
+
+    // ids in the start order
+    ids_.resize(sz);
+    size_type* ids = ids_.data();
+    for (size_type i = 0; i < sz; ++i)
+        ids[i] = i;
+    start_less less; less.starts = starts_.data();
+    std::sort(ids, ids + sz, less);
+
+    size_vector_type coord;
+    coord.resize(sz);
+    for (size_type i = 0; i < sz; ++i)
+        coord[i] = starts_[ids[i]];
+    start_dup_ = build_coord(coord, bv_start_, start_cum_);
+
+    // distinct ends (sorted)
+    for (size_type i = 0; i < sz; ++i)
+        coord[i] = ends_[i];
+    std::sort(coord.data(), coord.data() + sz);
+    end_dup_ = build_coord(coord, bv_end_, end_cum_);
+
+    // ends in the start order (starts are kept only in bv_start_)
+    for (size_type i = 0; i < sz; ++i)
+        coord[i] = ends_[ids[i]];
+    ends_.swap(coord);
+    starts_.resize(0);
+    build_max_end();
+
+    bv_start_.build_rs_index(rs_start_);
+    bv_end_.build_rs_index(rs_end_);
+    built_ = true;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::build_max_end()
+{
+    const size_type sz = ends_.size();
+    size_type m = 1;
+    while (m < sz)
+        m <<= 1;
+    // implicit binary tree: root 1, leaves m..2m-1 (padding never visited)
+    max_end_.resize(m * 2);
+    size_type* me = max_end_.data();
+    for (size_type i = 0; i < m; ++i)
+        me[m + i] = (i < sz) ? ends_[i] : 0;
+    for (size_type i = m - 1; i; --i)
+        me[i] = (me[i * 2] > me[i * 2 + 1]) ? me[i * 2] : me[i * 2 + 1];
+    me[0] = 0;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::reset_build()
+{
+    BM_ASSERT(built_);
+    const size_type sz = ends_.size();
+    size_vector_type ends;
+    ends.resize(sz);
+    starts_.resize(sz);
+    for (size_type k = 0; k < sz; ++k)
+    {
+        size_type from, to;
+        size_type id = get_interval(k, from, to);
+        starts_[id] = from; ends[id] = to;
+    }
+    ends_.swap(ends);
+    ids_.resize(0);
+    max_end_.resize(0);
+    built_ = false;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV> template<class Func>
+void interval_index<BV>::visit_open(size_type node,
+                                    size_type lo, size_type hi,
+                                    size_type k_lo, size_type from,
+                                    Func& func) const
+{
+    if (lo >= k_lo || max_end_[node] < from) // nothing open in the subtree
+        return;
+    if (hi - lo == 1)
+    {
+        func(lo);
+        return;
+    }
+    size_type mid = (lo + hi) >> 1;
+    visit_open(node * 2, lo, mid, k_lo, from, func);
+    visit_open(node * 2 + 1, mid, hi, k_lo, from, func);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV> template<class Func>
+void interval_index<BV>::visit_overlaps(size_type from, size_type to,
+                                        Func& func) const
+{
+    BM_ASSERT(built_);
+    BM_ASSERT(from <= to);
+    // started before "from" and still open (stabbing "from")
+    size_type k_lo = from ? count_start_le(from - 1) : 0;
+    if (k_lo)
+        visit_open(1, 0, max_end_.size() >> 1, k_lo, from, func);
+    // starts inside [from..to]: contiguous range in the start order
+    size_type k_hi = count_start_le(to);
+    for (size_type k = k_lo; k < k_hi; ++k)
+        func(k);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::find_overlaps(size_type from, size_type to,
+                                       bvector_type& bv_ids) const
+{
+    bv_ids.clear();
+    typedef typename bvector_type::bulk_insert_iterator iterator_type;
+    struct id_func
+    {
+        iterator_type*          iit;
+        const size_vector_type* ids;
+        void operator()(size_type k) { *iit = (*ids)[k]; }
+    };
+    iterator_type iit(bv_ids);
+    id_func func; func.iit = &iit; func.ids = &ids_;
+    visit_overlaps(from, to, func);
+    iit.flush();
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV> template<class Func>
+void interval_index<BV>::for_each_overlap(size_type from, size_type to,
+                                          Func& func) const
+{
+    struct select_func
+    {
+        const interval_index* iidx;
+        Func*                 f;
+        void operator()(size_type k)
+        {
+            size_type start, end;
+            size_type id = iidx->get_interval(k, start, end);
+            (*f)(id, start, end);
+        }
+    };
+    select_func sfunc; sfunc.iidx = this; sfunc.f = &func;
+    visit_overlaps(from, to, sfunc);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+typename interval_index<BV>::size_type
+interval_index<BV>::rank_next(const bvector_type& bv,
+                              const rs_index_type& rs,
+                              size_type pos, size_type& prev_pos,
+                              size_type& prev_rank) BMNOEXCEPT
+{
+    size_type r;
+    if (prev_pos != bm::id_max && pos >= prev_pos &&
+        (pos >> bm::set_block_shift) == (prev_pos >> bm::set_block_shift))
+    {
+        r = prev_rank;
+        if (pos > prev_pos) // count only the distance from the previous point
+            r += bv.count_range_no_check(prev_pos + 1, pos);
+    }
+    else
+        r = bv.count_to(pos, rs);
+    prev_pos = pos; prev_rank = r;
+    return r;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+void interval_index<BV>::stab_count_sorted(const size_type* points,
+                                           size_type size,
+                                           size_type* counts) const BMNOEXCEPT
+{
+    size_type s_pos = bm::id_max, s_rank = 0;
+    size_type e_pos = bm::id_max, e_rank = 0;
+    for (size_type i = 0; i < size; ++i)
+    {
+        size_type pos = points[i];
+        BM_ASSERT(!i || pos >= points[i - 1]);
+        size_type r = rank_next(bv_start_, *rs_start_, pos, s_pos, s_rank);
+        size_type cnt = start_dup_ ? start_cum_[r] : r;
+        if (pos)
+        {
+            r = rank_next(bv_end_, *rs_end_, pos - 1, e_pos, e_rank);
+            cnt -= end_dup_ ? end_cum_[r] : r;
+        }
+        counts[i] = cnt;
+    } // for i
+}
+
+//----------------------------------------------------------------------------
+
+template<typename BV>
+typename interval_index<BV>::size_type
+interval_index<BV>::get_interval(size_type idx,
+                                 size_type& from,
+                                 size_type& to) const BMNOEXCEPT
+{
+    BM_ASSERT(idx < size());
+    size_type r = idx + 1; // rank of the distinct start
+    if (start_dup_) // first rank with cum[rank] > idx
+        r = size_type(std::upper_bound(start_cum_.begin(),
+                                       start_cum_.begin() + start_cum_.size(),
+                                       idx) - start_cum_.begin());
+    bool found = bv_start_.select(r, from, *rs_start_);
+    BM_ASSERT(found); (void)found;
+    to = ends_[idx];
+    return ids_[idx];
+}
+
 //----------------------------------------------------------------------------
 //
 //----------------------------------------------------------------------------
@@ -0,0 +1,484 @@
+#ifndef BMMINHASH__H__INCLUDED__
+#define BMMINHASH__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmminhash.h
+    \brief MinHash (one permutation hashing) sketches of bit-vectors,
+    b-bit signatures and LSH banding for approximate Jaccard similarity
+*/
+
+#ifndef BM__H__INCLUDED__
+// BitMagic utility headers do not include main "bm.h" declaration
+// #include "bm.h" or "bm64.h" explicitly
+# error missing include (bm.h or bm64.h)
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "bmbuffer.h"
+#include "bmalgo.h"
+
+namespace bm
+{
+
+/**
+    64-bit hash (mixer) of an integer
+    @internal
+*/
+inline
+bm::id64_t minhash_mix64(bm::id64_t x) BMNOEXCEPT
+{
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+    MinHash sketch builder for bit-vectors.
+
+    Signature is computed with one permutation hashing (OPH): every set
+    bit is hashed once, the hash selects a bin and the minimum value is
+    kept per bin, so cost is one hash per bit (not one per bin).
+    Bits are decoded block by block with bitscan (for_each_bit), full
+    blocks and GAP runs are visited as ranges.
+    Empty bins are filled by rotation densification (value of the next
+    non-empty bin, mixed with the distance), so signatures of
+    sparse vectors stay comparable bin by bin.
+
+    Jaccard estimate: fraction of equal bins (SIMD compare).
+    b-bit signatures keep only the lower b bits of each bin
+    (1, 2, 4, 8 or 16) packed into 64-bit words, compared with
+    XOR + popcount.
+
+    @ingroup distance
+*/
+template<typename BV>
+class minhash_sketch
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef
+      bm::heap_vector<unsigned, allocator_type, true>   signature_type;
+    typedef
+      bm::heap_vector<bm::id64_t, allocator_type, true> bbit_signature_type;
+
+    enum { empty_bin = ~0u };
+
+public:
+    /**
+        \param bins - number of bins (signature size), power of 2
+        \param seed - hash seed (sketches are comparable for the same
+                      seed and number of bins)
+    */
+    minhash_sketch(unsigned bins = 256, bm::id64_t seed = 0) BMNOEXCEPT;
+
+    /// Number of bins (signature size)
+    unsigned size() const BMNOEXCEPT { return bins_; }
+
+    /**
+        Compute signature of a vector
+        \param bv - source vector
+        \param sig - [out] signature (all bins empty for an empty vector)
+    */
+    void build(const bvector_type& bv, signature_type& sig) const;
+
+    /// true if signature is of an empty vector
+    static bool is_empty(const signature_type& sig) BMNOEXCEPT
+        { return !sig.size() || sig[0] == unsigned(empty_bin); }
+
+    /**
+        Jaccard similarity estimate (fraction of equal bins)
+        \return estimate, 0 if one of the vectors is empty
+    */
+    float jaccard(const signature_type& sig1,
+                  const signature_type& sig2) const BMNOEXCEPT;
+
+    /**
+        Pack b-bit signature (lower b bits of each bin)
+        \param sig - full signature
+        \param b - bits per bin: 1, 2, 4, 8 or 16
+        \param bsig - [out] b-bit signature
+    */
+    void pack_bbit(const signature_type& sig, unsigned b,
+                   bbit_signature_type& bsig) const;
+
+    /**
+        Jaccard similarity estimate from b-bit signatures
+        (corrected for the 2^-b probability of random collision)
+    */
+    float jaccard_bbit(const bbit_signature_type& bsig1,
+                       const bbit_signature_type& bsig2,
+                       unsigned b) const BMNOEXCEPT;
+
+protected:
+    /// OPH bit visitor (for_each_bit)
+    /// @internal
+    struct oph_func
+    {
+        unsigned*   sig;
+        unsigned    bin_mask;
+        bm::id64_t  seed;
+
+        void add(size_type idx) BMNOEXCEPT
+        {
+            bm::id64_t h = bm::minhash_mix64(bm::id64_t(idx) + seed);
+            unsigned bin = unsigned(h >> 32) & bin_mask;
+            unsigned v = unsigned(h) >> 1; // 31-bit (high bit: densified)
+            if (v < sig[bin])
+                sig[bin] = v;
+        }
+        void add_bits(size_type offset,
+                      const unsigned char* bits, unsigned size) BMNOEXCEPT
+        {
+            for (unsigned i = 0; i < size; ++i)
+                add(offset + bits[i]);
+        }
+        void add_range(size_type offset, size_type size) BMNOEXCEPT
+        {
+            for (size_type i = 0; i < size; ++i)
+                add(offset + i);
+        }
+    };
+
+    /// Fill empty bins (rotation densification)
+    void densify(unsigned* sig) const BMNOEXCEPT;
+
+protected:
+    unsigned     bins_;  ///< number of bins
+    bm::id64_t   seed_;  ///< hash seed
+};
+
+/**
+    LSH banding index of MinHash signatures for candidate pairs generation.
+
+    Signature is split into bands of rows bins, vectors with equal band
+    (in any band) become candidate pairs. Probability to become
+    a candidate for Jaccard J: 1 - (1 - J^rows)^bands.
+    Candidates should be refined with the exact distance
+    (see minhash_refine()).
+
+    @ingroup distance
+*/
+template<typename BV>
+class minhash_lsh
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename
+        bm::minhash_sketch<BV>::signature_type        signature_type;
+
+    /// Candidate (or refined) pair of vectors
+    struct pair_type
+    {
+        size_type  idx1;        ///< first vector (idx1 < idx2)
+        size_type  idx2;        ///< second vector
+        float      similarity;  ///< exact similarity (after refinement)
+
+        bool operator<(const pair_type& p) const BMNOEXCEPT
+        {
+            return (idx1 < p.idx1) || (idx1 == p.idx1 && idx2 < p.idx2);
+        }
+        bool operator==(const pair_type& p) const BMNOEXCEPT
+            { return idx1 == p.idx1 && idx2 == p.idx2; }
+    };
+    typedef std::vector<pair_type>                    pair_vector_type;
+
+public:
+    /**
+        \param bands - number of bands
+        \param rows - bins per band (bands * rows <= signature size)
+    */
+    minhash_lsh(unsigned bands, unsigned rows);
+
+    /// Add signature of a vector (empty vectors are not indexed)
+    void add(size_type idx, const signature_type& sig);
+
+    /// Remove all signatures
+    void clear() BMNOEXCEPT;
+
+    /**
+        Generate candidate pairs (sorted, unique)
+        \param pairs - [out] candidate pairs
+    */
+    void get_candidates(pair_vector_type& pairs) const;
+
+protected:
+    struct band_key
+    {
+        bm::id64_t  hash;
+        size_type   idx;
+
+        bool operator<(const band_key& k) const BMNOEXCEPT
+        {
+            return (hash < k.hash) || (hash == k.hash && idx < k.idx);
+        }
+    };
+    typedef std::vector<band_key>  band_vector_type;
+
+    unsigned                       bands_;  ///< number of bands
+    unsigned                       rows_;   ///< bins per band
+    std::vector<band_vector_type>  keys_;   ///< band keys per band
+};
+
+/**
+    Refine candidate pairs with the exact Jaccard similarity
+    (distance_operation COUNT_AND, COUNT_OR)
+
+    \param bv_arr - collection of vectors (NULL - empty)
+    \param pairs - [in, out] candidate pairs, pairs with similarity
+                   below the threshold are removed
+    \param threshold - minimal Jaccard similarity
+
+    @ingroup distance
+*/
+template<typename BV, typename PairVector>
+void minhash_refine(const BV* const* bv_arr, PairVector& pairs,
+                    float threshold)
+{
+    size_t cnt = 0;
+    for (size_t k = 0; k < pairs.size(); ++k)
+    {
+        const BV* bv1 = bv_arr[pairs[k].idx1];
+        const BV* bv2 = bv_arr[pairs[k].idx2];
+        if (!bv1 || !bv2)
+            continue;
+        bm::distance_metric_descriptor dmd[2];
+        dmd[0].metric = bm::COUNT_AND;
+        dmd[1].metric = bm::COUNT_OR;
+        bm::distance_operation(*bv1, *bv2, &dmd[0], &dmd[0] + 2);
+        float sim = dmd[1].result ?
+                    float(double(dmd[0].result) / double(dmd[1].result)) : 0;
+        if (sim < threshold)
+            continue;
+        pairs[cnt] = pairs[k];
+        pairs[cnt++].similarity = sim;
+    } // for k
+    pairs.resize(cnt);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+minhash_sketch<BV>::minhash_sketch(unsigned bins,
+                                   bm::id64_t seed) BMNOEXCEPT
+    : bins_(bins), seed_(bm::minhash_mix64(seed) | 1)
+{
+    BM_ASSERT(bins && !(bins & (bins - 1))); // power of 2
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_sketch<BV>::build(const bvector_type& bv,
+                               signature_type& sig) const
+{
+    sig.resize(bins_);
+    unsigned* s = sig.data();
+    for (unsigned i = 0; i < bins_; ++i)
+        s[i] = unsigned(empty_bin);
+
+    oph_func func;
+    func.sig = s; func.bin_mask = bins_ - 1; func.seed = seed_;
+    bm::for_each_bit(bv, func);
+
+    densify(s);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_sketch<BV>::densify(unsigned* sig) const BMNOEXCEPT
+{
+    unsigned last = bins_; // last non-empty bin
+    for (unsigned i = bins_; i; --i)
+    {
+        if (sig[i - 1] != unsigned(empty_bin))
+        {
+            last = i - 1;
+            break;
+        }
+    }
+    if (last == bins_) // empty vector
+        return;
+    // right to left: donor is the nearest non-empty bin on the right
+    // (circular), densified values are marked with the high bit
+    unsigned donor = last;
+    for (unsigned i = last; ; )
+    {
+        i = i ? i - 1 : bins_ - 1;
+        if (i == last)
+            break;
+        if (!(sig[i] >> 31)) // genuine (not empty) bin
+        {
+            donor = i;
+            continue;
+        }
+        unsigned dist = (donor >= i) ? donor - i : donor + bins_ - i;
+        unsigned h = unsigned(bm::minhash_mix64(bm::id64_t(dist) + seed_));
+        // keep the low bits intact (b-bit signatures), avoid empty_bin
+        // by clearing a high bit instead
+        unsigned v = (sig[donor] ^ h) | 0x80000000u;
+        sig[i] = (v == unsigned(empty_bin)) ? v & ~0x40000000u : v;
+    } // for i
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+float minhash_sketch<BV>::jaccard(const signature_type& sig1,
+                                  const signature_type& sig2) const BMNOEXCEPT
+{
+    BM_ASSERT(sig1.size() == bins_ && sig2.size() == bins_);
+    if (is_empty(sig1) || is_empty(sig2))
+        return 0.0f;
+    unsigned eq = bm::u32_eq_count(&sig1[0], &sig2[0], bins_);
+    return float(eq) / float(bins_);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_sketch<BV>::pack_bbit(const signature_type& sig, unsigned b,
+                                   bbit_signature_type& bsig) const
+{
+    BM_ASSERT(b && b <= 16 && !(b & (b - 1)));
+    BM_ASSERT(sig.size() == bins_);
+    const unsigned per_word = 64 / b;
+    const unsigned words = (bins_ + per_word - 1) / per_word;
+    const bm::id64_t mask = (1ull << b) - 1;
+    bsig.resize(words);
+    for (unsigned w = 0; w < words; ++w)
+    {
+        bm::id64_t acc = 0;
+        unsigned from = w * per_word;
+        unsigned to = bm::min_value(from + per_word, bins_);
+        for (unsigned i = from; i < to; ++i)
+            acc |= (bm::id64_t(sig[i]) & mask) << ((i - from) * b);
+        bsig[w] = acc;
+    } // for w
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+float minhash_sketch<BV>::jaccard_bbit(const bbit_signature_type& bsig1,
+                                       const bbit_signature_type& bsig2,
+                                       unsigned b) const BMNOEXCEPT
+{
+    BM_ASSERT(bsig1.size() == bsig2.size());
+    // low bit of each b-bit lane
+    bm::id64_t lane_mask = 0;
+    for (unsigned i = 0; i < 64; i += b)
+        lane_mask |= 1ull << i;
+
+    unsigned diff = 0;
+    for (size_t w = 0; w < bsig1.size(); ++w)
+    {
+        bm::id64_t x = bsig1[w] ^ bsig2[w];
+        for (unsigned s = 1; s < b; s <<= 1) // fold lane to its low bit
+            x |= x >> s;
+        diff += bm::word_bitcount64(x & lane_mask);
+    } // for w
+    double p = double(bins_ - diff) / double(bins_);
+    double r = 1.0 / double(1ull << b); // random collision probability
+    double j = (p - r) / (1.0 - r);
+    return (j > 0) ? float(j) : 0.0f;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+minhash_lsh<BV>::minhash_lsh(unsigned bands, unsigned rows)
+    : bands_(bands), rows_(rows), keys_(bands)
+{
+    BM_ASSERT(bands && rows);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_lsh<BV>::add(size_type idx, const signature_type& sig)
+{
+    BM_ASSERT(sig.size() >= bands_ * rows_);
+    if (bm::minhash_sketch<BV>::is_empty(sig))
+        return;
+    for (unsigned band = 0; band < bands_; ++band)
+    {
+        const unsigned* s = &sig[band * rows_];
+        bm::id64_t h = band;
+        for (unsigned r = 0; r < rows_; ++r)
+            h = bm::minhash_mix64(h ^ s[r]);
+        band_key k; k.hash = h; k.idx = idx;
+        keys_[band].push_back(k);
+    } // for band
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_lsh<BV>::clear() BMNOEXCEPT
+{
+    for (unsigned band = 0; band < bands_; ++band)
+        keys_[band].clear();
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void minhash_lsh<BV>::get_candidates(pair_vector_type& pairs) const
+{
+    pairs.resize(0);
+    band_vector_type bkeys;
+    for (unsigned band = 0; band < bands_; ++band)
+    {
+        bkeys = keys_[band];
+        std::sort(bkeys.begin(), bkeys.end());
+        for (size_t i = 0; i < bkeys.size(); )
+        {
+            size_t j = i + 1;
+            for (; j < bkeys.size() && bkeys[j].hash == bkeys[i].hash; ++j)
+            {}
+            for (size_t a = i; a < j; ++a) // all pairs of the bucket
+            {
+                for (size_t b = a + 1; b < j; ++b)
+                {
+                    if (bkeys[a].idx == bkeys[b].idx)
+                        continue;
+                    pair_type p;
+                    p.idx1 = bkeys[a].idx; p.idx2 = bkeys[b].idx;
+                    p.similarity = 0;
+                    pairs.push_back(p);
+                } // for b
+            } // for a
+            i = j;
+        } // for i
+    } // for band
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
+
+
+} // namespace bm
+
+#endif
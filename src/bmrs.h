@@ -28,10 +28,20 @@ namespace bm
 /**
     @brief Rank-Select acceleration index
  
-    Index uses two-level acceleration structure:
-    bcount - running total popcount for all (possible) blocks
-    (missing blocks give duplicate counts as POPCNT(N-1) + 0).
-    subcount - sub-count inside blocks
+    Index uses interleaved (cache-line) acceleration structure:
+    super-block running counts - for fast super-block search (select),
+    block running counts per super-block - for block search (select),
+    one 64-byte line per non-empty block which keeps the running count
+    of all blocks before it, the block bit-count and running counts of
+    4096-bit sub-blocks, so rank of a position touches one index line
+    and at most a half of a sub-block in the bit-block.
+    Lines are addressed via a per super-block mask of non-empty blocks,
+    so sparse vectors do not pay for lines of empty blocks.
+
+    Optional sampled-select directory keeps the super-block of every
+    2^k-th rank (Elias-Fano style samples), select then searches only
+    the super-blocks between two samples instead of all super-blocks,
+    which is useful for very sparse vectors.
  
     @ingroup bvector
     @internal
@@ -52,11 +62,45 @@ public:
     typedef bm::id_t                                     sblock_count_type;
 #endif
 
-    typedef bm::pair<bm::gap_word_t, bm::gap_word_t> sb_pair_type;
+    /// Interleaved index line (one per block, 64 bytes)
+    struct rs_line
+    {
+        size_type      rcount;  ///< running count of all blocks before
+        unsigned       bcount;  ///< bit-count of the block
+        /// running counts of sub-blocks [0..k] (rs_sub_blocks-1 used)
+        bm::gap_word_t sub_rcount[(bm::rs_line_size - sizeof(size_type)
+                            - sizeof(unsigned)) / sizeof(bm::gap_word_t)];
+
+        /// bit-count in [0, k * rs_sub_block_size)
+        unsigned sub_count_to(unsigned k) const BMNOEXCEPT
+        {
+            return (!k) ? 0 :
+                   (k < bm::rs_sub_blocks) ? sub_rcount[k-1] : bcount;
+        }
+
+        /// find sub-block which holds the rank (branchless count)
+        unsigned find_sub_block(unsigned rank) const BMNOEXCEPT
+        {
+            BM_ASSERT(rank && rank <= bcount);
+            unsigned k = 0;
+            for (unsigned i = 0; i < bm::rs_sub_blocks-1; ++i)
+                k += (sub_rcount[i] < rank);
+            return k;
+        }
+    };
 
 public:
-    rs_index() : total_blocks_(0), max_sblock_(0) {}
+    rs_index() : sblock_rows_(0), lines_(0), lines_cnt_(0), lines_cap_(0),
+                 total_blocks_(0), max_sblock_(0), sample_shift_(0)
+    {}
     rs_index(const rs_index& rsi);
+
+    rs_index& operator=(const rs_index& rsi)
+    {
+        if (this != &rsi)
+            copy_from(rsi);
+        return *this;
+    }
     
     /// init arrays to zeros
     void init() BMNOEXCEPT;
@@ -92,17 +136,34 @@ public:
     void resize_effective_super_blocks(size_type sb_eff);
     
     /// Add block list belonging to one super block
+    ///
+    /// @param i - super-block index
+    /// @param bcount - bit-counts of blocks
+    /// @param sub_count - running sub-block counts of blocks
+    ///                    (rs_sub_blocks-1 per block)
+    ///
     void register_super_block(unsigned i,
                               const unsigned* bcount,
-                              const unsigned* sub_count);
+                              const bm::gap_word_t* sub_count);
 
     /// find block position and sub-range for the specified rank
     bool find(size_type* rank,
               block_idx_type* nb, bm::gap_word_t* sub_range) const;
     
-    /// return sub-clock counts
-    unsigned sub_count(block_idx_type nb) const;
+    /// return index line of a block (NULL for empty blocks and FULL
+    /// super-blocks)
+    const rs_line* get_line(block_idx_type nb) const BMNOEXCEPT;
 
+    /// memory used by the index (bytes)
+    size_t mem_usage() const BMNOEXCEPT
+    {
+        return sizeof(rs_index) +
+            sblock_count_.size() * sizeof(sblock_count_type) +
+            sblock_row_idx_.size() * sizeof(unsigned) +
+            size_t(block_matr_.rows()) * block_matr_.cols() * sizeof(unsigned) +
+            rows_.size() * sizeof(rs_row) + lines_buf_.size() +
+            samples_.size() * sizeof(unsigned);
+    }
 
     // -----------------------------------------------------------------
     
@@ -123,16 +184,33 @@ public:
 
     /// return running bit-count for specified block
     size_type rcount(block_idx_type nb) const;
-    
-    /// determine the sub-range within a bit-block
-    static
-    unsigned find_sub_range(unsigned block_bit_pos);
+
+    /// return running bit-count of all blocks before the specified block
+    size_type rcount_before(block_idx_type nb) const;
     
     /// determine block sub-range for rank search
     bm::gap_word_t select_sub_range(block_idx_type nb, size_type& rank) const;
     
     /// find block position for the specified rank
     block_idx_type find(size_type rank) const;
+
+    // -----------------------------------------------------------------
+
+    /// Enable sampled-select directory: super-block of every
+    /// 2^sample_shift-th rank is stored (0 - disable). Takes effect on the next build
+    /// (bvector::build_rs_index() or build_select_samples())
+    void set_select_sampling(unsigned sample_shift) BMNOEXCEPT
+                                        { sample_shift_ = sample_shift; }
+
+    /// return select sampling (0 - disabled)
+    unsigned get_select_sampling() const BMNOEXCEPT { return sample_shift_; }
+
+    /// build select samples from the index (if sampling is enabled)
+    void build_select_samples();
+
+    /// return number of select samples
+    size_type select_samples_size() const BMNOEXCEPT
+                                    { return (size_type)samples_.size(); }
     
 private:
     typedef bm::heap_vector<sblock_count_type, bv_allocator_type, false>
@@ -140,15 +218,52 @@ private:
     typedef bm::heap_vector<unsigned, bv_allocator_type, false>
                                                     sblock_row_vector_type;
     typedef bm::dynamic_heap_matrix<unsigned, bv_allocator_type>  blocks_matrix_type;
+    typedef bm::byte_buffer<bv_allocator_type>      lines_buffer_type;
+    typedef bm::heap_vector<unsigned, bv_allocator_type, false>
+                                                    samples_vector_type;
+
+    /// super-block row: addressing of lines of non-empty blocks
+    struct rs_row
+    {
+        block_idx_type line_base;  ///< first line of the row
+        bm::id64_t     nz_mask[bm::set_sub_array_size / 64]; ///< non-empty
+        unsigned short nz_off[bm::set_sub_array_size / 64];  ///< mask prefix
+    };
+    typedef bm::heap_vector<rs_row, bv_allocator_type, false>
+                                                    rows_vector_type;
+
+    /// find block in super-block for the rank (rank is adjusted)
+    unsigned find_block(unsigned i, size_type& rank) const BMNOEXCEPT;
+
+    /// find super-block with specified rank using select samples
+    unsigned find_super_block_sampled(size_type rank) const BMNOEXCEPT;
+
+    /// reserve capacity for block lines (keeps content)
+    void reserve_lines(size_t cnt);
+
+    /// align lines pointer to the cache line
+    static
+    rs_line* align_lines(unsigned char* buf) BMNOEXCEPT
+    {
+        size_t p = (size_t)buf;
+        p = (p + bm::rs_line_size - 1) & ~size_t(bm::rs_line_size - 1);
+        return (rs_line*)p;
+    }
 
 private:
     unsigned                  sblock_rows_;
     sblock_count_vector_type  sblock_count_;   ///< super-block accumulated counts
-    sblock_row_vector_type    sblock_row_idx_; ///< super-block row numbers
+    sblock_row_vector_type    sblock_row_idx_; ///< super-block row numbers (+1)
     blocks_matrix_type        block_matr_;     ///< blocks within super-blocks (matrix)
-    blocks_matrix_type        sub_block_matr_; ///< sub-block counts
+    rows_vector_type          rows_;           ///< lines addressing per row
+    lines_buffer_type         lines_buf_;      ///< buffer of block lines
+    rs_line*                  lines_;          ///< block lines (64-byte aligned)
+    size_t                    lines_cnt_;      ///< number of lines used
+    size_t                    lines_cap_;      ///< lines capacity
     size_type                 total_blocks_;   ///< total bit-blocks in the index
     unsigned                  max_sblock_;     ///< max. superblock index
+    unsigned                  sample_shift_;   ///< select sampling (0 - off)
+    samples_vector_type       samples_;        ///< super-block of 2^k-th ranks
 };
 
 //---------------------------------------------------------------------
@@ -157,6 +272,7 @@ private:
 
 template<typename BVAlloc>
 rs_index<BVAlloc>::rs_index(const rs_index<BVAlloc>& rsi)
+    : lines_(0), lines_cnt_(0), lines_cap_(0), sample_shift_(0)
 {
     copy_from(rsi);
 }
@@ -170,7 +286,9 @@ void rs_index<BVAlloc>::init() BMNOEXCEPT
     sblock_count_.resize(0);
     sblock_row_idx_.resize(0);
     block_matr_.resize(0, 0);
-    sub_block_matr_.resize(0, 0);
+    rows_.resize(0);
+    lines_cnt_ = 0;
+    samples_.resize(0);
     
     total_blocks_ = sblock_rows_ = max_sblock_ = 0;
 }
@@ -197,35 +315,63 @@ void rs_index<BVAlloc>::copy_from(const rs_index& rsi)
     sblock_count_ = rsi.sblock_count_;
     sblock_row_idx_ = rsi.sblock_row_idx_;
     block_matr_ = rsi.block_matr_;
-    sub_block_matr_ = rsi.sub_block_matr_;
+    rows_ = rsi.rows_;
+
+    // lines are copied with re-alignment (buffers may differ in offset)
+    lines_cnt_ = 0;
+    reserve_lines(rsi.lines_cnt_);
+    if (rsi.lines_cnt_)
+        ::memcpy(lines_, rsi.lines_, rsi.lines_cnt_ * sizeof(rs_line));
+    lines_cnt_ = rsi.lines_cnt_;
 
     total_blocks_ = rsi.total_blocks_;
     max_sblock_ = rsi.max_sblock_;
+    sample_shift_ = rsi.sample_shift_;
+    samples_ = rsi.samples_;
 }
 
 //---------------------------------------------------------------------
 
 template<typename BVAlloc>
-unsigned rs_index<BVAlloc>::count(block_idx_type nb) const
+const typename rs_index<BVAlloc>::rs_line*
+rs_index<BVAlloc>::get_line(block_idx_type nb) const BMNOEXCEPT
 {
     if (nb >= total_blocks_)
         return 0;
     unsigned i = unsigned(nb >> bm::set_array_shift);
-    size_type sb_count = get_super_block_count(i);
-    
-    if (!sb_count)
+    if (i > max_sblock_)
+        return 0;
+    unsigned row_idx = sblock_row_idx_[i+1];
+    if (!row_idx) // NULL or FULL super-block
+        return 0;
+    const rs_row& row = rows_[row_idx - 1];
+    unsigned j = unsigned(nb & bm::set_array_mask);
+    unsigned w = j >> 6;
+    bm::id64_t mask = bm::id64_t(1) << (j & 63);
+    bm::id64_t nz = row.nz_mask[w];
+    if (!(nz & mask)) // empty block
         return 0;
-    if (sb_count == (bm::set_sub_array_size * bm::gap_max_bits)) // FULL BLOCK
-        return bm::gap_max_bits;
+    size_t ln_idx = size_t(row.line_base) + row.nz_off[w] +
+                    bm::word_bitcount64(nz & (mask - 1));
+    BM_ASSERT(ln_idx < lines_cnt_);
+    return lines_ + ln_idx;
+}
 
-    unsigned j = unsigned(nb &  bm::set_array_mask);
+//---------------------------------------------------------------------
 
-    unsigned row_idx = sblock_row_idx_[i+1];
-    const unsigned* row = block_matr_.row(row_idx);
-    unsigned bc;
-    
-    bc = (!j) ? row[j] : row[j] - row[j-1];
-    return bc;
+template<typename BVAlloc>
+unsigned rs_index<BVAlloc>::count(block_idx_type nb) const
+{
+    const rs_line* ln = get_line(nb);
+    if (ln)
+        return ln->bcount;
+    if (nb >= total_blocks_)
+        return 0;
+    unsigned i = unsigned(nb >> bm::set_array_shift);
+    size_type sb_count = get_super_block_count(i);
+    // FULL super-block or empty block
+    return (sb_count == bm::set_sub_array_size * bm::gap_max_bits) ?
+                                                        bm::gap_max_bits : 0;
 }
 
 //---------------------------------------------------------------------
@@ -243,38 +389,39 @@ rs_index<BVAlloc>::count() const
 
 template<typename BVAlloc>
 typename rs_index<BVAlloc>::size_type
-rs_index<BVAlloc>::rcount(block_idx_type nb) const
+rs_index<BVAlloc>::rcount_before(block_idx_type nb) const
 {
+    const rs_line* ln = get_line(nb);
+    if (ln)
+        return ln->rcount;
     unsigned i = unsigned(nb >> bm::set_array_shift);
-    size_type sb_rcount = i ? get_super_block_rcount(i-1) : i;
+    if (nb >= total_blocks_ || i > max_sblock_)
+        return count();
 
-    unsigned sb_count = get_super_block_count(i);
-    if (!sb_count)
-        return sb_rcount;
-    
-    unsigned j = unsigned(nb &  bm::set_array_mask);
-    if (sb_count == (bm::set_sub_array_size * bm::gap_max_bits)) // FULL BLOCK
+    size_type sb_rcount = sblock_count_[i];
+    unsigned j = unsigned(nb & bm::set_array_mask);
+    unsigned row_idx = sblock_row_idx_[i+1];
+    if (row_idx) // empty block in a row
     {
-        sb_count = (j+1) * bm::gap_max_bits;
-        sb_rcount += sb_count;
-        return sb_rcount;
+        if (j)
+            sb_rcount += block_matr_.row(row_idx - 1)[j-1];
     }
-    
-    unsigned row_idx = sblock_row_idx_[i+1];
-    const unsigned* row = block_matr_.row(row_idx);
-    unsigned bc = row[j];
-    sb_rcount += bc;
+    else
+    if (get_super_block_count(i)) // FULL super-block
+        sb_rcount += size_type(j) * bm::gap_max_bits;
     return sb_rcount;
-
 }
 
 //---------------------------------------------------------------------
 
 template<typename BVAlloc>
-unsigned rs_index<BVAlloc>::find_sub_range(unsigned block_bit_pos)
+typename rs_index<BVAlloc>::size_type
+rs_index<BVAlloc>::rcount(block_idx_type nb) const
 {
-    return (block_bit_pos <= rs3_border0) ? 0 :
-            (block_bit_pos > rs3_border1) ? 2 : 1;
+    const rs_line* ln = get_line(nb);
+    if (ln)
+        return ln->rcount + ln->bcount;
+    return rcount_before(nb) + count(nb);
 }
 
 //---------------------------------------------------------------------
@@ -283,92 +430,98 @@ template<typename BVAlloc>
 bm::gap_word_t rs_index<BVAlloc>::select_sub_range(block_idx_type nb,
                                                    size_type& rank) const
 {
-    unsigned sub_cnt = sub_count(nb);
-    unsigned first = sub_cnt & 0xFFFF;
-    unsigned second = sub_cnt >> 16;
-
-    if (rank > first)
+    BM_ASSERT(rank && rank <= count(nb));
+    unsigned k;
+    const rs_line* ln = get_line(nb);
+    if (ln)
     {
-        rank -= first;
-        if (rank > second)
-        {
-            rank -= second;
-            return rs3_border1 + 1;
-        }
-        else
-            return rs3_border0 + 1;
+        k = ln->find_sub_block(unsigned(rank));
+        rank -= ln->sub_count_to(k);
     }
-    return 0;
+    else // FULL block
+    {
+        k = unsigned(rank - 1) >> bm::rs_sub_block_shift;
+        rank -= size_type(k) << bm::rs_sub_block_shift;
+    }
+    return bm::gap_word_t(k << bm::rs_sub_block_shift);
 }
 
 //---------------------------------------------------------------------
 
 template<typename BVAlloc>
-typename rs_index<BVAlloc>::block_idx_type
-rs_index<BVAlloc>::find(size_type rank) const
+unsigned rs_index<BVAlloc>::find_block(unsigned i,
+                                       size_type& rank) const BMNOEXCEPT
 {
-    BM_ASSERT(rank);
-
-    unsigned i = find_super_block(rank);
-    BM_ASSERT(i < super_block_size());
-    
     size_type prev_rc = sblock_count_[i];
     size_type curr_rc = sblock_count_[i+1];
     size_type bc = curr_rc - prev_rc;
     
     BM_ASSERT(bc);
+    BM_ASSERT(rank > prev_rc);
 
     unsigned j;
     rank -= prev_rc;
     if (bc == (bm::set_sub_array_size * bm::gap_max_bits)) // FULL BLOCK
     {
-        for (j = 0; j < bm::set_sub_array_size; ++j)
-        {
-            if (rank <= bm::gap_max_bits)
-                break;
-            rank -= bm::gap_max_bits;
-        } // for j
+        j = unsigned((rank - 1) >> bm::set_block_shift);
+        rank -= size_type(j) * bm::gap_max_bits;
     }
     else
     {
         unsigned row_idx = sblock_row_idx_[i+1];
-        const unsigned* row = block_matr_.row(row_idx);
+        BM_ASSERT(row_idx);
+        const unsigned* row = block_matr_.row(row_idx - 1);
         BM_ASSERT(rank <= (bm::set_sub_array_size * bm::gap_max_bits));
         j = bm::lower_bound_u32(row, unsigned(rank), 0, bm::set_sub_array_size-1);
+        if (j)
+            rank -= row[j-1];
     }
     BM_ASSERT(j < bm::set_sub_array_size);
+    return j;
+}
 
-    block_idx_type nb = (i * bm::set_sub_array_size) + j;
-    return nb;
+//---------------------------------------------------------------------
+
+template<typename BVAlloc>
+unsigned
+rs_index<BVAlloc>::find_super_block_sampled(size_type rank) const BMNOEXCEPT
+{
+    BM_ASSERT(rank && rank <= count());
+    size_type s = (rank - 1) >> sample_shift_;
+    BM_ASSERT(s < samples_.size());
+
+    // target is between the super-blocks of two samples
+    unsigned i_from = samples_[s];
+    unsigned i_to = (s + 1 < samples_.size()) ? samples_[s + 1] : max_sblock_;
+    if (i_from == i_to)
+        return i_from;
+    const sblock_count_type* bcount_arr = sblock_count_.begin();
+    unsigned i;
+    #ifdef BM64ADDR
+        i = bm::lower_bound_u64(bcount_arr, rank, i_from+1, i_to+1);
+    #else
+        i = bm::lower_bound_u32(bcount_arr, rank, i_from+1, i_to+1);
+    #endif
+    return i-1;
 }
 
 //---------------------------------------------------------------------
+
 template<typename BVAlloc>
-unsigned rs_index<BVAlloc>::sub_count(block_idx_type nb) const
+typename rs_index<BVAlloc>::block_idx_type
+rs_index<BVAlloc>::find(size_type rank) const
 {
-    if (nb >= total_blocks_)
-        return 0;
-    
-    unsigned i = unsigned(nb >> bm::set_array_shift);
-    size_type sb_count = get_super_block_count(i);
-    
-    if (!sb_count)
-        return 0;
-    if (sb_count == (bm::set_sub_array_size * bm::gap_max_bits)) // FULL BLOCK
-    {
-        unsigned first = rs3_border0 + 1;
-        unsigned second = rs3_border1 - first + 1;
-        return (second << 16) | first;
-    }
-    
-    unsigned j = unsigned(nb &  bm::set_array_mask);
+    BM_ASSERT(rank);
 
-    unsigned row_idx = sblock_row_idx_[i+1];
-    const unsigned* sub_row = sub_block_matr_.row(row_idx);
-    return sub_row[j];
+    unsigned i = samples_.size() ? find_super_block_sampled(rank)
+                                 : find_super_block(rank);
+    BM_ASSERT(i < super_block_size());
+    
+    unsigned j = find_block(i, rank);
+    block_idx_type nb = (block_idx_type(i) * bm::set_sub_array_size) + j;
+    return nb;
 }
 
-
 //---------------------------------------------------------------------
 
 template<typename BVAlloc>
@@ -380,87 +533,24 @@ bool rs_index<BVAlloc>::find(size_type* rank,
     BM_ASSERT(nb);
     BM_ASSERT(sub_range);
 
-    unsigned i = find_super_block(*rank);
-    if (i > max_sblock_)
-        return false;
-    
-    size_type prev_rc = sblock_count_[i];
-    size_type curr_rc = sblock_count_[i+1];
-    size_type bc = curr_rc - prev_rc;
-    
-    BM_ASSERT(bc);
-
-    unsigned j;
-    *rank -= prev_rc;
-    if (bc == (bm::set_sub_array_size * bm::gap_max_bits)) // FULL BLOCK
+    unsigned i;
+    if (samples_.size())
     {
-        // TODO: optimize
-        size_type r = *rank;
-        for (j = 0; j < bm::set_sub_array_size; ++j)
-        {
-            if (r <= bm::gap_max_bits)
-                break;
-            r -= bm::gap_max_bits;
-        } // for j
-        *rank = r;
-
-        unsigned first = rs3_border0 + 1;
-        unsigned second = rs3_border1 - first + 1;
-        if (*rank > first)
-        {
-            *rank -= first;
-            if (*rank > second)
-            {
-                *rank -= second;
-                *sub_range = bm::rs3_border1 + 1;
-            }
-            else
-            {
-                *sub_range = bm::rs3_border0 + 1;
-            }
-        }
-        else
-        {
-            *sub_range = 0;
-        }
+        if (*rank > count())
+            return false;
+        i = find_super_block_sampled(*rank);
     }
     else
     {
-        unsigned row_idx = sblock_row_idx_[i+1];
-        const unsigned* row = block_matr_.row(row_idx);
-
-        BM_ASSERT(*rank <= (bm::set_sub_array_size * bm::gap_max_bits));
-        j = bm::lower_bound_u32(row, unsigned(*rank), 0, bm::set_sub_array_size-1);
-        BM_ASSERT(j < bm::set_sub_array_size);
-        if (j)
-            *rank -= row[j-1];
-        
-        const unsigned* sub_row = sub_block_matr_.row(row_idx);
-        unsigned first = sub_row[j] & 0xFFFF;
-        unsigned second = sub_row[j] >> 16;
-        if (*rank > first)
-        {
-            *rank -= first;
-            if (*rank > second)
-            {
-                *rank -= second;
-                *sub_range = bm::rs3_border1 + 1;
-            }
-            else
-            {
-                *sub_range = bm::rs3_border0 + 1;
-            }
-        }
-        else
-        {
-            *sub_range = 0;
-        }
+        i = find_super_block(*rank);
+        if (i > max_sblock_)
+            return false;
     }
-    BM_ASSERT(j < bm::set_sub_array_size);
-    *nb = (i * bm::set_sub_array_size) + j;
+    unsigned j = find_block(i, *rank);
+    *nb = (block_idx_type(i) * bm::set_sub_array_size) + j;
+    *sub_range = select_sub_range(*nb, *rank);
     
     return true;
-
 }
 
 //---------------------------------------------------------------------
@@ -497,8 +587,15 @@ void rs_index<BVAlloc>::set_super_block(unsigned i, size_type bcount)
     }
     else
     {
-        sblock_row_idx_[i+1] = sblock_rows_;
+        BM_ASSERT(sblock_rows_ < rows_.size());
+        rs_row& row = rows_[sblock_rows_];
+        row.line_base = 0;
+        for (unsigned w = 0; w < bm::set_sub_array_size / 64; ++w)
+        {
+            row.nz_mask[w] = 0; row.nz_off[w] = 0;
+        }
         ++sblock_rows_;
+        sblock_row_idx_[i+1] = sblock_rows_;
     }
 }
 
@@ -562,7 +659,25 @@ template<typename BVAlloc>
 void rs_index<BVAlloc>::resize_effective_super_blocks(size_type sb_eff)
 {
     block_matr_.resize(sb_eff+1,     bm::set_sub_array_size);
-    sub_block_matr_.resize(sb_eff+1, bm::set_sub_array_size);
+    rows_.resize(sb_eff+1);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BVAlloc>
+void rs_index<BVAlloc>::reserve_lines(size_t cnt)
+{
+    if (cnt <= lines_cap_)
+        return;
+    size_t new_cap = cnt + (cnt >> 1) + 64;
+    lines_buffer_type buf;
+    buf.resize((new_cap + 1) * sizeof(rs_line)); // +1 line to align
+    rs_line* new_lines = align_lines(buf.data());
+    if (lines_cnt_)
+        ::memcpy(new_lines, lines_, lines_cnt_ * sizeof(rs_line));
+    lines_buf_.swap(buf);
+    lines_ = new_lines;
+    lines_cap_ = new_cap;
 }
 
 //---------------------------------------------------------------------
@@ -570,29 +685,69 @@ void rs_index<BVAlloc>::resize_effective_super_blocks(size_type sb_eff)
 template<typename BVAlloc>
 void rs_index<BVAlloc>::register_super_block(unsigned i,
                                              const unsigned* bcount,
-                                             const unsigned* sub_count_in)
+                                             const bm::gap_word_t* sub_count)
 {
     BM_ASSERT(bcount);
-    BM_ASSERT(sub_count_in);
+    BM_ASSERT(sub_count);
 
     if (i > max_sblock_)
         max_sblock_ = i;
 
-    
-    sblock_row_idx_[i+1] = sblock_rows_;
+    BM_ASSERT(sblock_rows_ < block_matr_.rows());
     unsigned* row = block_matr_.row(sblock_rows_);
-    unsigned* sub_row = sub_block_matr_.row(sblock_rows_);
+    rs_row& rw = rows_[sblock_rows_];
     ++sblock_rows_;
+    sblock_row_idx_[i+1] = sblock_rows_;
 
-    unsigned bc = 0;
+    unsigned nz_cnt = 0;
+    for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+        nz_cnt += bool(bcount[j]);
+    reserve_lines(lines_cnt_ + nz_cnt);
+    rw.line_base = block_idx_type(lines_cnt_);
+    for (unsigned w = 0; w < bm::set_sub_array_size / 64; ++w)
+        rw.nz_mask[w] = 0;
+
+    const size_type sb_rcount = sblock_count_[i];
+    unsigned bc = 0, ln_cnt = 0;
     for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
     {
+        if ((j & 63) == 0)
+            rw.nz_off[j >> 6] = (unsigned short)ln_cnt;
+        if (bcount[j])
+        {
+            rw.nz_mask[j >> 6] |= (bm::id64_t(1) << (j & 63));
+            rs_line& line = lines_[lines_cnt_ + ln_cnt];
+            ++ln_cnt;
+            line.rcount = sb_rcount + bc;
+            line.bcount = bcount[j];
+            for (unsigned k = 0; k < bm::rs_sub_blocks-1; ++k)
+            {
+                line.sub_rcount[k] = sub_count[k];
+                BM_ASSERT(line.sub_rcount[k] <= bcount[j]);
+            }
+        }
+        sub_count += bm::rs_sub_blocks-1;
         bc += bcount[j];
         row[j] = bc;
-        sub_row[j] = sub_count_in[j];
-        BM_ASSERT(bcount[j] >= (sub_count_in[j] >> 16) + (sub_count_in[j] & bm::set_block_mask));
     } // for j
-    sblock_count_[i+1] = sblock_count_[i] + bc;
+    lines_cnt_ += ln_cnt;
+    sblock_count_[i+1] = sb_rcount + bc;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BVAlloc>
+void rs_index<BVAlloc>::build_select_samples()
+{
+    samples_.resize(0);
+    size_type cnt = count();
+    if (!sample_shift_ || !cnt)
+        return;
+    BM_ASSERT(sample_shift_ < sizeof(size_type) * 8);
+    size_type samples_cnt = ((cnt - 1) >> sample_shift_) + 1;
+    samples_.resize(samples_cnt);
+    for (size_type s = 0; s < samples_cnt; ++s)
+        samples_[s] = find_super_block((s << sample_shift_) + 1);
 }
 
 //---------------------------------------------------------------------
@@ -59,6 +59,37 @@ namespace bm
 const unsigned set_compression_max = 6;     ///< Maximum supported compression level
 const unsigned set_compression_default = 6; ///< Default compression level
 
+/**
+    Decode cost model of bit-block codecs for the serializer.
+
+    Decode time of a block is estimated as a linear function of the
+    number of encoded elements (bits, gaps, non-zero waves or bytes,
+    depending on the codec):
+        ns = ns_block[codec] + ns_item[codec] * items
+    Codecs are addressed by serialization code (bm::set_block_*).
+
+    @sa serializer::set_decode_cost_model, bm::calibrate_decode_cost
+    @ingroup bvserial
+*/
+struct serializer_decode_cost
+{
+    float ns_block[256]; ///< decode time of a block (ns)
+    float ns_item[256];  ///< decode time of an encoded element (ns)
+
+    serializer_decode_cost() BMNOEXCEPT { reset(); }
+
+    /// Set all costs to zero
+    void reset() BMNOEXCEPT
+    {
+        for (unsigned i = 0; i < 256; ++i)
+            ns_block[i] = ns_item[i] = 0.0f;
+    }
+
+    /// Estimated decode time (ns) of a block
+    float estimate(unsigned char codec, unsigned items) const BMNOEXCEPT
+        { return ns_block[codec] + ns_item[codec] * float(items); }
+};
+
 /**
     Bit-vector serialization class.
     
@@ -84,6 +115,7 @@ public:
 
     typedef byte_buffer<allocator_type>     buffer;
     typedef bm::bv_ref_vector<BV>           bv_ref_vector_type;
+    typedef bm::xor_search_plan<BV>         xor_plan_type;
 public:
     /**
         Constructor
@@ -129,6 +161,24 @@ public:
     unsigned get_compression_level() const BMNOEXCEPT
         { return compression_level_; }
 
+    /**
+        Attach decode cost model for bit-block codecs. Codec is chosen to
+        minimize size_bits + 8 * bytes_per_ns * decode_ns
+        instead of the size alone, so blocks of "hot" data can be stored
+        using faster to decode codecs at the expense of some size increase.
+        (no transfer of ownership for the pointer)
+
+        @param cost - cost model (see bm::calibrate_decode_cost) or NULL
+        @param bytes_per_ns - trade-off: BLOB bytes worth one nanosecond
+               of decode time (0 - optimize for size only)
+    */
+    void set_decode_cost_model(const serializer_decode_cost* cost,
+                               float bytes_per_ns) BMNOEXCEPT
+    {
+        decode_cost_ = cost;
+        cost_bits_per_ns_ = bytes_per_ns * 8.0f;
+    }
+
 
     //@}
 
@@ -250,6 +300,16 @@ public:
     */
     void set_curr_ref_idx(size_type ref_idx) BMNOEXCEPT;
 
+    /**
+        Attach pre-computed XOR search plan (built for the attached
+        reference vectors), plan replaces the XOR reference search
+        (no transfer of ownership for the pointer)
+        @sa xor_plan_builder
+        @internal
+    */
+    void set_xor_plan(const xor_plan_type* plan) BMNOEXCEPT
+        { xor_plan_ = plan; }
+
 
 protected:
     /**
@@ -350,7 +410,10 @@ protected:
     unsigned char find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT;
 
     void reset_models() BMNOEXCEPT { mod_size_ = 0; }
-    void add_model(unsigned char mod, unsigned score) BMNOEXCEPT;
+    void add_model(unsigned char mod, unsigned score,
+                   unsigned items = 0) BMNOEXCEPT;
+    /// Pick the model with the best score (size and decode cost)
+    unsigned char find_best_model() const BMNOEXCEPT;
 protected:
 
     /// Bookmark state structure
@@ -409,7 +472,10 @@ private:
     sblock_arridx_type sb_bit_idx_arr_;
     unsigned           scores_[bm::block_waves];
     unsigned char      models_[bm::block_waves];
+    unsigned           items_[bm::block_waves]; ///< model decode elements
     unsigned           mod_size_;
+    const serializer_decode_cost* decode_cost_ = 0; ///< decode cost model
+    float              cost_bits_per_ns_ = 0; ///< size vs decode trade-off
     
     allocator_type  alloc_;
     size_type*      compression_stat_;
@@ -436,6 +502,7 @@ private:
     //
     const bv_ref_vector_type* ref_vect_; ///< ref.vector for XOR compression
     bm::xor_scanner<BV>       xor_scan_; ///< scanner for XOR similarity
+    const xor_plan_type*      xor_plan_; ///< pre-computed XOR search
     size_type                 ref_idx_;  ///< current reference index
     bm::word_t*               xor_block_; ///< xor product
 
@@ -1124,6 +1191,7 @@ serializer<BV>::serializer(const allocator_type&   alloc,
   compression_level_(bm::set_compression_default),
   enc_header_pos_(0), header_flag_(0),
   ref_vect_(0),
+  xor_plan_(0),
   ref_idx_(0),
   xor_block_(0),
   sparse_cutoff_(sparse_max_l6)
@@ -1154,6 +1222,7 @@ serializer<BV>::serializer(bm::word_t*    temp_block)
   compression_level_(bm::set_compression_default),
   enc_header_pos_(0), header_flag_(0),
   ref_vect_(0),
+  xor_plan_(0),
   ref_idx_(0),
   xor_block_(0),
   sparse_cutoff_(sparse_max_l6)
@@ -1377,12 +1446,11 @@ void serializer<BV>::gamma_gap_block(const bm::gap_word_t* gap_block,
         encoder::position_type enc_pos0 = enc.get_pos();
         {
             bit_out_type bout(enc);
-            gamma_encoder_func gamma(bout);
 
             enc.put_8(bm::set_block_gap_egamma);
             enc.put_16(gap_block[0]);
 
-            for_each_dgap(gap_block, gamma);        
+            bout.gamma_dgap_u16(&gap_block[1], len-2);
         }
         // re-evaluate coding efficiency
         //
@@ -1421,15 +1489,7 @@ void serializer<BV>::gamma_gap_array(const bm::gap_word_t* gap_array,
             bit_out_type bout(enc);
             enc.put_8(scode);
             bout.gamma(arr_len);
-            gap_word_t prev = gap_array[0];
-            bout.gamma(prev + 1);
-
-            for (unsigned i = 1; i < arr_len; ++i)
-            {
-                gap_word_t curr = gap_array[i];
-                bout.gamma(curr - prev);
-                prev = curr;
-            }
+            bout.gamma_dgap_u16(gap_array, arr_len);
         }
         encoder::position_type enc_pos1 = enc.get_pos();
         unsigned gamma_size = (unsigned)(enc_pos1 - enc_pos0);
@@ -1575,13 +1635,48 @@ void serializer<BV>::interpolated_gap_array(const bm::gap_word_t* gap_block,
 
 
 template<class BV>
-void serializer<BV>::add_model(unsigned char mod, unsigned score) BMNOEXCEPT
+void serializer<BV>::add_model(unsigned char mod, unsigned score,
+                               unsigned items) BMNOEXCEPT
 {
     BM_ASSERT(mod_size_ < 64); // too many models (memory corruption?)
     scores_[mod_size_] = score; models_[mod_size_] = mod;
+    items_[mod_size_] = items;
     ++mod_size_;
 }
 
+template<class BV>
+unsigned char serializer<BV>::find_best_model() const BMNOEXCEPT
+{
+    unsigned char model = bm::set_block_bit;
+    if (!decode_cost_)
+    {
+        unsigned min_score = bm::gap_max_bits;
+        for (unsigned i = 0; i < mod_size_; ++i)
+        {
+            if (scores_[i] < min_score)
+            {
+                min_score = scores_[i];
+                model = models_[i];
+            }
+        }
+        return model;
+    }
+    // size + decode time model
+    float min_score = float(bm::gap_max_bits) + cost_bits_per_ns_ *
+                        decode_cost_->estimate(bm::set_block_bit, 0);
+    for (unsigned i = 0; i < mod_size_; ++i)
+    {
+        float score = float(scores_[i]) + cost_bits_per_ns_ *
+                        decode_cost_->estimate(models_[i], items_[i]);
+        if (score < min_score)
+        {
+            min_score = score;
+            model = models_[i];
+        }
+    }
+    return model;
+}
+
 template<class BV>
 unsigned char
 serializer<BV>::find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT
@@ -1595,7 +1690,8 @@ serializer<BV>::find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT
     add_model(bm::set_block_bit, bm::gap_max_bits); // default model (bit-block)
     
     bit_model_0run_size_ = bm::bit_count_nonzero_size(block, bm::set_block_size);
-    add_model(bm::set_block_bit_0runs, bit_model_0run_size_ * 8);
+    add_model(bm::set_block_bit_0runs, bit_model_0run_size_ * 8,
+              bit_model_0run_size_);
 
     bm::id64_t d0 = digest0_ = bm::calc_block_digest0(block);
     if (!d0)
@@ -1604,7 +1700,7 @@ serializer<BV>::find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT
     unsigned d0_bc = word_bitcount64(d0);
     bit_model_d0_size_ = unsigned(8 + (32 * d0_bc * sizeof(bm::word_t)));
     if (d0 != ~0ull)
-        add_model(bm::set_block_bit_digest0, bit_model_d0_size_ * 8);
+        add_model(bm::set_block_bit_digest0, bit_model_d0_size_ * 8, d0_bc);
 
     bm::bit_block_change_bc(block, &gc, &bc);
     ibc = bm::gap_max_bits - bc;
@@ -1618,26 +1714,27 @@ serializer<BV>::find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT
         unsigned arr_size_inv =
             unsigned(sizeof(gap_word_t) + (ibc * sizeof(gap_word_t)));
 
-        add_model(bm::set_block_arrbit, arr_size * 8);
-        add_model(bm::set_block_arrbit_inv, arr_size_inv * 8);
+        add_model(bm::set_block_arrbit, arr_size * 8, bc);
+        add_model(bm::set_block_arrbit_inv, arr_size_inv * 8, ibc);
     }
 
     float gcf=float(gc);
 
     if (gc > 3 && gc < bm::gap_max_buff_len)
         add_model(bm::set_block_gap_bienc,
-                  32 + unsigned((gcf-1) * bie_bits_per_int));
+                  32 + unsigned((gcf-1) * bie_bits_per_int), gc);
 
 
     float bcf=float(bc), ibcf=float(ibc);
 
     if (bc < bie_limit) 
-        add_model(bm::set_block_arr_bienc, 16 * 3 + unsigned(bcf * bie_bits_per_int));
+        add_model(bm::set_block_arr_bienc,
+                  16 * 3 + unsigned(bcf * bie_bits_per_int), bc);
     else
     {
         if (ibc < bie_limit)
             add_model(bm::set_block_arr_bienc_inv,
-                      16 * 3 + unsigned(ibcf * bie_bits_per_int));
+                      16 * 3 + unsigned(ibcf * bie_bits_per_int), ibc);
     }
 
     gc -= gc > 2 ? 2 : 0;
@@ -1645,27 +1742,18 @@ serializer<BV>::find_bit_best_encoding_l5(const bm::word_t* block) BMNOEXCEPT
     if (gc < bm::gap_max_buff_len) // GAP block
     {
         add_model(bm::set_block_bitgap_bienc,
-                  16 * 4 + unsigned(gcf * bie_bits_per_int));
+                  16 * 4 + unsigned(gcf * bie_bits_per_int), gc);
     }
     else
     {
         if (gc < bie_limit)
             add_model(bm::set_block_bitgap_bienc,
-                      16 * 4 + unsigned(gcf * bie_bits_per_int));
+                      16 * 4 + unsigned(gcf * bie_bits_per_int), gc);
     }
 
     // find the best representation based on computed approx.models
     //
-    unsigned min_score = bm::gap_max_bits;
-    unsigned char model = bm::set_block_bit;
-    for (unsigned i = 0; i < mod_size_; ++i)
-    {
-        if (scores_[i] < min_score)
-        {
-            min_score = scores_[i];
-            model = models_[i];
-        }
-    }
+    unsigned char model = find_best_model();
 #if 0
     if (model == set_block_bit_0runs)
     {
@@ -1721,7 +1809,8 @@ serializer<BV>::find_bit_best_encoding(const bm::word_t* block) BMNOEXCEPT
     // check if it is a very sparse block with some areas of dense areas
     bit_model_0run_size_ = bm::bit_count_nonzero_size(block, bm::set_block_size);
     if (compression_level_ <= 5)
-        add_model(bm::set_block_bit_0runs, bit_model_0run_size_ * 8);
+        add_model(bm::set_block_bit_0runs, bit_model_0run_size_ * 8,
+                  bit_model_0run_size_);
     
     if (compression_level_ >= 2)
     {
@@ -1734,7 +1823,8 @@ serializer<BV>::find_bit_best_encoding(const bm::word_t* block) BMNOEXCEPT
         unsigned d0_bc = word_bitcount64(d0);
         bit_model_d0_size_ = unsigned(8 + (32 * d0_bc * sizeof(bm::word_t)));
         if (d0 != ~0ull)
-            add_model(bm::set_block_bit_digest0, bit_model_d0_size_ * 8);
+            add_model(bm::set_block_bit_digest0, bit_model_d0_size_ * 8,
+                      d0_bc);
 
         if (compression_level_ >= 4)
         {
@@ -1766,8 +1856,8 @@ serializer<BV>::find_bit_best_encoding(const bm::word_t* block) BMNOEXCEPT
             unsigned arr_size_inv =
                 unsigned(sizeof(gap_word_t) + (inverted_bc * sizeof(gap_word_t)));
             
-            add_model(bm::set_block_arrbit, arr_size*8);
-            add_model(bm::set_block_arrbit_inv, arr_size_inv*8);
+            add_model(bm::set_block_arrbit, arr_size*8, bc);
+            add_model(bm::set_block_arrbit_inv, arr_size_inv*8, inverted_bc);
             
             if (compression_level_ >= 4)
             {
@@ -1778,13 +1868,15 @@ serializer<BV>::find_bit_best_encoding(const bm::word_t* block) BMNOEXCEPT
                 {
                     if (bit_gaps > 3 && bit_gaps < bm::gap_max_buff_len)
                         add_model(bm::set_block_gap_egamma,
-                                  16 + (bit_gaps-1) * gamma_bits_per_int);
+                                  16 + (bit_gaps-1) * gamma_bits_per_int,
+                                  bit_gaps);
                     if (bc < bit_gaps && bc < bm::gap_equiv_len)
                         add_model(bm::set_block_arrgap_egamma,
-                                  16 + bc * gamma_bits_per_int);
+                                  16 + bc * gamma_bits_per_int, bc);
                     if (inverted_bc > 3 && inverted_bc < bit_gaps && inverted_bc < bm::gap_equiv_len)
                         add_model(bm::set_block_arrgap_egamma_inv,
-                                  16 + inverted_bc * gamma_bits_per_int);
+                                  16 + inverted_bc * gamma_bits_per_int,
+                                  inverted_bc);
                 }
             } // level >= 3
         } // level >= 3
@@ -1792,17 +1884,7 @@ serializer<BV>::find_bit_best_encoding(const bm::word_t* block) BMNOEXCEPT
     
     // find the best representation based on computed approx.models
     //
-    unsigned min_score = bm::gap_max_bits;
-    unsigned char model = bm::set_block_bit;
-    for (unsigned i = 0; i < mod_size_; ++i)
-    {
-        if (scores_[i] < min_score)
-        {
-            min_score = scores_[i];
-            model = models_[i];
-        }
-    }
-    return model;
+    return find_best_model();
 }
 
 template<class BV>
@@ -2638,10 +2720,24 @@ serializer<BV>::serialize(const BV& bv,
             if (ref_vect_) // XOR filter
             {
                 bm::gap_word_t* tmp_buf = (bm::gap_word_t*)xor_block_;
-                bool found = xor_scan_.search_best_xor_gap(tmp_buf, blk,
-                                                           ref_idx_+1,
-                                                           ref_vect_->size(),
-                                                           i0, j0);
+                bool found;
+                if (xor_plan_)
+                {
+                    const typename xor_plan_type::match* m =
+                                            xor_plan_->find(ref_idx_, i);
+                    if ((found = bool(m)))
+                    {
+                        const bm::word_t* block_xor = ref_vect_->get_bv(
+                            m->ridx)->get_blocks_manager().get_block_ptr(i0, j0);
+                        xor_scan_.set_found(m->ridx,
+                                    (const bm::word_t*)BMGAP_PTR(block_xor), 0);
+                    }
+                }
+                else
+                    found = xor_scan_.search_best_xor_gap(tmp_buf, blk,
+                                                          ref_idx_+1,
+                                                          ref_vect_->size(),
+                                                          i0, j0);
                 if (found)
                 {
                     const bm::gap_word_t* gap_block = BMGAP_PTR(blk);
@@ -2685,8 +2781,18 @@ serializer<BV>::serialize(const BV& bv,
             if (ref_vect_) // XOR filter
             {
                 xor_scan_.compute_x_block_stats(blk);
-                bool found =
-                    xor_scan_.search_best_xor_mask(blk,
+                bool found;
+                if (xor_plan_)
+                {
+                    const typename xor_plan_type::match* m =
+                                            xor_plan_->find(ref_idx_, i);
+                    if ((found = bool(m)))
+                        xor_scan_.set_found(m->ridx, ref_vect_->get_bv(
+                            m->ridx)->get_blocks_manager().get_block_ptr(i0, j0),
+                            m->d64);
+                }
+                else
+                    found = xor_scan_.search_best_xor_mask(blk,
                                                    ref_idx_+1, ref_vect_->size(),
                                                    i0, j0,
                                                    xor_block_);
@@ -2739,6 +2845,7 @@ serializer<BV>::serialize(const BV& bv,
             {
             case bm::set_block_bit:
                 enc.put_prefixed_array_32(set_block_bit, blk, bm::set_block_size);
+                compression_stat_[bm::set_block_bit]++;
                 break;
             case bm::set_block_bit_1bit:
             {
@@ -3075,15 +3182,7 @@ unsigned deseriaizer_base<DEC, BLOCK_IDX>::read_id_list(
         {
             bit_in_type bin(decoder);
             len = (gap_word_t)bin.gamma();
-            gap_word_t prev = 0;
-            for (gap_word_t k = 0; k < len; ++k)
-            {
-                gap_word_t bit_idx = (gap_word_t)bin.gamma();
-                if (k == 0) --bit_idx; // TODO: optimization
-                bit_idx = (gap_word_t)(bit_idx + prev);
-                prev = bit_idx;
-				dst_arr[k] = bit_idx;
-            } // for
+            bin.gamma_dgap_u16(dst_arr, len);
         }
         break;
     case set_block_arrgap_bienc:
@@ -3412,14 +3511,7 @@ deseriaizer_base<DEC, BLOCK_IDX>::read_gap_block(decoder_type&   decoder,
             gap_word_t* gap_data_ptr = dst_block + 1;
 
             bit_in_type bin(decoder);
-            gap_word_t v = (gap_word_t)bin.gamma();
-            gap_word_t gap_sum = *gap_data_ptr = (gap_word_t)(v - 1);
-            for (unsigned i = 1; i < len; ++i)
-            {
-                v = (gap_word_t)bin.gamma();
-                gap_sum = (gap_word_t)(gap_sum + v);
-                *(++gap_data_ptr) = gap_sum;
-            }
+            bin.gamma_dgap_u16(gap_data_ptr, len);
             dst_block[len+1] = bm::gap_max_bits - 1;
         }
         break;
@@ -0,0 +1,287 @@
+#ifndef BMSERIAL_COST__H__INCLUDED__
+#define BMSERIAL_COST__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmserial_cost.h
+    \brief Calibration of serializer decode cost model and compression
+    level tuning
+*/
+
+#ifndef BM__H__INCLUDED__
+// BitMagic utility headers do not include main "bm.h" declaration
+// #include "bm.h" or "bm64.h" explicitly
+# error missing include (bm.h or bm64.h)
+#endif
+
+#include <chrono>
+
+#include "bmserial.h"
+
+namespace bm
+{
+
+/**
+    Decode time (ns) of a serialized BLOB (best of several runs)
+    @internal
+*/
+template<class BV>
+double serial_decode_ns(const unsigned char* buf, unsigned reps)
+{
+    double best_ns = 0;
+    for (unsigned k = 0; k < reps; ++k)
+    {
+        BV bv;
+        auto start = std::chrono::steady_clock::now();
+        bm::deserialize(bv, buf);
+        auto finish = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(
+                                                    finish - start).count();
+        if (!k || ns < best_ns)
+            best_ns = ns;
+    } // for k
+    return best_ns;
+}
+
+/**
+    Generate calibration sample block: cnt isolated bits scattered over
+    the first span_bits of the block (so digest and 0-runs codecs apply)
+    @internal
+*/
+inline
+void calibration_sample_block(bm::word_t* block, unsigned cnt,
+                              unsigned span_bits,
+                              bool invert, unsigned seed) BMNOEXCEPT
+{
+    bm::bit_block_set(block, 0);
+    BM_ASSERT(cnt && span_bits <= bm::gap_max_bits);
+    unsigned step = span_bits / cnt;
+    BM_ASSERT(step >= 4);
+    for (unsigned i = 0; i < cnt; ++i)
+    {
+        seed = seed * 1103515245u + 12345u; // LCG
+        unsigned pos = i * step + 1 + ((seed >> 16) % (step - 2));
+        block[pos >> bm::set_word_shift] |= (1u << (pos & bm::set_word_mask));
+    }
+    if (invert)
+        bm::bit_invert(block);
+}
+
+/**
+    Generate calibration sample block of dense waves: waves (digest
+    sub-blocks) at stride have all words non-zero, the rest is empty
+    (stride 2 - digest0 wins over 0-runs, all waves - raw bit-block)
+    @internal
+*/
+inline
+void calibration_wave_block(bm::word_t* block, unsigned waves,
+                            unsigned stride, unsigned seed) BMNOEXCEPT
+{
+    bm::bit_block_set(block, 0);
+    BM_ASSERT(waves && stride && (waves - 1) * stride < 64);
+    for (unsigned w = 0; w < waves; ++w)
+    {
+        bm::word_t* wblk = block + w * stride * bm::set_block_digest_wave_size;
+        for (unsigned j = 0; j < bm::set_block_digest_wave_size; ++j)
+        {
+            seed = seed * 1103515245u + 12345u; // LCG
+            wblk[j] = (seed >> 8) | 1u;
+        }
+    } // for w
+}
+
+/**
+    Measure decode cost of the bit-block codecs of the serializer on
+    the current CPU and build the cost model.
+
+    Each codec is forced (via a penalty cost model) on sample vectors
+    of two densities, deserialization is timed, cost per block and per
+    encoded element are fitted as a line between two samples.
+    Digest0 samples differ by the number of occupied waves. A codec the
+    serializer did not emit for every sample block is left at zero cost.
+    Codecs: raw bit-block, 0-runs, digest0, bit arrays, Elias Gamma,
+    Binary Interpolative Coding (BIC).
+
+    @param cost - [out] decode cost model
+    @param blocks - number of blocks in the sample vector
+    @param reps - number of decode runs (best time is used)
+
+    @sa serializer::set_decode_cost_model
+    @ingroup bvserial
+*/
+template<class BV>
+void calibrate_decode_cost(bm::serializer_decode_cost& cost,
+                           unsigned blocks = 64, unsigned reps = 5)
+{
+    struct codec_descr
+    {
+        unsigned char codec;  ///< codec (set_block_*)
+        unsigned      clevel; ///< compression level to make it a candidate
+        bool          invert; ///< codec for inverted (dense) blocks
+    };
+    static const codec_descr codecs[] = {
+        { bm::set_block_bit,              6, false },
+        { bm::set_block_bit_0runs,        6, false },
+        { bm::set_block_bit_digest0,      6, false },
+        { bm::set_block_arrbit,           6, false },
+        { bm::set_block_arrbit_inv,       6, true },
+        { bm::set_block_gap_egamma,       4, false },
+        { bm::set_block_arrgap_egamma,    4, false },
+        { bm::set_block_arrgap_egamma_inv,4, true },
+        { bm::set_block_gap_bienc,        6, false },
+        { bm::set_block_arr_bienc,        6, false },
+        { bm::set_block_arr_bienc_inv,    6, true },
+        { bm::set_block_bitgap_bienc,     6, false }
+    };
+    const unsigned sample_cnt[2] = { 64, 512 }; // bits per block
+    const unsigned digest_waves[2] = { 8, 32 }; // digest0: every other wave
+
+    cost.reset();
+    BM_ASSERT(blocks);
+
+    bm::serializer_decode_cost force_cost;
+    BM_DECLARE_TEMP_BLOCK(temp_blk)
+    bm::word_t* tb = (bm::word_t*)temp_blk;
+    for (unsigned c = 0; c < sizeof(codecs)/sizeof(codecs[0]); ++c)
+    {
+        const codec_descr& cd = codecs[c];
+        for (unsigned i = 0; i < 256; ++i)
+            force_cost.ns_block[i] = 1e9f;
+        force_cost.ns_block[cd.codec] = 0.0f;
+
+        double ns[2], items[2];
+        bool emitted = true;
+        for (unsigned d = 0; d < 2 && emitted; ++d)
+        {
+            BV bv(bm::BM_BIT);
+            unsigned gc = 0, bc = 0;
+            for (unsigned nb = 0; nb < blocks; ++nb)
+            {
+                unsigned seed = nb * 7919 + d;
+                switch (cd.codec)
+                {
+                case bm::set_block_bit:
+                    bm::calibration_wave_block(tb, 64, 1, seed);
+                    break;
+                case bm::set_block_bit_digest0:
+                    bm::calibration_wave_block(tb, digest_waves[d], 2, seed);
+                    break;
+                case bm::set_block_arrgap_egamma:
+                case bm::set_block_arrgap_egamma_inv:
+                    // short gaps: gamma codes are shorter than 16-bit ints
+                    bm::calibration_sample_block(tb, sample_cnt[d],
+                                    sample_cnt[d] * 16, cd.invert, seed);
+                    break;
+                default:
+                    bm::calibration_sample_block(tb, sample_cnt[d],
+                                    bm::gap_max_bits / 2, cd.invert, seed);
+                } // switch
+                bv.combine_operation_with_block(nb, tb, false, BM_OR);
+            } // for nb
+            // elements of the (last) sample block as the serializer counts
+            bm::bit_block_change_bc(tb, &gc, &bc);
+            switch (cd.codec)
+            {
+            case bm::set_block_bit:
+                items[d] = 0; break;
+            case bm::set_block_bit_0runs:
+                items[d] = bm::bit_count_nonzero_size(tb, bm::set_block_size);
+                break;
+            case bm::set_block_bit_digest0:
+                items[d] = bm::word_bitcount64(bm::calc_block_digest0(tb));
+                break;
+            case bm::set_block_gap_egamma:
+            case bm::set_block_gap_bienc:
+            case bm::set_block_bitgap_bienc:
+                items[d] = gc; break;
+            default:
+                items[d] = cd.invert ? bm::gap_max_bits - bc : bc;
+            } // switch
+
+            bm::serializer<BV> bvs;
+            bvs.set_compression_level(cd.clevel);
+            bvs.set_sparse_cutoff(0);
+            bvs.set_decode_cost_model(&force_cost, 1.0f);
+            typename bm::serializer<BV>::buffer buf;
+            bvs.serialize(bv, buf);
+            // penalty model may lose to a mandatory encoding: check stat
+            emitted = (bvs.get_compression_stat()[cd.codec] == blocks);
+
+            ns[d] = bm::serial_decode_ns<BV>(buf.buf(), reps) /
+                                                        double(blocks);
+        } // for d
+        if (!emitted)
+            continue;
+
+        // linear fit: ns = ns_block + ns_item * items
+        double ns_item = 0;
+        if (items[1] > items[0])
+            ns_item = (ns[1] - ns[0]) / (items[1] - items[0]);
+        if (ns_item < 0)
+            ns_item = 0;
+        double ns_block = ns[0] - ns_item * items[0];
+        if (ns_block < 0)
+            ns_block = 0;
+        cost.ns_block[cd.codec] = float(ns_block);
+        cost.ns_item[cd.codec] = float(ns_item);
+    } // for c
+}
+
+/**
+    Find compression level for a bit-vector which gives the best
+    trade-off between BLOB size and decode time (measured):
+        size + bytes_per_ns * decode_ns
+
+    @param bv - bit-vector to analyse (representative sample)
+    @param bytes_per_ns - trade-off: BLOB bytes worth one nanosecond
+           of decode time (0 - the smallest BLOB)
+    @param reps - number of decode runs (best time is used)
+
+    @return compression level (1 - set_compression_max)
+
+    @sa serializer::set_compression_level
+    @ingroup bvserial
+*/
+template<class BV>
+unsigned tune_compression_level(const BV& bv, float bytes_per_ns,
+                                unsigned reps = 3)
+{
+    unsigned best_level = bm::set_compression_default;
+    double best_score = 0;
+    bm::serializer<BV> bvs;
+    typename bm::serializer<BV>::buffer buf;
+    for (unsigned level = 1; level <= bm::set_compression_max; ++level)
+    {
+        bvs.set_compression_level(level);
+        bvs.serialize(bv, buf);
+        double score = double(buf.size());
+        if (bytes_per_ns > 0)
+            score += double(bytes_per_ns) *
+                     bm::serial_decode_ns<BV>(buf.buf(), reps);
+        if (level == 1 || score < best_score)
+        {
+            best_score = score;
+            best_level = level;
+        }
+    } // for level
+    return best_level;
+}
+
+} // namespace bm
+
+#endif
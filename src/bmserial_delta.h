@@ -0,0 +1,442 @@
+#ifndef BMSERIAL_DELTA__H__INCLUDED__
+#define BMSERIAL_DELTA__H__INCLUDED__
+/*
+Copyright(c) 2020 Anatoliy Kuznetsov(anatoliy_kuznetsov at yahoo.com)
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+For more information please visit:  http://bitmagic.io
+*/
+
+/*! \file bmserial_delta.h
+    \brief Delta (diff snapshot) serialization of bit-vector changes
+*/
+
+#ifndef BM__H__INCLUDED__
+// BitMagic utility headers do not include main "bm.h" declaration
+// #include "bm.h" or "bm64.h" explicitly
+# error missing include (bm.h or bm64.h)
+#endif
+
+#include "bmserial.h"
+
+namespace bm
+{
+
+/**
+    Delta serializer: encodes the difference between two versions of a
+    bit-vector, so a snapshot can be shipped as a patch.
+
+    Vectors are compared block by block (block_find_first_diff), equal
+    blocks are skipped. A changed block is either XOR-encoded against
+    the previous version or stored as a replacement, whichever has the
+    lower cost estimate (min of population and run count).
+
+    Delta format:
+    <pre>
+    'D' | version | new size (64) |
+        len (64) | replaced block index vector (serialized)
+        len (64) | replacement blocks vector (serialized)
+        len (64) | XOR blocks vector (serialized)
+    </pre>
+
+    @sa delta_deserializer
+    @ingroup bvserial
+*/
+template<typename BV>
+class delta_serializer
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef bm::serializer<BV>                        serializer_type;
+    typedef typename serializer_type::buffer          buffer_type;
+
+    /// Delta statistics
+    struct statistics
+    {
+        size_type blocks_changed;   ///< number of changed blocks
+        size_type blocks_xor;       ///< blocks encoded as XOR
+        size_type blocks_replaced;  ///< blocks encoded as replacement
+
+        void reset() BMNOEXCEPT
+            { blocks_changed = blocks_xor = blocks_replaced = 0; }
+    };
+
+public:
+    delta_serializer();
+    ~delta_serializer();
+
+    /// Set compression level for the delta parts (see serializer)
+    void set_compression_level(unsigned clevel) BMNOEXCEPT
+        { clevel_ = clevel; }
+
+    /**
+        Compute and serialize delta
+        \param bv_old - previous version
+        \param bv_new - current version
+        \param buf - [out] delta buffer
+    */
+    void serialize(const bvector_type& bv_old,
+                   const bvector_type& bv_new,
+                   buffer_type& buf);
+
+    /**
+        Compute and serialize delta for a known set of changed blocks
+        (for example from bvector_fingerprint::find_changed_blocks()),
+        other blocks are not compared
+        \param bv_old - previous version
+        \param bv_new - current version
+        \param bv_blocks - indexes of blocks to compare
+        \param buf - [out] delta buffer
+    */
+    void serialize_blocks(const bvector_type& bv_old,
+                          const bvector_type& bv_new,
+                          const bvector_type& bv_blocks,
+                          buffer_type& buf);
+
+    /// Statistics of the last delta
+    const statistics& get_statistics() const BMNOEXCEPT { return stat_; }
+
+protected:
+    /// Get block as a bit-block (NULL/FULL/GAP are expanded into tmp)
+    static
+    const bm::word_t* get_bit_block(const bm::word_t* blk,
+                                    bm::word_t* tmp) BMNOEXCEPT;
+
+    /// Encoding cost estimate for a bit-block
+    static
+    unsigned block_cost(const bm::word_t* blk) BMNOEXCEPT;
+
+    /// Compare and encode one block pair
+    void encode_block(block_idx_type nb,
+                      const bm::word_t* blk_o, const bm::word_t* blk_n);
+
+    void serialize_part(bvector_type& bv, buffer_type& buf);
+    void serialize_parts(const bvector_type& bv_new, buffer_type& buf);
+
+private:
+    delta_serializer(const delta_serializer&);
+    delta_serializer& operator=(const delta_serializer&);
+
+protected:
+    allocator_type   alloc_;
+    bm::word_t*      tb_;        ///< temp blocks (3 blocks)
+    unsigned         clevel_;    ///< compression level
+    statistics       stat_;
+    buffer_type      buf_idx_;   ///< block index part
+    buffer_type      buf_repl_;  ///< replacement part
+    buffer_type      buf_xor_;   ///< XOR part
+    bvector_type     bv_idx_;    ///< replaced block indexes
+    bvector_type     bv_repl_;   ///< replacement blocks
+    bvector_type     bv_xor_;    ///< XOR blocks
+};
+
+/**
+    Delta deserializer: patches a bit-vector in place using a delta
+    produced by delta_serializer. Target must be equal to the old
+    version used for the delta.
+
+    @sa delta_serializer
+    @ingroup bvserial
+*/
+template<typename BV>
+class delta_deserializer
+{
+public:
+    typedef BV                                        bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+
+    /**
+        Apply delta
+        \param bv - target vector (old version) to patch
+        \param buf - delta buffer
+        \return number of bytes consumed
+    */
+    size_t apply(bvector_type& bv, const unsigned char* buf);
+
+protected:
+    static
+    const char* err_msg() BMNOEXCEPT { return "BM::Invalid delta format"; }
+    static
+    void throw_bad_format();
+};
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV>
+delta_serializer<BV>::delta_serializer()
+: tb_(0), clevel_(bm::set_compression_default)
+{
+    tb_ = alloc_.alloc_bit_block(3);
+    stat_.reset();
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+delta_serializer<BV>::~delta_serializer()
+{
+    alloc_.free_bit_block(tb_, 3);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+const bm::word_t*
+delta_serializer<BV>::get_bit_block(const bm::word_t* blk,
+                                    bm::word_t* tmp) BMNOEXCEPT
+{
+    if (!blk)
+    {
+        bm::bit_block_set(tmp, 0);
+        return tmp;
+    }
+    if (IS_FULL_BLOCK(blk))
+        return FULL_BLOCK_REAL_ADDR;
+    if (BM_IS_GAP(blk))
+    {
+        bm::gap_convert_to_bitset(tmp, BMGAP_PTR(blk));
+        return tmp;
+    }
+    return blk;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+unsigned delta_serializer<BV>::block_cost(const bm::word_t* blk) BMNOEXCEPT
+{
+    unsigned cnt = bm::bit_block_count(blk);
+    if (!cnt)
+        return 0;
+    unsigned gc = bm::bit_block_calc_change(blk);
+    return (gc < cnt) ? gc : cnt;
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_serializer<BV>::serialize_part(bvector_type& bv, buffer_type& buf)
+{
+    buf.resize(0);
+    if (!bv.any())
+        return;
+    serializer_type bv_ser(alloc_, tb_ + 2 * bm::set_block_size);
+    bv_ser.set_compression_level(clevel_);
+    bv_ser.optimize_serialize_destroy(bv, buf);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_serializer<BV>::encode_block(block_idx_type nb,
+                                        const bm::word_t* blk_o,
+                                        const bm::word_t* blk_n)
+{
+    if (blk_o == blk_n) // both NULL or both FULL
+        return;
+    if (IS_FULL_BLOCK(blk_o) && IS_FULL_BLOCK(blk_n))
+        return;
+    unsigned pos;
+    bool diff = bm::block_find_first_diff(
+        IS_FULL_BLOCK(blk_o) ? FULL_BLOCK_REAL_ADDR : blk_o,
+        IS_FULL_BLOCK(blk_n) ? FULL_BLOCK_REAL_ADDR : blk_n, &pos);
+    if (!diff)
+        return;
+
+    ++stat_.blocks_changed;
+    const bm::word_t* b_o = get_bit_block(blk_o, tb_);
+    const bm::word_t* b_n = get_bit_block(blk_n, tb_ + bm::set_block_size);
+    bm::word_t* blk_x = alloc_.alloc_bit_block();
+    bm::bit_block_copy(blk_x, b_o);
+    bm::bit_block_xor(blk_x, b_n);
+
+    if (block_cost(blk_x) <= block_cost(b_n)) // XOR pays off
+    {
+        ++stat_.blocks_xor;
+        if (!bv_xor_.import_bit_block(nb, blk_x))
+            alloc_.free_bit_block(blk_x);
+        return;
+    }
+    ++stat_.blocks_replaced;
+    bv_idx_.set(size_type(nb));
+    if (blk_n) // non-empty replacement
+    {
+        bm::bit_block_copy(blk_x, b_n);
+        if (!bv_repl_.import_bit_block(nb, blk_x))
+            alloc_.free_bit_block(blk_x);
+    }
+    else
+        alloc_.free_bit_block(blk_x);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_serializer<BV>::serialize(const bvector_type& bv_old,
+                                     const bvector_type& bv_new,
+                                     buffer_type& buf)
+{
+    stat_.reset();
+    const typename bvector_type::blocks_manager_type& bman_o =
+                                            bv_old.get_blocks_manager();
+    const typename bvector_type::blocks_manager_type& bman_n =
+                                            bv_new.get_blocks_manager();
+    unsigned top_o = bman_o.is_init() ? bman_o.top_block_size() : 0;
+    unsigned top_n = bman_n.is_init() ? bman_n.top_block_size() : 0;
+    unsigned top_size = (top_o > top_n) ? top_o : top_n;
+
+    for (unsigned i = 0; i < top_size; ++i)
+    {
+        const bm::word_t* const* blk_blk_o =
+                        (i < top_o) ? bman_o.get_topblock(i) : 0;
+        const bm::word_t* const* blk_blk_n =
+                        (i < top_n) ? bman_n.get_topblock(i) : 0;
+        if (!blk_blk_o && !blk_blk_n)
+            continue;
+        for (unsigned j = 0; j < bm::set_sub_array_size; ++j)
+        {
+            const bm::word_t* blk_o = blk_blk_o ? bman_o.get_block_ptr(i, j) : 0;
+            const bm::word_t* blk_n = blk_blk_n ? bman_n.get_block_ptr(i, j) : 0;
+            encode_block((block_idx_type(i) << bm::set_array_shift) + j,
+                         blk_o, blk_n);
+        } // for j
+    } // for i
+    serialize_parts(bv_new, buf);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_serializer<BV>::serialize_blocks(const bvector_type& bv_old,
+                                            const bvector_type& bv_new,
+                                            const bvector_type& bv_blocks,
+                                            buffer_type& buf)
+{
+    stat_.reset();
+    const typename bvector_type::blocks_manager_type& bman_o =
+                                            bv_old.get_blocks_manager();
+    const typename bvector_type::blocks_manager_type& bman_n =
+                                            bv_new.get_blocks_manager();
+    typename bvector_type::enumerator en = bv_blocks.first();
+    for (; en.valid(); ++en)
+    {
+        block_idx_type nb = block_idx_type(*en);
+        unsigned i, j;
+        bm::get_block_coord(nb, i, j);
+        encode_block(nb, bman_o.get_block(i, j), bman_n.get_block(i, j));
+    } // for en
+    serialize_parts(bv_new, buf);
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_serializer<BV>::serialize_parts(const bvector_type& bv_new,
+                                           buffer_type& buf)
+{
+    serialize_part(bv_idx_, buf_idx_);
+    serialize_part(bv_repl_, buf_repl_);
+    serialize_part(bv_xor_, buf_xor_);
+    bv_idx_.clear(true); bv_repl_.clear(true); bv_xor_.clear(true);
+
+    size_t total = 2 + 8 * 4 +
+                   buf_idx_.size() + buf_repl_.size() + buf_xor_.size();
+    buf.resize(total);
+    bm::encoder enc(buf.data(), buf.capacity());
+    enc.put_8('D');
+    enc.put_8(1); // version
+    enc.put_64(bm::id64_t(bv_new.size()));
+    enc.put_64(bm::id64_t(buf_idx_.size()));
+    enc.memcpy(buf_idx_.buf(), buf_idx_.size());
+    enc.put_64(bm::id64_t(buf_repl_.size()));
+    enc.memcpy(buf_repl_.buf(), buf_repl_.size());
+    enc.put_64(bm::id64_t(buf_xor_.size()));
+    enc.memcpy(buf_xor_.buf(), buf_xor_.size());
+    BM_ASSERT(enc.size() == total);
+}
+
+//---------------------------------------------------------------------
+//---------------------------------------------------------------------
+
+template<typename BV>
+void delta_deserializer<BV>::throw_bad_format()
+{
+#ifndef BM_NO_STL
+    throw std::logic_error(err_msg());
+#else
+    BM_THROW(BM_ERR_SERIALFORMAT);
+#endif
+}
+
+//---------------------------------------------------------------------
+
+template<typename BV>
+size_t delta_deserializer<BV>::apply(bvector_type& bv,
+                                     const unsigned char* buf)
+{
+    BM_ASSERT(buf);
+    bm::decoder dec(buf);
+    unsigned char magic = dec.get_8();
+    unsigned char version = dec.get_8();
+    if (magic != 'D' || version != 1)
+        throw_bad_format();
+
+    size_type new_size = size_type(dec.get_64());
+    if (new_size > bv.size())
+        bv.resize(new_size);
+
+    size_t len = size_t(dec.get_64());
+    if (len) // replaced blocks: clear first
+    {
+        bvector_type bv_idx;
+        bm::deserialize(bv_idx, dec.get_pos());
+        typename bvector_type::enumerator en = bv_idx.first();
+        for (; en.valid(); ++en)
+        {
+            size_type from = size_type(*en) << bm::set_block_shift;
+            size_type to = from + (bm::gap_max_bits - 1);
+            if (to >= bm::id_max)
+                to = bm::id_max - 1;
+            bv.set_range(from, to, false);
+        } // for en
+        dec.set_pos(dec.get_pos() + len); // size_t offset (parts may be > 2GB)
+    }
+    len = size_t(dec.get_64());
+    if (len) // replacement content (OR)
+    {
+        bm::deserialize(bv, dec.get_pos());
+        dec.set_pos(dec.get_pos() + len);
+    }
+    len = size_t(dec.get_64());
+    if (len) // XOR patch
+    {
+        bm::operation_deserializer<BV> op_deserial;
+        op_deserial.deserialize(bv, dec.get_pos(), bm::set_XOR);
+        dec.set_pos(dec.get_pos() + len);
+    }
+    if (new_size < bv.size())
+        bv.resize(new_size);
+    return dec.size();
+}
+
+//---------------------------------------------------------------------
+
+
+} // namespace bm
+
+#endif
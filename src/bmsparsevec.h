@@ -938,11 +938,16 @@ protected:
     /// increment by v  without chnaging NULL vector or size
     void inc_no_null(size_type idx, value_type v);
 
+    /// import values into one block of bit-planes (bit transposition)
+    void import_block(const value_type* arr, unsigned arr_size,
+                      block_idx_type nb, unsigned nbit);
+
 protected:
     template<class V, class SV> friend class rsc_sparse_vector;
     template<class SVect> friend class sparse_vector_scanner;
     template<class SVect> friend class sparse_vector_serializer;
     template<class SVect> friend class sparse_vector_deserializer;
+    template<class SVect> friend class import_plan_builder;
 
 
 };
@@ -1030,12 +1035,6 @@ void sparse_vector<Val, BV>::import(const value_type* arr,
                                     size_type         offset,
                                     bool              set_not_null)
 {
-    unsigned char b_list[sizeof(Val)*8];
-    unsigned row_len[sizeof(Val)*8] = {0, };
-    
-    const unsigned transpose_window = 256;
-    bm::tmatrix<size_type, sizeof(Val)*8, transpose_window> tm; // matrix accumulator
-    
     if (arr_size == 0)
         throw_range_error("sparse_vector range error (import size 0)");
     
@@ -1045,52 +1044,24 @@ void sparse_vector<Val, BV>::import(const value_type* arr,
         this->clear_range(offset, offset + arr_size - 1);
     }
     
-    // transposition algorithm uses bitscan to find index bits and store it
-    // in temporary matrix (list for each bit plane), matrix here works
-    // when array gets to big - the list gets loaded into bit-vector using
-    // bulk load algorithm, which is faster than single bit access
+    // transposition algorithm works block by block: each run of 32 values
+    // gets transposed into bit-plane words (SIMD kernel when available)
+    // and OR-ed directly into bit-blocks of the planes
     //
-    
-    size_type i;
-    for (i = 0; i < arr_size; ++i)
+    for (size_type i = 0; i < arr_size; )
     {
-        unsigned bcnt = bm::bitscan(arr[i], b_list);
-        const size_type bit_idx = i + offset;
-        
-        for (unsigned j = 0; j < bcnt; ++j)
-        {
-            unsigned p = b_list[j];
-            unsigned rl = row_len[p];
-            tm.row(p)[rl] = bit_idx;
-            row_len[p] = ++rl;
-            
-            if (rl == transpose_window)
-            {
-                bvector_type* bv = this->get_plane(p);
-                const size_type* r = tm.row(p);
-                bv->set(r, rl, BM_SORTED);
-                row_len[p] = 0;
-                tm.row(p)[0] = 0;
-            }
-        } // for j
+        const size_type idx = i + offset;
+        const block_idx_type nb = (idx >> bm::set_block_shift);
+        const unsigned nbit = unsigned(idx & bm::set_block_mask);
+        size_type len = bm::gap_max_bits - nbit;
+        if (len > arr_size - i)
+            len = arr_size - i;
+        import_block(arr + i, unsigned(len), nb, nbit);
+        i += len;
     } // for i
     
-    // process incomplete transposition lines
-    //
-    for (unsigned k = 0; k < tm.rows(); ++k)
-    {
-        unsigned rl = row_len[k];
-        if (rl)
-        {
-            bvector_type* bv = this->get_plane(k);
-            const size_type* r = tm.row(k);
-            bv->set(r, rl, BM_SORTED);
-        }
-    } // for k
-    
-    
-    if (i + offset > this->size_)
-        this->size_ = i + offset;
+    if (offset + arr_size > this->size_)
+        this->size_ = offset + arr_size;
     
     if (set_not_null)
     {
@@ -1102,6 +1073,36 @@ void sparse_vector<Val, BV>::import(const value_type* arr,
 
 //---------------------------------------------------------------------
 
+template<class Val, class BV>
+void sparse_vector<Val, BV>::import_block(const value_type* arr,
+                                          unsigned          arr_size,
+                                          block_idx_type    nb,
+                                          unsigned          nbit)
+{
+    BM_ASSERT(arr_size && (nbit + arr_size) <= bm::gap_max_bits);
+
+    value_type acc = 0; // OR of all values: planes with any bits set
+    for (unsigned i = 0; i < arr_size; ++i)
+        acc |= arr[i];
+    if (!acc)
+        return;
+
+    bm::word_t* planes[sizeof(Val)*8];
+    unsigned n = 0;
+    for (unsigned j = 0; j < sizeof(Val)*8; ++j)
+    {
+        planes[j] = 0;
+        if (!((acc >> j) & 1u))
+            continue;
+        n = j + 1;
+        this->get_plane(j);
+        planes[j] = this->bmatr_.check_allocate_bit_block(j, nb);
+    } // for j
+    bm::bit_block_planes_encode(planes, n, nbit, arr, arr_size);
+}
+
+//---------------------------------------------------------------------
+
 template<class Val, class BV>
 void sparse_vector<Val, BV>::sync_size() BMNOEXCEPT
 {
@@ -1171,7 +1172,8 @@ sparse_vector<Val, BV>::gather(value_type*       arr,
                 size_type idx_prev = idx[r];
                 for (; (r < size) && (nb == (idx[r] >> bm::set_block_shift)); ++r)
                 {
-                    sorted_block = !(idx[r] < idx_prev); // sorted check
+                    if (idx[r] < idx_prev) // sorted check
+                        sorted_block = false;
                     idx_prev = idx[r];
                 }
             }
@@ -1315,7 +1317,8 @@ sparse_vector<Val, BV>::extract_range(value_type* arr,
     const bm::word_t* blk = 0;
     unsigned is_set;
     
-    for (unsigned j = 0; j < sizeof(Val)*8; ++j)
+    unsigned eff_planes = this->effective_planes();
+    for (unsigned j = 0; j < eff_planes; ++j)
     {
         blk = this->bmatr_.get_block(j, i0, j0);
         bool is_gap = BM_IS_GAP(blk);
@@ -1385,7 +1388,8 @@ sparse_vector<Val, BV>::extract_planes(value_type* arr,
         end = this->size_;
     }
     
-    for (size_type i = 0; i < parent_type::value_bits(); ++i)
+    unsigned eff_planes = this->effective_planes();
+    for (unsigned i = 0; i < eff_planes; ++i)
     {
         const bvector_type* bv = this->bmatr_.get_row(i);
         if (!bv)
@@ -1463,14 +1467,108 @@ sparse_vector<Val, BV>::extract(value_type* BMRESTRICT arr,
 
     sv_decode_visitor_func func(arr, 0, offset);
 
-    for (size_type i = 0; i < parent_type::value_bits(); ++i)
+    unsigned eff_planes = this->effective_planes();
+    if (eff_planes > bm::bit_planes_decode_max) // wide values: plane by plane
+    {
+        for (unsigned i = 0; i < eff_planes; ++i)
+        {
+            const bvector_type* bv = this->bmatr_.get_row(i);
+            if (!bv)
+                continue;
+            func.mask_ = (value_type(1) << i); // set target plane OR mask
+            bm::for_each_bit_range_no_check(*bv, offset, end-1, func);
+        } // for i
+        return end - offset;
+    }
+
+    // narrow values: block by block reverse transposition of bit-blocks
+    // using kernels specialized for the number of planes
+    //
+    const bm::word_t* blks[bm::bit_planes_decode_max];
+    bm::word_t        masks[bm::bit_planes_decode_max];
+    value_type        tmp_arr[32];
+
+    block_idx_type nb_from = (offset >> bm::set_block_shift);
+    block_idx_type nb_to = ((end-1) >> bm::set_block_shift);
+    for (block_idx_type nb = nb_from; nb <= nb_to; ++nb)
     {
-        const bvector_type* bv = this->bmatr_.get_row(i);
-        if (!bv)
+        unsigned i0, j0;
+        bm::get_block_coord(nb, i0, j0);
+        unsigned n = 0;
+        bool is_bit = true; // all planes of the block are bit-blocks
+        for (unsigned j = 0; j < eff_planes; ++j)
+        {
+            const bm::word_t* blk = this->bmatr_.get_block(j, i0, j0);
+            if (blk)
+            {
+                n = j + 1;
+                is_bit &= !BM_IS_GAP(blk);
+                blks[j] = BLOCK_ADDR_SAN(blk);
+                masks[j] = ~0u;
+            }
+            else
+            {
+                blks[j] = FULL_BLOCK_REAL_ADDR; // any valid block to read
+                masks[j] = 0u;
+            }
+        } // for j
+        if (!n)
             continue;
-        func.mask_ = (value_type(1) << i); // set target plane OR mask
-        bm::for_each_bit_range_no_check(*bv, offset, end-1, func);
-    } // for i
+
+        size_type block_offset = size_type(nb) * bm::bits_in_block;
+        unsigned left = (nb == nb_from) ?
+                        unsigned(offset & bm::set_block_mask) : 0u;
+        unsigned right = (nb == nb_to) ?
+                        unsigned((end-1) & bm::set_block_mask) :
+                        bm::bits_in_block-1;
+        if (!is_bit)
+        {
+            for (unsigned j = 0; j < n; ++j)
+            {
+                if (!masks[j])
+                    continue;
+                func.mask_ = (value_type(1) << j);
+                if (BM_IS_GAP(blks[j]))
+                    bm::for_each_gap_blk_range(BMGAP_PTR(blks[j]),
+                                        block_offset, left, right, func);
+                else
+                    bm::for_each_bit_blk(blks[j],
+                                        block_offset, left, right, func);
+            } // for j
+            continue;
+        }
+
+        // arr_l[k] is a target for block bit (left + k)
+        value_type* arr_l = arr + (block_offset + left - offset);
+        unsigned nw_from = left >> bm::set_word_shift;
+        unsigned nw_to = right >> bm::set_word_shift;
+        unsigned lbit = left & bm::set_word_mask;
+        unsigned rbit = right & bm::set_word_mask;
+
+        unsigned nw = nw_from;
+        if (lbit) // unaligned head word
+        {
+            bm::bit_block_planes_decode(n, blks, masks, nw, nw+1, tmp_arr);
+            unsigned to = (nw_from == nw_to) ? rbit : 31u;
+            for (unsigned k = lbit; k <= to; ++k)
+                arr_l[k - lbit] = tmp_arr[k];
+            if (nw_from == nw_to)
+                continue;
+            ++nw;
+        }
+        unsigned nw_end = (rbit == 31u) ? nw_to + 1 : nw_to;
+        if (nw < nw_end)
+            bm::bit_block_planes_decode(n, blks, masks, nw, nw_end,
+                         arr_l + (nw * 32u - left));
+        if (rbit != 31u) // unaligned tail word
+        {
+            bm::bit_block_planes_decode(n, blks, masks,
+                                        nw_to, nw_to+1, tmp_arr);
+            value_type* arr_t = arr_l + (nw_to * 32u - left);
+            for (unsigned k = 0; k <= rbit; ++k)
+                arr_t[k] = tmp_arr[k];
+        }
+    } // for nb
     return end - offset;
 }
 
@@ -27,6 +27,8 @@ For more information please visit:  http://bitmagic.io
 # error missing include (bm.h or bm64.h)
 #endif
 
+#include <algorithm>
+
 #include "bmdef.h"
 #include "bmsparsevec.h"
 #include "bmaggregator.h"
@@ -762,8 +764,25 @@ protected:
     /// Rank-Select decompression for RSC vectors
     void decompress(const SV&   sv, typename SV::bvector_type& bv_out);
 
-    /// compare sv[idx] with input str
-    int compare_str(const SV& sv, size_type idx, const value_type* str);
+    /// compare sv[idx] with input str (zero padded, see pad_str())
+    /// skipping the known common prefix
+    int compare_str(const SV& sv, size_type idx, const value_type* str,
+                    unsigned& prefix_len);
+
+    /// copy search string into a zero padded buffer (SIMD compare)
+    const value_type* pad_str(const value_type* str) BMNOEXCEPT;
+
+    /// narrow down sorted vector lower bound range [l, r]
+    /// using the cache of sampled elements (see bind()),
+    /// computes common prefixes of str with vect[l-1] and vect[r]
+    void narrow_str_range(const value_type* str,
+                          size_type& l, size_type& r,
+                          unsigned& l_prefix,
+                          unsigned& r_prefix) const BMNOEXCEPT;
+
+    /// lower bound search in sorted vector (str is zero padded)
+    bool lower_bound_str_padded(const SV& sv, const value_type* str,
+                                size_type& pos);
 
     /// compare sv[idx] with input value
     int compare(const SV& sv, size_type idx, const value_type val) BMNOEXCEPT;
@@ -776,20 +795,19 @@ protected:
 
     enum vector_capacity
     {
-        max_columns = SV::max_vector_size
+        max_columns = SV::max_vector_size,
+        max_padded_columns = ((max_columns + bm::str_cmp_pad - 1) /
+                                    bm::str_cmp_pad) * bm::str_cmp_pad
     };
     
     enum search_algo_params
     {
         linear_cutoff1 = 16,
-        linear_cutoff2 = 128
+        linear_cutoff2 = 128,
+        str_sample_shift = bm::set_block_digest_pos_shift ///< 1024 elements
     };
 
     typedef bm::dynamic_heap_matrix<value_type, allocator_type> heap_matrix_type;
-    typedef bm::heap_matrix<typename SV::value_type,
-                           linear_cutoff2,
-                           SV::sv_octet_planes,
-                           allocator_type> matrix_search_buf_type;
 
 
 private:
@@ -803,14 +821,13 @@ private:
     bool                               mask_set_;
     
     const SV*                          bound_sv_;
-    heap_matrix_type                   block0_elements_cache_; ///< cache for elements[0] of each block
-    heap_matrix_type                   block3_elements_cache_; ///< cache for elements[16384x] of each block
+    heap_matrix_type                   str_samples_cache_; ///< cache for elements[1024x] (sorted vector sparse index)
     size_type                          effective_str_max_;
     
     value_type                         remap_value_vect_[SV::max_vector_size];
+    value_type                         padded_str_[max_padded_columns]; ///< search string (zero padded)
     /// masks of allocated bit-planes (1 - means there is a bit-plane)
     bm::id64_t                         vector_plane_masks_[SV::max_vector_size];
-    matrix_search_buf_type             hmatr_; ///< heap matrix for string search linear stage
 };
 
 
@@ -940,6 +957,135 @@ protected:
 };
 
 
+/**
+    \brief Sort (argsort) of a sparse vector using radix over bit-planes
+
+    Sorter computes the sorted permutation of sparse vector indexes
+    (argsort) without full decode of the vector. Bit-planes are used as
+    MSB-first radix partitions: each partition (row bit-vector) gets split
+    by AND/SUB with the next bit-plane. Once partition becomes small
+    (spill size) it is decoded with gather and sorted in memory.
+
+    Sort is stable (equal values keep the order of indexes), values are
+    compared as unsigned integers. NULL (unassigned) elements are placed
+    at the end of the permutation (NULLs last).
+
+    Works with bm::sparse_vector<> (not compressed vectors).
+
+    @ingroup svalgo
+*/
+template<typename SV>
+class sparse_vector_sorter
+{
+public:
+    typedef typename SV::bvector_type       bvector_type;
+    typedef typename SV::value_type         value_type;
+    typedef typename SV::size_type          size_type;
+
+    typedef typename bvector_type::allocator_type        allocator_type;
+    typedef typename allocator_type::allocator_pool_type allocator_pool_type;
+
+    enum sorter_params
+    {
+        default_spill_size = 4096
+    };
+
+public:
+    sparse_vector_sorter();
+
+    /**
+        \brief Set partition size to switch from bit-plane radix
+               partitioning to decode and sort
+        \param spill_size - partition size threshold (number of elements)
+    */
+    void set_spill_size(size_type spill_size);
+
+    /**
+        \brief Iterate indexes of the sparse vector in sorted order
+
+        Visitor receives the sorted permutation as a series of
+        index arrays (in order).
+
+        \param sv - input sparse vector
+        \param func - visitor: should support add(const size_type*, size_type)
+    */
+    template<class Func>
+    void for_each_sorted(const SV& sv, Func& func);
+
+    /**
+        \brief Compute sorted permutation (argsort) into a C-style array
+
+        For efficiency, this is a low level function, it does not do
+        any bounds checking on the target array
+        (array should be sv.size() long).
+
+        \param sv - input sparse vector
+        \param idx_arr - [out] permutation of sparse vector indexes
+
+        \return number of exported indexes (sv.size())
+    */
+    size_type argsort(const SV& sv, size_type* idx_arr);
+
+    /**
+        \brief Compute sorted permutation (argsort) into a sparse vector
+        \param sv - input sparse vector
+        \param sv_perm - [out] permutation vector of sparse vector indexes
+                         (sorted permutation gets appended to it)
+    */
+    template<class SV_IDX>
+    void argsort(const SV& sv, SV_IDX& sv_perm);
+
+protected:
+    /// recursive radix partition on bit-planes (MSB first)
+    template<class Func>
+    void partition(const SV&      sv,
+                   bvector_type&  bv,
+                   size_type      cnt,
+                   int            plane,
+                   Func&          func);
+
+    /// decode and sort partition of elements (block-local spill)
+    template<class Func>
+    void sort_partition(const SV&           sv,
+                        const bvector_type& bv,
+                        size_type           cnt,
+                        Func&               func);
+
+    /// output all indexes of a partition of equal values (in order)
+    template<class Func>
+    void emit_partition(const bvector_type& bv, Func& func);
+
+protected:
+    sparse_vector_sorter(const sparse_vector_sorter&) = delete;
+    void operator=(const sparse_vector_sorter&) = delete;
+
+protected:
+    /// @internal
+    struct value_idx_pair
+    {
+        value_type v;
+        size_type  idx;
+
+        bool operator<(const value_idx_pair& p) const BMNOEXCEPT
+        {
+            return (v < p.v) || ((v == p.v) && (idx < p.idx));
+        }
+    };
+    typedef bm::heap_vector<size_type, allocator_type, true>  idx_vector_type;
+    typedef bm::heap_vector<value_type, allocator_type, true> value_vector_type;
+    typedef
+    bm::heap_vector<value_idx_pair, allocator_type, true> pair_vector_type;
+
+private:
+    allocator_pool_type   pool_;
+    size_type             spill_size_;  ///< partition size to decode-sort
+    idx_vector_type       idx_buf_;     ///< index buffer
+    value_vector_type     value_buf_;   ///< gather values buffer
+    pair_vector_type      pair_buf_;    ///< sort buffer
+};
+
+
+
 
 //----------------------------------------------------------------------------
 //
@@ -1166,6 +1312,7 @@ sparse_vector_scanner<SV>::sparse_vector_scanner()
 
     bound_sv_ = 0;
     effective_str_max_ = 0;
+    str_samples_cache_.resize(0, 0);
 }
 
 //----------------------------------------------------------------------------
@@ -1174,33 +1321,26 @@ template<typename SV>
 void sparse_vector_scanner<SV>::bind(const SV&  sv, bool sorted)
 {
     bound_sv_ = &sv;
-    if (sorted)
-    {
-        size_type sv_sz = sv.size();
-        BM_ASSERT(sv_sz);
-        size_type total_nb = sv_sz / bm::gap_max_bits + 1;
-        effective_str_max_ = sv.effective_vector_max();
-
-        block0_elements_cache_.resize(total_nb, effective_str_max_+1);
-        block0_elements_cache_.set_zero();
-
-        block3_elements_cache_.resize(total_nb * 3, effective_str_max_+1);
-        block3_elements_cache_.set_zero();
-        
-        // fill in elements cache
-        for (size_type i = 0; i < sv_sz; i+= bm::gap_max_bits)
+    str_samples_cache_.resize(0, 0); // drop samples of a previous binding
+    effective_str_max_ = sv.effective_vector_max();
+    size_type sv_sz = sv.size();
+    if (sorted && sv_sz)
+    {
+        size_type total_s = ((sv_sz - 1) >> str_sample_shift) + 1;
+        size_type cols = ((effective_str_max_ + bm::str_cmp_pad) /
+                                    bm::str_cmp_pad) * bm::str_cmp_pad;
+        if (cols > size_type(max_padded_columns))
+            cols = size_type(max_padded_columns);
+
+        str_samples_cache_.resize(total_s, cols);
+        str_samples_cache_.set_zero();
+
+        // fill in elements cache (zero padded for SIMD compare)
+        for (size_type k = 0; k < total_s; ++k)
         {
-            size_type nb = (i >> bm::set_block_shift);
-            value_type* s0 = block0_elements_cache_.row(nb);
-            sv.get(i, s0, size_type(block0_elements_cache_.cols()));
-            
-            for (size_type k = 0; k < 3; ++k)
-            {
-                value_type* s1 = block3_elements_cache_.row(nb * 3 + k);
-                size_type idx = i + (k+1) * bm::sub_block3_size;
-                sv.get(idx, s1, size_type(block3_elements_cache_.cols()));
-            } // for k
-        } // for i
+            value_type* s0 = str_samples_cache_.row(k);
+            sv.get(k << str_sample_shift, s0, cols);
+        } // for k
     }
     // pre-calculate vector plane masks
     //
@@ -1713,122 +1853,19 @@ bool sparse_vector_scanner<SV>::bfind_eq_str(const SV&                      sv,
 
     if (*str)
     {
-        bool remaped = false;
         // test search pre-condition based on remap tables
         if (bm::conditional<SV::is_remap_support::value>::test())
         {
             if (sv.is_remap() && str != remap_value_vect_)
             {
-                remaped = sv.remap_tosv(
+                bool remaped = sv.remap_tosv(
                                 remap_value_vect_, SV::max_vector_size, str);
                 if (!remaped)
                     return remaped;
             }
         }
-        
-        reset_search_range();
-        
-        // narrow down the search
-        const unsigned min_distance_cutoff = bm::gap_max_bits + bm::gap_max_bits / 2;
-        size_type l, r, dist;
-        l = 0; r = sv.size()-1;
         size_type found_pos;
-        
-        // binary search to narrow down the search window
-        while (l <= r)
-        {
-            dist = r - l;
-            if (dist < min_distance_cutoff)
-            {
-                // we are in an narrow <2 blocks window, but still may be in two
-                // different neighboring blocks, lets try to narrow
-                // to exactly one block
-                
-                size_type nb_l = (l >> bm::set_block_shift);
-                size_type nb_r = (r >> bm::set_block_shift);
-                if (nb_l != nb_r)
-                {
-                    size_type mid = nb_r * bm::gap_max_bits;
-                    if (mid < r)
-                    {
-                        int cmp = this->compare_str(sv, mid, str);
-                        if (cmp < 0) // mid < str
-                            l = mid;
-                        else
-                            r = mid-(cmp!=0); // branchless if (cmp==0) r=mid;
-                        BM_ASSERT(l < r);
-                    }
-                    nb_l = unsigned(l >> bm::set_block_shift);
-                    nb_r = unsigned(r >> bm::set_block_shift);
-                }
-                
-                if (nb_l == nb_r)
-                {
-                    size_type max_nb = sv.size() >> bm::set_block_shift;
-                    if (nb_l != max_nb)
-                    {
-                        // linear in-place fixed depth scan to identify the sub-range
-                        size_type mid = nb_r * bm::gap_max_bits + bm::sub_block3_size;
-                        int cmp = this->compare_str(sv, mid, str);
-                        if (cmp < 0)
-                        {
-                            l = mid;
-                            mid = nb_r * bm::gap_max_bits + bm::sub_block3_size * 2;
-                            cmp = this->compare_str(sv, mid, str);
-                            if (cmp < 0)
-                            {
-                                l = mid;
-                                mid = nb_r * bm::gap_max_bits + bm::sub_block3_size * 3;
-                                cmp = this->compare_str(sv, mid, str);
-                                if (cmp < 0)
-                                    l = mid;
-                                else
-                                    r = mid;
-                            }
-                            else
-                            {
-                                r = mid;
-                            }
-                        }
-                        else
-                        {
-                            r = mid;
-                        }
-                    }
-                }
-                
-                set_search_range(l, r);
-                break;
-            }
-
-            typename SV::size_type mid = dist/2+l;
-            size_type nb = (mid >> bm::set_block_shift);
-            mid = nb * bm::gap_max_bits;
-            if (mid <= l)
-            {
-                if (nb == 0 && r > bm::gap_max_bits)
-                    mid = bm::gap_max_bits;
-                else
-                    mid = dist / 2 + l;
-            }
-            BM_ASSERT(mid > l);
-
-            int cmp = this->compare_str(sv, mid, str);
-            if (cmp == 0)
-            {
-                found_pos = mid;
-                found = true;
-                set_search_range(l, mid);
-                break;
-            }
-            if (cmp < 0)
-                l = mid+1;
-            else
-                r = mid-1;
-        } // while
-
-        // use linear search (range is set)
-        found = find_first_eq(sv, str, found_pos, remaped);
+        found = lower_bound_str_padded(sv, pad_str(str), found_pos);
         if (found)
         {
             pos = found_pos;
@@ -1838,7 +1875,6 @@ bool sparse_vector_scanner<SV>::bfind_eq_str(const SV&                      sv,
                     found = sv.find_rank(found_pos + 1, pos);
             }
         }
-        reset_search_range();
     }
     else // search for zero value
     {
@@ -1988,125 +2024,111 @@ bool sparse_vector_scanner<SV>::lower_bound_str(
                                         const typename SV::value_type* str,
                                         typename SV::size_type&        pos)
 {
-    int cmp;
-    size_type l = 0, r = sv.size();
-    
-    if (l == r) // empty vector
+    return lower_bound_str_padded(sv, pad_str(str), pos);
+}
+
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+const typename SV::value_type*
+sparse_vector_scanner<SV>::pad_str(const value_type* str) BMNOEXCEPT
+{
+    BM_ASSERT(str);
+    unsigned i = 0;
+    for (; i < unsigned(max_columns) && str[i]; ++i)
+        padded_str_[i] = str[i];
+    for (; i < unsigned(max_padded_columns); ++i)
+        padded_str_[i] = 0;
+    return padded_str_;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+void sparse_vector_scanner<SV>::narrow_str_range(const value_type* str,
+                                                 size_type& l,
+                                                 size_type& r,
+                                                 unsigned& l_prefix,
+                                                 unsigned& r_prefix) const BMNOEXCEPT
+{
+    BM_ASSERT(l == 0 && r);
+    const unsigned cols = unsigned(str_samples_cache_.cols());
+    size_type total_s = ((r - 1) >> str_sample_shift) + 1;
+    if (total_s > str_samples_cache_.rows())
+        total_s = str_samples_cache_.rows();
+
+    // binary search in the cached samples (first sample >= str)
+    size_type lo = 0, hi = total_s;
+    while (lo < hi)
+    {
+        size_type mid = (hi - lo) / 2 + lo;
+        int cmp = bm::str_cmp_padded(str_samples_cache_.row(mid), str, cols);
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    } // while
+    if (!lo) // vect[0] >= str
     {
-        pos = 0;
-        return false;
+        r = 0;
+        return;
     }
-    --r;
-    
-    // check initial boundary conditions if insert point is at tail/head
-    cmp = this->compare_str(sv, l, str); // left (0) boundary check
-    if (cmp > 0) // vect[x] > str
+    l = ((lo - 1) << str_sample_shift) + 1;
+    l_prefix = bm::str_common_prefix(str_samples_cache_.row(lo - 1), str, cols);
+    if (lo < total_s)
     {
-        pos = 0;
-        return false;
+        r = lo << str_sample_shift;
+        r_prefix = bm::str_common_prefix(str_samples_cache_.row(lo), str, cols);
     }
-    if (cmp == 0)
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+bool sparse_vector_scanner<SV>::lower_bound_str_padded(
+                                        const SV&  sv,
+                                        const typename SV::value_type* str,
+                                        typename SV::size_type&        pos)
+{
+    // lower bound is in [l, r], vect[r] >= str (or r == size)
+    size_type l = 0, r = sv.size();
+    if (!r) // empty vector
     {
         pos = 0;
-        return true;
-    }
-    cmp = this->compare_str(sv, r, str); // right(size-1) boundary check
-    if (cmp == 0)
-    {
-        pos = r;
-        // back-scan to rewind all duplicates
-        // TODO: adapt one-sided binary search to traverse large platos
-        for (; r >= 0; --r)
-        {
-            cmp = this->compare_str(sv, r, str);
-            if (cmp != 0)
-                return true;
-            pos = r;
-        } // for i
-        return true;
-    }
-    if (cmp < 0) // vect[x] < str
-    {
-        pos = r+1;
         return false;
     }
-    
-    size_type dist = r - l;
-    if (dist < linear_cutoff1)
-    {
-        for (; l <= r; ++l)
-        {
-            cmp = this->compare_str(sv, l, str);
-            if (cmp == 0)
-            {
-                pos = l;
-                return true;
-            }
-            if (cmp > 0)
-            {
-                pos = l;
-                return false;
-            }
-        } // for
-    }
-    while (l <= r)
-    {
-        size_type mid = (r-l)/2+l;
-        cmp = this->compare_str(sv, mid, str);
-        if (cmp == 0)
+    // binary search, elements in [l, r) share with str
+    // min(l_prefix, r_prefix) chars (prefix of vect[l-1], vect[r])
+    unsigned l_prefix = 0, r_prefix = 0;
+    if (bound_sv_ == &sv && str_samples_cache_.rows())
+        narrow_str_range(str, l, r, l_prefix, r_prefix);
+    int r_cmp = 1; // vect[r] vs str (1 - not yet compared)
+    bool r_known = false;
+    while (l < r)
+    {
+        size_type mid = (r - l) / 2 + l;
+        unsigned prefix_len = (l_prefix < r_prefix) ? l_prefix : r_prefix;
+        int cmp = this->compare_str(sv, mid, str, prefix_len);
+        if (cmp < 0)
         {
-            pos = mid;
-            // back-scan to rewind all duplicates
-            for (size_type i = mid-1; i >= 0; --i)
-            {
-                cmp = this->compare_str(sv, i, str);
-                if (cmp != 0)
-                    return true;
-                pos = i;
-            } // for i
-            pos = 0;
-            return true;
+            l = mid + 1;
+            l_prefix = prefix_len;
         }
-        if (cmp < 0)
-            l = mid+1;
         else
-            r = mid-1;
-
-        dist = r - l;
-        if (dist < linear_cutoff2) // do linear scan here
         {
-            hmatr_.init();
-            
-            dist = sv.decode(hmatr_, l, dist+1);
-            for (unsigned i = 0; i < dist; ++i, ++l)
-            {
-                const typename SV::value_type* hm_str = hmatr_.row(i);
-                cmp = ::strcmp(hm_str, str);
-                if (cmp == 0)
-                {
-                    pos = l;
-                    return true;
-                }
-                if (cmp > 0) // vect[x] > str
-                {
-                    pos = l;
-                    return false;
-                }
-            }
-            cmp = this->compare_str(sv, l, str);
-            if (cmp > 0) // vect[x] > str
-            {
-                pos = l;
-                return false;
-            }
-            BM_ASSERT(0);
-            pos = l;
-            return false;
+            r = mid;
+            r_prefix = prefix_len;
+            r_cmp = cmp;
+            r_known = true;
         }
     } // while
-    
-    BM_ASSERT(0);
-    return false;
+    pos = r;
+    if (r == sv.size())
+        return false;
+    if (!r_known)
+        r_cmp = this->compare_str(sv, r, str, r_prefix);
+    return !r_cmp;
 }
 
 
@@ -2115,51 +2137,18 @@ bool sparse_vector_scanner<SV>::lower_bound_str(
 template<typename SV>
 int sparse_vector_scanner<SV>::compare_str(const SV& sv,
                                            size_type idx,
-                                           const value_type* str)
+                                           const value_type* str,
+                                           unsigned& prefix_len)
 {
-    if (bound_sv_ == &sv)
+    if (bound_sv_ == &sv &&
+        !(idx & ((size_type(1) << str_sample_shift) - 1))) // sample element
     {
-        size_type nb = (idx >> bm::set_block_shift);
-        size_type nbit = (idx & bm::set_block_mask);
-        if (nbit == 0) // access to sentinel, first block element
-        {
-            value_type* s0 = block0_elements_cache_.row(nb);
-            if (*s0 == 0) // uninitialized element
-            {
-                sv.get(idx, s0, size_type(block0_elements_cache_.cols()));
-            }
-            int res = 0;
-            for (unsigned i = 0; i < block0_elements_cache_.cols(); ++i)
-            {
-                char octet = str[i]; char value = s0[i];
-                res = (value > octet) - (value < octet);
-                if (res || !octet)
-                    break;
-            } // for i
-
-            //BM_ASSERT(res == sv.compare(idx, str));
-            return res;
-        }
-        else
-        {
-            if (nbit % bm::sub_block3_size == 0) // TODO: use AND mask here
-            {
-                size_type k = nbit / bm::sub_block3_size - 1;
-                value_type* s1 = block3_elements_cache_.row(nb * 3 + k);
-                int res = 0;
-                for (unsigned i = 0; i < block3_elements_cache_.cols(); ++i)
-                {
-                    char octet = str[i]; char value = s1[i];
-                    res = (value > octet) - (value < octet);
-                    if (res || !octet)
-                        break;
-                } // for i
-                //BM_ASSERT(res == sv.compare(idx, str));
-                return res;
-            }
-        }
+        size_type k = (idx >> str_sample_shift);
+        if (k < str_samples_cache_.rows())
+            return bm::str_cmp_padded(str_samples_cache_.row(k), str,
+                                      unsigned(str_samples_cache_.cols()));
     }
-    return sv.compare(idx, str);
+    return sv.compare(idx, str, prefix_len);
 }
 
 //----------------------------------------------------------------------------
@@ -2280,6 +2269,209 @@ void sparse_vector_scanner<SV>::reset_search_range()
 //
 //----------------------------------------------------------------------------
 
+template<typename SV>
+sparse_vector_sorter<SV>::sparse_vector_sorter()
+: spill_size_(default_spill_size)
+{}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+void sparse_vector_sorter<SV>::set_spill_size(size_type spill_size)
+{
+    BM_ASSERT(spill_size);
+    spill_size_ = spill_size ? spill_size : 1;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+template<class Func>
+void sparse_vector_sorter<SV>::for_each_sorted(const SV& sv, Func& func)
+{
+    BM_ASSERT(!sv.is_compressed());
+    size_type sz = sv.size();
+    if (!sz)
+        return;
+
+    idx_buf_.resize(spill_size_);
+    value_buf_.resize(spill_size_);
+    pair_buf_.resize(spill_size_);
+
+    bvector_type bv_rows;
+    typename bvector_type::mem_pool_guard mp_guard(pool_, bv_rows);
+
+    const bvector_type* bv_null = sv.get_null_bvector();
+    if (bv_null)
+    {
+        bv_rows = *bv_null;
+        bv_rows.keep_range(0, sz-1);
+    }
+    else
+        bv_rows.set_range(0, sz-1);
+
+    size_type cnt = bv_rows.count();
+    partition(sv, bv_rows, cnt, int(sv.effective_planes())-1, func);
+
+    if (cnt < sz) // NULLs last
+    {
+        bv_rows.clear(true);
+        bv_rows.set_range(0, sz-1);
+        bv_rows.bit_sub(*bv_null);
+        emit_partition(bv_rows, func);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+template<class Func>
+void sparse_vector_sorter<SV>::partition(const SV&      sv,
+                                         bvector_type&  bv,
+                                         size_type      cnt,
+                                         int            plane,
+                                         Func&          func)
+{
+    BM_ASSERT(cnt == bv.count());
+    if (!cnt)
+        return;
+    for (; plane >= 0; --plane)
+    {
+        if (cnt <= spill_size_)
+        {
+            sort_partition(sv, bv, cnt, func);
+            return;
+        }
+        const bvector_type* bv_plane = sv.get_plane(unsigned(plane));
+        if (!bv_plane)
+            continue;
+        size_type cnt_hi = bm::count_and(bv, *bv_plane);
+        if (!cnt_hi || cnt_hi == cnt) // plane does not split the partition
+            continue;
+
+        bvector_type bv_hi;
+        typename bvector_type::mem_pool_guard mp_guard(pool_, bv_hi);
+        bv_hi.bit_and(bv, *bv_plane, bvector_type::opt_none);
+        bv.bit_sub(*bv_plane);  // bv becomes the low (0) partition
+
+        partition(sv, bv, cnt - cnt_hi, plane-1, func);
+        partition(sv, bv_hi, cnt_hi, plane-1, func);
+        return;
+    } // for plane
+
+    // all planes exhausted: partition of equal values
+    emit_partition(bv, func);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+template<class Func>
+void sparse_vector_sorter<SV>::sort_partition(const SV&           sv,
+                                              const bvector_type& bv,
+                                              size_type           cnt,
+                                              Func&               func)
+{
+    BM_ASSERT(cnt && cnt <= spill_size_);
+    size_type* idx = idx_buf_.data();
+    value_type* vals = value_buf_.data();
+
+    size_type i = 0;
+    typename bvector_type::enumerator en = bv.first();
+    for (; en.valid(); ++en, ++i)
+    {
+        BM_ASSERT(i < cnt);
+        idx[i] = *en;
+    }
+    BM_ASSERT(i == cnt);
+
+    sv.gather(vals, idx, cnt, bm::BM_SORTED);
+
+    value_idx_pair* pairs = pair_buf_.data();
+    for (i = 0; i < cnt; ++i)
+    {
+        pairs[i].v = vals[i];
+        pairs[i].idx = idx[i];
+    }
+    std::sort(pairs, pairs + cnt);
+    for (i = 0; i < cnt; ++i)
+        idx[i] = pairs[i].idx;
+    func.add(idx, cnt);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+template<class Func>
+void sparse_vector_sorter<SV>::emit_partition(const bvector_type& bv,
+                                              Func&               func)
+{
+    size_type* idx = idx_buf_.data();
+    size_type i = 0;
+    typename bvector_type::enumerator en = bv.first();
+    for (; en.valid(); ++en)
+    {
+        idx[i++] = *en;
+        if (i == spill_size_)
+        {
+            func.add(idx, i);
+            i = 0;
+        }
+    } // for en
+    if (i)
+        func.add(idx, i);
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+typename sparse_vector_sorter<SV>::size_type
+sparse_vector_sorter<SV>::argsort(const SV& sv, size_type* idx_arr)
+{
+    /// copy visitor
+    /// @internal
+    struct copy_func
+    {
+        copy_func(size_type* arr) : arr_(arr), pos_(0) {}
+        void add(const size_type* idx, size_type size)
+        {
+            ::memcpy(arr_ + pos_, idx, size * sizeof(size_type));
+            pos_ += size;
+        }
+        size_type* arr_;
+        size_type  pos_;
+    };
+
+    BM_ASSERT(idx_arr);
+    copy_func func(idx_arr);
+    for_each_sorted(sv, func);
+    return func.pos_;
+}
+
+//----------------------------------------------------------------------------
+
+template<typename SV>
+template<class SV_IDX>
+void sparse_vector_sorter<SV>::argsort(const SV& sv, SV_IDX& sv_perm)
+{
+    /// back insert visitor
+    /// @internal
+    struct back_insert_func
+    {
+        back_insert_func(SV_IDX& sv_idx) : bi_(sv_idx.get_back_inserter()) {}
+        void add(const size_type* idx, size_type size)
+        {
+            for (size_type i = 0; i < size; ++i)
+                bi_ = typename SV_IDX::value_type(idx[i]);
+        }
+        typename SV_IDX::back_insert_iterator bi_;
+    };
+
+    back_insert_func func(sv_perm);
+    for_each_sorted(sv, func);
+    func.bi_.flush();
+}
+
 
 } // namespace bm
 
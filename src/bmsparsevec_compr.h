@@ -529,6 +529,34 @@ public:
                          size_type   size,
                          bool        zero_mem = true) const BMNOEXCEPT;
 
+    /**
+        \brief Gather elements to a C-style array
+
+        Gather collects values from different locations, for best
+        performance feed it with sorted list of indexes.
+        Sorted runs of indexes resolve rank incrementally (block by block)
+        without restarting rank-select walk for each element,
+        values are decoded block-at-a-time from the bit-planes.
+        NULL (unassigned) elements are gathered as 0 values.
+
+        \param arr - dest array (must be properly sized)
+        \param idx - index list to gather elements
+        \param idx_tmp_buf - temp buffer for rank translation
+                             (must be same size of idx)
+        \param size - decoding index list size (array allocation should match)
+        \param sorted_idx - sort order directive for the idx array
+                            (BM_UNSORTED, BM_SORTED, BM_UNKNOWN)
+
+        \return number of exported elements
+
+        \sa decode, sync
+     */
+    size_type gather(value_type*       arr,
+                     const size_type*  idx,
+                     size_type*        idx_tmp_buf,
+                     size_type         size,
+                     bm::sort_order    sorted_idx) const;
+
     ///@}
 
     
@@ -1296,10 +1324,7 @@ void rsc_sparse_vector<Val, SV>::optimize(bm::word_t*  temp_block,
     sv_.optimize(temp_block, opt_mode, (typename sparse_vector_type::statistics*)st);
     if (st)
     {
-        st->memory_used += sizeof(rs_index_type);
-        st->memory_used += bv_blocks_ptr_->get_total() *
-             (sizeof(typename rs_index_type::size_type)
-             + sizeof(typename rs_index_type::sb_pair_type));
+        st->memory_used += bv_blocks_ptr_->mem_usage();
     }
 }
 
@@ -1322,10 +1347,7 @@ void rsc_sparse_vector<Val, SV>::calc_stat(
     sv_.calc_stat((typename sparse_vector_type::statistics*)st);
     if (st)
     {
-        st->memory_used += sizeof(rs_index_type);
-        st->memory_used += bv_blocks_ptr_->get_total() *
-                   (sizeof(typename rs_index_type::size_type)
-                   + sizeof(typename rs_index_type::sb_pair_type));
+        st->memory_used += bv_blocks_ptr_->mem_usage();
     }
 }
 
@@ -1473,6 +1495,169 @@ rsc_sparse_vector<Val, SV>::decode_buf(value_type*     arr,
 }
 
 
+//---------------------------------------------------------------------
+
+template<class Val, class SV>
+typename rsc_sparse_vector<Val, SV>::size_type
+rsc_sparse_vector<Val, SV>::gather(value_type*       arr,
+                                   const size_type*  idx,
+                                   size_type*        idx_tmp_buf,
+                                   size_type         size,
+                                   bm::sort_order    sorted_idx) const
+{
+    typedef typename bvector_type::block_idx_type block_idx_type;
+
+    BM_ASSERT(arr && idx && idx_tmp_buf);
+    BM_ASSERT(in_sync_);  // call sync() before gather
+    BM_ASSERT(bv_blocks_ptr_);
+
+    if (!size)
+        return 0;
+
+    const bvector_type* bv_null = sv_.get_null_bvector();
+    const typename bvector_type::blocks_manager_type& bman =
+                                        bv_null->get_blocks_manager();
+    const rs_index_type& rs_idx = *bv_blocks_ptr_;
+    const block_idx_type total_blocks = rs_idx.get_total();
+
+    // translate indexes into ranks (positions in sv_)
+    // resolved ranks are stored in the head of idx_tmp_buf,
+    // positions of NULL elements in the tail (in reverse order)
+    //
+    size_type cnt_resolved = 0;
+    size_type null_pos = size;
+
+    const bm::word_t* block = 0;
+    block_idx_type nb_prev = 0;
+    size_type rank_base = 0; // count of bits before the current block
+    unsigned  nbit_prev = 0;
+    unsigned  cnt = 0;       // count of bits in the block in [0..nbit_prev]
+    bool      block_valid = false;
+
+    for (size_type k = 0; k < size; ++k)
+    {
+        size_type i = idx[k];
+        if (i >= this->size())
+        {
+            idx_tmp_buf[--null_pos] = k;
+            continue;
+        }
+        block_idx_type nb = (i >> bm::set_block_shift);
+        unsigned nbit = unsigned(i & bm::set_block_mask);
+
+        if (!block_valid || nb != nb_prev)
+        {
+            nb_prev = nb; block_valid = true;
+            if (nb >= total_blocks)
+            {
+                rank_base = rs_idx.count(); block = 0;
+            }
+            else
+            {
+                rank_base = rs_idx.rcount_before(nb);
+                unsigned i0, j0;
+                bm::get_block_coord(nb, i0, j0);
+                block = bman.get_block_ptr(i0, j0);
+            }
+            nbit_prev = nbit;
+            cnt = 0;
+            if (block)
+            {
+                if (BM_IS_GAP(block))
+                    cnt = bm::gap_bit_count_to(BMGAP_PTR(block),
+                                               (bm::gap_word_t)nbit);
+                else
+                if (block == FULL_BLOCK_FAKE_ADDR)
+                    cnt = nbit + 1;
+                else
+                    cnt = bm::bit_block_calc_count_to(block, nbit);
+            }
+        }
+        else // same block: incremental rank
+        {
+            if (block && nbit != nbit_prev)
+            {
+                if (nbit > nbit_prev)
+                {
+                    if (BM_IS_GAP(block))
+                        cnt += bm::gap_bit_count_range(BMGAP_PTR(block),
+                                                       nbit_prev+1, nbit);
+                    else
+                    if (block == FULL_BLOCK_FAKE_ADDR)
+                        cnt += nbit - nbit_prev;
+                    else
+                        cnt += bm::bit_block_calc_count_range(block,
+                                                        nbit_prev+1, nbit);
+                }
+                else // unsorted step back in the block
+                {
+                    if (BM_IS_GAP(block))
+                        cnt -= bm::gap_bit_count_range(BMGAP_PTR(block),
+                                                       nbit+1, nbit_prev);
+                    else
+                    if (block == FULL_BLOCK_FAKE_ADDR)
+                        cnt -= nbit_prev - nbit;
+                    else
+                        cnt -= bm::bit_block_calc_count_range(block,
+                                                        nbit+1, nbit_prev);
+                }
+            }
+            nbit_prev = nbit;
+        }
+
+        bool is_set;
+        if (!block)
+            is_set = false;
+        else
+        if (BM_IS_GAP(block))
+            is_set = bm::gap_test_unr(BMGAP_PTR(block), nbit);
+        else
+        if (block == FULL_BLOCK_FAKE_ADDR)
+            is_set = true;
+        else
+            is_set = block[nbit >> bm::set_word_shift] &
+                                        (1u << (nbit & bm::set_word_mask));
+        if (is_set)
+        {
+            BM_ASSERT(rank_base + cnt == bv_null->count_range(0, i));
+            idx_tmp_buf[cnt_resolved++] = rank_base + cnt - 1;
+        }
+        else
+            idx_tmp_buf[--null_pos] = k;
+    } // for k
+    BM_ASSERT(cnt_resolved == null_pos);
+
+    if (cnt_resolved)
+    {
+        // ranks preserve the sort order of indexes
+        bm::sort_order sv_sorted_idx = sorted_idx;
+        if (sorted_idx == bm::BM_SORTED_UNIFORM)
+            sv_sorted_idx = bm::BM_SORTED;
+        sv_.gather(arr, idx_tmp_buf, cnt_resolved, sv_sorted_idx);
+    }
+
+    // expand gathered values in place to the places of NULLs
+    //
+    if (cnt_resolved < size)
+    {
+        size_type j = cnt_resolved;
+        for (size_type k = size; k-- > 0; )
+        {
+            if (null_pos < size && idx_tmp_buf[null_pos] == k)
+            {
+                arr[k] = value_type(0);
+                ++null_pos;
+            }
+            else
+            {
+                BM_ASSERT(j);
+                arr[k] = arr[--j];
+            }
+        } // for k
+    }
+    return size;
+}
+
 //---------------------------------------------------------------------
 
 template<class Val, class SV>
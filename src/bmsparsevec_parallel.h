@@ -93,6 +93,719 @@ protected:
     }
 };
 
+/**
+    Builder class to prepare a batch of tasks for parallel bulk import
+    of a C-style array into a sparse vector (sparse_vector::import())
+
+    Import range gets split into chunks of whole blocks (65536 elements)
+    of the target vector. Each task transposes its chunk directly into
+    bit-blocks of the planes. Planes and their top level block
+    descriptors are prepared while building the plan, chunks cover
+    disjoint block indexes, so tasks run without locks.
+
+    Target vector should not be accessed until the batch is done,
+    builder and source array should stay alive until the batch is done.
+    Vector should not use a memory pool (pool is not thread safe).
+ */
+template<typename SVect>
+class import_plan_builder
+{
+public:
+    typedef SVect                                     sparse_vector_type;
+    typedef typename sparse_vector_type::value_type   value_type;
+    typedef typename sparse_vector_type::size_type    size_type;
+    typedef typename sparse_vector_type::bvector_type bvector_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+
+    class task_batch : public bm::task_batch<allocator_type>
+    {
+    };
+
+public:
+    import_plan_builder() BMNOEXCEPT
+        : sv_(0), arr_(0), arr_size_(0), offset_(0), chunk_blocks_(1)
+    {}
+
+    /**
+        Set number of blocks (65536 elements) per task (default: 1)
+     */
+    void set_chunk_blocks(unsigned cnt) BMNOEXCEPT
+    {
+        BM_ASSERT(cnt);
+        chunk_blocks_ = cnt ? cnt : 1;
+    }
+
+    /**
+        Prepare target vector and build the batch of import tasks
+
+        \param batch - [out] batch of tasks
+        \param sv - target sparse vector
+        \param arr - source array
+        \param arr_size - source array size
+        \param offset - target index in the sparse vector
+        \param set_not_null - import should register in not null vector
+     */
+    void build_plan(task_batch&         batch,
+                    sparse_vector_type& sv,
+                    const value_type*   arr,
+                    size_type           arr_size,
+                    size_type           offset = 0,
+                    bool                set_not_null = true)
+    {
+        if (arr_size == 0)
+            sparse_vector_type::throw_range_error(
+                            "sparse_vector range error (import size 0)");
+        sv_ = &sv; arr_ = arr; arr_size_ = arr_size; offset_ = offset;
+
+        const size_type idx_to = offset + arr_size - 1;
+        if (offset < sv.size_) // in case it touches existing elements
+            sv.clear_range(offset, idx_to);
+
+        value_type acc = 0; // OR of all values: planes to prepare
+        for (size_type i = 0; i < arr_size; ++i)
+            acc |= arr[i];
+
+        const block_idx_type nb_from = (offset >> bm::set_block_shift);
+        const block_idx_type nb_to = (idx_to >> bm::set_block_shift);
+        for (unsigned j = 0; j < sizeof(value_type) * 8; ++j)
+        {
+            if ((acc >> j) & 1u)
+            {
+                bvector_type* bv = sv.get_plane(j);
+                bv->get_blocks_manager().reserve_top_subblocks(nb_from,
+                                                               nb_to);
+            }
+        } // for j
+
+        if (idx_to >= sv.size_)
+            sv.size_ = idx_to + 1;
+        if (set_not_null)
+        {
+            bvector_type* bv_null = sv.get_null_bvect();
+            if (bv_null)
+                bv_null->set_range(offset, idx_to);
+        }
+
+        auto& tv = batch.get_task_vector();
+        const block_idx_type ch_from = nb_from / chunk_blocks_;
+        const block_idx_type ch_to = nb_to / chunk_blocks_;
+        for (block_idx_type k = ch_from; k <= ch_to; ++k)
+        {
+            bm::task_description& tdescr = tv.add();
+            tdescr.init(task_run, (void*)&tdescr, (void*)this, 0, k);
+        } // for k
+    }
+
+protected:
+    /// Task execution Entry Point
+    /// @internal
+    static void* task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        const import_plan_builder* pb =
+                        static_cast<const import_plan_builder*>(tdescr->ctx0);
+        const block_idx_type k = block_idx_type(tdescr->param0);
+
+        // chunk range of [from..to] (closed) in the target vector
+        const size_type chunk_size =
+                        size_type(pb->chunk_blocks_) * bm::gap_max_bits;
+        size_type from = size_type(k) * chunk_size;
+        size_type to = from + (chunk_size - 1);
+        const size_type idx_to = pb->offset_ + pb->arr_size_ - 1;
+        if (from < pb->offset_)
+            from = pb->offset_;
+        if (to > idx_to)
+            to = idx_to;
+
+        for (size_type i = from; i <= to; )
+        {
+            const block_idx_type nb = (i >> bm::set_block_shift);
+            const unsigned nbit = unsigned(i & bm::set_block_mask);
+            size_type len = bm::gap_max_bits - nbit;
+            if (len > to - i + 1)
+                len = to - i + 1;
+            pb->sv_->import_block(pb->arr_ + (i - pb->offset_),
+                                  unsigned(len), nb, nbit);
+            i += len;
+            if (!i) // 32-bit address space end
+                break;
+        } // for i
+        return 0;
+    }
+
+protected:
+    sparse_vector_type*  sv_;           ///< target vector
+    const value_type*    arr_;          ///< source array
+    size_type            arr_size_;     ///< source array size
+    size_type            offset_;       ///< target index
+    unsigned             chunk_blocks_; ///< number of blocks per task
+};
+
+
+/**
+    Builder class to prepare batches of tasks for parallel bulk import
+    of a matrix of chars into a string sparse vector
+    (str_sparse_vector::import())
+
+    Import runs in two batches:
+    - pre-pass (optional, see build_remap_plan()) - rows are split into
+    chunks, each task remaps characters (for remapped vectors) and
+    collects octet statistics of its rows
+    - transposition (see build_plan()) - target range is split into
+    chunks of whole blocks, each task transposes character columns
+    directly into bit-blocks of the planes (no locking, planes are
+    prepared while building the plan)
+
+    Target vector should not be accessed until the batch is done,
+    builder and the matrix should stay alive until the batch is done.
+    Vector should not use a memory pool (pool is not thread safe).
+ */
+template<typename SVect>
+class str_import_plan_builder
+{
+public:
+    typedef SVect                                     str_sparse_vector_type;
+    typedef typename str_sparse_vector_type::value_type value_type;
+    typedef typename str_sparse_vector_type::size_type  size_type;
+    typedef typename str_sparse_vector_type::bvector_type bvector_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+
+    enum octets
+    {
+        max_octets = str_sparse_vector_type::sv_octet_planes
+    };
+
+    class task_batch : public bm::task_batch<allocator_type>
+    {
+    };
+
+    /// octet statistics of a chunk of rows
+    struct chunk_stat
+    {
+        unsigned char  or_mask[max_octets]; ///< OR of all octets of a column
+        unsigned       err;                 ///< remapping error
+    };
+
+    typedef
+    bm::heap_vector<chunk_stat, allocator_type, true> chunk_stat_vector_type;
+
+public:
+    str_import_plan_builder() BMNOEXCEPT
+        : sv_(0), cmatr_(0), idx_from_(0), imp_size_(0), chunk_blocks_(1),
+          remap_planned_(false)
+    {
+        ::memset(or_mask_, 0, sizeof(or_mask_));
+    }
+
+    /**
+        Set number of blocks (65536 rows) per task (default: 1)
+     */
+    void set_chunk_blocks(unsigned cnt) BMNOEXCEPT
+    {
+        BM_ASSERT(cnt);
+        chunk_blocks_ = cnt ? cnt : 1;
+    }
+
+    /**
+        Build the batch of the pre-pass tasks: remap of characters and
+        octet statistics (run before build_plan() for the same matrix)
+
+        \param batch - [out] batch of tasks
+        \param sv - target sparse vector (remap tables source)
+        \param cmatr - source matrix [in/out] gets modified in the process
+        \param imp_size - import size (number or rows to import)
+     */
+    template<typename CharMatrix>
+    void build_remap_plan(task_batch&             batch,
+                          str_sparse_vector_type& sv,
+                          CharMatrix&             cmatr,
+                          size_type               imp_size)
+    {
+        BM_ASSERT(cmatr.is_init());
+        sv_ = &sv; cmatr_ = (void*)&cmatr; imp_size_ = imp_size;
+        const size_type chunk_size =
+                        size_type(chunk_blocks_) * bm::gap_max_bits;
+        size_type cnt = (imp_size + chunk_size - 1) / chunk_size;
+        stat_vect_.resize(cnt);
+        remap_planned_ = true;
+
+        auto& tv = batch.get_task_vector();
+        for (size_type k = 0; k < cnt; ++k)
+        {
+            bm::task_description& tdescr = tv.add();
+            tdescr.init(remap_task_run<CharMatrix>, (void*)&tdescr,
+                        (void*)this, 0, k);
+        } // for k
+    }
+
+    /**
+        Prepare target vector and build the batch of transposition tasks
+        If pre-pass batch was not built and executed for this matrix,
+        it runs here (sequentially)
+
+        \param batch - [out] batch of tasks
+        \param sv - target sparse vector
+        \param cmatr - source matrix [in/out] gets modified in the process
+        \param idx_from - destination index in the sparse vector
+        \param imp_size - import size (number or rows to import)
+        \param set_not_null - import should register in not null vector
+     */
+    template<typename CharMatrix>
+    void build_plan(task_batch&             batch,
+                    str_sparse_vector_type& sv,
+                    CharMatrix&             cmatr,
+                    size_type               idx_from,
+                    size_type               imp_size,
+                    bool                    set_not_null = true)
+    {
+        if (!imp_size)
+            return;
+        if (!remap_planned_ ||
+            sv_ != &sv || cmatr_ != (void*)&cmatr || imp_size_ != imp_size)
+        {
+            task_batch remap_batch;
+            build_remap_plan(remap_batch, sv, cmatr, imp_size);
+            bm::run_task_batch(remap_batch);
+        }
+        idx_from_ = idx_from;
+        remap_planned_ = false;
+
+        // merge statistics of the pre-pass chunks
+        ::memset(or_mask_, 0, sizeof(or_mask_));
+        for (size_type k = 0; k < stat_vect_.size(); ++k)
+        {
+            const chunk_stat& st = stat_vect_[k];
+            if (st.err)
+                str_sparse_vector_type::throw_bad_value(0);
+            for (unsigned i = 0; i < max_octets; ++i)
+                or_mask_[i] |= st.or_mask[i];
+        } // for k
+
+        const size_type idx_to = idx_from + imp_size - 1;
+        if (idx_from < sv.size_) // in case it touches existing elements
+            sv.clear_range(idx_from, idx_to);
+
+        const block_idx_type nb_from = (idx_from >> bm::set_block_shift);
+        const block_idx_type nb_to = (idx_to >> bm::set_block_shift);
+        for (unsigned i = 0; i < max_octets; ++i)
+        {
+            for (unsigned bi = 0; or_mask_[i] && bi < 8; ++bi)
+            {
+                if (!(or_mask_[i] & (1u << bi)))
+                    continue;
+                unsigned plane = i * 8 + bi;
+                bvector_type* bv = sv.bmatr_.get_row(plane);
+                if (!bv)
+                {
+                    bv = sv.bmatr_.construct_row(plane);
+                    bv->init();
+                }
+                bv->get_blocks_manager().reserve_top_subblocks(nb_from,
+                                                               nb_to);
+            } // for bi
+        } // for i
+
+        if (set_not_null)
+        {
+            bvector_type* bv_null = sv.get_null_bvect();
+            if (bv_null)
+                bv_null->set_range(idx_from, idx_to);
+        }
+        if (idx_to >= sv.size_)
+            sv.size_ = idx_to + 1;
+
+        auto& tv = batch.get_task_vector();
+        const block_idx_type ch_from = nb_from / chunk_blocks_;
+        const block_idx_type ch_to = nb_to / chunk_blocks_;
+        for (block_idx_type k = ch_from; k <= ch_to; ++k)
+        {
+            bm::task_description& tdescr = tv.add();
+            tdescr.init(task_run<CharMatrix>, (void*)&tdescr,
+                        (void*)this, 0, k);
+        } // for k
+    }
+
+protected:
+    /// Pre-pass task execution Entry Point
+    /// @internal
+    template<typename CharMatrix>
+    static void* remap_task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        str_import_plan_builder* pb =
+                        static_cast<str_import_plan_builder*>(tdescr->ctx0);
+        const size_type k = size_type(tdescr->param0);
+        CharMatrix& cmatr = *static_cast<CharMatrix*>(pb->cmatr_);
+        const str_sparse_vector_type& sv = *pb->sv_;
+
+        chunk_stat& st = pb->stat_vect_[k];
+        ::memset(&st, 0, sizeof(st));
+
+        const size_type chunk_size =
+                        size_type(pb->chunk_blocks_) * bm::gap_max_bits;
+        size_type from = k * chunk_size;
+        size_type to = from + chunk_size;
+        if (to > pb->imp_size_)
+            to = pb->imp_size_;
+        for (size_type j = from; j < to; ++j)
+        {
+            typename CharMatrix::value_type* str = cmatr.row(j);
+            unsigned i;
+            for (i = 0; i < max_octets; ++i)
+            {
+                value_type ch = str[i];
+                if (!ch)
+                    break;
+                if (sv.remap_flags_) // re-mapping is in effect
+                {
+                    unsigned char remap_value =
+                                    sv.remap_matrix2_.get(i, unsigned(ch));
+                    if (!remap_value) // unknown dictionary element
+                    {
+                        st.err = 1;
+                        tdescr->err_code = 1;
+                        return 0;
+                    }
+                    str[i] = value_type(remap_value);
+                }
+                st.or_mask[i] |= (unsigned char)str[i];
+            } // for i
+            for (; i < max_octets; ++i) // clear the tail after 0 terminator
+                str[i] = 0;
+        } // for j
+        return 0;
+    }
+
+    /// Transposition task execution Entry Point
+    /// @internal
+    template<typename CharMatrix>
+    static void* task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        const str_import_plan_builder* pb =
+                    static_cast<const str_import_plan_builder*>(tdescr->ctx0);
+        const block_idx_type k = block_idx_type(tdescr->param0);
+        const CharMatrix& cmatr = *static_cast<const CharMatrix*>(pb->cmatr_);
+        str_sparse_vector_type& sv = *pb->sv_;
+
+        // chunk range of [from..to] (closed) in the target vector
+        const size_type chunk_size =
+                        size_type(pb->chunk_blocks_) * bm::gap_max_bits;
+        size_type from = size_type(k) * chunk_size;
+        size_type to = from + (chunk_size - 1);
+        const size_type idx_to = pb->idx_from_ + pb->imp_size_ - 1;
+        if (from < pb->idx_from_)
+            from = pb->idx_from_;
+        if (to > idx_to)
+            to = idx_to;
+
+        const unsigned window = 2048;
+        unsigned char octets[window];
+        bm::word_t* planes[8];
+        for (size_type b = from; b <= to; )
+        {
+            const block_idx_type nb = (b >> bm::set_block_shift);
+            size_type b_to = (size_type(nb) << bm::set_block_shift) +
+                                                    (bm::gap_max_bits - 1);
+            if (b_to > to)
+                b_to = to;
+            for (unsigned i = 0; i < max_octets; ++i)
+            {
+                unsigned char mask = pb->or_mask_[i];
+                if (!mask)
+                    continue;
+                for (unsigned bi = 0; bi < 8; ++bi)
+                {
+                    planes[bi] = (mask & (1u << bi)) ?
+                        sv.bmatr_.check_allocate_bit_block(i * 8 + bi, nb)
+                        : 0;
+                }
+                for (size_type w = b; w <= b_to; w += window)
+                {
+                    unsigned len = window;
+                    if (len > b_to - w + 1)
+                        len = unsigned(b_to - w + 1);
+                    size_type row = w - pb->idx_from_;
+                    for (unsigned r = 0; r < len; ++r)
+                        octets[r] = (unsigned char)cmatr.row(row + r)[i];
+                    bm::bit_block_planes_encode(planes, 8,
+                                        unsigned(w & bm::set_block_mask),
+                                        octets, len);
+                } // for w
+            } // for i
+            b = b_to + 1;
+            if (!b) // 32-bit address space end
+                break;
+        } // for b
+        return 0;
+    }
+
+protected:
+    str_sparse_vector_type*  sv_;           ///< target vector
+    void*                    cmatr_;        ///< source matrix
+    size_type                idx_from_;     ///< target index
+    size_type                imp_size_;     ///< number of rows
+    unsigned                 chunk_blocks_; ///< number of blocks per task
+    chunk_stat_vector_type   stat_vect_;    ///< pre-pass statistics
+    unsigned char            or_mask_[max_octets]; ///< merged statistics
+    bool                     remap_planned_; ///< pre-pass batch is built
+};
+
+/**
+    Builder class to prepare a batch of tasks for parallel XOR reference
+    search (XOR compression of sparse vector serialization).
+
+    Reference vectors (bit-planes) are split into chunks of blocks, each
+    task runs the XOR search for all planes of its blocks, candidates are
+    pre-filtered by complexity descriptors of the reference blocks
+    (see bm::xor_gain_upper_bound()). When the batch is done, results
+    are merged into the search plan by merge_plan().
+
+    Plan gives the same references as the serial search, it is used via
+    sparse_vector_serializer::set_xor_plan().
+    Builder, plan and the vector should stay alive until merge_plan().
+    Requires bmserial.h (bmxor.h).
+ */
+template<typename SVect>
+class xor_plan_builder
+{
+public:
+    typedef SVect                                     sparse_vector_type;
+    typedef typename sparse_vector_type::bvector_type bvector_type;
+    typedef typename bvector_type::size_type          size_type;
+    typedef typename bvector_type::allocator_type     allocator_type;
+    typedef typename bvector_type::block_idx_type     block_idx_type;
+    typedef bm::bv_ref_vector<bvector_type>           bv_ref_vector_type;
+    typedef bm::xor_search_plan<bvector_type>         xor_plan_type;
+    typedef typename xor_plan_type::match_vector_type match_vector_type;
+
+    class task_batch : public bm::task_batch<allocator_type>
+    {
+    };
+
+public:
+    xor_plan_builder() BMNOEXCEPT
+        : ref_ptr_(0), plan_(0), chunk_blocks_(16), prune_(true)
+    {}
+
+    /**
+        Set number of blocks per task (default: 16)
+     */
+    void set_chunk_blocks(unsigned cnt) BMNOEXCEPT
+    {
+        BM_ASSERT(cnt);
+        chunk_blocks_ = cnt ? cnt : 1;
+    }
+
+    /**
+        Enable/disable candidate pruning by complexity descriptors
+        (default: enabled)
+     */
+    void set_pruning(bool prune) BMNOEXCEPT { prune_ = prune; }
+
+    /**
+        Build the batch of search tasks for the sparse vector
+        (references are the planes of the vector, same as
+        sparse_vector_serializer builds by default)
+
+        \param batch - [out] batch of tasks
+        \param sv - sparse vector to serialize
+        \param plan - [out] search plan
+     */
+    void build_plan(task_batch&               batch,
+                    const sparse_vector_type& sv,
+                    xor_plan_type&            plan)
+    {
+        ref_.build(sv.get_bmatrix());
+        build_plan(batch, ref_, plan);
+    }
+
+    /**
+        Build the batch of search tasks for the external reference vectors
+        (see sparse_vector_serializer::set_xor_ref())
+
+        \param batch - [out] batch of tasks
+        \param ref_vect - reference vectors
+        \param plan - [out] search plan
+     */
+    void build_plan(task_batch&               batch,
+                    const bv_ref_vector_type& ref_vect,
+                    xor_plan_type&            plan)
+    {
+        ref_ptr_ = &ref_vect; plan_ = &plan;
+        const size_type ref_size = ref_vect.size();
+        plan.init(ref_size);
+
+        unsigned top_size = 0;
+        for (size_type r = 0; r < ref_size; ++r)
+        {
+            const bvector_type* bv = ref_vect.get_bv(r);
+            unsigned ts = bv->get_blocks_manager().top_block_size();
+            if (ts > top_size)
+                top_size = ts;
+        }
+        block_idx_type total_blocks =
+                        block_idx_type(top_size) * bm::set_sub_array_size;
+        block_idx_type chunks =
+                    (total_blocks + chunk_blocks_ - 1) / chunk_blocks_;
+        chunk_res_.resize(0);
+        chunk_res_.resize(size_t(chunks));
+
+        auto& tv = batch.get_task_vector();
+        for (block_idx_type k = 0; k < chunks; ++k)
+        {
+            bm::task_description& tdescr = tv.add();
+            tdescr.init(task_run, (void*)&tdescr, (void*)this, 0, k);
+        } // for k
+    }
+
+    /**
+        Merge results of the (completed) batch into the search plan
+     */
+    void merge_plan();
+
+protected:
+    /// Match with the target vector index (before merge)
+    struct chunk_match
+    {
+        size_type                        r;  ///< target vector
+        typename xor_plan_type::match    m;  ///< search result
+    };
+    typedef
+    bm::heap_vector<chunk_match, allocator_type, true> chunk_match_vector_type;
+    typedef bm::heap_vector<chunk_match_vector_type, allocator_type, false>
+                                                    chunk_result_vector_type;
+    typedef bm::heap_vector<bm::block_waves_xor_descr, allocator_type, true>
+                                                    descr_vector_type;
+
+    /// Task execution Entry Point: search for a chunk of blocks
+    /// @internal
+    static void* task_run(void* argp)
+    {
+        if (!argp)
+            return 0;
+        bm::task_description* tdescr = (bm::task_description*) argp;
+        xor_plan_builder* pb = static_cast<xor_plan_builder*>(tdescr->ctx0);
+        const block_idx_type k = block_idx_type(tdescr->param0);
+        const bv_ref_vector_type& ref_vect = *pb->ref_ptr_;
+        const size_type ref_size = ref_vect.size();
+        chunk_match_vector_type& res = pb->chunk_res_[size_t(k)];
+
+        bm::xor_scanner<bvector_type> xor_scan;
+        xor_scan.set_ref_vector(&ref_vect);
+        descr_vector_type descr;
+        descr.resize(ref_size);
+        allocator_type alloc;
+        bm::word_t* tb = alloc.alloc_bit_block(2);
+        bm::gap_word_t* tmp_buf = (bm::gap_word_t*)(tb + bm::set_block_size);
+
+        block_idx_type nb = k * pb->chunk_blocks_;
+        block_idx_type nb_to = nb + pb->chunk_blocks_;
+        for (; nb < nb_to; ++nb)
+        {
+            unsigned i0, j0;
+            bm::get_block_coord(nb, i0, j0);
+            unsigned bit_cnt = 0;
+            for (size_type r = 0; r < ref_size; ++r) // reference descriptors
+            {
+                const bm::word_t* blk = ref_vect.get_bv(r)->
+                                    get_blocks_manager().get_block_ptr(i0, j0);
+                if (!IS_VALID_ADDR(blk) || BM_IS_GAP(blk))
+                    continue;
+                ++bit_cnt;
+                if (pb->prune_)
+                    bm::compute_complexity_descr(blk, descr[r]);
+            } // for r
+
+            for (size_type r = 0; r + 1 < ref_size; ++r)
+            {
+                const bm::word_t* blk = ref_vect.get_bv(r)->
+                                    get_blocks_manager().get_block_ptr(i0, j0);
+                if (!IS_VALID_ADDR(blk))
+                    continue;
+                bool found;
+                bm::id64_t d64 = 0;
+                if (BM_IS_GAP(blk))
+                {
+                    found = xor_scan.search_best_xor_gap(tmp_buf, blk,
+                                                         r+1, ref_size,
+                                                         i0, j0);
+                }
+                else
+                {
+                    if (bit_cnt < 2)
+                        continue;
+                    xor_scan.compute_x_block_stats(blk);
+                    found = xor_scan.search_best_xor_mask(blk, r+1, ref_size,
+                                        i0, j0, tb,
+                                        pb->prune_ ? descr.begin() : 0);
+                    d64 = xor_scan.get_xor_digest();
+                }
+                if (found)
+                {
+                    chunk_match& cm = res.add();
+                    cm.r = r;
+                    cm.m.nb = nb; cm.m.ridx = xor_scan.found_ridx();
+                    cm.m.d64 = d64;
+                }
+            } // for r
+        } // for nb
+        alloc.free_bit_block(tb, 2);
+        return 0;
+    }
+
+protected:
+    bv_ref_vector_type         ref_;          ///< references (planes of sv)
+    const bv_ref_vector_type*  ref_ptr_;      ///< references to use
+    xor_plan_type*             plan_;         ///< target plan
+    unsigned                   chunk_blocks_; ///< number of blocks per task
+    bool                       prune_;        ///< use candidate pruning
+    chunk_result_vector_type   chunk_res_;    ///< per chunk matches
+};
+
+//---------------------------------------------------------------------
+
+template<typename SVect>
+void xor_plan_builder<SVect>::merge_plan()
+{
+    BM_ASSERT(plan_);
+    typename xor_plan_type::offset_vector_type& off = plan_->get_offsets();
+    match_vector_type& matches = plan_->get_matches();
+    const size_t chunks = chunk_res_.size();
+    const size_type ref_size = plan_->size();
+
+    // count matches per vector, offsets are prefix sums
+    size_t total = 0;
+    for (size_t k = 0; k < chunks; ++k)
+    {
+        const chunk_match_vector_type& res = chunk_res_[k];
+        for (size_t i = 0; i < res.size(); ++i)
+            ++off[res[i].r + 1];
+        total += res.size();
+    } // for k
+    for (size_type r = 0; r < ref_size; ++r)
+        off[r + 1] += off[r];
+    matches.resize(total);
+
+    // scatter in chunk (block) order, matches of a vector stay sorted
+    typename xor_plan_type::offset_vector_type pos(off);
+    for (size_t k = 0; k < chunks; ++k)
+    {
+        const chunk_match_vector_type& res = chunk_res_[k];
+        for (size_t i = 0; i < res.size(); ++i)
+            matches[pos[res[i].r]++] = res[i].m;
+    } // for k
+    chunk_res_.resize(0);
+}
+
 } // namespace bm
 
 #endif
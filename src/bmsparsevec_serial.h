@@ -169,6 +169,8 @@ public:
                                                    allocator_pool_type;
     typedef typename
     bm::serializer<bvector_type>::bv_ref_vector_type bv_ref_vector_type;
+    typedef typename
+    bm::serializer<bvector_type>::xor_plan_type      xor_plan_type;
     typedef typename bvector_type::allocator_type      alloc_type;
 
 public:
@@ -227,6 +229,16 @@ public:
     */
     bool is_xor_ref() const BMNOEXCEPT { return is_xor_ref_; }
 
+    /** Attach pre-computed XOR reference search plan (see
+        xor_plan_builder), plan must be built for the vector being
+        serialized and for the same reference vectors.
+        Plan replaces the (slow) XOR reference search.
+
+        @param plan - search plan or NULL to reset
+    */
+    void set_xor_plan(const xor_plan_type* plan) BMNOEXCEPT
+        { xor_plan_ = plan; }
+
     //@}
 
 
@@ -278,6 +290,7 @@ protected:
     bool                             is_xor_ref_;
     bv_ref_vector_type               bv_ref_;
     const bv_ref_vector_type*        bv_ref_ptr_;
+    const xor_plan_type*             xor_plan_;
 };
 
 /**
@@ -726,7 +739,7 @@ int compressed_collection_deserializer<CBC>::deserialize(
 
 template<typename SV>
 sparse_vector_serializer<SV>::sparse_vector_serializer()
-: bv_ref_ptr_(0)
+: bv_ref_ptr_(0), xor_plan_(0)
 {
     bvs_.gap_length_serialization(false);
     #ifdef BMXORCOMP
@@ -917,6 +930,7 @@ void sparse_vector_serializer<SV>::serialize(const SV&  sv,
             build_xor_ref_vector(sv);
             bvs_.set_ref_vectors(&bv_ref_);
         }
+        bvs_.set_xor_plan(xor_plan_);
     }
 
     // ----------------------------------------------------
@@ -958,6 +972,7 @@ void sparse_vector_serializer<SV>::serialize(const SV&  sv,
     } // for i
 
     bvs_.set_ref_vectors(0); // dis-engage XOR ref vector
+    bvs_.set_xor_plan(0);
 
     // -----------------------------------------------------
     // serialize the re-map matrix
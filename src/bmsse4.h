@@ -724,7 +724,8 @@ void sse42_bit_block_calc_xor_change(const __m128i* BMRESTRICT block,
         ( __m128i*)((bm::word_t*)(block) + size);
     __m128i m1COshft, m2COshft;
 
-    unsigned w0 = *((bm::word_t*)(block));
+    // first word of the XOR product (for carry-in correction)
+    unsigned w0 = *((bm::word_t*)(block)) ^ *((bm::word_t*)(xor_block));
     unsigned gap_count = 1;
     unsigned bit_count = 0;
 
@@ -1244,6 +1245,67 @@ unsigned sse4_lower_bound_scan_u32(const unsigned* BMRESTRICT arr,
     return to + 1;
 }
 
+/**
+    Count equal elements of two u32 arrays (same index)
+    @ingroup SSE4
+    \internal
+*/
+inline
+unsigned sse4_u32_eq_count(const unsigned* BMRESTRICT arr1,
+                           const unsigned* BMRESTRICT arr2,
+                           unsigned size) BMNOEXCEPT
+{
+    unsigned cnt = 0;
+    unsigned size_unr = size - (size % 8);
+    unsigned k = 0;
+    for (; k < size_unr; k += 8)
+    {
+        __m128i cmp0 = _mm_cmpeq_epi32(
+                            _mm_loadu_si128((const __m128i*)(arr1 + k)),
+                            _mm_loadu_si128((const __m128i*)(arr2 + k)));
+        __m128i cmp1 = _mm_cmpeq_epi32(
+                            _mm_loadu_si128((const __m128i*)(arr1 + k + 4)),
+                            _mm_loadu_si128((const __m128i*)(arr2 + k + 4)));
+        unsigned mask = unsigned(_mm_movemask_ps(_mm_castsi128_ps(cmp0))) |
+                   (unsigned(_mm_movemask_ps(_mm_castsi128_ps(cmp1))) << 4);
+        cnt += unsigned(_mm_popcnt_u32(mask));
+    } // for k
+    for (; k < size; ++k)
+        cnt += (arr1[k] == arr2[k]);
+    return cnt;
+}
+
+/**
+    Compare two zero-terminated strings 16 bytes at a time (PCMPISTRI).
+    Both strings must be zero padded to 'size' (multiple of 16) so that
+    reads past the terminator stay inside the buffers.
+    @return <0, 0, >0 (as the first mismatched chars)
+    @ingroup SSE4
+    \internal
+*/
+inline
+int sse42_str_cmp_padded(const char* BMRESTRICT s1,
+                         const char* BMRESTRICT s2,
+                         unsigned size) BMNOEXCEPT
+{
+    const int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH |
+                     _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+    for (unsigned k = 0; k < size; k += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s1 + k));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s2 + k));
+        int idx = _mm_cmpistri(a, b, mode);
+        if (idx != 16) // mismatch (or one of the strings ended)
+        {
+            char c1 = s1[k + unsigned(idx)], c2 = s2[k + unsigned(idx)];
+            return (c1 > c2) - (c1 < c2);
+        }
+        if (_mm_cmpistrz(a, b, mode)) // both strings ended, all equal
+            break;
+    } // for k
+    return 0;
+}
+
 
 
 /*!
@@ -1740,6 +1802,76 @@ void sse42_bit_block_xor(bm::word_t*  target_block,
     } // for i
 }
 
+/**
+    Transposition of 16 unsigned values into 4 registers of bytes
+    (register k holds byte k of all 16 values)
+
+    @ingroup SSE4
+    @internal
+*/
+inline
+void sse42_bytes_transpose16(const unsigned* BMRESTRICT arr,
+                             __m128i* BMRESTRICT bt) BMNOEXCEPT
+{
+    const __m128i shuf = _mm_setr_epi8(0,4,8,12, 1,5,9,13,
+                                       2,6,10,14, 3,7,11,15);
+    __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)arr), shuf);
+    __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(arr+4)), shuf);
+    __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(arr+8)), shuf);
+    __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(arr+12)), shuf);
+
+    __m128i t0 = _mm_unpacklo_epi32(m0, m1);
+    __m128i t1 = _mm_unpacklo_epi32(m2, m3);
+    __m128i t2 = _mm_unpackhi_epi32(m0, m1);
+    __m128i t3 = _mm_unpackhi_epi32(m2, m3);
+
+    bt[0] = _mm_unpacklo_epi64(t0, t1);
+    bt[1] = _mm_unpackhi_epi64(t0, t1);
+    bt[2] = _mm_unpacklo_epi64(t2, t3);
+    bt[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+    Transposition of 32 unsigned values into bit-plane words
+    (byte shuffle + movemask)
+
+    @param arr - source array of 32 values
+    @param w - target plane words (must fit 8*ceil(n/8) words)
+    @param n - number of planes to produce
+
+    @ingroup SSE4
+    @internal
+*/
+inline
+void sse42_bit_planes_encode32(const unsigned* BMRESTRICT arr,
+                               unsigned* BMRESTRICT w,
+                               unsigned n) BMNOEXCEPT
+{
+    __m128i bl[4], bh[4];
+    bm::sse42_bytes_transpose16(arr, bl);
+    bm::sse42_bytes_transpose16(arr + 16, bh);
+
+    #define BM_SSE42_PLANE_W(sh) \
+        (unsigned(_mm_movemask_epi8(_mm_slli_epi16(l, sh))) | \
+        (unsigned(_mm_movemask_epi8(_mm_slli_epi16(h, sh))) << 16))
+
+    for (unsigned k = 0; k < 4 && (k * 8) < n; ++k, w += 8)
+    {
+        __m128i l = bl[k], h = bh[k];
+        w[0] = BM_SSE42_PLANE_W(7);
+        w[1] = BM_SSE42_PLANE_W(6);
+        w[2] = BM_SSE42_PLANE_W(5);
+        w[3] = BM_SSE42_PLANE_W(4);
+        w[4] = BM_SSE42_PLANE_W(3);
+        w[5] = BM_SSE42_PLANE_W(2);
+        w[6] = BM_SSE42_PLANE_W(1);
+        w[7] = unsigned(_mm_movemask_epi8(l)) |
+               (unsigned(_mm_movemask_epi8(h)) << 16);
+    } // for k
+
+    #undef BM_SSE42_PLANE_W
+}
+
 
 
 #define VECT_XOR_ARR_2_MASK(dst, src, src_end, mask)\
@@ -1829,6 +1961,12 @@ void sse42_bit_block_xor(bm::word_t*  target_block,
 #define VECT_LOWER_BOUND_SCAN_U32(arr, target, from, to) \
     sse4_lower_bound_scan_u32(arr, target, from, to)
 
+#define VECT_U32_EQ_COUNT(arr1, arr2, size) \
+    sse4_u32_eq_count(arr1, arr2, size)
+
+#define VECT_STR_CMP_PADDED(s1, s2, size) \
+    sse42_str_cmp_padded(s1, s2, size)
+
 #define VECT_SHIFT_L1(b, acc, co) \
     sse42_shift_l1((__m128i*)b, acc, co)
 
@@ -1867,6 +2005,9 @@ void sse42_bit_block_xor(bm::word_t*  target_block,
 #define VECT_GAP_BFIND(buf, pos, is_set) \
     sse42_gap_bfind(buf, pos, is_set)
 
+#define VECT_BIT_PLANES_ENCODE32(arr, w, n) \
+    sse42_bit_planes_encode32(arr, w, n)
+
 #ifdef __GNUG__
 #pragma GCC diagnostic pop
 #endif
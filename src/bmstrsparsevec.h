@@ -643,6 +643,21 @@ public:
         \return 0 - equal, < 0 - vect[i] < str, >0 otherwise
     */
     int compare(size_type idx, const value_type* str) const BMNOEXCEPT;
+
+    /**
+        \brief Compare vector element with argument lexicographically,
+        skipping the known common prefix (for searches in sorted vectors,
+        where neighbor elements share prefixes)
+
+        \param idx - vactor element index
+        \param str - argument to compare with
+        \param prefix_len - [in/out] length of the known common prefix
+                           of the element and str (updated on return)
+
+        \return 0 - equal, < 0 - vect[i] < str, >0 otherwise
+    */
+    int compare(size_type idx, const value_type* str,
+                unsigned& prefix_len) const BMNOEXCEPT;
     
     
     /**
@@ -1290,6 +1305,7 @@ protected:
 protected:
     template<class SVect> friend class sparse_vector_serializer;
     template<class SVect> friend class sparse_vector_deserializer;
+    template<class SVect> friend class str_import_plan_builder;
 
 protected:
     unsigned                 remap_flags_;   ///< remapping status
@@ -1553,12 +1569,26 @@ template<class CharType, class BV, unsigned MAX_STR_SIZE>
 int str_sparse_vector<CharType, BV, MAX_STR_SIZE>::compare(
                      size_type idx,
                      const value_type* str) const BMNOEXCEPT
+{
+    unsigned prefix_len = 0;
+    return compare(idx, str, prefix_len);
+}
+
+//---------------------------------------------------------------------
+
+template<class CharType, class BV, unsigned MAX_STR_SIZE>
+int str_sparse_vector<CharType, BV, MAX_STR_SIZE>::compare(
+                     size_type idx,
+                     const value_type* str,
+                     unsigned& prefix_len) const BMNOEXCEPT
 {
     BM_ASSERT(str);
+    BM_ASSERT(prefix_len <= MAX_STR_SIZE);
     int res = 0;
+    unsigned i = prefix_len;
     if (remap_flags_)
     {
-        for (unsigned i = 0; i < MAX_STR_SIZE; ++i)
+        for (; i < MAX_STR_SIZE; ++i)
         {
             CharType octet = str[i];
             CharType sv_octet = (CharType)this->bmatr_.get_octet(idx, i);
@@ -1577,7 +1607,7 @@ int str_sparse_vector<CharType, BV, MAX_STR_SIZE>::compare(
     }
     else
     {
-        for (unsigned i = 0; i < MAX_STR_SIZE; ++i)
+        for (; i < MAX_STR_SIZE; ++i)
         {
             CharType octet = str[i];
             CharType sv_octet = (CharType)this->bmatr_.get_octet(idx, i);
@@ -1591,6 +1621,7 @@ int str_sparse_vector<CharType, BV, MAX_STR_SIZE>::compare(
                 break;
         } // for
     }
+    prefix_len = i;
     return res;
 }
 
@@ -859,6 +859,276 @@ public:
 };
 
 
+/// max number of bit-planes for specialized decode kernels
+const unsigned bit_planes_decode_max = 32;
+
+/*!
+    \brief Reverse transposition of one word position of N bit-planes
+    into 32 values (bit-plane decode kernel)
+
+    Number of planes is a compile time constant, so the plane loop
+    gets unrolled. With BMI2 planes of up to 8 bits are deposited
+    into bytes (PDEP), 8 values per step.
+
+    \param w - array of N plane words
+    \param arr - target array of 32 values
+
+    @internal
+*/
+template<typename VT, unsigned N>
+void bit_planes_word_decode(const bm::word_t* BMRESTRICT w,
+                            VT* BMRESTRICT arr) BMNOEXCEPT
+{
+#ifdef BMI2_PDEP64
+    if (bm::conditional<(N <= 8)>::test())
+    {
+        for (unsigned k = 0; k < 32; k += 8)
+        {
+            bm::id64_t acc = 0;
+            for (unsigned j = 0; j < N; ++j)
+                acc |= BMI2_PDEP64((w[j] >> k) & 0xFFu,
+                                   0x0101010101010101ULL << j);
+            for (unsigned i = 0; i < 8; ++i)
+                arr[k+i] = VT((acc >> (i * 8)) & 0xFFu);
+        } // for k
+        return;
+    }
+#endif
+    for (unsigned i = 0; i < 32; ++i)
+    {
+        VT v = 0;
+        for (unsigned j = 0; j < N; ++j)
+            v |= VT((w[j] >> i) & 1u) << j;
+        arr[i] = v;
+    } // for i
+}
+
+/*!
+    \brief Reverse transposition of N bit-blocks (bit-planes) into
+    array of values for the words range [nword_from, nword_to)
+
+    \param planes - bit-blocks of planes (must be valid pointers)
+    \param masks - AND masks for plane words (0 - plane is empty)
+    \param nword_from - first word to decode
+    \param nword_to - end word (exclusive)
+    \param arr - target array (32 values per word)
+
+    @internal
+*/
+template<typename VT, unsigned N>
+void bit_block_planes_decode(const bm::word_t* const* BMRESTRICT planes,
+                             const bm::word_t* BMRESTRICT masks,
+                             unsigned nword_from, unsigned nword_to,
+                             VT* BMRESTRICT arr) BMNOEXCEPT
+{
+    bm::word_t w[N];
+    for (unsigned nw = nword_from; nw < nword_to; ++nw, arr += 32)
+    {
+        for (unsigned j = 0; j < N; ++j)
+            w[j] = planes[j][nw] & masks[j];
+        bm::bit_planes_word_decode<VT, N>(w, arr);
+    } // for nw
+}
+
+/*!
+    \brief Dispatch of bit-plane decode to a kernel specialized for the
+    number of planes
+
+    \param n - number of planes (1..bit_planes_decode_max)
+    \return false if number of planes is not supported by the kernels
+
+    @internal
+*/
+template<typename VT>
+bool bit_block_planes_decode(unsigned n,
+                             const bm::word_t* const* BMRESTRICT planes,
+                             const bm::word_t* BMRESTRICT masks,
+                             unsigned nword_from, unsigned nword_to,
+                             VT* BMRESTRICT arr) BMNOEXCEPT
+{
+    #define BM_PLANES_DECODE_CASE(x) \
+        case x: \
+            bm::bit_block_planes_decode<VT, x>(planes, masks, \
+                                               nword_from, nword_to, arr); \
+            return true;
+    switch (n)
+    {
+    BM_PLANES_DECODE_CASE(1)
+    BM_PLANES_DECODE_CASE(2)
+    BM_PLANES_DECODE_CASE(3)
+    BM_PLANES_DECODE_CASE(4)
+    BM_PLANES_DECODE_CASE(5)
+    BM_PLANES_DECODE_CASE(6)
+    BM_PLANES_DECODE_CASE(7)
+    BM_PLANES_DECODE_CASE(8)
+    BM_PLANES_DECODE_CASE(9)
+    BM_PLANES_DECODE_CASE(10)
+    BM_PLANES_DECODE_CASE(11)
+    BM_PLANES_DECODE_CASE(12)
+    BM_PLANES_DECODE_CASE(13)
+    BM_PLANES_DECODE_CASE(14)
+    BM_PLANES_DECODE_CASE(15)
+    BM_PLANES_DECODE_CASE(16)
+    BM_PLANES_DECODE_CASE(17)
+    BM_PLANES_DECODE_CASE(18)
+    BM_PLANES_DECODE_CASE(19)
+    BM_PLANES_DECODE_CASE(20)
+    BM_PLANES_DECODE_CASE(21)
+    BM_PLANES_DECODE_CASE(22)
+    BM_PLANES_DECODE_CASE(23)
+    BM_PLANES_DECODE_CASE(24)
+    BM_PLANES_DECODE_CASE(25)
+    BM_PLANES_DECODE_CASE(26)
+    BM_PLANES_DECODE_CASE(27)
+    BM_PLANES_DECODE_CASE(28)
+    BM_PLANES_DECODE_CASE(29)
+    BM_PLANES_DECODE_CASE(30)
+    BM_PLANES_DECODE_CASE(31)
+    BM_PLANES_DECODE_CASE(32)
+    default:
+        break;
+    }
+    #undef BM_PLANES_DECODE_CASE
+    return false;
+}
+
+/*!
+    \brief In-place transposition of 32x32 bit matrix
+    (bit i of word j is exchanged with bit j of word i)
+
+    Recursive block swap: 16x16, 8x8, 4x4, 2x2 and 1x1 sub-blocks,
+    5 rounds of 16 word pair exchanges.
+
+    @internal
+*/
+inline
+void bit_matrix_transpose32(bm::word_t* BMRESTRICT a) BMNOEXCEPT
+{
+    bm::word_t m = 0x0000FFFFu;
+    for (unsigned j = 16; j != 0; j >>= 1, m ^= (m << j))
+    {
+        for (unsigned k = 0; k < 32; k = (k + j + 1) & ~j)
+        {
+            bm::word_t t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k]     ^= (t << j);
+            a[k + j] ^= t;
+        } // for k
+    } // for j
+}
+
+/*!
+    \brief Forward transposition of 32 values into bit-plane words
+    (bit-plane encode kernel)
+
+    Word j of the result holds bit j of all 32 values
+    (value i goes to bit i of the plane word).
+
+    \param arr - source array of 32 values
+    \param w - target array of plane words (must fit 32 words,
+                64 for 64-bit values)
+    \param n - number of planes to produce
+
+    @internal
+*/
+template<typename VT>
+void bit_planes_word_encode(const VT* BMRESTRICT arr,
+                            bm::word_t* BMRESTRICT w,
+                            unsigned n) BMNOEXCEPT
+{
+    BM_ASSERT(n && n <= sizeof(VT) * 8);
+#ifdef VECT_BIT_PLANES_ENCODE32
+    if (bm::conditional<sizeof(VT) == 4>::test())
+    {
+        VECT_BIT_PLANES_ENCODE32((const unsigned*)arr, w, n);
+        return;
+    }
+#endif
+    if (bm::conditional<sizeof(VT) <= 4>::test())
+    {
+        for (unsigned i = 0; i < 32; ++i)
+            w[i] = bm::word_t(arr[i]);
+        bm::bit_matrix_transpose32(w);
+        return;
+    }
+    // 64-bit values: low and high halves as two 32x32 matrices
+    for (unsigned i = 0; i < 32; ++i)
+        w[i] = bm::word_t(arr[i]);
+    bm::bit_matrix_transpose32(w);
+    if (n > 32)
+    {
+        bm::word_t* w_hi = w + 32;
+        for (unsigned i = 0; i < 32; ++i)
+            w_hi[i] = bm::word_t(bm::id64_t(arr[i]) >> 32);
+        bm::bit_matrix_transpose32(w_hi);
+    }
+}
+
+/*!
+    \brief Forward transposition of an array of values into bit-blocks
+    of planes (OR into the target blocks)
+
+    Values arr[0..len) are placed at bit positions [nbit, nbit+len)
+    of the block. Target bits are expected to be clear.
+
+    \param planes - bit-blocks of planes (NULL - plane is not needed,
+                     no bits of it are set in the source values)
+    \param n - number of planes (size of planes array)
+    \param nbit - start bit in block
+    \param arr - source values
+    \param len - number of values ((nbit + len) <= bm::gap_max_bits)
+
+    @internal
+*/
+template<typename VT>
+void bit_block_planes_encode(bm::word_t* const* BMRESTRICT planes,
+                             unsigned n,
+                             unsigned nbit,
+                             const VT* BMRESTRICT arr,
+                             unsigned len) BMNOEXCEPT
+{
+    BM_ASSERT(len && (nbit + len) <= bm::gap_max_bits);
+    BM_ASSERT(n <= sizeof(VT) * 8);
+
+    bm::word_t BM_VECT_ALIGN w[sizeof(VT) * 8 < 32 ? 32 : sizeof(VT) * 8]
+                                                        BM_VECT_ALIGN_ATTR;
+    VT tmp[32];
+
+    unsigned nword = nbit >> bm::set_word_shift;
+    unsigned nbit_w = nbit & bm::set_word_mask;
+    if (nbit_w) // head: partial word
+    {
+        unsigned cnt = 32 - nbit_w;
+        if (cnt > len)
+            cnt = len;
+        ::memset(tmp, 0, sizeof(tmp));
+        for (unsigned i = 0; i < cnt; ++i)
+            tmp[nbit_w + i] = arr[i];
+        bm::bit_planes_word_encode(tmp, w, n);
+        for (unsigned j = 0; j < n; ++j)
+            if (planes[j])
+                planes[j][nword] |= w[j];
+        arr += cnt; len -= cnt; ++nword;
+    }
+    for (; len >= 32; len -= 32, arr += 32, ++nword)
+    {
+        bm::bit_planes_word_encode(arr, w, n);
+        for (unsigned j = 0; j < n; ++j)
+            if (planes[j])
+                planes[j][nword] |= w[j];
+    } // for
+    if (len) // tail
+    {
+        ::memset(tmp, 0, sizeof(tmp));
+        for (unsigned i = 0; i < len; ++i)
+            tmp[i] = arr[i];
+        bm::bit_planes_word_encode(tmp, w, n);
+        for (unsigned j = 0; j < n; ++j)
+            if (planes[j])
+                planes[j][nword] |= w[j];
+    }
+}
+
+
 } // namespace bm
 
 
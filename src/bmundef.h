@@ -68,6 +68,8 @@ For more information please visit:  http://bitmagic.io
 #undef VECT_IS_ONE_BLOCK
 
 #undef VECT_LOWER_BOUND_SCAN_U32
+#undef VECT_U32_EQ_COUNT
+#undef VECT_STR_CMP_PADDED
 #undef VECT_SHIFT_R1
 #undef VECT_SHIFT_R1_AND
 
@@ -78,6 +80,7 @@ For more information please visit:  http://bitmagic.io
 #undef VECT_BLOCK_CHANGE_BC
 
 #undef VECT_BIT_TO_GAP
+#undef VECT_BIT_PLANES_ENCODE32
 
 #undef VECT_AND_DIGEST
 #undef VECT_AND_DIGEST_2WAY
@@ -86,6 +89,7 @@ For more information please visit:  http://bitmagic.io
 
 #undef VECT_BLOCK_XOR_CHANGE
 #undef VECT_BIT_BLOCK_XOR
+#undef VECT_BIT_BLOCK_XOR_CHANGE_BC
 
 #undef VECT_BIT_FIND_FIRST
 #undef VECT_BIT_FIND_DIFF
@@ -93,6 +97,8 @@ For more information please visit:  http://bitmagic.io
 
 #undef BMI1_SELECT64
 #undef BMI2_SELECT64
+#undef BMI2_PDEP64
+#undef BMI2_BZHI64
 
 #undef BM_UNALIGNED_ACCESS_OK
 #undef BM_x86
@@ -285,6 +285,56 @@ void compute_xor_complexity_descr(
     return;
 }
 
+/**
+    Upper bound of the XOR gain (as computed by compute_xor_complexity_descr)
+    which can be achieved by a reference block, estimated only from
+    complexity descriptors (sb_gc, sb_bc) of both blocks:
+     - popcount(a^b) >= |popcount(a) - popcount(b)|
+     - popcount(a^b) <= min(popcount(a)+popcount(b), 2W-popcount(a)-popcount(b))
+     - changes(a^b) >= |changes(a) - changes(b)|
+
+    Used to prune reference candidates without computing the XOR
+    descriptor.
+
+    @param x_descr - descriptor of the target block
+    @param ref_descr - descriptor of the reference block
+    @param d0 - digest of zero waves of the target (~calc_block_digest0())
+
+    @internal
+*/
+inline
+unsigned xor_gain_upper_bound(
+                    const bm::block_waves_xor_descr& BMRESTRICT x_descr,
+                    const bm::block_waves_xor_descr& BMRESTRICT ref_descr,
+                    bm::id64_t d0) BMNOEXCEPT
+{
+    const int wave_max_bits = bm::set_block_digest_wave_size * 32;
+    unsigned gc_gain(0), bc_gain(0), ibc_gain(0);
+    for (unsigned i = 0; i < bm::block_waves; ++i)
+    {
+        if (d0 & (1ull << i))
+            continue;
+        int gc = x_descr.sb_gc[i], bc = x_descr.sb_bc[i];
+        int r_gc = ref_descr.sb_gc[i], r_bc = ref_descr.sb_bc[i];
+
+        int lb_gc = (gc > r_gc) ? gc - r_gc : r_gc - gc;
+        gc_gain += unsigned((lb_gc <= 1) ? gc : (lb_gc < gc ? gc - lb_gc : 0));
+
+        int lb_bc = (bc > r_bc) ? bc - r_bc : r_bc - bc;
+        bc_gain += unsigned((lb_bc < bc) ? bc - lb_bc : 0);
+
+        int ub_bc = bc + r_bc;
+        if (ub_bc > 2 * wave_max_bits - bc - r_bc)
+            ub_bc = 2 * wave_max_bits - bc - r_bc;
+        ibc_gain += unsigned((ub_bc > bc) ? ub_bc - bc : 0);
+    } // for i
+    unsigned gain = (gc_gain > bc_gain) ? gc_gain : bc_gain;
+    if (ibc_gain > gain)
+        gain = ibc_gain;
+    // no-gain case may still report a digest match gain
+    return (gain > bm::block_waves) ? gain : unsigned(bm::block_waves);
+}
+
 /**
     Build partial XOR product of 2 bit-blocks using digest mask
 
@@ -333,6 +383,81 @@ void bit_block_xor(bm::word_t*  target_block,
 }
 
 
+/**
+    Build partial XOR product of 2 bit-blocks using digest mask and
+    compute bit count and number of bit changes of the product in one
+    pass (fused bit_block_xor() and bit_block_change_bc())
+
+    @param target_block - target := block ^ xor_block
+    @param block - arg1
+    @param xor_block - arg2
+    @param digest - mask for each block wave to XOR (1) or just copy (0)
+    @param gc - [out] gap count of the product
+    @param bc - [out] bit count of the product
+
+    @internal
+*/
+inline
+void bit_block_xor_change_bc(bm::word_t* BMRESTRICT target_block,
+                             const bm::word_t* BMRESTRICT block,
+                             const bm::word_t* BMRESTRICT xor_block,
+                             bm::id64_t digest,
+                             unsigned* BMRESTRICT gc,
+                             unsigned* BMRESTRICT bc) BMNOEXCEPT
+{
+    BM_ASSERT(target_block);
+    BM_ASSERT(block);
+    BM_ASSERT(xor_block);
+    BM_ASSERT(gc && bc);
+
+#ifdef VECT_BIT_BLOCK_XOR_CHANGE_BC
+    VECT_BIT_BLOCK_XOR_CHANGE_BC(target_block, block, xor_block, digest, gc, bc);
+#else
+    const int w_shift = int(sizeof(bm::word_t) * 8 - 1);
+    unsigned gap_count = 1;
+    unsigned bit_count = 0;
+    bm::word_t w, w0, w_l, w_prev = 0;
+
+    for (unsigned i = 0; i < bm::block_waves; ++i)
+    {
+        // all 1s mask for XOR filtered sub-block, 0 - just copy
+        const bm::word_t wave_mask = bm::word_t(0) - bm::word_t((digest >> i) & 1u);
+        unsigned off = (i * bm::set_block_digest_wave_size);
+        for (unsigned k = off; k < off + bm::set_block_digest_wave_size; ++k)
+        {
+            target_block[k] = w = w0 = block[k] ^ (xor_block[k] & wave_mask);
+            bit_count += bm::word_bitcount(w);
+            if (!k)
+            {
+                w ^= (w >> 1);
+                gap_count += bm::word_bitcount(w);
+                gap_count -= (w_prev = (w0 >> w_shift)); // negative correction
+                continue;
+            }
+            ++gap_count;
+            if (!w)
+            {
+                gap_count -= !w_prev;
+                w_prev = 0;
+            }
+            else
+            {
+                w ^= (w >> 1);
+                gap_count += bm::word_bitcount(w);
+
+                w_l = w0 & 1;
+                gap_count -= (w0 >> w_shift);  // negative value correction
+                gap_count -= !(w_prev ^ w_l);  // word border correction
+
+                w_prev = (w0 >> w_shift);
+            }
+        } // for k
+    } // for i
+    *gc = gap_count;
+    *bc = bit_count;
+#endif
+}
+
 /**
     List of reference bit-vectors with their true index associations
 
@@ -456,6 +581,85 @@ protected:
     bv_plane_vector_type     ref_bvects_rows_;  ///< reference vector row idxs
 };
 
+/**
+    Pre-computed results of the XOR reference search (xor_scanner) for
+    a list of reference vectors: best reference per (vector, block).
+    Vectors are addressed by position in the reference list.
+
+    Plan is computed in parallel (see xor_plan_builder) and used by
+    serializer instead of the search (see serializer::set_xor_plan()).
+
+    @internal
+*/
+template<typename BV>
+class xor_search_plan
+{
+public:
+    typedef BV                                          bvector_type;
+    typedef typename bvector_type::size_type            size_type;
+    typedef typename bvector_type::block_idx_type       block_idx_type;
+    typedef typename bvector_type::allocator_type       bv_allocator_type;
+
+    /// Search result for a block
+    struct match
+    {
+        block_idx_type nb;    ///< block index
+        size_type      ridx;  ///< found reference (position in ref.vector)
+        bm::id64_t     d64;   ///< XOR digest (0 for GAP blocks)
+    };
+    typedef bm::heap_vector<match, bv_allocator_type, true>  match_vector_type;
+    typedef bm::heap_vector<size_t, bv_allocator_type, true> offset_vector_type;
+
+public:
+    /// Reset the plan for a reference list of ref_size vectors
+    void init(size_type ref_size)
+    {
+        matches_.resize(0);
+        off_.resize(ref_size + 1);
+        for (size_type i = 0; i <= ref_size; ++i)
+            off_[i] = 0;
+    }
+
+    /// Number of vectors in the plan
+    size_type size() const BMNOEXCEPT
+        { return off_.size() ? size_type(off_.size() - 1) : 0; }
+
+    /// Total number of matches
+    size_t matches() const BMNOEXCEPT { return matches_.size(); }
+
+    /**
+        Find match for vector r, block nb
+        @return NULL if reference was not found
+    */
+    const match* find(size_type r, block_idx_type nb) const BMNOEXCEPT
+    {
+        if (r >= size())
+            return 0;
+        size_t from = off_[r], to = off_[r+1];
+        while (from < to) // binary search, matches are sorted by block
+        {
+            size_t mid = (from + to) >> 1;
+            const match& m = matches_[mid];
+            if (m.nb == nb)
+                return &m;
+            if (m.nb < nb)
+                from = mid + 1;
+            else
+                to = mid;
+        }
+        return 0;
+    }
+
+    /// Access to matches for plan building, sorted by (vector, block)
+    match_vector_type& get_matches() BMNOEXCEPT { return matches_; }
+    /// Access to offsets (of the first match) for plan building
+    offset_vector_type& get_offsets() BMNOEXCEPT { return off_; }
+
+protected:
+    match_vector_type   matches_; ///< matches sorted by (vector, block)
+    offset_vector_type  off_;     ///< offsets of vector matches (size+1)
+};
+
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
@@ -487,13 +691,26 @@ public:
     void compute_x_block_stats(const bm::word_t* block) BMNOEXCEPT;
 
     /** Scan for all candidate bit-blocks to find mask or match
+        @param ref_descr - optional complexity descriptors of the reference
+        blocks [i, j] (indexed by reference position), used to skip
+        candidates which cannot improve the best gain found so far
         @return true if XOR complement or matching vector found
     */
     bool search_best_xor_mask(const bm::word_t* block,
                               size_type ridx_from,
                               size_type ridx_to,
                               unsigned i, unsigned j,
-                              bm::word_t* tb);
+                              bm::word_t* tb,
+                const bm::block_waves_xor_descr* ref_descr = 0);
+
+    /** Set search result found by other means (pre-computed search plan)
+        as if it was found by search_best_xor_mask()
+    */
+    void set_found(size_type ridx, const bm::word_t* block_xor,
+                   bm::id64_t d64) BMNOEXCEPT
+    {
+        found_ridx_ = ridx; found_block_xor_ = block_xor; x_d64_ = d64;
+    }
 
     /** Scan all candidate gap-blocks to find best XOR match
     */
@@ -593,7 +810,8 @@ bool xor_scanner<BV>::search_best_xor_mask(const bm::word_t* block,
                                            size_type ridx_from,
                                            size_type ridx_to,
                                            unsigned i, unsigned j,
-                                           bm::word_t* tb)
+                                           bm::word_t* tb,
+                            const bm::block_waves_xor_descr* ref_descr)
 {
     BM_ASSERT(ridx_from <= ridx_to);
     BM_ASSERT(IS_VALID_ADDR(block));
@@ -609,6 +827,7 @@ bool xor_scanner<BV>::search_best_xor_mask(const bm::word_t* block,
 
     unsigned best_block_gain = 0;
     int best_ri = -1;
+    bm::id64_t d0 = ref_descr ? ~bm::calc_block_digest0(block) : 0;
 
     for (size_type ri = ridx_from; ri < ridx_to; ++ri)
     {
@@ -617,6 +836,13 @@ bool xor_scanner<BV>::search_best_xor_mask(const bm::word_t* block,
             continue;
 
         BM_ASSERT(block != block_xor);
+        if (ref_descr && best_block_gain) // prune by the gain estimate
+        {
+            unsigned gain_ub =
+                bm::xor_gain_upper_bound(x_descr_, ref_descr[ri], d0);
+            if (gain_ub <= best_block_gain)
+                continue;
+        }
 
         unsigned block_gain = 0;
 
@@ -648,8 +874,8 @@ bool xor_scanner<BV>::search_best_xor_mask(const bm::word_t* block,
         unsigned xor_bc, xor_gc, xor_ibc;
         const bm::word_t* block_xor = get_ref_block(size_type(best_ri), i, j);
 
-        bm::bit_block_xor(tb, block, block_xor, d64);
-        bm::bit_block_change_bc(tb, &xor_gc, &xor_bc);
+        bm::bit_block_xor_change_bc(tb, block, block_xor, d64,
+                                    &xor_gc, &xor_bc);
 
         if (!xor_bc) // completely identical block?
         {
@@ -816,10 +1042,8 @@ xor_scanner<BV>::validate_found(bm::word_t* xor_block,
     bm::id64_t d64 = get_xor_digest();
     BM_ASSERT(d64);
     const bm::word_t* key_block = get_found_block();
-    bm::bit_block_xor(xor_block, block, key_block, d64); // TODO: use one pass operation XOR + BC/GC
-
     unsigned bc, gc;
-    bm::bit_block_change_bc(xor_block, &gc, &bc);
+    bm::bit_block_xor_change_bc(xor_block, block, key_block, d64, &gc, &bc);
 
     unsigned xor_best_metric;
     bm::xor_complement_match mtype = best_metric(bc, gc, &xor_best_metric);
@@ -197,12 +197,17 @@ public:
 
     /// Elias Gamma encode the specified value
     void gamma(unsigned value) BMNOEXCEPT;
+
+    /// Elias Gamma encode D-GAPs of a sorted array:
+    /// arr[0]+1, arr[1]-arr[0], ... arr[sz-1]-arr[sz-2]
+    void gamma_dgap_u16(const bm::gap_word_t* arr, unsigned sz) BMNOEXCEPT;
     
     /// Binary Interpolative array decode
     void bic_encode_u16(const bm::gap_word_t* arr, unsigned sz,
                         bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT
     {
-        bic_encode_u16_cm(arr, sz, lo, hi);
+        if (sz)
+            bic_encode_u16_cm_it(arr, sz, lo, hi);
     }
 
     /// Binary Interpolative encoding (array of 16-bit ints)
@@ -216,6 +221,12 @@ public:
                            bm::gap_word_t lo,
                            bm::gap_word_t hi) BMNOEXCEPT;
 
+    /// Binary Interpolative encoding (array of 16-bit ints)
+    /// Non-recursive version of bic_encode_u16_cm() (same bit-stream)
+    void bic_encode_u16_cm_it(const bm::gap_word_t* arr, unsigned sz,
+                              bm::gap_word_t lo,
+                              bm::gap_word_t hi) BMNOEXCEPT;
+
     /// Binary Interpolative encoding (array of 32-bit ints)
     /// cm - "center-minimal"
     void bic_encode_u32_cm(const bm::word_t* arr, unsigned sz,
@@ -259,6 +270,10 @@ public:
 
     /// decode unsigned value using Elias Gamma coding
     unsigned gamma() BMNOEXCEPT;
+
+    /// decode sz Elias Gamma D-GAPs into a sorted array
+    /// (inverse of bit_out::gamma_dgap_u16())
+    void gamma_dgap_u16(bm::gap_word_t* arr, unsigned sz) BMNOEXCEPT;
     
     /// read number of bits out of the stream
     unsigned get_bits(unsigned count) BMNOEXCEPT;
@@ -271,20 +286,20 @@ public:
                         bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT
     {
         if (sz)
-            bic_decode_u16_cm(arr, sz, lo, hi);
+            bic_decode_u16_cm_it(arr, sz, lo, hi);
     }
     
     void bic_decode_u16_bitset(bm::word_t* block, unsigned sz,
                                bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT
     {
         if (sz)
-            bic_decode_u16_cm_bitset(block, sz, lo, hi);
+            bic_decode_u16_cm_bitset_it(block, sz, lo, hi);
     }
     void bic_decode_u16_dry(unsigned sz,
                             bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT
     {
         if (sz)
-            bic_decode_u16_cm_dry(sz, lo, hi);
+            bic_decode_u16_cm_dry_it(sz, lo, hi);
     }
 
 
@@ -317,6 +332,34 @@ public:
     void bic_decode_u16_cm_dry(unsigned sz,
                                bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT;
 
+    /// Binary Interpolative array decode
+    /// Non-recursive version of bic_decode_u16_cm()
+    void bic_decode_u16_cm_it(bm::gap_word_t* arr, unsigned sz,
+                              bm::gap_word_t lo, bm::gap_word_t hi) BMNOEXCEPT;
+
+    /// Binary Interpolative array decode into bitset
+    /// Non-recursive version of bic_decode_u16_cm_bitset()
+    void bic_decode_u16_cm_bitset_it(bm::word_t* block, unsigned sz,
+                                     bm::gap_word_t lo,
+                                     bm::gap_word_t hi) BMNOEXCEPT;
+
+    /// Binary Interpolative array decode into /dev/null
+    /// Non-recursive version of bic_decode_u16_cm_dry()
+    void bic_decode_u16_cm_dry_it(unsigned sz,
+                                  bm::gap_word_t lo,
+                                  bm::gap_word_t hi) BMNOEXCEPT;
+
+private:
+    /// read one center-minimal BIC value (range r) from the 64-bit
+    /// look-ahead window (buf, avail)
+    unsigned bic_read_cm(unsigned r,
+                         bm::id64_t& buf, unsigned& avail) BMNOEXCEPT;
+
+    /// BIC decode traversal (pre-order, explicit stack)
+    template<class TFunc>
+    void bic_decode_u16_cm_traverse(unsigned sz,
+                                    bm::gap_word_t lo, bm::gap_word_t hi,
+                                    TFunc& func) BMNOEXCEPT;
 private:
     bit_in(const bit_in&);
     bit_in& operator=(const bit_in&);
@@ -1211,6 +1254,64 @@ void bit_out<TEncoder>::gamma(unsigned value) BMNOEXCEPT
 
 // ----------------------------------------------------------------------
 
+template<typename TEncoder>
+void bit_out<TEncoder>::gamma_dgap_u16(const bm::gap_word_t* arr,
+                                       unsigned sz) BMNOEXCEPT
+{
+    if (!sz)
+        return;
+#if defined(BM64OPT) || defined(BM64_SSE4) || defined(BM64_AVX2) || \
+    defined(BM64_AVX512)
+    // 64-bit accumulator: a code word is at most 33 bits (value <= 65536)
+    // and always fits next to the < 32 bits pending in the accumulator
+    const unsigned acc_bits = unsigned(sizeof(accum_) * 8);
+    bm::id64_t acc = accum_;
+    unsigned used = used_bits_;
+    if (used == acc_bits) // gamma() leaves the full accumulator pending
+    {
+        dest_.put_32(unsigned(acc));
+        acc = used = 0;
+    }
+
+    unsigned prev = unsigned(arr[0]);
+    unsigned value = prev + 1;
+    for (unsigned i = 0; true; )
+    {
+        BM_ASSERT(value && value <= 65536);
+        unsigned logv = bm::bit_scan_reverse32(value);
+        // logv 0s, 1, logv low bits of the value
+        bm::id64_t code = (bm::id64_t(value & ~(1u << logv)) << (logv + 1)) |
+                          (1ull << logv);
+        acc |= code << used;
+        used += logv + logv + 1;
+        if (used >= acc_bits)
+        {
+            dest_.put_32(unsigned(acc));
+            acc >>= acc_bits;
+            used -= acc_bits;
+        }
+        if (++i == sz)
+            break;
+        unsigned curr = arr[i];
+        value = curr - prev;
+        prev = curr;
+    } // for i
+    accum_ = unsigned(acc);
+    used_bits_ = used;
+#else
+    bm::gap_word_t prev = arr[0];
+    gamma(unsigned(prev) + 1);
+    for (unsigned i = 1; i < sz; ++i)
+    {
+        bm::gap_word_t curr = arr[i];
+        gamma(bm::gap_word_t(curr - prev));
+        prev = curr;
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------
+
 template<typename TEncoder>
 void bit_out<TEncoder>::bic_encode_u16_rg(
                                 const bm::gap_word_t* arr,
@@ -1414,6 +1515,85 @@ void bit_out<TEncoder>::bic_encode_u16_cm(const bm::gap_word_t* arr,
     } // for sz
 }
 
+// ----------------------------------------------------------------------
+
+template<typename TEncoder>
+void bit_out<TEncoder>::bic_encode_u16_cm_it(const bm::gap_word_t* arr,
+                                             unsigned sz,
+                                             bm::gap_word_t lo,
+                                             bm::gap_word_t hi) BMNOEXCEPT
+{
+    BM_ASSERT(sz);
+    struct stack_entry
+    {
+        const bm::gap_word_t* arr;
+        unsigned              sz;
+        unsigned              lo;
+        unsigned              hi;
+    };
+    // depth is bound by the height of the BIC tree (log2(65536)+1)
+    stack_entry stack[32];
+    unsigned depth = 0;
+
+    const unsigned acc_bits = unsigned(sizeof(accum_) * 8);
+    bm::id64_t acc = accum_;
+    unsigned used = used_bits_;
+    BM_ASSERT(used <= acc_bits); // code words are short: fits 64-bit acc
+
+    unsigned lo_i = lo, hi_i = hi;
+    while (true)
+    {
+        BM_ASSERT(lo_i <= hi_i);
+        // r == 0: dense run, the whole sub-tree is implied by [lo, hi]
+        unsigned r = hi_i - lo_i - sz + 1;
+        if (r)
+        {
+            unsigned mid_idx = sz >> 1;
+            unsigned val = arr[mid_idx];
+            unsigned value = val - lo_i - mid_idx;
+
+            unsigned n = r + 1;
+            unsigned logv = bm::bit_scan_reverse32(n);
+            unsigned c = (unsigned)(1ull << (logv + 1)) - n;
+            unsigned half_c = c >> 1; // c / 2;
+            unsigned half_r = r >> 1; // r / 2;
+            int64_t  lo1 = (int64_t(half_r) - half_c - (n & 1u));
+            unsigned hi1 = (half_r + half_c);
+            logv += (value <= lo1 || value > hi1);
+            BM_ASSERT(value < (1u << logv));
+
+            acc |= bm::id64_t(value) << used;
+            used += logv;
+            if (used >= acc_bits)
+            {
+                dest_.put_32(unsigned(acc));
+                acc >>= acc_bits;
+                used -= acc_bits;
+            }
+
+            unsigned right_sz = sz - mid_idx - 1;
+            if (right_sz)
+            {
+                BM_ASSERT(depth < sizeof(stack)/sizeof(stack[0]));
+                stack_entry& se = stack[depth++];
+                se.arr = arr + mid_idx + 1; se.sz = right_sz;
+                se.lo = val + 1; se.hi = hi_i;
+            }
+            if (mid_idx)
+            {
+                sz = mid_idx; hi_i = val - 1;
+                continue;
+            }
+        }
+        if (!depth)
+            break;
+        const stack_entry& se = stack[--depth];
+        arr = se.arr; sz = se.sz; lo_i = se.lo; hi_i = se.hi;
+    } // while
+    accum_ = unsigned(acc);
+    used_bits_ = used;
+}
+
 
 
 
@@ -1745,6 +1925,190 @@ void bit_in<TDecoder>::bic_decode_u16_rg_dry(unsigned sz,
 
 
 
+// ----------------------------------------------------------------------
+
+/// BIC decode functor: array of 16-bit ints
+/// @internal
+struct bic_decode_func_arr_u16
+{
+    bm::gap_word_t* arr_;
+
+    void add(unsigned idx, unsigned val) BMNOEXCEPT
+        { arr_[idx] = bm::gap_word_t(val); }
+    void add_range(unsigned idx, unsigned val, unsigned cnt) BMNOEXCEPT
+    {
+        bm::gap_word_t* BMRESTRICT arr = arr_ + idx;
+        for (unsigned i = 0; i < cnt; ++i) // vectorizable
+            arr[i] = bm::gap_word_t(val + i);
+    }
+};
+
+/// BIC decode functor: bit-block
+/// @internal
+struct bic_decode_func_bitset
+{
+    bm::word_t* block_;
+
+    void add(unsigned, unsigned val) BMNOEXCEPT
+    {
+        unsigned nword = (val >> bm::set_word_shift);
+        block_[nword] |= (1u << (val & bm::set_word_mask));
+    }
+    void add_range(unsigned, unsigned val, unsigned cnt) BMNOEXCEPT
+        { bm::or_bit_block(block_, val, cnt); }
+};
+
+/// BIC decode functor: /dev/null
+/// @internal
+struct bic_decode_func_dry
+{
+    void add(unsigned, unsigned) BMNOEXCEPT {}
+    void add_range(unsigned, unsigned, unsigned) BMNOEXCEPT {}
+};
+
+// ----------------------------------------------------------------------
+
+template<class TDecoder>
+BMFORCEINLINE
+unsigned bit_in<TDecoder>::bic_read_cm(unsigned r,
+                                       bm::id64_t& buf,
+                                       unsigned& avail) BMNOEXCEPT
+{
+    BM_ASSERT(r);
+    unsigned logv = bm::bit_scan_reverse32(r+1);
+    unsigned c = unsigned((1ull << (logv + 1)) - r - 1);
+    int64_t half_c = c >> 1; // c / 2;
+    int64_t half_r = r >> 1; // r / 2;
+    int64_t lo1 = half_r - half_c - ((r + 1) & 1);
+    int64_t hi1 = half_r + half_c + 1;
+
+    // the window is refilled only when the bits are needed, so the
+    // stream is consumed word by word exactly as get_bits() does
+    if (avail < logv)
+    {
+        buf |= bm::id64_t(src_.get_32()) << avail;
+        avail += 32;
+    }
+    #if defined(BMI2_BZHI64)
+        unsigned val = unsigned(BMI2_BZHI64(buf, logv));
+    #else
+        unsigned val = unsigned(buf & ((1ull << logv) - 1));
+    #endif
+    // long code word: one more bit (branchless, the branch is
+    // unpredictable on real data)
+    unsigned ext = unsigned(val <= lo1) | unsigned(val >= hi1);
+    if (avail < logv + ext)
+    {
+        buf |= bm::id64_t(src_.get_32()) << avail;
+        avail += 32;
+    }
+    val |= unsigned((buf >> logv) & ext) << logv;
+    logv += ext;
+    buf >>= logv;
+    avail -= logv;
+    return val;
+}
+
+// ----------------------------------------------------------------------
+
+template<class TDecoder> template<class TFunc>
+void bit_in<TDecoder>::bic_decode_u16_cm_traverse(unsigned sz,
+                                                  bm::gap_word_t lo,
+                                                  bm::gap_word_t hi,
+                                                  TFunc& func) BMNOEXCEPT
+{
+    BM_ASSERT(sz);
+    struct stack_entry
+    {
+        unsigned idx; ///< index of the first element in the output array
+        unsigned sz;
+        unsigned lo;
+        unsigned hi;
+    };
+    // depth is bound by the height of the BIC tree (log2(65536)+1)
+    stack_entry stack[32];
+    unsigned depth = 0;
+
+    // 64-bit look-ahead window on the stream (bits above avail are 0)
+    const unsigned acc_bits = unsigned(sizeof(accum_) * 8);
+    unsigned avail = acc_bits - used_bits_;
+    bm::id64_t buf = avail ? (accum_ & (~0u >> (acc_bits - avail))) : 0;
+
+    unsigned idx = 0, lo_i = lo, hi_i = hi;
+    while (true)
+    {
+        BM_ASSERT(lo_i <= hi_i);
+        unsigned r = hi_i - lo_i - sz + 1;
+        if (!r) // dense run: sub-tree carries no bits
+        {
+            func.add_range(idx, lo_i, sz);
+        }
+        else
+        {
+            unsigned mid_idx = sz >> 1;
+            unsigned val = bic_read_cm(r, buf, avail) + lo_i + mid_idx;
+            BM_ASSERT(val < 65536);
+            func.add(idx + mid_idx, val);
+
+            unsigned right_sz = sz - mid_idx - 1;
+            if (right_sz)
+            {
+                BM_ASSERT(depth < sizeof(stack)/sizeof(stack[0]));
+                stack_entry& se = stack[depth++];
+                se.idx = idx + mid_idx + 1; se.sz = right_sz;
+                se.lo = val + 1; se.hi = hi_i;
+            }
+            if (mid_idx)
+            {
+                sz = mid_idx; hi_i = val - 1;
+                continue;
+            }
+        }
+        if (!depth)
+            break;
+        const stack_entry& se = stack[--depth];
+        idx = se.idx; sz = se.sz; lo_i = se.lo; hi_i = se.hi;
+    } // while
+
+    BM_ASSERT(avail <= acc_bits);
+    accum_ = unsigned(buf);
+    used_bits_ = acc_bits - avail;
+}
+
+// ----------------------------------------------------------------------
+
+template<class TDecoder>
+void bit_in<TDecoder>::bic_decode_u16_cm_it(bm::gap_word_t* arr, unsigned sz,
+                                            bm::gap_word_t lo,
+                                            bm::gap_word_t hi) BMNOEXCEPT
+{
+    bm::bic_decode_func_arr_u16 func = { arr };
+    bic_decode_u16_cm_traverse(sz, lo, hi, func);
+}
+
+// ----------------------------------------------------------------------
+
+template<class TDecoder>
+void bit_in<TDecoder>::bic_decode_u16_cm_bitset_it(bm::word_t* block,
+                                                   unsigned sz,
+                                                   bm::gap_word_t lo,
+                                                   bm::gap_word_t hi) BMNOEXCEPT
+{
+    bm::bic_decode_func_bitset func = { block };
+    bic_decode_u16_cm_traverse(sz, lo, hi, func);
+}
+
+// ----------------------------------------------------------------------
+
+template<class TDecoder>
+void bit_in<TDecoder>::bic_decode_u16_cm_dry_it(unsigned sz,
+                                                bm::gap_word_t lo,
+                                                bm::gap_word_t hi) BMNOEXCEPT
+{
+    bm::bic_decode_func_dry func;
+    bic_decode_u16_cm_traverse(sz, lo, hi, func);
+}
+
 // ----------------------------------------------------------------------
 
 template<class TDecoder>
@@ -1832,6 +2196,67 @@ ret:
 
 // ----------------------------------------------------------------------
 
+template<class TDecoder>
+void bit_in<TDecoder>::gamma_dgap_u16(bm::gap_word_t* arr,
+                                      unsigned sz) BMNOEXCEPT
+{
+#if defined(BM64OPT) || defined(BM64_SSE4) || defined(BM64_AVX2) || \
+    defined(BM64_AVX512)
+    // 64-bit look-ahead window (bits above avail are 0), several
+    // code words are decoded per 32-bit refill;
+    // refill happens only when the bits are needed, so the stream is
+    // consumed exactly as gamma() does it
+    const unsigned acc_bits = unsigned(sizeof(accum_) * 8);
+    unsigned avail = acc_bits - used_bits_;
+    bm::id64_t buf = avail ? (accum_ & (~0u >> (acc_bits - avail))) : 0;
+
+    bm::gap_word_t sum = bm::gap_word_t(~0u); // first D-GAP is +1
+    for (unsigned i = 0; i < sz; ++i)
+    {
+        BM_ASSERT(avail <= acc_bits);
+        if (!buf) // 0s run continues in the next word
+        {
+            buf |= bm::id64_t(src_.get_32()) << avail;
+            avail += 32;
+            BM_ASSERT(buf);
+        }
+        unsigned zero_bits = bm::count_trailing_zeros_u64(buf);
+        BM_ASSERT(zero_bits <= 16);
+        unsigned code_bits = zero_bits + zero_bits + 1;
+        if (avail < code_bits)
+        {
+            buf |= bm::id64_t(src_.get_32()) << avail;
+            avail += 32;
+        }
+        unsigned value = unsigned(buf >> (zero_bits + 1));
+        #if defined(BMI2_BZHI64)
+            value = unsigned(BMI2_BZHI64(value, zero_bits));
+        #else
+            value &= (1u << zero_bits) - 1;
+        #endif
+        value |= (1u << zero_bits);
+        buf >>= code_bits;
+        avail -= code_bits;
+
+        sum = bm::gap_word_t(sum + value);
+        arr[i] = sum;
+    } // for i
+
+    BM_ASSERT(avail <= acc_bits);
+    accum_ = unsigned(buf);
+    used_bits_ = acc_bits - avail;
+#else
+    bm::gap_word_t sum = bm::gap_word_t(~0u); // first D-GAP is +1
+    for (unsigned i = 0; i < sz; ++i)
+    {
+        sum = bm::gap_word_t(sum + gamma());
+        arr[i] = sum;
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------
+
 template<class TDecoder>
 unsigned bit_in<TDecoder>::get_bits(unsigned count) BMNOEXCEPT
 {
@@ -37,12 +37,16 @@ For more information please visit:  http://bitmagic.io
 #include <vector>
 #include <random>
 #include <memory>
+#include <mutex>
 
 #include "bm.h"
 #include "bmalgo.h"
+#include "bmalgo_similarity.h"
+#include "bmminhash.h"
 #include "bmintervals.h"
 #include "bmaggregator.h"
 #include "bmserial.h"
+#include "bmserial_cost.h"
 #include "bmsparsevec.h"
 #include "bmsparsevec_algo.h"
 #include "bmsparsevec_serial.h"
@@ -858,6 +862,131 @@ void BitCountSparseTest()
     delete bset;
 }
 
+static
+void RankSelectRandomTest()
+{
+    bvect bv;
+    {
+        bvect::bulk_insert_iterator iit(bv);
+        for (unsigned i = 0; i < BSIZE * 4; i += 1 + unsigned(rand()) % 4)
+            iit = i;
+    }
+    std::unique_ptr<bvect::rs_index_type> rs_idx(new bvect::rs_index_type());
+    bv.build_rs_index(rs_idx.get());
+
+    const unsigned qsize = 2000000;
+    std::vector<unsigned> qvect(qsize);
+    for (unsigned i = 0; i < qsize; ++i)
+        qvect[i] = unsigned(rand_dis(gen)) * 4;
+
+    size_t value = 0;
+    {
+        bm::chrono_taker tt("count_to: random queries (rs_index)", qsize);
+        for (unsigned i = 0; i < qsize; ++i)
+            value += bv.count_to(qvect[i], *rs_idx);
+    }
+    {
+        bm::chrono_taker tt("rank_corrected: random queries (rs_index)", qsize);
+        for (unsigned i = 0; i < qsize; ++i)
+            value += bv.rank_corrected(qvect[i], *rs_idx);
+    }
+    const bvect::size_type cnt = rs_idx->count();
+    for (unsigned i = 0; i < qsize; ++i)
+        qvect[i] = 1 + unsigned(rand_dis(gen) % cnt);
+    {
+        bm::chrono_taker tt("select: random queries (rs_index)", qsize);
+        for (unsigned i = 0; i < qsize; ++i)
+        {
+            bvect::size_type pos;
+            if (bv.select(qvect[i], pos, *rs_idx))
+                value += pos;
+        }
+    }
+
+    // sorted (monotonic) queries: one-by-one vs batch
+    std::vector<bvect::size_type> sq(qsize), sout(qsize);
+    for (unsigned i = 0; i < qsize; ++i)
+        sq[i] = unsigned(rand_dis(gen)) * 4;
+    std::sort(sq.begin(), sq.end());
+    {
+        bm::chrono_taker tt("count_to: sorted queries", qsize);
+        for (unsigned i = 0; i < qsize; ++i)
+            sout[i] = bv.count_to(sq[i], *rs_idx);
+    }
+    {
+        bm::chrono_taker tt("rank_batch: sorted queries", qsize);
+        bv.rank_batch(sq.data(), sout.data(), qsize, *rs_idx);
+    }
+    for (unsigned i = 0; i < qsize; ++i)
+        sq[i] = 1 + unsigned(rand_dis(gen) % cnt);
+    std::sort(sq.begin(), sq.end());
+    {
+        bm::chrono_taker tt("select: sorted queries", qsize);
+        for (unsigned i = 0; i < qsize; ++i)
+            bv.select(sq[i], sout[i], *rs_idx);
+    }
+    {
+        bm::chrono_taker tt("select_batch: sorted queries", qsize);
+        value += bv.select_batch(sq.data(), sout.data(), qsize, *rs_idx);
+    }
+    value += sout[qsize / 2];
+
+    char buf[256];
+    sprintf(buf, "%i", (int)value); // to fool some smart compilers like ICC
+}
+
+static
+void SelectSparseTest()
+{
+    bvect bv;
+    for (unsigned i = 0; i < 100000; ++i)
+        bv.set(unsigned(rand_dis(gen)) * 28u);
+    bv.optimize();
+
+    std::unique_ptr<bvect::rs_index_type> rs_idx(new bvect::rs_index_type());
+    bv.build_rs_index(rs_idx.get());
+    const bvect::size_type cnt = rs_idx->count();
+
+    const unsigned qsize = 2000000;
+    std::vector<unsigned> rvect(qsize), fvect(qsize);
+    for (unsigned i = 0; i < qsize; ++i)
+    {
+        rvect[i] = 1 + unsigned(rand_dis(gen) % cnt);
+        fvect[i] = unsigned(rand_dis(gen)) * 28u;
+    }
+    size_t value = 0;
+    for (unsigned sampled = 0; sampled < 2; ++sampled)
+    {
+        if (sampled) // select samples: block of every 8-th rank
+        {
+            rs_idx->set_select_sampling(1);
+            bv.build_rs_index(rs_idx.get());
+        }
+        {
+            bm::chrono_taker tt(sampled ? "select: sparse vector (sampled)"
+                                        : "select: sparse vector", qsize);
+            for (unsigned i = 0; i < qsize; ++i)
+            {
+                bvect::size_type pos;
+                if (bv.select(rvect[i], pos, *rs_idx))
+                    value += pos;
+            }
+        }
+        {
+            bm::chrono_taker tt(sampled ? "find_rank: sparse vector (sampled)"
+                                        : "find_rank: sparse vector", qsize);
+            for (unsigned i = 0; i < qsize; ++i)
+            {
+                bvect::size_type pos;
+                if (bv.find_rank(1 + (i & 7), fvect[i], pos, *rs_idx))
+                    value += pos;
+            }
+        }
+    } // for sampled
+    char buf[256];
+    sprintf(buf, "%i", (int)value); // to fool some smart compilers like ICC
+}
+
 static
 void BitTestSparseTest()
 {
@@ -1449,6 +1578,45 @@ void SerializationTest()
     delete [] buf;
 }
 
+static
+void SerializationDecodeCostTest()
+{
+    bm::serializer_decode_cost cost;
+    {
+        bm::chrono_taker tt("Serializer decode cost calibration", 1);
+        bm::calibrate_decode_cost<bvect>(cost);
+    }
+    const unsigned char codecs[] = {
+        bm::set_block_bit, bm::set_block_bit_0runs, bm::set_block_bit_digest0,
+        bm::set_block_arrbit, bm::set_block_gap_egamma,
+        bm::set_block_arr_bienc, bm::set_block_bitgap_bienc };
+    const char* names[] = {
+        "raw", "0runs", "digest0", "arrbit", "gamma", "arr BIC", "gap BIC" };
+    for (unsigned i = 0; i < sizeof(codecs)/sizeof(codecs[0]); ++i)
+        cout << "  " << names[i] << ": " << cost.ns_block[codecs[i]]
+             << " ns/block + " << cost.ns_item[codecs[i]] << " ns/item" << endl;
+
+    bvect bv(bm::BM_BIT);
+    SimpleFillSets(nullptr, bv, 0, BSIZE, 130);
+    bm::serializer<bvect> bvs;
+    bm::serializer<bvect>::buffer buf;
+    const float trade_off[] = { 0.0f, 0.5f, 4.0f }; // bytes per ns
+    for (unsigned k = 0; k < 3; ++k)
+    {
+        bvs.set_decode_cost_model(&cost, trade_off[k]);
+        bvs.serialize(bv, buf);
+        std::string msg = "  decode (bytes/ns=" +
+                          std::to_string(trade_off[k]) + ", size=" +
+                          std::to_string(buf.size()) + ")";
+        bm::chrono_taker tt(msg, REPEATS/10);
+        for (unsigned i = 0; i < REPEATS/10; ++i)
+        {
+            bvect bv2;
+            bm::deserialize(bv2, buf.buf());
+        }
+    } // for k
+}
+
 static
 void InvertTest()
 {
@@ -1640,6 +1808,73 @@ void SubTest()
 
 }
 
+
+static
+void IntervalListOpsTest()
+{
+    typedef bm::interval_list<bvect> ilist_type;
+    const unsigned vcnt = 4;
+    std::vector<bvect> bv_vect(vcnt);
+    std::vector<ilist_type> il_vect(vcnt);
+    for (unsigned k = 0; k < vcnt; ++k) // coverage-like long runs
+    {
+        bvect& bv = bv_vect[k];
+        unsigned pos = unsigned(rand()) % 1000;
+        while (pos < BSIZE * 4)
+        {
+            unsigned len = 1000 + unsigned(rand()) % 200000;
+            bv.set_range(pos, pos + len - 1);
+            pos += len + 1 + unsigned(rand()) % 100000;
+        }
+        bv.optimize();
+    }
+    {
+        bm::chrono_taker tt("interval_list import", vcnt);
+        for (unsigned k = 0; k < vcnt; ++k)
+            il_vect[k].import_from(bv_vect[k]);
+    }
+
+    const unsigned repeats = 20;
+    bm::id_t cnt1 = 0, cnt2 = 0;
+    {
+        bvect bv_r;
+        bm::chrono_taker tt("bvector AND/OR/SUB (run-heavy)", repeats);
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            for (unsigned k = 1; k < vcnt; ++k)
+            {
+                bv_r.bit_and(bv_vect[0], bv_vect[k], bvect::opt_none);
+                cnt1 += bv_r.count();
+                bv_r.bit_or(bv_vect[0], bv_vect[k], bvect::opt_none);
+                cnt1 += bv_r.count();
+                bv_r.bit_sub(bv_vect[0], bv_vect[k], bvect::opt_none);
+                cnt1 += bv_r.count();
+            }
+        }
+    }
+    {
+        ilist_type il_r;
+        bm::chrono_taker tt("interval_list AND/OR/SUB (run-heavy)", repeats);
+        for (unsigned r = 0; r < repeats; ++r)
+        {
+            for (unsigned k = 1; k < vcnt; ++k)
+            {
+                il_r.bit_and(il_vect[0], il_vect[k]);
+                cnt2 += il_r.count();
+                il_r.bit_or(il_vect[0], il_vect[k]);
+                cnt2 += il_r.count();
+                il_r.bit_sub(il_vect[0], il_vect[k]);
+                cnt2 += il_r.count();
+            }
+        }
+    }
+    if (cnt1 != cnt2)
+    {
+        cerr << "interval_list check failed!" << endl;
+        exit(1);
+    }
+}
+
 static
 void XorCountTest()
 {
@@ -2107,6 +2342,86 @@ void TI_MetricTest()
     delete bset2;    
 }
 
+
+static
+void MinHashTest()
+{
+    typedef bm::minhash_sketch<bvect> sketch_type;
+    const unsigned vcnt = 256;
+    sketch_type sketch(256);
+    std::vector<sketch_type::signature_type> sigs(vcnt);
+    {
+        bvect bv;
+        bm::chrono_taker tt("MinHash signature build", vcnt);
+        for (unsigned k = 0; k < vcnt; ++k)
+        {
+            bv.clear();
+            for (unsigned i = k; i < BSIZE / 8; i += 7 + unsigned(rand()) % 256)
+                bv.set(i);
+            sketch.build(bv, sigs[k]);
+        }
+    }
+    float sum = 0;
+    {
+        bm::chrono_taker tt("MinHash all-pairs Jaccard estimate", 50);
+        for (unsigned r = 0; r < 50; ++r)
+            for (unsigned i = 0; i < vcnt; ++i)
+                for (unsigned j = i + 1; j < vcnt; ++j)
+                    sum += sketch.jaccard(sigs[i], sigs[j]);
+    }
+    char buf[256];
+    sprintf(buf, "%i", (int)sum);
+}
+
+static
+void SimilarityMatrixTest()
+{
+    typedef bm::similarity_matrix_builder<bvect, std::mutex> builder_type;
+    const unsigned vcnt = 64;
+    std::vector<bvect> bv_vect(vcnt);
+    std::vector<const bvect*> bv_ptrs(vcnt);
+    for (unsigned k = 0; k < vcnt; ++k)
+    {
+        bvect& bv = bv_vect[k];
+        for (unsigned i = k % 7; i < BSIZE / 16; i += 3 + unsigned(rand()) % 32)
+            bv.set(i);
+        bv.optimize();
+        bv_ptrs[k] = &bv;
+    }
+
+    double sum1 = 0, sum2 = 0;
+    {
+        bm::chrono_taker tt("Jaccard all-pairs (count_and)", 1);
+        std::vector<bm::id_t> cnts(vcnt);
+        for (unsigned i = 0; i < vcnt; ++i)
+            cnts[i] = bv_vect[i].count();
+        for (unsigned i = 0; i < vcnt; ++i)
+        {
+            for (unsigned j = i + 1; j < vcnt; ++j)
+            {
+                bm::id_t and_cnt = bm::count_and(bv_vect[i], bv_vect[j]);
+                sum1 += builder_type::similarity(and_cnt, cnts[i], cnts[j],
+                                                 builder_type::jaccard);
+            }
+        }
+    }
+    {
+        bm::chrono_taker tt("Jaccard all-pairs (similarity_matrix_builder)", 1);
+        builder_type sbuilder;
+        builder_type::task_batch tbatch;
+        sbuilder.build_plan(tbatch, bv_ptrs.data(), vcnt);
+        bm::run_task_batch(tbatch);
+        for (unsigned i = 0; i < vcnt; ++i)
+            for (unsigned j = i + 1; j < vcnt; ++j)
+                sum2 += sbuilder.get_similarity(i, j);
+    }
+    if (fabs(sum1 - sum2) > 0.001)
+    {
+        cerr << "Similarity matrix check failed!" << endl;
+        exit(1);
+    }
+}
+
 #if 0
 static
 void BitBlockTransposeTest()
@@ -2568,6 +2883,87 @@ void SparseVectorAccessTest()
 
 }
 
+static
+void PrintLoadThroughput(const bm::chrono_taker::duration_map_type& dmap,
+                         unsigned long long values)
+{
+    bm::chrono_taker::duration_map_type::const_iterator it = dmap.begin();
+    for ( ;it != dmap.end(); ++it)
+    {
+        double sec = it->second.duration.count() / 1000;
+        double vps = sec > 0 ? double(values) / sec : 0;
+        cout << it->first << "; " << std::setprecision(4)
+             << (vps / 1000000) << " M values/sec" << endl;
+    }
+}
+
+static
+void SparseVectorImportTest()
+{
+    typedef bm::sparse_vector<unsigned long long, bvect> svect64;
+
+    const unsigned sv_size = 16 * 1024 * 1024;
+    const unsigned repeats = 10;
+    std::vector<unsigned> arr(sv_size);
+    std::vector<unsigned long long> arr64(sv_size);
+    for (unsigned i = 0; i < sv_size; ++i)
+    {
+        arr[i] = unsigned(rand()) & 0xFFFFF; // 20-bit values
+        arr64[i] = ((unsigned long long)(rand()) << 32) | unsigned(rand());
+    }
+
+    svect sv1, sv2;
+    bm::chrono_taker::duration_map_type dmap;
+    for (unsigned i = 0; i < repeats; ++i)
+    {
+        {
+            svect sv;
+            {
+                bm::chrono_taker tt("sparse_vector<u32>::import()", 1, &dmap);
+                sv.import(arr.data(), sv_size);
+            }
+            if (!i)
+                sv1.swap(sv);
+        }
+        {
+            svect sv;
+            {
+                bm::chrono_taker tt("sparse_vector<u32>::back_insert_iterator",
+                                    1, &dmap);
+                svect::back_insert_iterator bi(sv.get_back_inserter());
+                for (unsigned j = 0; j < sv_size; ++j)
+                    bi = arr[j];
+                bi.flush();
+            }
+            if (!i)
+                sv2.swap(sv);
+        }
+        {
+            svect64 sv;
+            bm::chrono_taker tt("sparse_vector<u64>::import()", 1, &dmap);
+            sv.import(arr64.data(), sv_size);
+        }
+    } // for i
+    PrintLoadThroughput(dmap, (unsigned long long)(sv_size) * repeats);
+
+    // check
+    //
+    if (!sv1.equal(sv2))
+    {
+        std::cerr << "Error! sparse_vector import mismatch." << std::endl;
+        exit(1);
+    }
+    for (unsigned i = 0; i < sv_size; i += 4099)
+    {
+        if (sv1[i] != arr[i])
+        {
+            std::cerr << "Error! sparse_vector import mismatch at: " << i
+                      << std::endl;
+            exit(1);
+        }
+    }
+}
+
 static
 void RSC_SparseVectorFillTest()
 {
@@ -3867,6 +4263,63 @@ void GenerateTestStrCollection(std::vector<string>& str_coll, unsigned max_coll)
 }
 
 
+static
+void StrSortedSearchTest()
+{
+    const unsigned max_coll = 2000000;
+    const unsigned q_size = 50000;
+
+    std::vector<string> str_coll;
+    GenerateTestStrCollection(str_coll, max_coll);
+    std::sort(str_coll.begin(), str_coll.end());
+
+    str_svect_type str_sv;
+    {
+        str_svect_type::back_insert_iterator bi = str_sv.get_back_inserter();
+        for (const string& s : str_coll)
+            bi = s;
+        bi.flush();
+    }
+    str_sv.optimize();
+
+    std::vector<string> q_coll;
+    for (unsigned i = 0; i < q_size; ++i)
+        q_coll.emplace_back(str_coll[unsigned(rand()) % max_coll]);
+
+    bm::sparse_vector_scanner<str_svect_type> scanner;
+    bm::sparse_vector_scanner<str_svect_type> scanner_b;
+    scanner_b.bind(str_sv, true);
+
+    unsigned found_cnt = 0;
+    {
+        bm::chrono_taker tt("str_sparse_vector<> sorted lower_bound_str()", q_size);
+        for (const string& s : q_coll)
+        {
+            unsigned pos;
+            found_cnt += scanner.lower_bound_str(str_sv, s.c_str(), pos);
+        }
+    }
+    {
+        bm::chrono_taker tt("str_sparse_vector<> sorted bfind_eq_str() (bind)", q_size);
+        for (const string& s : q_coll)
+        {
+            unsigned pos;
+            bool found = scanner_b.bfind_eq_str(s.c_str(), pos);
+            found_cnt += found;
+            if (!found || str_coll[pos] != s)
+            {
+                cerr << "Sorted str search failed: " << s << endl;
+                exit(1);
+            }
+        }
+    }
+    if (found_cnt != 2 * q_size)
+    {
+        cerr << "Sorted str search count failed!" << endl;
+        exit(1);
+    }
+}
+
 static
 void StrSparseVectorTest()
 {
@@ -4060,6 +4513,58 @@ void InterpolativeCodingTest()
 }
 
 
+static
+void GammaCodingTest()
+{
+    unsigned char buf[1024 * 200] = { 0, };
+
+    const unsigned code_repeats = 200000;
+    vector<bm::gap_word_t> sa, da;
+    for (unsigned v = rand() % 16; v < 65536; v += 1 + rand() % 48)
+        sa.push_back(bm::gap_word_t(v));
+    unsigned sz = unsigned(sa.size());
+    da.resize(sz);
+    {
+        bm::encoder enc(buf, sizeof(buf));
+        bm::bit_out<bm::encoder> bout(enc);
+        bout.gamma_dgap_u16(sa.data(), sz);
+        bout.flush();
+    }
+
+    unsigned check_sum = 0;
+    {
+        bm::chrono_taker tt("gamma() decode ", 1);
+        for (unsigned k = 0; k < code_repeats; ++k)
+        {
+            bm::decoder dec(buf);
+            bm::bit_in<bm::decoder> bin(dec);
+            bm::gap_word_t sum = bm::gap_word_t(~0u);
+            for (unsigned i = 0; i < sz; ++i)
+            {
+                sum = bm::gap_word_t(sum + bin.gamma());
+                da[i] = sum;
+            }
+            check_sum += da[sz-1];
+        } // for k
+    }
+    {
+        bm::chrono_taker tt("gamma_dgap_u16() decode ", 1);
+        for (unsigned k = 0; k < code_repeats; ++k)
+        {
+            bm::decoder dec(buf);
+            bm::bit_in<bm::decoder> bin(dec);
+            bin.gamma_dgap_u16(da.data(), sz);
+            check_sum -= da[sz-1];
+        } // for k
+    }
+    if (check_sum || da != sa)
+    {
+        cerr << "Gamma decode check failed!" << endl;
+        exit(1);
+    }
+}
+
+
 int main(void)
 {
     cout << bm::_copyright<true>::_p << endl;
@@ -4079,6 +4584,8 @@ int main(void)
         BitForEachTest();
 
         WordSelectTest();
+        RankSelectRandomTest();
+        SelectSparseTest();
         cout << endl;
 
         BitTestSparseTest();
@@ -4097,6 +4604,7 @@ int main(void)
         cout << endl;
 
         InterpolativeCodingTest();
+        GammaCodingTest();
         cout << endl;
 
         EnumeratorTest();
@@ -4120,6 +4628,7 @@ int main(void)
         AndTest();
         XorTest();
         SubTest();
+        IntervalListOpsTest();
         cout << endl;
 
         InvertTest();
@@ -4131,14 +4640,20 @@ int main(void)
         XorCountTest();
         AndCountTest();
         TI_MetricTest();
+        SimilarityMatrixTest();
+        MinHashTest();
         cout << endl;
 
         SerializationTest();
+        SerializationDecodeCostTest();
         cout << endl;
 
         SparseVectorAccessTest();
         cout << endl;
 
+        SparseVectorImportTest();
+        cout << endl;
+
         SparseVectorScannerTest();
         cout << endl;
 
@@ -4153,6 +4668,7 @@ int main(void)
         cout << endl;
 
         StrSparseVectorTest();
+        StrSortedSearchTest();
         cout << endl;
     }
     catch (std::exception& ex)
@@ -57,12 +57,19 @@ For more information please visit:  http://bitmagic.io
 #include <bmsparsevec_algo.h>
 #include <bmsparsevec_serial.h>
 #include <bmalgo_similarity.h>
+#include <bmminhash.h>
 #include <bmsparsevec_util.h>
 #include <bmsparsevec_compr.h>
 #include <bmstrsparsevec.h>
 #include <bmtimer.h>
 #include <bmtask.h>
+#include <bmthreadpool.h>
 #include <bmsparsevec_parallel.h>
+#include <bmbvimport_parallel.h>
+#include <bmserial_delta.h>
+#include <bmfingerprint.h>
+#include <bmdedup.h>
+#include <bmserial_cost.h>
 
 using namespace bm;
 using namespace std;
@@ -2620,20 +2627,30 @@ void RSIndexTest()
     }
     
     {
+        const unsigned sub_n = bm::rs_sub_blocks - 1;
+        const unsigned sub_last = sub_n * bm::rs_sub_block_size;
+        const unsigned sub_mid = (sub_n / 2) * bm::rs_sub_block_size;
         unsigned bcount[bm::set_sub_array_size];
-        unsigned sub_count1[bm::set_sub_array_size];
-        unsigned sub_count2[bm::set_sub_array_size];
+        bm::gap_word_t sub_count1[bm::set_sub_array_size * sub_n];
+        bm::gap_word_t sub_count2[bm::set_sub_array_size * sub_n];
         for (unsigned i = 0; i < bm::set_sub_array_size; ++i)
-        {
-            bcount[i] = sub_count1[i] = sub_count2[i] = 0;
-        } // for
+            bcount[i] = 0;
+        for (unsigned i = 0; i < bm::set_sub_array_size * sub_n; ++i)
+            sub_count1[i] = sub_count2[i] = 0;
         bcount[0] = 1;
         bcount[255] = 2;
         
-        sub_count1[0] = 1;          // sub-range 0
-        sub_count1[255] = 0;        // sub-3
-        sub_count2[0] = 1 << 16;    // sub-2
-        sub_count2[255] = 1 << 16;  // sub 2,3
+        // running counts of sub-blocks
+        for (unsigned k = 0; k < sub_n; ++k)
+        {
+            sub_count1[k] = 1;                      // first sub-block
+            // block 255 of sb1: both bits in the last sub-block
+            if (k >= sub_n / 2)
+            {
+                sub_count2[k] = 1;                  // middle sub-block
+                sub_count2[255 * sub_n + k] = 1;    // middle and last
+            }
+        }
 
         
         rs_ind rsi;
@@ -2738,43 +2755,43 @@ void RSIndexTest()
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 1);
 
             rank = 3;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 2);
 
             rank = 4;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255+1);
-            assert(sub_range == bm::rs3_border0 + 1);
+            assert(sub_range == sub_mid);
             assert(rank == 1);
 
             rank = 5;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+256+255);
-            assert(sub_range == bm::rs3_border0 + 1);
+            assert(sub_range == sub_mid);
             assert(rank == 1);
 
             rank = 6;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+256+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 1);
 
             rank = 65536;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == 3*bm::set_sub_array_size+0);
-            assert(sub_range == bm::rs3_border1 + 1);
-            assert(rank == 65536 - 6 - bm::rs3_border1 - 1);
+            assert(sub_range == sub_last);
+            assert(rank == 65536 - 6 - sub_last);
 
             rank = 65536 + 7;
             b = rsi.find(&rank, &nb, &sub_range);
@@ -3006,6 +3023,14 @@ void Check_XOR_Product(const bm::word_t*  block,
 
     unsigned cnt = bm::bit_block_xor_count(block, t_blk2);
     assert(cnt == 0); // identically restored
+
+    // fused XOR product + BC/GC
+    unsigned gc, bc;
+    bm::bit_block_xor_change_bc(t_blk2, block, xor_block, digest, &gc, &bc);
+    cnt = bm::bit_block_xor_count(t_blk1, t_blk2);
+    assert(cnt == 0);
+    assert(gc == bm::bit_block_change32(t_blk1, bm::set_block_size));
+    assert(bc == bm::bit_block_count(t_blk1));
 }
 
 
@@ -3177,6 +3202,53 @@ void TestBlockCountXORChange()
 
     }
 
+    // random blocks and digests: SIMD kernels vs scalar reference
+    {
+        bm::word_t BM_VECT_ALIGN blk[bm::set_block_size] BM_VECT_ALIGN_ATTR;
+        bm::word_t BM_VECT_ALIGN blk_xor[bm::set_block_size] BM_VECT_ALIGN_ATTR;
+        for (unsigned pass = 0; pass < 1000; ++pass)
+        {
+            unsigned density = pass % 7;
+            for (i = 0; i < bm::set_block_size; ++i)
+            {
+                blk[i] = density ? unsigned(rand()) : 0u;
+                for (unsigned k = 0; k < density; ++k)
+                    blk[i] &= unsigned(rand());
+                blk_xor[i] = blk[i];
+                if (rand() % 8 == 0)
+                    blk_xor[i] ^= unsigned(rand()) | (1u << 31);
+            }
+            if (pass & 1)
+                blk[0] |= 1u;
+            bm::id64_t digest = (bm::id64_t(rand()) << 32) ^ unsigned(rand());
+            if (pass % 5 == 0)
+                digest = ~0ull;
+            if (!digest)
+                digest = 1;
+            Check_XOR_Product(blk, blk_xor, digest);
+
+            unsigned gc, bc, gc_c, bc_c;
+            bm::bit_block_change_bc(blk, &gc, &bc);
+            assert(gc == bm::bit_block_change32(blk, bm::set_block_size));
+            assert(bc == bm::bit_block_count(blk));
+
+            bm::bit_block_xor_change(blk, blk_xor, bm::set_block_size,
+                                     &gc, &bc);
+            bm::bit_block_xor_change32(blk, blk_xor, bm::set_block_size,
+                                       &gc_c, &bc_c);
+            assert(gc == gc_c && bc == bc_c);
+            unsigned off = (pass % bm::block_waves) *
+                                        bm::set_block_digest_wave_size;
+            bm::bit_block_xor_change(blk + off, blk_xor + off,
+                                     bm::set_block_digest_wave_size,
+                                     &gc, &bc);
+            bm::bit_block_xor_change32(blk + off, blk_xor + off,
+                                       bm::set_block_digest_wave_size,
+                                       &gc_c, &bc_c);
+            assert(gc == gc_c && bc == bc_c);
+        } // for pass
+    }
+
     cout << "---------------------------- TestBlockCountXORChange() test OK" << endl;
 }
 
@@ -4655,6 +4727,241 @@ void BvectorBulkSetTest()
 
 
 
+static
+void FillBulkSortedTarget(bvect& bv, unsigned kind)
+{
+    bv.clear(true);
+    switch (kind)
+    {
+    case 0: break; // empty
+    case 1: // GAP-friendly runs
+        for (unsigned i = 0; i < 65536 * 4; i += 1000)
+            bv.set_range(i, i + 300);
+        bv.optimize();
+        break;
+    case 2: // random bits
+        for (unsigned i = 0; i < 30000; ++i)
+            bv.set(unsigned(rand()) % (65536 * 4));
+        break;
+    case 3: // FULL blocks
+        bv.set_range(0, 65536 * 3 - 1);
+        bv.set_range(65536 * 5, 65536 * 6 + 7);
+        break;
+    case 4:
+        bv.invert();
+        break;
+    }
+}
+
+static
+void TestBulkSortedSetClear()
+{
+    cout << "---------------------------- Bvector sorted bulk set/clear/keep test" << endl;
+
+    // compact runs into an empty vector produce GAP blocks
+    {
+        std::vector<bm::id_t> ids;
+        for (unsigned i = 100; i < 20000; ++i)
+            ids.push_back(i);
+        bvect bv;
+        bv.set(ids.data(), bvect::size_type(ids.size()), bm::BM_SORTED);
+        bvect::statistics st;
+        bv.calc_stat(&st);
+        assert(st.gap_blocks == 1 && st.bit_blocks == 0);
+        assert(bv.count() == ids.size());
+        assert(bv.get_first() == 100);
+    }
+
+    std::vector<bm::id_t> ids;
+    for (unsigned pass = 0; pass < 60; ++pass)
+    {
+        unsigned mode = pass % 4;
+        ids.resize(0);
+        for (unsigned i = 0; i < 65536 * 7; )
+        {
+            ids.push_back(i);
+            switch (mode)
+            {
+            case 0: i += 1 + unsigned(rand()) % 3000; break; // sparse
+            case 1: i += (rand() % 50) ? 1 : 1 + unsigned(rand()) % 500; break; // runs
+            case 2: i += 1 + unsigned(rand()) % 4; break; // dense random
+            case 3: i += (i / 65536) & 1 ? 1 : 2; break; // alternate
+            }
+            if (mode == 2 && rand() % 3 == 0)
+                ids.push_back(ids.back()); // duplicates
+        }
+        if (pass & 1)
+            ids.push_back(bm::id_max - 1);
+        bvect::size_type sz = bvect::size_type(ids.size());
+
+        unsigned kind = (pass / 4) % 5;
+        bvect bv, bv_c;
+        // set
+        {
+            FillBulkSortedTarget(bv, kind);
+            bv_c = bv;
+            bv.set(ids.data(), sz, bm::BM_SORTED);
+            for (size_t i = 0; i < ids.size(); ++i)
+                bv_c.set(ids[i]);
+            int cmp = bv.compare(bv_c);
+            if (cmp != 0)
+            {
+                cerr << "sorted set() failed pass=" << pass << endl;
+                DetailedCompareBVectors(bv, bv_c);
+                assert(0); exit(1);
+            }
+            assert(bv.size() == bv_c.size());
+        }
+        // clear
+        {
+            FillBulkSortedTarget(bv, kind);
+            bv.set(ids.data(), sz / 2, bm::BM_SORTED);
+            bv_c = bv;
+            bv.clear(ids.data() + sz / 4, sz - sz / 4, bm::BM_SORTED);
+            for (size_t i = sz / 4; i < ids.size(); ++i)
+                bv_c.set(ids[i], false);
+            int cmp = bv.compare(bv_c);
+            if (cmp != 0)
+            {
+                cerr << "sorted clear() failed pass=" << pass << endl;
+                DetailedCompareBVectors(bv, bv_c);
+                assert(0); exit(1);
+            }
+        }
+        // keep
+        {
+            FillBulkSortedTarget(bv, kind);
+            bv_c = bv;
+            bvect::size_type from = sz / 3;
+            bv.keep(ids.data() + from, sz - from, bm::BM_SORTED);
+            bvect bv_mask;
+            for (size_t i = from; i < ids.size(); ++i)
+                bv_mask.set(ids[i]);
+            bv_c &= bv_mask;
+            int cmp = bv.compare(bv_c);
+            if (cmp != 0)
+            {
+                cerr << "sorted keep() failed pass=" << pass << endl;
+                DetailedCompareBVectors(bv, bv_c);
+                assert(0); exit(1);
+            }
+        }
+        cout << "\rpass=" << pass << flush;
+    } // for pass
+    cout << endl;
+
+    cout << "---------------------------- Bvector sorted bulk set/clear/keep test OK" << endl;
+}
+
+static
+void TestSortedBulkInsert()
+{
+    cout << "---------------------------- Test sorted bulk insert (append-only)" << endl;
+
+    std::vector<bm::id_t> ids;
+    for (unsigned pass = 0; pass < 5; ++pass)
+    {
+        ids.resize(0);
+        unsigned i = unsigned(rand()) % 100;
+        const unsigned max_id = 65536 * 12;
+        while (i < max_id)
+        {
+            ids.push_back(i);
+            unsigned nb = i >> 16;
+            switch ((nb + pass) % 4)
+            {
+            case 0: i += 1 + unsigned(rand()) % 7; break;   // bit-block
+            case 1: i += (rand() % 100) ? 1 : 300; break;  // GAP runs
+            case 2: ++i; break;                              // FULL
+            case 3: i += 65536 / 3; break;                   // sparse
+            }
+            if (pass == 3 && rand() % 5 == 0)
+                ids.push_back(ids.back()); // duplicates
+        }
+        if (pass == 4)
+            ids.push_back(bm::id_max - 1);
+
+        bvect bv_ref;
+        for (size_t k = 0; k < ids.size(); ++k)
+            bv_ref.set(ids[k]);
+
+        bvect bv1, bv2, bv3, bv4;
+        {
+            bvect::bulk_insert_iterator iit(bv1, bm::BM_SORTED);
+            for (size_t k = 0; k < ids.size(); ++k)
+                iit = ids[k];
+            iit.flush();
+        }
+        {
+            bm::sorted_import_builder<bvect> bld(bv2);
+            for (size_t k = 0; k < ids.size(); ++k)
+                bld.add(ids[k]);
+        }
+        {
+            bm::sorted_import_builder<bvect> bld(bv3, true /*background*/);
+            for (size_t k = 0; k < ids.size(); ++k)
+                bld = ids[k];
+            bld.flush();
+            assert(bld.blocks_finalized() > 1);
+            // keep using after flush, out of order ids OR into blocks
+            bld.add(5); bld.add(65536 * 2 + 9); bld.add(7);
+        }
+        {
+            // existing content gets OR-ed
+            bv4.set_range(65536, 65536 * 3);
+            bv4.set(65536 * 7 + 3);
+            bv4.optimize();
+            bm::sorted_import_builder<bvect> bld(bv4, pass & 1);
+            for (size_t k = 0; k < ids.size(); ++k)
+                bld.add(ids[k]);
+        }
+        assert(bv1.equal(bv_ref));
+        assert(bv1.size() == bv_ref.size());
+        assert(bv2.equal(bv_ref));
+        assert(bv2.size() == bv_ref.size());
+        {
+            bvect bv_c(bv_ref);
+            bv_c.set(5); bv_c.set(65536 * 2 + 9); bv_c.set(7);
+            assert(bv3.equal(bv_c));
+            bv_c = bv_ref;
+            bv_c.set_range(65536, 65536 * 3);
+            bv_c.set(65536 * 7 + 3);
+            assert(bv4.equal(bv_c));
+        }
+
+        // blocks are compacted on the fly: no optimize() needed
+        {
+            bvect::statistics st1, st2;
+            bv1.calc_stat(&st1);
+            bv_ref.optimize();
+            bv_ref.calc_stat(&st2);
+            assert(st1.bit_blocks == st2.bit_blocks);
+            assert(st1.gap_blocks == st2.gap_blocks);
+            bv2.calc_stat(&st1);
+            assert(st1.bit_blocks == st2.bit_blocks);
+        }
+        cout << "\rpass=" << pass << flush;
+    } // for pass
+    cout << endl;
+
+    // more blocks than allowed in flight (background producer waits)
+    {
+        bvect bv_ref, bv1;
+        {
+            bm::sorted_import_builder<bvect> bld(bv1, true /*background*/);
+            for (unsigned i = 0; i < 65536 * 700; i += 1 + unsigned(rand()) % 4000)
+            {
+                bld.add(i);
+                bv_ref.set(i);
+            }
+        }
+        assert(bv1.equal(bv_ref));
+        assert(bv1.size() == bv_ref.size());
+    }
+
+    cout << "---------------------------- Test sorted bulk insert (append-only) OK" << endl;
+}
+
 static
 void RankFindTest()
 {
@@ -7941,6 +8248,432 @@ void XorOperationsTest(bool detailed)
 
 }
 
+template<class TBatch>
+void RunTaskBatchPool(TBatch& tbatch, unsigned thread_cnt)
+{
+    typedef bm::thread_pool<bm::task_description*, std::mutex> pool_type;
+    pool_type tpool;
+    tpool.start(thread_cnt);
+    bm::thread_pool_executor<pool_type> exec;
+    exec.run(tpool, tbatch, true);
+    tpool.set_stop_mode(pool_type::stop_when_done);
+    tpool.join(); // all tasks are done
+}
+
+static
+void TestMinHashSketch()
+{
+    cout << "---------------------------- Test MinHash sketch" << endl;
+
+    // SIMD equal count
+    {
+        std::vector<unsigned> a(300), b(300);
+        for (unsigned i = 0; i < 300; ++i)
+        {
+            a[i] = unsigned(rand()) % 4;
+            b[i] = unsigned(rand()) % 4;
+        }
+        for (unsigned sz = 0; sz < 300; sz += 1 + sz / 8)
+        {
+            unsigned cnt = 0;
+            for (unsigned i = 0; i < sz; ++i)
+                cnt += (a[i] == b[i]);
+            unsigned cnt2 = bm::u32_eq_count(a.data(), b.data(), sz);
+            assert(cnt == cnt2); (void)cnt2;
+        }
+    }
+
+    typedef bm::minhash_sketch<bvect> sketch_type;
+    typedef bm::minhash_lsh<bvect>    lsh_type;
+
+    sketch_type sketch(512, 7);
+    sketch_type::signature_type sig1, sig2, sig_e;
+    sketch_type::bbit_signature_type bsig1, bsig2;
+
+    {
+        bvect bv_e;
+        sketch.build(bv_e, sig_e);
+        assert(sketch_type::is_empty(sig_e));
+        bvect bv1 { 1, 10, 100000 };
+        sketch.build(bv1, sig1);
+        assert(!sketch_type::is_empty(sig1));
+        assert(sketch.jaccard(sig1, sig_e) == 0);
+        bvect bv2; // same content, different representation
+        bv2.set(1); bv2.set(10); bv2.set(100000);
+        bv2.optimize();
+        sketch.build(bv2, sig2);
+        assert(sketch.jaccard(sig1, sig2) == 1.0f);
+        for (unsigned i = 0; i < sketch.size(); ++i)
+            assert(sig1[i] != sketch_type::empty_bin);
+    }
+
+    // estimates vs exact Jaccard
+    const float jref[] = { 0.0f, 0.1f, 0.5f, 0.8f, 1.0f };
+    for (unsigned t = 0; t < sizeof(jref)/sizeof(jref[0]); ++t)
+    {
+        // |A & B| = c, |A|=|B|= c + d  => J = c / (c + 2d)
+        const unsigned total = 20000;
+        unsigned c = unsigned(jref[t] * total);
+        unsigned d = (total - c) / 2;
+        bvect bv1, bv2;
+        unsigned pos = 0;
+        for (unsigned i = 0; i < c; ++i, pos += 1 + rand() % 100)
+            { bv1.set(pos); bv2.set(pos); }
+        for (unsigned i = 0; i < d; ++i, pos += 1 + rand() % 100)
+            bv1.set(pos);
+        for (unsigned i = 0; i < d; ++i, pos += 1 + rand() % 100)
+            bv2.set(pos);
+        if (t == 3)
+            bv1.set_range(pos + 10, pos + 65536 * 2); // full block range
+        float j = float(bm::count_and(bv1, bv2)) /
+                  float(bm::count_or(bv1, bv2));
+
+        sketch.build(bv1, sig1);
+        sketch.build(bv2, sig2);
+        float je = sketch.jaccard(sig1, sig2);
+        cout << "J=" << j << " MinHash=" << je;
+        assert(fabs(je - j) < 0.1);
+        for (unsigned b = 1; b <= 16; b *= 2)
+        {
+            sketch.pack_bbit(sig1, b, bsig1);
+            sketch.pack_bbit(sig2, b, bsig2);
+            float jb = sketch.jaccard_bbit(bsig1, bsig2, b);
+            cout << " b" << b << "=" << jb;
+            assert(fabs(jb - j) < (b == 1 ? 0.2 : 0.12));
+        }
+        cout << endl;
+    } // for t
+
+    // sparse vectors: b-bit estimates of densified bins
+    {
+        sketch_type sketch256(256, 3);
+        for (unsigned k = 0; k < 4; ++k)
+        {
+            bvect bv1, bv2;
+            for (unsigned i = 0; i < 10; ++i)
+            {
+                bv1.set(k * 1000000 + i * 7919);
+                bv2.set(k * 1000000 + i * 7919 + 1);
+            }
+            assert(!bm::count_and(bv1, bv2));
+            sketch256.build(bv1, sig1);
+            sketch256.build(bv2, sig2);
+            float je = sketch256.jaccard(sig1, sig2);
+            cout << "sparse J=0 MinHash=" << je;
+            assert(je < 0.05f);
+            for (unsigned b = 1; b <= 16; b *= 2)
+            {
+                sketch256.pack_bbit(sig1, b, bsig1);
+                sketch256.pack_bbit(sig2, b, bsig2);
+                float jb = sketch256.jaccard_bbit(bsig1, bsig2, b);
+                cout << " b" << b << "=" << jb;
+                assert(jb < 0.25f);
+            }
+            cout << endl;
+        } // for k
+    }
+
+    // LSH candidates + exact refinement
+    {
+        const unsigned vcnt = 60;
+        std::vector<bvect> bv_vect(vcnt);
+        std::vector<const bvect*> bv_ptrs(vcnt);
+        for (unsigned k = 0; k < vcnt; k += 2)
+        {
+            bvect& bv = bv_vect[k];
+            for (unsigned i = 0; i < 2000; ++i)
+                bv.set(unsigned(rand()) % (65536 * 8));
+            bv_vect[k + 1] = bv; // near duplicate
+            for (unsigned i = 0; i < 40; ++i)
+                bv_vect[k + 1].flip(unsigned(rand()) % (65536 * 8));
+        }
+        bv_vect[7].clear(); // empty vector is never a candidate
+        lsh_type lsh(32, 4);
+        for (unsigned k = 0; k < vcnt; ++k)
+        {
+            bv_ptrs[k] = &bv_vect[k];
+            sketch.build(bv_vect[k], sig1);
+            lsh.add(k, sig1);
+        }
+        lsh_type::pair_vector_type pairs;
+        lsh.get_candidates(pairs);
+        bm::minhash_refine(bv_ptrs.data(), pairs, 0.9f);
+
+        unsigned found = 0;
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            const lsh_type::pair_type& p = pairs[i];
+            assert(p.idx1 < p.idx2);
+            float j = float(bm::count_and(bv_vect[p.idx1], bv_vect[p.idx2])) /
+                      float(bm::count_or(bv_vect[p.idx1], bv_vect[p.idx2]));
+            assert(p.similarity == j); (void)j;
+            assert(p.similarity >= 0.9f);
+            found += (p.idx2 == p.idx1 + 1 && !(p.idx1 & 1));
+        }
+        assert(found == vcnt / 2 - 1); // all near duplicates (but empty)
+    }
+
+    cout << "---------------------------- Test MinHash sketch OK" << endl;
+}
+
+static
+void TestSimilaritySearch()
+{
+    cout << "---------------------------- Test similarity search (top-K)" << endl;
+
+    typedef bm::similarity_search<bvect, std::mutex> search_type;
+
+    const unsigned vcnt = 300;
+    std::vector<bvect> bv_vect(vcnt);
+    std::vector<const bvect*> bv_ptrs(vcnt);
+    for (unsigned k = 0; k < vcnt; ++k)
+    {
+        bvect& bv = bv_vect[k];
+        unsigned base = (k % 7) * 65536 * 2;
+        unsigned len = 1000 + (k % 13) * 9000;
+        switch (k % 3)
+        {
+        case 0:
+            for (unsigned i = 0; i < len / 8; ++i)
+                bv.set(base + unsigned(rand()) % len);
+            break;
+        case 1:
+            bv.set_range(base + k, base + k + len);
+            break;
+        default:
+            for (unsigned i = base; i < base + len; i += 1 + rand() % 4)
+                bv.set(i);
+            bv.optimize();
+        }
+        bv_ptrs[k] = (k == 17) ? 0 : &bv; // NULL - empty vector
+    } // for k
+    bv_vect[17].clear();
+    bv_vect[18].clear(); // empty vector
+
+    bvect bv_q1(bv_vect[5]);
+    bv_q1.set_range(1000, 5000);
+    bvect bv_q2; // empty query
+    bvect bv_q3;
+    bv_q3.set_range(65536 * 4, 65536 * 4 + 30000);
+    const bvect* queries[] = { &bv_q1, &bv_q2, &bv_q3, &bv_vect[100] };
+
+    search_type ssearch;
+    ssearch.build_index(bv_ptrs.data(), vcnt);
+
+    std::vector<search_type::neighbor> res(vcnt + 10);
+    for (unsigned m = 0; m < 2; ++m)
+    {
+        search_type::metric_type metric =
+                m ? search_type::hamming : search_type::jaccard;
+        ssearch.set_metric(metric);
+        for (unsigned q = 0; q < sizeof(queries)/sizeof(queries[0]); ++q)
+        {
+            const bvect& bv_q = *queries[q];
+            // reference: brute force (score, idx) ordering
+            std::vector<std::pair<double, unsigned> > ref(vcnt);
+            bm::id_t q_cnt = bv_q.count();
+            for (unsigned i = 0; i < vcnt; ++i)
+            {
+                bm::id_t and_cnt = bm::count_and(bv_q, bv_vect[i]);
+                bm::id_t or_cnt = q_cnt + bv_vect[i].count() - and_cnt;
+                double sc;
+                if (m)
+                    sc = -double(or_cnt - and_cnt);
+                else
+                    sc = or_cnt ? double(and_cnt) / double(or_cnt) : 0.0;
+                ref[i] = std::make_pair(-sc, i);
+            }
+            std::sort(ref.begin(), ref.end());
+
+            const unsigned ks[] = { 1, 5, 20, vcnt + 5 };
+            for (unsigned t = 0; t < sizeof(ks)/sizeof(ks[0]); ++t)
+            {
+                unsigned k = ks[t];
+                ssearch.set_chunk_size(t & 1 ? 16 : 1024);
+                if (t & 2)
+                {
+                    search_type::task_batch tbatch;
+                    ssearch.build_plan(tbatch, bv_q, k);
+                    RunTaskBatchPool(tbatch, 3);
+                }
+                else
+                    ssearch.search(bv_q, k);
+
+                unsigned cnt = ssearch.get_results(res.data());
+                assert(cnt == std::min(k, vcnt));
+                for (unsigned i = 0; i < cnt; ++i)
+                {
+                    unsigned idx = ref[i].second;
+                    if (res[i].idx != idx)
+                    {
+                        cerr << "Top-K mismatch m=" << m << " q=" << q
+                             << " k=" << k << " i=" << i << endl;
+                        assert(0); exit(1);
+                    }
+                    bm::id_t and_cnt = bm::count_and(bv_q, bv_vect[idx]);
+                    bm::id_t or_cnt = q_cnt + bv_vect[idx].count() - and_cnt;
+                    assert(res[i].distance == or_cnt - and_cnt);
+                    float j = or_cnt ? float(double(and_cnt) / double(or_cnt))
+                                     : 0.0f;
+                    assert(res[i].similarity == j); (void)j;
+                }
+                if (k == 5 && q == 0)
+                {
+                    cout << " metric=" << m << " exact evaluations: "
+                         << ssearch.get_exact_count() << " of " << vcnt
+                         << endl;
+                    assert(ssearch.get_exact_count() < vcnt);
+                }
+            } // for t
+        } // for q
+    } // for m
+
+    cout << "---------------------------- Test similarity search (top-K) OK" << endl;
+}
+
+static
+void TestSimilarityMatrixBuilder()
+{
+    cout << "---------------------------- Test similarity matrix builder" << endl;
+
+    typedef bm::similarity_matrix_builder<bvect, std::mutex> builder_type;
+
+    const unsigned vcnt = 37;
+    std::vector<bvect> bv_vect(vcnt);
+    std::vector<const bvect*> bv_ptrs(vcnt + 1);
+    for (unsigned k = 0; k < vcnt; ++k)
+    {
+        bvect& bv = bv_vect[k];
+        switch (k % 4)
+        {
+        case 0: // sparse random
+            for (unsigned i = 0; i < 3000; ++i)
+                bv.set(unsigned(rand()) % (65536 * 9));
+            break;
+        case 1: // ranges (GAP blocks)
+            bv.set_range(k * 1000, 65536 * 3 + k * 5000);
+            break;
+        case 2: // dense random
+            for (unsigned i = 0; i < 65536 * 2; i += 1 + (rand() % 3))
+                bv.set(i + 65536 * 256 * (k % 3));
+            break;
+        default: // full blocks + sparse
+            bv.set_range(0, 65536 * 256 * 2);
+            bv.set(65536 * 256 * 4 + k);
+        }
+        if (k % 5 == 0)
+            bv.optimize();
+        bv_ptrs[k] = &bv;
+    } // for k
+    bv_ptrs[vcnt] = 0; // NULL vector is an empty vector
+
+    const unsigned n = vcnt + 1;
+    std::vector<bm::id_t> cnts(n);
+    for (unsigned i = 0; i < n; ++i)
+        cnts[i] = bv_ptrs[i] ? bv_ptrs[i]->count() : 0;
+
+    for (unsigned m = 0; m < 2; ++m)
+    {
+        builder_type::metric_type metric =
+            m ? builder_type::cosine : builder_type::jaccard;
+        // reference similarities
+        std::vector<float> ref(n * n);
+        for (unsigned i = 0; i < n; ++i)
+        {
+            for (unsigned j = 0; j < n; ++j)
+            {
+                bm::id_t and_cnt = 0;
+                if (bv_ptrs[i] && bv_ptrs[j])
+                    and_cnt = bm::count_and(*bv_ptrs[i], *bv_ptrs[j]);
+                ref[i * n + j] =
+                    builder_type::similarity(and_cnt, cnts[i], cnts[j], metric);
+            }
+        }
+
+        const unsigned tiles[] = { 1, 5, 64 };
+        for (unsigned t = 0; t < sizeof(tiles)/sizeof(tiles[0]); ++t)
+        {
+            // dense
+            {
+                builder_type sbuilder;
+                builder_type::task_batch tbatch;
+                sbuilder.set_metric(metric);
+                sbuilder.set_tile_size(tiles[t]);
+                sbuilder.build_plan(tbatch, bv_ptrs.data(), n);
+                if (t & 1)
+                    RunTaskBatchPool(tbatch, 3);
+                else
+                    bm::run_task_batch(tbatch);
+                for (unsigned i = 0; i < n; ++i)
+                    for (unsigned j = 0; j < n; ++j)
+                    {
+                        float s = sbuilder.get_similarity(i, j);
+                        if (s != ref[i * n + j])
+                        {
+                            cerr << "Similarity mismatch " << i << "," << j
+                                 << " " << s << " " << ref[i * n + j] << endl;
+                            assert(0); exit(1);
+                        }
+                    }
+            }
+            // top-K
+            {
+                const unsigned top_k = 5;
+                builder_type sbuilder;
+                builder_type::task_batch tbatch;
+                sbuilder.set_metric(metric);
+                sbuilder.set_tile_size(tiles[t]);
+                sbuilder.set_top_k(top_k);
+                sbuilder.build_plan(tbatch, bv_ptrs.data(), n);
+                if (t & 1)
+                    bm::run_task_batch(tbatch);
+                else
+                    RunTaskBatchPool(tbatch, 2);
+
+                std::vector<builder_type::neighbor> nb(top_k);
+                for (unsigned i = 0; i < n; ++i)
+                {
+                    std::vector<builder_type::neighbor> ref_nb;
+                    for (unsigned j = 0; j < n; ++j)
+                    {
+                        if (i == j || ref[i * n + j] == 0)
+                            continue;
+                        builder_type::neighbor r;
+                        r.idx = j; r.similarity = ref[i * n + j];
+                        ref_nb.push_back(r);
+                    }
+                    std::sort(ref_nb.begin(), ref_nb.end(),
+                        [](const builder_type::neighbor& a,
+                           const builder_type::neighbor& b)
+                        { return a.similarity > b.similarity ||
+                            (a.similarity == b.similarity && a.idx < b.idx); });
+                    if (ref_nb.size() > top_k)
+                        ref_nb.resize(top_k);
+
+                    unsigned cnt =
+                        sbuilder.get_top_k(i, nb.data(), unsigned(nb.size()));
+                    assert(cnt == ref_nb.size());
+                    if (cnt > 2) // short output buffer: best results only
+                    {
+                        builder_type::neighbor nb2[2];
+                        unsigned cnt2 = sbuilder.get_top_k(i, nb2, 2);
+                        assert(cnt2 == 2);
+                        assert(nb2[0].idx == ref_nb[0].idx);
+                        assert(nb2[1].idx == ref_nb[1].idx);
+                    }
+                    for (unsigned k = 0; k < cnt; ++k)
+                    {
+                        assert(nb[k].idx == ref_nb[k].idx);
+                        assert(nb[k].similarity == ref_nb[k].similarity);
+                    }
+                } // for i
+            }
+        } // for t
+    } // for m
+
+    cout << "---------------------------- Test similarity matrix builder OK" << endl;
+}
+
 static
 void ComparisonTest()
 {
@@ -8609,24 +9342,461 @@ void generate_sparse_bv(bvect& bv, bvect::size_type from,
 
 
 static
-void RangeDeserializationTest()
+void CheckDeltaApply(const bvect& bv_old, const bvect& bv_new,
+                     size_t* delta_size = 0)
 {
-    cout << "\n------------------------------- RangeDeserializationTest()" << endl;
+    bm::delta_serializer<bvect> dser;
+    bm::delta_serializer<bvect>::buffer_type buf;
+    dser.serialize(bv_old, bv_new, buf);
+
+    bvect bv(bv_old);
+    bm::delta_deserializer<bvect> ddeser;
+    size_t consumed = ddeser.apply(bv, buf.buf());
+    assert(consumed == buf.size());
+    if (!bv.equal(bv_new) || bv.size() != bv_new.size())
+    {
+        cerr << "Delta apply mismatch!" << endl;
+        bvect bv_x;
+        bv_x.bit_xor(bv, bv_new, bvect::opt_none);
+        bvect::size_type pos;
+        if (bv_x.find(pos))
+            cerr << "first diff at: " << pos << endl;
+        cerr << "sizes: " << bv.size() << " " << bv_new.size() << endl;
+        assert(0); exit(1);
+    }
+    if (delta_size)
+        *delta_size = buf.size();
+}
+
+static
+void TestDeltaSerialization()
+{
+    cout << "\n------------------------------- TestDeltaSerialization()" << endl;
 
-    cout << "============ BV sparse vector" << endl;
     {
-        std::vector<std::pair<bvect::size_type, bvect::size_type> > ranges;
+        bvect bv_old, bv_new;
+        CheckDeltaApply(bv_old, bv_new);
+        bv_new.set(10);
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+        bv_new.set_range(65536, 65536 * 3 - 1); // FULL blocks
+        bv_new.set_range(65536 * 5 + 10, 65536 * 5 + 200); // GAP block
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+        bv_old = bv_new;
+        bv_old.set(65536 * 2 + 5, false);
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+    }
 
-        ranges.push_back(std::make_pair(0, 65535 * 255));
-        ranges.push_back(std::make_pair(0, 65535 * 255 * 3));
-        ranges.push_back(std::make_pair(65535 * 5, 65535 * 255 * 2));
-        ranges.push_back(std::make_pair(65535 * 255 / 2, 65535 * 255));
-        ranges.push_back(std::make_pair(65535 * 255 / 2, 65535 * 255 * 2));
-        ranges.push_back(std::make_pair(bm::id_max / 2 - 65535 * 255 / 2, bm::id_max / 2 + 65535 * 255 * 2));
-        ranges.push_back(std::make_pair(bm::id_max / 2, bm::id_max / 2 + 65535 * 255 * 2));
-        ranges.push_back(std::make_pair(bm::id_max - 65535 * 255 * 2, bm::id_max - 1));
+    // size changes
+    {
+        bvect bv_old(1000), bv_new(2000);
+        bv_old.set(10); bv_new.set(10); bv_new.set(1500);
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+    }
 
-        for (size_t k = 0; k < ranges.size(); ++k)
+    // small mutations of a large vector
+    {
+        bvect bv_old;
+        generate_bvector(bv_old, 65536 * 200, true);
+
+        bm::serializer<bvect> bv_ser;
+        bm::serializer<bvect>::buffer sbuf;
+        {
+            bvect bv_tmp(bv_old);
+            bv_ser.optimize_serialize_destroy(bv_tmp, sbuf);
+        }
+
+        bvect bv_new(bv_old);
+        for (unsigned i = 0; i < 20; ++i)
+        {
+            bvect::size_type idx = bvect::size_type(rand()) % (65536 * 200);
+            bv_new.flip(idx);
+        }
+        size_t dsize;
+        CheckDeltaApply(bv_old, bv_new, &dsize);
+        cout << "  full: " << sbuf.size() << " delta: " << dsize << endl;
+        assert(dsize * 10 < sbuf.size());
+
+        // replaced blocks: cleared and re-filled with new content
+        bv_new.set_range(65536 * 3, 65536 * 4 - 1, false);
+        bv_new.set_range(65536 * 7, 65536 * 8 - 1, true);
+        for (unsigned i = 0; i < 2000; ++i)
+            bv_new.set(65536 * 9 + unsigned(rand()) % 65536);
+        bv_new.set(bm::id_max - 1);
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+
+        bm::delta_serializer<bvect> dser;
+        bm::delta_serializer<bvect>::buffer_type buf;
+        dser.serialize(bv_old, bv_new, buf);
+        const bm::delta_serializer<bvect>::statistics& st =
+                                                dser.get_statistics();
+        assert(st.blocks_changed == st.blocks_xor + st.blocks_replaced);
+        assert(st.blocks_replaced);
+    }
+
+    // random pairs
+    for (unsigned pass = 0; pass < 5; ++pass)
+    {
+        bvect bv_old, bv_new;
+        generate_bvector(bv_old, 65536 * 20, pass & 1);
+        generate_bvector(bv_new, 65536 * 30, !(pass & 1));
+        CheckDeltaApply(bv_old, bv_new);
+        CheckDeltaApply(bv_new, bv_old);
+    }
+
+    // corrupted header
+    {
+        unsigned char bad[64] = {0, };
+        bool caught = false;
+        try
+        {
+            bvect bv;
+            bm::delta_deserializer<bvect> ddeser;
+            ddeser.apply(bv, bad);
+        }
+        catch (std::exception&)
+        {
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    cout << "\n------------------------------- TestDeltaSerialization() OK" << endl;
+}
+
+static
+void TestSerializerDecodeCost()
+{
+    cout << "\n------------------------------- TestSerializerDecodeCost()" << endl;
+
+    bvect bv(bm::BM_BIT); // cost model applies to bit-blocks
+    {
+        // mix of sparse, dense and gap-friendly blocks
+        for (unsigned i = 0; i < 65536 * 4; i += 47)
+            bv.set(i);
+        for (unsigned i = 65536 * 4; i < 65536 * 6; ++i)
+            if (i % 31)
+                bv.set(i);
+        for (unsigned i = 65536 * 6; i < 65536 * 8; ++i)
+            if (i % 1024 < 100)
+                bv.set(i);
+        for (unsigned i = 65536 * 8; i < 65536 * 10; ++i)
+            if (rand() % 3 == 0)
+                bv.set(i);
+    }
+    const unsigned bic_codes[] = { bm::set_block_arr_bienc,
+                                   bm::set_block_arr_bienc_inv,
+                                   bm::set_block_gap_bienc,
+                                   bm::set_block_bitgap_bienc };
+
+    bm::serializer<bvect>::buffer buf0, buf1;
+    bm::serializer<bvect> bvs;
+    bvs.set_compression_level(6);
+    bvs.serialize(bv, buf0);
+    {
+        const bvect::size_type* cstat = bvs.get_compression_stat();
+        bvect::size_type bic_cnt = 0;
+        for (unsigned i = 0; i < sizeof(bic_codes)/sizeof(bic_codes[0]); ++i)
+            bic_cnt += cstat[bic_codes[i]];
+        assert(bic_cnt);
+    }
+
+    // zero cost model: same encoding as size-only
+    bm::serializer_decode_cost cost;
+    bvs.set_decode_cost_model(&cost, 1.0f);
+    bvs.serialize(bv, buf1);
+    assert(buf0.size() == buf1.size());
+    assert(::memcmp(buf0.buf(), buf1.buf(), buf0.size()) == 0);
+
+    // expensive BIC: codec is avoided, BLOB gets bigger
+    for (unsigned i = 0; i < sizeof(bic_codes)/sizeof(bic_codes[0]); ++i)
+        cost.ns_item[bic_codes[i]] = 100.0f;
+    bvs.serialize(bv, buf1);
+    {
+        const bvect::size_type* cstat = bvs.get_compression_stat();
+        for (unsigned i = 0; i < sizeof(bic_codes)/sizeof(bic_codes[0]); ++i)
+        {
+            assert(cstat[bic_codes[i]] == 0);
+        }
+        assert(buf1.size() > buf0.size());
+        bvect bv2;
+        bm::deserialize(bv2, buf1.buf());
+        assert(bv.equal(bv2));
+    }
+    bvs.set_decode_cost_model(0, 0);
+
+    // calibration on this CPU
+    {
+        bm::calibrate_decode_cost<bvect>(cost, 8, 2);
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            assert(cost.ns_block[i] >= 0 && cost.ns_item[i] >= 0);
+        }
+        assert(cost.ns_block[bm::set_block_bit] > 0);
+        cout << "  calibrated decode ns (block/item): raw=" <<
+            cost.ns_block[bm::set_block_bit] << " BIC=" <<
+            cost.ns_block[bm::set_block_arr_bienc] << "/" <<
+            cost.ns_item[bm::set_block_arr_bienc] << " 0runs=" <<
+            cost.ns_block[bm::set_block_bit_0runs] << "/" <<
+            cost.ns_item[bm::set_block_bit_0runs] << endl;
+
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            float bytes_per_ns = float(k) * 2.0f;
+            bvs.set_decode_cost_model(&cost, bytes_per_ns);
+            bvs.serialize(bv, buf1);
+            if (!k) // decode time has no weight: size-only encoding
+            {
+                assert(buf1.size() == buf0.size());
+            }
+            // codec choice depends on the measured timings: round-trip only
+            bvect bv2;
+            bm::deserialize(bv2, buf1.buf());
+            assert(bv.equal(bv2));
+        } // for k
+        bvs.set_decode_cost_model(0, 0);
+    }
+
+    // compression level tuning
+    {
+        unsigned level = bm::tune_compression_level(bv, 0.0f, 1);
+        assert(level >= 1 && level <= bm::set_compression_max);
+        bm::serializer<bvect> bvs_l;
+        size_t min_size = 0;
+        for (unsigned l = 1; l <= bm::set_compression_max; ++l)
+        {
+            bvs_l.set_compression_level(l);
+            bvs_l.serialize(bv, buf1);
+            if (l == 1 || buf1.size() < min_size)
+                min_size = buf1.size();
+        }
+        bvs_l.set_compression_level(level);
+        bvs_l.serialize(bv, buf1);
+        assert(buf1.size() == min_size);
+
+        level = bm::tune_compression_level(bv, 10.0f, 1);
+        assert(level >= 1 && level <= bm::set_compression_max);
+        cout << "  tuned compression level (10 bytes/ns): " << level << endl;
+    }
+
+    cout << "------------------------------- TestSerializerDecodeCost() OK" << endl;
+}
+
+
+static
+void TestBlockFingerprint()
+{
+    cout << "\n------------------------------- TestBlockFingerprint()" << endl;
+
+    typedef bm::bvector_fingerprint<bvect> fingerprint_type;
+    {
+        bvect bv1, bv2;
+        fingerprint_type fp1, fp2;
+        fp1.build(bv1); fp2.build(bv2);
+        assert(fp1.root() == 0);
+        assert(fp1.equal(fp2));
+
+        bv1.set_range(0, 65535); // FULL block
+        bv2.set_range(0, 65534);
+        bv2.set(65535);          // bit block, same content
+        bv1.set_range(65536 * 3, 65536 * 3 + 100); // GAP block
+        for (unsigned i = 0; i <= 100; ++i)
+            bv2.set(65536 * 3 + i);
+        bv1.optimize();
+        fp1.build(bv1); fp2.build(bv2);
+        assert(fp1.root());
+        assert(fp1.equal(fp2));
+        assert(fp1.block_hash(0) == fp2.block_hash(0));
+        assert(fp1.block_hash(1) == 0);
+
+        // empty blocks and trailing empty sub-arrays do not matter
+        bv2.set(bm::id_max - 1); bv2.set(bm::id_max - 1, false);
+        fp2.build(bv2);
+        assert(fp1.equal(fp2));
+    }
+
+    // block moved to a different position: roots must differ
+    {
+        const bvect::size_type moves[] = { 65536, 65536 * 256, 65536 * 257 };
+        for (unsigned m = 0; m < sizeof(moves)/sizeof(moves[0]); ++m)
+        {
+            bvect bv1 { 5 };
+            bvect bv2 { 5 + moves[m] };
+            fingerprint_type fp1, fp2;
+            fp1.build(bv1); fp2.build(bv2);
+            assert(!fp1.equal(fp2));
+            bvect bv_blocks;
+            fingerprint_type::size_type cnt =
+                                fp1.find_changed_blocks(fp2, bv_blocks);
+            assert(cnt == 2);
+            assert(bv_blocks.test(0));
+            assert(bv_blocks.test(moves[m] >> bm::set_block_shift));
+        }
+    }
+
+    for (unsigned pass = 0; pass < 3; ++pass)
+    {
+        bvect bv_old;
+        generate_bvector(bv_old, 65536 * 300, pass & 1);
+        bvect bv_new(bv_old);
+
+        fingerprint_type fp_old, fp_new;
+        fp_old.build(bv_old);
+        fp_new.build(bv_new);
+        assert(fp_old.equal(fp_new));
+
+        // mutate a few blocks, refresh incrementally
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            bvect::size_type idx = bvect::size_type(rand()) % (65536 * 600);
+            bv_new.flip(idx);
+            fp_new.update_range(bv_new, idx, idx);
+        }
+        bv_new.set_range(65536 * 700, 65536 * 702 + 10);
+        fp_new.update_range(bv_new, 65536 * 700, 65536 * 702 + 10);
+
+        fingerprint_type fp_chk;
+        fp_chk.build(bv_new);
+        assert(fp_chk.root() == fp_new.root());
+        assert(!fp_old.equal(fp_new));
+
+        bvect bv_blocks;
+        bvect::size_type cnt = fp_new.find_changed_blocks(fp_old, bv_blocks);
+        assert(cnt == bv_blocks.count());
+        {
+            // reported blocks are exactly the blocks with differences
+            bvect bv_x;
+            bv_x.bit_xor(bv_old, bv_new, bvect::opt_none);
+            bvect bv_diff_nb;
+            bvect::enumerator en = bv_x.first();
+            for (; en.valid(); ++en)
+                bv_diff_nb.set(*en >> 16);
+            assert(bv_diff_nb.equal(bv_blocks));
+        }
+
+        // fingerprint driven delta
+        bm::delta_serializer<bvect> dser;
+        bm::delta_serializer<bvect>::buffer_type buf;
+        dser.serialize_blocks(bv_old, bv_new, bv_blocks, buf);
+        assert(dser.get_statistics().blocks_changed == cnt);
+        bvect bv(bv_old);
+        bm::delta_deserializer<bvect> ddeser;
+        ddeser.apply(bv, buf.buf());
+        assert(bv.equal(bv_new));
+    }
+
+    cout << "\n------------------------------- TestBlockFingerprint() OK" << endl;
+}
+
+
+static
+void TestBlockDedupPool()
+{
+    cout << "\n------------------------------- TestBlockDedupPool()" << endl;
+
+    {
+        bvect bv1, bv2, bv3;
+        generate_bvector(bv1, 65536 * 50, false);
+        bv2 = bv1;
+        bv3 = bv1;
+        bv2.set(65536 * 10 + 5, !bv2.test(65536 * 10 + 5));
+        bv3.set_range(65536 * 20, 65536 * 20 + 100); // GAP-able block
+        bv3.set_range(65536 * 60, 65536 * 60 + 100);
+        bvect bv1c(bv1), bv2c(bv2), bv3c(bv3);
+
+        bm::bv_statistics st_orig;
+        {
+            bvect::statistics st;
+            bv1c.optimize(); bv2c.optimize(); bv3c.optimize();
+            bv1c.calc_stat(&st); st_orig.reset(); st_orig.add(st);
+            bv2c.calc_stat(&st); st_orig.add(st);
+            bv3c.calc_stat(&st); st_orig.add(st);
+        }
+        {
+            bm::block_dedup_pool<bvect> pool;
+            pool.add(bv1);
+            pool.add(bv2);
+            pool.add(bv3);
+            const bm::block_dedup_pool<bvect>::statistics& st =
+                                                    pool.get_statistics();
+            assert(st.blocks_unique < st.blocks_total);
+            assert(st.memory_saved);
+            bm::bv_statistics st_pool;
+            pool.calc_stat(&st_pool);
+            assert(st_pool.memory_used + st.memory_saved ==
+                   st_orig.memory_used);
+            cout << "  blocks: " << st.blocks_total
+                 << " unique: " << st.blocks_unique
+                 << " saved: " << st.memory_saved << endl;
+
+            // read-only access works on shared blocks
+            assert(bv1.equal(bv1c));
+            assert(bv2.equal(bv2c));
+            assert(bv3.equal(bv3c));
+            assert(bv3.count() == bv3c.count());
+
+            pool.release(bv2);
+            assert(pool.size() == 2);
+            bv2.set(65536 * 11); // writable again
+            bv2c.set(65536 * 11);
+            assert(bv2.equal(bv2c));
+            assert(bv1.equal(bv1c));
+        } // pool releases the rest
+        bv1.set(10); bv1c.set(10);
+        bv3.clear_range(0, 65536 * 5); bv3c.clear_range(0, 65536 * 5);
+        assert(bv1.equal(bv1c));
+        assert(bv3.equal(bv3c));
+    }
+
+    // sparse vector planes
+    {
+        typedef bm::sparse_vector<unsigned, bvect> svector_u32;
+        svector_u32 sv1, sv2;
+        for (unsigned i = 0; i < 65536 * 8; ++i)
+        {
+            sv1.set(i, i & 0xF);
+            sv2.set(i, (i & 0xF) | ((i >> 16) << 8));
+        }
+        svector_u32 sv1c(sv1), sv2c(sv2);
+        {
+            bm::block_dedup_pool<bvect> pool;
+            pool.add_planes(sv1);
+            pool.add_planes(sv2);
+            assert(pool.get_statistics().memory_saved);
+            assert(sv1.equal(sv1c));
+            assert(sv2.equal(sv2c));
+        }
+        sv1.set(5, 100); sv1c.set(5, 100);
+        assert(sv1.equal(sv1c));
+    }
+
+    cout << "\n------------------------------- TestBlockDedupPool() OK" << endl;
+}
+
+
+static
+void RangeDeserializationTest()
+{
+    cout << "\n------------------------------- RangeDeserializationTest()" << endl;
+
+    cout << "============ BV sparse vector" << endl;
+    {
+        std::vector<std::pair<bvect::size_type, bvect::size_type> > ranges;
+
+        ranges.push_back(std::make_pair(0, 65535 * 255));
+        ranges.push_back(std::make_pair(0, 65535 * 255 * 3));
+        ranges.push_back(std::make_pair(65535 * 5, 65535 * 255 * 2));
+        ranges.push_back(std::make_pair(65535 * 255 / 2, 65535 * 255));
+        ranges.push_back(std::make_pair(65535 * 255 / 2, 65535 * 255 * 2));
+        ranges.push_back(std::make_pair(bm::id_max / 2 - 65535 * 255 / 2, bm::id_max / 2 + 65535 * 255 * 2));
+        ranges.push_back(std::make_pair(bm::id_max / 2, bm::id_max / 2 + 65535 * 255 * 2));
+        ranges.push_back(std::make_pair(bm::id_max - 65535 * 255 * 2, bm::id_max - 1));
+
+        for (size_t k = 0; k < ranges.size(); ++k)
         {
             bvect bv;  // generated random
 
@@ -14121,6 +15291,229 @@ void BlockLevelTest()
 
 
 
+static
+void IntervalListTest()
+{
+    cout << "----------------------------- IntervalListTest()" << endl;
+
+    typedef bm::interval_list<bvect> ilist_type;
+
+    {
+        ilist_type il;
+        assert(il.empty());
+        il.add_interval(10, 20);
+        il.add_interval(15, 30); // overlap
+        il.add_interval(31, 40); // adjacent
+        il.add_interval(100, 100);
+        assert(il.size() == 2);
+        assert(il.start(0) == 10 && il.end(0) == 40);
+        assert(il.count() == 32);
+        assert(il.test(10) && il.test(40) && il.test(100));
+        assert(!il.test(9) && !il.test(41) && !il.test(101));
+
+        bvect bv;
+        il.export_to(bv);
+        assert(bv.count() == 32);
+        ilist_type il2(bv);
+        assert(il2.equal(il));
+
+        bvect bv_f;
+        bv_f.set_range(bm::id_max - 100, bm::id_max - 1); // vector end
+        ilist_type il3(bv_f), il4;
+        assert(il3.size() == 1 && il3.end(0) == bm::id_max - 1);
+        il4.bit_sub(il3, il);
+        assert(il4.equal(il3));
+        il4.bit_and(il3, il3);
+        assert(il4.equal(il3));
+    }
+
+    // run-heavy vectors vs block engine
+    for (unsigned pass = 0; pass < 20; ++pass)
+    {
+        bvect bv1, bv2;
+        const unsigned max_len = (pass & 1) ? 300 : 300000;
+        for (unsigned k = 0; k < 2; ++k)
+        {
+            bvect& bv = k ? bv2 : bv1;
+            unsigned pos = unsigned(rand()) % 1000;
+            for (unsigned i = 0; i < 200; ++i)
+            {
+                unsigned len = 1 + unsigned(rand()) % max_len;
+                bv.set_range(pos, pos + len - 1);
+                pos += len + 1 + unsigned(rand()) % max_len;
+            }
+        }
+        if (pass == 2)
+            bv2 = bv1; // identical
+        if (pass == 4)
+            bv2.clear(); // empty
+        if (pass & 2)
+            bv1.optimize();
+
+        ilist_type il1(bv1), il2(bv2), il_r, il_c;
+        bvect bv_r, bv_c;
+
+        assert(il1.count() == bv1.count());
+        for (unsigned i = 0; i < 1000; ++i)
+        {
+            unsigned pos = unsigned(rand()) % (il1.empty() ? 1 :
+                                    unsigned(il1.end(il1.size() - 1) + 2));
+            assert(il1.test(pos) == bv1.test(pos));
+        }
+
+        for (unsigned op = 0; op < 3; ++op)
+        {
+            switch (op)
+            {
+            case 0: il_r.bit_and(il1, il2); bv_c = bv1 & bv2; break;
+            case 1: il_r.bit_or(il1, il2);  bv_c = bv1 | bv2; break;
+            default: il_r.bit_sub(il1, il2); bv_c = bv1 - bv2;
+            }
+            il_r.export_to(bv_r);
+            if (!bv_r.equal(bv_c))
+            {
+                cerr << "Interval list op=" << op << " mismatch" << endl;
+                assert(0); exit(1);
+            }
+            il_c.import_from(bv_c);
+            assert(il_c.equal(il_r));
+        } // for op
+    } // for pass
+
+    cout << "----------------------------- IntervalListTest() OK" << endl;
+}
+
+static
+void IntervalIndexTest()
+{
+    cout << "----------------------------- IntervalIndexTest()" << endl;
+
+    typedef bm::interval_index<bvect> iindex_type;
+
+    {
+        iindex_type iidx;
+        iidx.build(); // empty
+        assert(iidx.size() == 0);
+        assert(iidx.stab_count(10) == 0);
+        assert(iidx.overlap_count(0, 100) == 0);
+        bvect bv_ids;
+        iidx.find_overlaps(0, 100, bv_ids);
+        assert(!bv_ids.any());
+    }
+
+    for (unsigned pass = 0; pass < 4; ++pass)
+    {
+        // pass 0, 2: unique starts/ends; 1, 3: repeats
+        const unsigned icnt = 3000;
+        const unsigned max_pos = (pass & 2) ? 65536 * 300 : 65536 * 2;
+        std::vector<std::pair<unsigned, unsigned> > ivals;
+        iindex_type iidx;
+        for (unsigned i = 0; i < icnt; ++i)
+        {
+            unsigned from = (pass & 1) ? (unsigned(rand()) % 200) * 97
+                                       : i * (max_pos / icnt) + 1;
+            unsigned len = (i % 10 == 0) ? unsigned(rand()) % 200000
+                                         : unsigned(rand()) % 500;
+            if (pass & 1)
+                len = (len / 50) * 50;
+            unsigned to = from + len;
+            ivals.push_back(std::make_pair(from, to));
+            iidx.add(from, to);
+        }
+        iidx.build();
+        assert(iidx.size() == icnt);
+
+        // get_interval() in the start order
+        {
+            unsigned prev_from = 0;
+            for (unsigned k = 0; k < icnt; ++k)
+            {
+                bvect::size_type from, to;
+                bvect::size_type id = iidx.get_interval(k, from, to);
+                assert(ivals[id].first == from && ivals[id].second == to);
+                assert(from >= prev_from);
+                prev_from = unsigned(from);
+            }
+        }
+
+        std::vector<bvect::size_type> points, counts;
+        for (unsigned i = 0; i < 2000; ++i)
+            points.push_back(unsigned(rand()) % (max_pos + 300000));
+        points.push_back(0);
+        points.push_back(ivals[5].first);
+        points.push_back(ivals[5].second);
+        points.push_back(ivals[5].second + 1);
+        std::sort(points.begin(), points.end());
+        counts.resize(points.size());
+        iidx.stab_count_sorted(points.data(), points.size(), counts.data());
+
+        bvect bv_ids, bv_ref;
+        for (size_t q = 0; q < points.size(); ++q)
+        {
+            unsigned a = unsigned(points[q]);
+            unsigned b = a + ((q & 1) ? 0 : unsigned(rand()) % 5000);
+            bv_ref.clear();
+            unsigned stab = 0;
+            for (unsigned i = 0; i < icnt; ++i)
+            {
+                stab += (ivals[i].first <= a && ivals[i].second >= a);
+                if (ivals[i].first <= b && ivals[i].second >= a)
+                    bv_ref.set(i);
+            }
+            assert(iidx.stab_count(a) == stab);
+            assert(counts[q] == stab);
+            assert(iidx.overlap_count(a, b) == bv_ref.count());
+            iidx.find_overlaps(a, b, bv_ids);
+            if (!bv_ids.equal(bv_ref))
+            {
+                cerr << "Interval index overlap mismatch [" << a << ", "
+                     << b << "]" << endl;
+                assert(0); exit(1);
+            }
+            if (q % 16 == 0) // enumeration with select-recovered starts
+            {
+                struct check_func
+                {
+                    const std::vector<std::pair<unsigned, unsigned> >* iv;
+                    bvect* bv;
+                    void operator()(bvect::size_type id,
+                                    bvect::size_type from,
+                                    bvect::size_type to)
+                    {
+                        assert((*iv)[id].first == from);
+                        assert((*iv)[id].second == to);
+                        bv->set(id);
+                        (void)from; (void)to;
+                    }
+                };
+                bv_ids.clear();
+                check_func cf; cf.iv = &ivals; cf.bv = &bv_ids;
+                iidx.for_each_overlap(a, b, cf);
+                assert(bv_ids.equal(bv_ref));
+            }
+        } // for q
+
+        // add() after build() reverts to construction, ids are kept
+        assert(iidx.is_built());
+        iidx.add(7, 2000000);
+        ivals.push_back(std::make_pair(7u, 2000000u));
+        assert(!iidx.is_built());
+        iidx.build();
+        assert(iidx.size() == icnt + 1);
+        for (unsigned k = 0; k < icnt + 1; ++k)
+        {
+            bvect::size_type from, to;
+            bvect::size_type id = iidx.get_interval(k, from, to);
+            assert(ivals[id].first == from && ivals[id].second == to);
+        }
+        iidx.find_overlaps(1000000, 1000000, bv_ids);
+        assert(bv_ids.test(icnt));
+        assert(iidx.stab_count(1000000) == bv_ids.count());
+    } // for pass
+
+    cout << "----------------------------- IntervalIndexTest() OK" << endl;
+}
+
 static
 void IntervalEnumeratorTest()
 {
@@ -16837,94 +18230,344 @@ void CountRangeTest()
     cout << "---------------------------- CountRangeTest OK" << endl;
 }
 
-// -----------------------------------------------------------------------
-
-bvect::size_type
-from_arr[] = { 0, 0, 0,  0,  7,  1,   0,     65535, 65535,   0,     0,                 bm::id_max/2-2001, bm::id_max-2000, bm::id_max-1};
-bvect::size_type
-to_arr[]   = { 0, 1, 16, 32, 31, 255, 65535, 65536, 65536*2, 65537, bm::id_max/2-2000, bm::id_max/2+2000, bm::id_max-1,    bm::id_max-1};
-
 static
-void verify_all_one_ranges(const bvect& bv, bool all_one)
+void RSIndexInterleavedTest()
 {
-    size_t fr_size = sizeof(from_arr) / sizeof(from_arr[0]);
-    size_t to_size = sizeof(to_arr) / sizeof(to_arr[0]);
+    cout << "---------------------------- RSIndexInterleavedTest..." << endl;
 
-    assert(fr_size == to_size);
+    bvect bv;
+    // bit-blocks, GAP blocks, FULL blocks and FULL super-block
+    for (unsigned i = 0; i < 65536 * 3; i += 1 + unsigned(rand()) % 7)
+        bv.set(i);
+    bv.set_range(65536 * 3, 65536 * 4 - 1);
+    for (unsigned i = 65536 * 5; i < 65536 * 6; i += 4096)
+        bv.set(i);
+    bv.set_range(65536 * 256, 65536 * 512 - 1);
+    for (unsigned i = 65536 * 600; i < 65536 * 601; i += 1 + unsigned(rand()) % 3)
+        bv.set(i);
+    bv.set(bm::id_max - 1);
 
-    for (unsigned t = 0; t < fr_size; ++t)
+    for (unsigned pass = 0; pass < 2; ++pass)
     {
-        bool one_test, one_test_cnt, any_one_test;
-        bool is_int, is_int_c;
-        bvect::size_type from(from_arr[t]), to(to_arr[t]);
+        bvect::rs_index_type rs_idx0;
+        bv.build_rs_index(&rs_idx0);
+        bvect::rs_index_type rs_idx(rs_idx0); // copy keeps lines aligned
+        bvect::rs_index_type rs_idx2;
+        rs_idx2 = rs_idx;
+        rs_idx0.init();
 
-        one_test = bv.is_all_one_range(from, to);
-        if (all_one)
+        assert(rs_idx.count() == bv.count());
+        for (unsigned nb = 0; nb < 700; ++nb)
         {
-            assert(one_test);
-            any_one_test = bv.any_range(from, to);
-            assert(any_one_test);
-            is_int = bm::is_interval(bv, from, to);
-            is_int_c = test_interval(bv, from, to);
-            assert(is_int == is_int_c);
-            assert(!is_int);
-            if (is_int)
-            {
-                if (to < from)
-                    bm::xor_swap(to, from);
-                bvect::size_type pos;
-                bool b = bm::find_interval_end(bv, from, pos);
-                assert(b && pos == to);
-                b = bm::find_interval_start(bv, to, pos);
-                assert(b && pos == from);
-            }
+            bvect::size_type c = bv.count_range(nb * 65536, nb * 65536 + 65535);
+            assert(rs_idx.count(nb) == c);
+            assert(rs_idx2.count(nb) == c);
+            c = nb ? bv.count_range(0, nb * 65536 - 1) : 0;
+            assert(rs_idx.rcount_before(nb) == c);
         }
-        else
+
+        // rank probes around sub-block borders
+        std::vector<bvect::size_type> probes;
+        for (unsigned nb = 0; nb < 7; ++nb)
         {
-            auto cnt = bv.count_range(from, to);
-            one_test_cnt = (cnt == to - from + 1);
-            assert(one_test_cnt == one_test);
-            any_one_test = bv.any_range(from, to);
-            if (cnt)
-            {
-                assert(any_one_test);
-            }
-            else
+            for (unsigned k = 0; k <= bm::rs_sub_blocks; ++k)
             {
-                assert(!any_one_test);
+                bvect::size_type p = nb * 65536 + k * bm::rs_sub_block_size;
+                probes.push_back(p);
+                probes.push_back(p + bm::rs_sub_block_size / 2);
+                if (p)
+                    probes.push_back(p - 1);
             }
-            is_int = bm::is_interval(bv, from, to);
-            is_int_c = test_interval(bv, from, to);
-            assert(is_int == is_int_c);
-            if (is_int)
+        }
+        for (unsigned i = 0; i < 10000; ++i)
+            probes.push_back(unsigned(rand()) % (65536 * 700));
+        probes.push_back(bm::id_max - 1);
+
+        for (size_t i = 0; i < probes.size(); ++i)
+        {
+            bvect::size_type p = probes[i];
+            bvect::size_type c = bv.count_range(0, p);
+            bvect::size_type c1 = bv.count_to(p, rs_idx);
+            bvect::size_type c2 = bv.count_to(p, rs_idx2);
+            assert(c == c1);
+            assert(c == c2);
+            bvect::size_type rc = bv.rank_corrected(p, rs_idx);
+            assert(rc == c - bv.test(p));
+            if (c)
             {
-                if (to < from)
-                    bm::xor_swap(to, from);
                 bvect::size_type pos;
-                bool b = bm::find_interval_end(bv, from, pos);
-                assert(b && pos == to);
-                b = bm::find_interval_start(bv, to, pos);
-                assert(b && pos == from);
+                bool found = bv.select(c, pos, rs_idx);
+                assert(found);
+                assert(pos <= p && bv.test(pos));
+                assert(bv.count_range(0, pos) == c);
+                bvect::size_type pos2;
+                found = bv.find_rank(c, 0, pos2, rs_idx2);
+                assert(found);
+                assert(pos == pos2);
             }
+        } // for i
+        bv.optimize();
+    } // for pass
 
-        }
-        // [from-1, to] range check
-        //
-        if (from)
+    // sparse: lines are kept only for non-empty blocks
+    {
+        bvect bv_s;
+        for (unsigned i = 0; i < 64; ++i)
+            bv_s.set(i * 65536 * 256 + i);
+        bvect::rs_index_type rs_idx;
+        bv_s.build_rs_index(&rs_idx);
+        assert(rs_idx.mem_usage() <
+               64 * (bm::set_sub_array_size * sizeof(unsigned) +
+                     4 * sizeof(bvect::rs_index_type::rs_line)) + 4096);
+        for (unsigned i = 0; i < 64; ++i)
         {
-            --from;
-            one_test = bv.is_all_one_range(from, to);
-            any_one_test = bv.any_range(from, to);
+            bvect::size_type pos;
+            bool found = bv_s.select(i + 1, pos, rs_idx);
+            assert(found && pos == bvect::size_type(i) * 65536 * 256 + i);
+            assert(bv_s.count_to(pos, rs_idx) == i + 1);
+        }
+    }
 
-            is_int = bm::is_interval(bv, from, to);
-            is_int_c = test_interval(bv, from, to);
-            assert(is_int == is_int_c);
+    cout << "---------------------------- RSIndexInterleavedTest OK" << endl;
+}
 
-            if (all_one)
-            {
-                assert(one_test);
-                assert(any_one_test);
-            }
+static
+void RankSelectBatchTest()
+{
+    cout << "---------------------------- RankSelectBatchTest..." << endl;
+
+    bvect bv;
+    for (unsigned i = 0; i < 65536 * 3; i += 1 + unsigned(rand()) % 7)
+        bv.set(i);
+    bv.set_range(65536 * 3, 65536 * 4 - 1);
+    for (unsigned i = 65536 * 5; i < 65536 * 6; i += 1000)
+        bv.set(i);
+    bv.set_range(65536 * 256, 65536 * 512 - 1);
+    bv.set(bm::id_max - 1);
+
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        bvect::rs_index_type rs_idx;
+        bv.build_rs_index(&rs_idx);
+        const bvect::size_type total = bv.count();
+
+        for (unsigned sorted = 0; sorted < 2; ++sorted)
+        {
+            std::vector<bvect::size_type> pos_v, rank_v;
+            for (unsigned i = 0; i < 20000; ++i)
+            {
+                pos_v.push_back(unsigned(rand()) % (65536 * 600));
+                rank_v.push_back(unsigned(rand()) % (total + 2));
+            }
+            // dense run of queries in one block
+            for (unsigned i = 0; i < 1000; ++i)
+            {
+                pos_v.push_back(65536 + i * 7);
+                rank_v.push_back(10000 + i * 3);
+            }
+            pos_v.push_back(bm::id_max - 1);
+            rank_v.push_back(total);
+            if (sorted)
+            {
+                std::sort(pos_v.begin(), pos_v.end());
+                std::sort(rank_v.begin(), rank_v.end());
+            }
+            std::vector<bvect::size_type> out(pos_v.size());
+            bv.rank_batch(pos_v.data(), out.data(), pos_v.size(), rs_idx);
+            for (size_t i = 0; i < pos_v.size(); ++i)
+            {
+                bvect::size_type c = bv.count_to(pos_v[i], rs_idx);
+                assert(out[i] == c);
+            }
+
+            bvect::size_type found_cnt =
+                bv.select_batch(rank_v.data(), out.data(), rank_v.size(), rs_idx);
+            bvect::size_type cnt = 0;
+            for (size_t i = 0; i < rank_v.size(); ++i)
+            {
+                bvect::size_type pos;
+                bool found = bv.select(rank_v[i], pos, rs_idx);
+                if (found)
+                {
+                    assert(out[i] == pos);
+                    ++cnt;
+                }
+                else
+                {
+                    assert(out[i] == bm::id_max);
+                }
+            }
+            assert(cnt == found_cnt);
+        } // for sorted
+        bv.optimize();
+    } // for pass
+
+    {
+        bvect bv_e;
+        bvect::rs_index_type rs_idx;
+        bv_e.build_rs_index(&rs_idx);
+        bvect::size_type p[2] = { 0, 100 }, out[2];
+        bv_e.rank_batch(p, out, 2, rs_idx);
+        assert(out[0] == 0 && out[1] == 0);
+        bvect::size_type r[2] = { 1, 2 };
+        bvect::size_type found_cnt = bv_e.select_batch(r, out, 2, rs_idx);
+        assert(found_cnt == 0);
+        assert(out[0] == bm::id_max);
+    }
+
+    cout << "---------------------------- RankSelectBatchTest OK" << endl;
+}
+
+static
+void SelectSampledTest()
+{
+    cout << "---------------------------- SelectSampledTest..." << endl;
+
+    bvect bv;
+    for (unsigned i = 0; i < 20000; ++i)
+        bv.set(unsigned(rand()) * 131u % bm::id_max);
+    bv.set_range(65536 * 256, 65536 * 257 + 100); // FULL super-block
+    bv.set(bm::id_max - 1);
+
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        bvect::rs_index_type rs_idx;
+        bv.build_rs_index(&rs_idx);
+        assert(rs_idx.select_samples_size() == 0);
+        const bvect::size_type total = bv.count();
+
+        const unsigned shifts[] = { 1, 2, 5, 20 };
+        for (unsigned si = 0; si < sizeof(shifts)/sizeof(shifts[0]); ++si)
+        {
+            bvect::rs_index_type rs_idx_s0;
+            rs_idx_s0.set_select_sampling(shifts[si]);
+            bv.build_rs_index(&rs_idx_s0);
+            assert(rs_idx_s0.select_samples_size() ==
+                   ((total - 1) >> shifts[si]) + 1);
+            bvect::rs_index_type rs_idx_s(rs_idx_s0);
+            assert(rs_idx_s.get_select_sampling() == shifts[si]);
+
+            for (bvect::size_type r = 1; r <= total + 1; r += 1 + r / 64)
+            {
+                bvect::size_type pos, pos_s;
+                bool found = bv.select(r, pos, rs_idx);
+                bool found_s = bv.select(r, pos_s, rs_idx_s);
+                assert(found == found_s);
+                if (found)
+                {
+                    assert(pos == pos_s);
+                }
+            } // for r
+            for (unsigned i = 0; i < 2000; ++i)
+            {
+                bvect::size_type from = unsigned(rand()) * 131u % bm::id_max;
+                bvect::size_type rank = 1 + unsigned(rand()) % 5;
+                bvect::size_type pos, pos_s;
+                bool found = bv.find_rank(rank, from, pos, rs_idx);
+                bool found_s = bv.find_rank(rank, from, pos_s, rs_idx_s);
+                assert(found == found_s);
+                if (found)
+                {
+                    assert(pos == pos_s);
+                    assert(bv.count_range(from, pos) == rank);
+                    assert(bv.test(pos));
+                }
+            } // for i
+        } // for si
+        bv.optimize();
+    } // for pass
+
+    cout << "---------------------------- SelectSampledTest OK" << endl;
+}
+
+// -----------------------------------------------------------------------
+
+bvect::size_type
+from_arr[] = { 0, 0, 0,  0,  7,  1,   0,     65535, 65535,   0,     0,                 bm::id_max/2-2001, bm::id_max-2000, bm::id_max-1};
+bvect::size_type
+to_arr[]   = { 0, 1, 16, 32, 31, 255, 65535, 65536, 65536*2, 65537, bm::id_max/2-2000, bm::id_max/2+2000, bm::id_max-1,    bm::id_max-1};
+
+static
+void verify_all_one_ranges(const bvect& bv, bool all_one)
+{
+    size_t fr_size = sizeof(from_arr) / sizeof(from_arr[0]);
+    size_t to_size = sizeof(to_arr) / sizeof(to_arr[0]);
+
+    assert(fr_size == to_size);
+
+    for (unsigned t = 0; t < fr_size; ++t)
+    {
+        bool one_test, one_test_cnt, any_one_test;
+        bool is_int, is_int_c;
+        bvect::size_type from(from_arr[t]), to(to_arr[t]);
+
+        one_test = bv.is_all_one_range(from, to);
+        if (all_one)
+        {
+            assert(one_test);
+            any_one_test = bv.any_range(from, to);
+            assert(any_one_test);
+            is_int = bm::is_interval(bv, from, to);
+            is_int_c = test_interval(bv, from, to);
+            assert(is_int == is_int_c);
+            assert(!is_int);
+            if (is_int)
+            {
+                if (to < from)
+                    bm::xor_swap(to, from);
+                bvect::size_type pos;
+                bool b = bm::find_interval_end(bv, from, pos);
+                assert(b && pos == to);
+                b = bm::find_interval_start(bv, to, pos);
+                assert(b && pos == from);
+            }
+        }
+        else
+        {
+            auto cnt = bv.count_range(from, to);
+            one_test_cnt = (cnt == to - from + 1);
+            assert(one_test_cnt == one_test);
+            any_one_test = bv.any_range(from, to);
+            if (cnt)
+            {
+                assert(any_one_test);
+            }
+            else
+            {
+                assert(!any_one_test);
+            }
+            is_int = bm::is_interval(bv, from, to);
+            is_int_c = test_interval(bv, from, to);
+            assert(is_int == is_int_c);
+            if (is_int)
+            {
+                if (to < from)
+                    bm::xor_swap(to, from);
+                bvect::size_type pos;
+                bool b = bm::find_interval_end(bv, from, pos);
+                assert(b && pos == to);
+                b = bm::find_interval_start(bv, to, pos);
+                assert(b && pos == from);
+            }
+
+        }
+        // [from-1, to] range check
+        //
+        if (from)
+        {
+            --from;
+            one_test = bv.is_all_one_range(from, to);
+            any_one_test = bv.any_range(from, to);
+
+            is_int = bm::is_interval(bv, from, to);
+            is_int_c = test_interval(bv, from, to);
+            assert(is_int == is_int_c);
+
+            if (all_one)
+            {
+                assert(one_test);
+                assert(any_one_test);
+            }
             else
             {
                 auto cnt = bv.count_range(from, to);
@@ -18778,6 +20421,217 @@ void InterpolativeCodingTest()
     cout << "---------------------------- InterpolativeCodingTest() OK " << endl;
 }
 
+static
+void InterpolativeCodingIterTest()
+{
+    cout << "---------------------------- InterpolativeCodingIterTest() " << endl;
+
+    std::vector<unsigned char> buf1(1024 * 200), buf2(1024 * 200);
+    std::vector<bm::gap_word_t> sa, da;
+    BM_DECLARE_TEMP_BLOCK(tb1)
+    BM_DECLARE_TEMP_BLOCK(tb2)
+    bm::word_t* blk1 = (bm::word_t*)tb1;
+    bm::word_t* blk2 = (bm::word_t*)tb2;
+
+    const unsigned test_count = 20000;
+    for (unsigned k = 0; k < test_count; ++k)
+    {
+        // sorted set of runs and isolated values in [lo, hi]
+        unsigned lo = (k & 1) ? 0 : unsigned(rand()) % 1024;
+        unsigned hi = (k & 2) ? 65535 : lo + unsigned(rand()) % (65535 - lo);
+        unsigned range = hi - lo + 1;
+        unsigned density = unsigned(rand()) % 5;
+        bm::bit_block_set(blk1, 0);
+        if (k % 97 == 0)
+        {
+            bm::or_bit_block(blk1, lo, range); // full (dense) range
+        }
+        else
+        {
+            unsigned cnt = 1 + unsigned(rand()) % (range / (1u << density) + 1);
+            for (unsigned i = 0; i < cnt; ++i)
+            {
+                unsigned v = lo + unsigned(rand()) % range;
+                unsigned run = (density & 1) ? unsigned(rand()) % 64 : 1;
+                if (v + run > hi + 1)
+                    run = hi + 1 - v;
+                bm::or_bit_block(blk1, v, run);
+            }
+        }
+        sa.resize(65536);
+        unsigned sz = bm::bit_block_convert_to_arr(sa.data(), blk1, false);
+        sa.resize(sz);
+        assert(sz);
+        if (k % 13 == 0 && sz > 2) // encode with borders (serializer style)
+        {
+            lo = sa[0]; hi = sa[sz-1];
+            sa.erase(sa.begin()); sa.pop_back();
+            sz -= 2;
+            bm::bit_block_set(blk1, 0);
+            for (unsigned i = 0; i < sz; ++i)
+                bm::set_bit(blk1, sa[i]);
+        }
+
+        // reference (recursive) and iterative encoders: same bit-stream
+        size_t sz1, sz2;
+        {
+            bm::encoder enc(buf1.data(), buf1.size());
+            bm::bit_out<bm::encoder> bout(enc);
+            bout.gamma(k+1);
+            if (sz)
+                bout.bic_encode_u16_cm(sa.data(), sz,
+                                       bm::gap_word_t(lo), bm::gap_word_t(hi));
+            bout.gamma(k+2);
+            bout.flush();
+            sz1 = enc.size();
+        }
+        {
+            bm::encoder enc(buf2.data(), buf2.size());
+            bm::bit_out<bm::encoder> bout(enc);
+            bout.gamma(k+1);
+            bout.bic_encode_u16(sa.data(), sz,
+                                bm::gap_word_t(lo), bm::gap_word_t(hi));
+            bout.gamma(k+2);
+            bout.flush();
+            sz2 = enc.size();
+        }
+        assert(sz1 == sz2);
+        int cmp = ::memcmp(buf1.data(), buf2.data(), sz1);
+        assert(cmp == 0); (void)cmp;
+
+        // iterative decoders: array, bit-block, dry
+        {
+            da.resize(sz + 1);
+            bm::decoder dec(buf1.data());
+            bm::bit_in<bm::decoder> bin(dec);
+            unsigned v = bin.gamma();
+            assert(v == k+1);
+            bin.bic_decode_u16(da.data(), sz,
+                               bm::gap_word_t(lo), bm::gap_word_t(hi));
+            v = bin.gamma();
+            assert(v == k+2);
+            for (unsigned i = 0; i < sz; ++i)
+            {
+                assert(sa[i] == da[i]);
+            }
+            assert(size_t(dec.get_pos() - buf1.data()) == sz1);
+        }
+        {
+            bm::bit_block_set(blk2, 0);
+            bm::decoder dec(buf1.data());
+            bm::bit_in<bm::decoder> bin(dec);
+            unsigned v = bin.gamma();
+            assert(v == k+1);
+            bin.bic_decode_u16_bitset(blk2, sz,
+                                bm::gap_word_t(lo), bm::gap_word_t(hi));
+            v = bin.gamma();
+            assert(v == k+2);
+            int bcmp = ::memcmp(blk1, blk2, bm::set_block_size * sizeof(bm::word_t));
+            assert(bcmp == 0); (void)bcmp;
+        }
+        {
+            bm::decoder dec(buf1.data());
+            bm::bit_in<bm::decoder> bin(dec);
+            unsigned v = bin.gamma();
+            assert(v == k+1);
+            bin.bic_decode_u16_dry(sz,
+                                bm::gap_word_t(lo), bm::gap_word_t(hi));
+            v = bin.gamma();
+            assert(v == k+2);
+        }
+        if ((k & 0xFFF) == 0)
+            cout << "\r" << k << "/" << test_count << flush;
+    } // for k
+
+    cout << "\n---------------------------- InterpolativeCodingIterTest() OK " << endl;
+}
+
+static
+void GammaDGapEncoderTest()
+{
+    cout << "---------------------------- GammaDGapEncoderTest" << endl;
+
+    std::vector<unsigned char> buf1(1024 * 200), buf2(1024 * 200);
+    std::vector<bm::gap_word_t> sa, da;
+
+    const unsigned test_count = 50000;
+    for (unsigned k = 0; k < test_count; ++k)
+    {
+        // sorted unique array with a random d-gap profile
+        unsigned max_gap = 1u << (unsigned(rand()) % 17);
+        unsigned v = unsigned(rand()) % max_gap;
+        if (k % 11 == 0)
+            v = (k % 22) ? 0 : 65535;
+        sa.resize(0);
+        while (v < 65536 && sa.size() < 4096)
+        {
+            sa.push_back(bm::gap_word_t(v));
+            v += 1 + unsigned(rand()) % max_gap;
+        }
+        unsigned sz = unsigned(sa.size());
+        unsigned pad = unsigned(rand()) % 33; // leading bits offset
+
+        // reference: value by value
+        size_t sz1, sz2;
+        {
+            bm::encoder enc(buf1.data(), buf1.size());
+            bm::bit_out<bm::encoder> bout(enc);
+            if (pad)
+                bout.put_bits(0x5u, pad);
+            bout.gamma(sz);
+            unsigned prev = sa[0];
+            bout.gamma(prev + 1);
+            for (unsigned i = 1; i < sz; ++i)
+            {
+                bout.gamma(sa[i] - prev);
+                prev = sa[i];
+            }
+            bout.gamma(k+1);
+            bout.flush();
+            sz1 = enc.size();
+        }
+        {
+            bm::encoder enc(buf2.data(), buf2.size());
+            bm::bit_out<bm::encoder> bout(enc);
+            if (pad)
+                bout.put_bits(0x5u, pad);
+            bout.gamma(sz);
+            bout.gamma_dgap_u16(sa.data(), sz);
+            bout.gamma(k+1);
+            bout.flush();
+            sz2 = enc.size();
+        }
+        assert(sz1 == sz2);
+        int cmp = ::memcmp(buf1.data(), buf2.data(), sz1);
+        assert(cmp == 0); (void)cmp;
+
+        {
+            bm::decoder dec(buf1.data());
+            bm::bit_in<bm::decoder> bin(dec);
+            if (pad)
+            {
+                unsigned p = bin.get_bits(pad);
+                assert(p == (0x5u & (~0u >> (32 - pad)))); (void)p;
+            }
+            unsigned len = bin.gamma();
+            assert(len == sz);
+            da.resize(len);
+            bin.gamma_dgap_u16(da.data(), len);
+            for (unsigned i = 0; i < sz; ++i)
+            {
+                assert(sa[i] == da[i]);
+            }
+            unsigned t = bin.gamma();
+            assert(t == k+1); (void)t;
+            assert(size_t(dec.get_pos() - buf1.data()) == sz1);
+        }
+        if ((k & 0xFFF) == 0)
+            cout << "\r" << k << "/" << test_count << flush;
+    } // for k
+
+    cout << "\n---------------------------- GammaDGapEncoderTest OK" << endl;
+}
+
 static
 void GammaEncoderTest()
 {
@@ -21411,120 +23265,672 @@ void CheckSparseVectorGather(const sparse_vector_u32& sv,
     sv.decode(target_v_control.data(), from, gather_size);
 
 
-    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_SORTED);
-    for (unsigned i = 0; i < gather_size; ++i)
+    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_SORTED);
+    for (unsigned i = 0; i < gather_size; ++i)
+    {
+        unsigned vg = target_v[i];
+        unsigned vc = target_v_control[i];
+        if (vg != vc)
+        {
+            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
+                 << " at=" << i << endl;
+            cerr << control_value << endl;
+            exit(1);
+        }
+    }
+    
+    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNSORTED);
+    for (unsigned i = 0; i < gather_size; ++i)
+    {
+        unsigned vg = target_v[i];
+        unsigned vc = target_v_control[i];
+        if (vg != vc)
+        {
+            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
+                 << " at=" << i << endl;
+            cerr << control_value << endl;
+            exit(1);
+        }
+    }
+
+    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNKNOWN);
+    for (unsigned i = 0; i < gather_size; ++i)
+    {
+        unsigned vg = target_v[i];
+        unsigned vc = target_v_control[i];
+        if (vg != vc)
+        {
+            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
+                 << " at=" << i << endl;
+            cerr << control_value << endl;
+            exit(1);
+        }
+    }
+
+
+#if 0
+    // detailed check (very slow)
+    unsigned k = 0;
+    for (unsigned i = from; i <= to; ++i, ++k)
+    {
+        unsigned v1 = i;
+        unsigned v2 = target_v[k];
+        if (v1 != v2)
+        {
+            if (control_value)
+            {
+                if (v2 != control_value)
+                {
+                    cerr << "Error! gather control mismatch " << control_value << " " << v2
+                         << " at=" << i << endl;
+                    exit(1);
+                }
+            }
+            else
+            {
+                v1 = sv.get(i);
+                if (v1 != v2)
+                {
+                    cerr << "Error! gather mismatch " << v1 << " " << v2
+                         << " at=" << i << endl;
+                    exit(1);
+                }
+            }
+        }
+    } // for
+#endif
+}
+
+static
+void CheckSparseVectorGatherRandom(const sparse_vector_u32& sv,
+                                   unsigned gather_size)
+{
+    assert(sv.size());
+    
+    if (gather_size == 0)
+        gather_size = 1;
+    
+    std::vector<unsigned> target_v;
+    std::vector<unsigned> idx_v;
+    target_v.resize(gather_size);
+    idx_v.reserve(gather_size);
+    
+    for (unsigned i = 0; i < gather_size; ++i)
+    {
+        unsigned r_idx = unsigned(rand()) % (sv.size()-1);
+        idx_v.push_back(r_idx);
+    }
+    
+    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNSORTED);
+
+    unsigned k = 0;
+    for (unsigned i = 0; i < gather_size; ++i, ++k)
+    {
+        unsigned v1 = sv.get(idx_v[k]);
+        unsigned v2 = target_v[k];
+        if (v1 != v2)
+        {
+            {
+                cerr << "Error! random gather mismatch " << v1 << " " << v2
+                     << " at=" << i << endl;
+                exit(1);
+            }
+        }
+    } // for
+}
+
+
+static
+void TestSparseVectorDecodePlanes()
+{
+    cout << "---------------------------- Test sparse vector decode (narrow planes)" << endl;
+
+    const unsigned max_size = 65536 * 3 + 1000;
+    std::vector<unsigned> arr(max_size);
+    std::vector<unsigned long long> arr64(max_size);
+
+    for (unsigned width = 1; width <= 34; width += 1 + (width > 18))
+    {
+        sparse_vector_u32 sv;
+        sparse_vector_u64 sv64;
+        unsigned vmask = (width >= 32) ? ~0u : ((1u << width) - 1);
+        for (unsigned i = 0; i < max_size; ++i)
+        {
+            unsigned v;
+            if (i > 65536 && i < 65536 * 2)
+                v = (i / 3000) & vmask; // GAP friendly runs
+            else
+                v = unsigned(rand()) & vmask;
+            if (i > 65536 * 2 && i < 65536 * 2 + 5000)
+                v = vmask; // full planes
+            sv.set(i, v);
+            sv64.set(i, v);
+        }
+        sv.optimize();
+        sv64.optimize();
+
+        for (unsigned pass = 0; pass < 40; ++pass)
+        {
+            unsigned from = pass ? unsigned(rand()) % max_size : 0;
+            unsigned sz = pass ? 1 + unsigned(rand()) % (65536 + 200)
+                               : max_size;
+            if (pass % 4 == 1)
+                sz = 1 + unsigned(rand()) % 70;
+            auto cnt = sv.decode(arr.data(), from, sz);
+            auto cnt64 = sv64.decode(arr64.data(), from, sz);
+            assert(cnt == cnt64);
+            assert(cnt <= sz);
+            for (unsigned k = 0; k < cnt; ++k)
+            {
+                unsigned v = sv.get(from + k);
+                if (arr[k] != v || arr64[k] != v)
+                {
+                    cerr << "narrow decode mismatch width=" << width
+                         << " from=" << from << " k=" << k
+                         << " v=" << v << " vx=" << arr[k] << endl;
+                    assert(0); exit(1);
+                }
+            }
+        } // for pass
+        cout << "\rwidth=" << width << flush;
+    } // for width
+    cout << endl;
+
+    cout << "---------------------------- Test sparse vector decode (narrow planes) OK" << endl;
+}
+
+template<class SV>
+void CheckImportRange(SV& sv, const typename SV::value_type* arr,
+                      unsigned arr_size, unsigned offset)
+{
+    SV sv_ref(sv);
+    for (unsigned i = 0; i < arr_size; ++i)
+        sv_ref.set(offset + i, arr[i]);
+
+    sv.import(arr, arr_size, offset);
+    assert(sv.size() == sv_ref.size());
+    if (!sv.equal(sv_ref))
+    {
+        for (unsigned i = 0; i < sv.size(); ++i)
+        {
+            if (sv.get(i) != sv_ref.get(i) ||
+                sv.is_null(i) != sv_ref.is_null(i))
+            {
+                cerr << "import mismatch at=" << i << " offset=" << offset
+                     << " size=" << arr_size << " v=" << sv.get(i)
+                     << " ref=" << sv_ref.get(i) << endl;
+                break;
+            }
+        }
+        assert(0); exit(1);
+    }
+}
+
+static
+void TestSparseVectorImport()
+{
+    cout << "---------------------------- Test sparse vector import (transpose)" << endl;
+
+    const unsigned max_size = 65536 * 3 + 777;
+    std::vector<unsigned> arr(max_size);
+    std::vector<unsigned long long> arr64(max_size);
+    std::vector<unsigned short> arr16(max_size);
+
+    for (unsigned width = 1; width <= 64; width += (width < 8) ? 1 : 8)
+    {
+        unsigned long long vmask =
+            (width >= 64) ? ~0ull : ((1ull << width) - 1);
+        for (unsigned i = 0; i < max_size; ++i)
+        {
+            unsigned long long v = (unsigned long long)(rand()) << 42 ^
+                                   (unsigned long long)(rand()) << 21 ^
+                                   (unsigned long long)(rand());
+            if (i % 7 == 0)
+                v = 0;
+            if (i > 65536 && i < 65536 + 3000)
+                v = ~0ull;
+            arr64[i] = v & vmask;
+            arr[i] = unsigned(arr64[i]);
+            arr16[i] = (unsigned short)(arr64[i]);
+        }
+        const unsigned offs[] = { 0, 1, 31, 33, 65536 - 17, 65536 * 2 + 5 };
+        for (unsigned k = 0; k < sizeof(offs)/sizeof(offs[0]); ++k)
+        {
+            unsigned offset = offs[k];
+            unsigned sz = 1 + unsigned(rand()) % (max_size - 1);
+            if (k == 1)
+                sz = 1 + unsigned(rand()) % 40; // within one word
+            {
+                sparse_vector_u32 sv(bm::use_null);
+                CheckImportRange(sv, arr.data(), sz, offset);
+                // import over existing values (overlap, zeros, GAP blocks)
+                unsigned offset2 = offset + (sz / 2);
+                unsigned sz2 = 1 + unsigned(rand()) % 70000;
+                sv.optimize();
+                CheckImportRange(sv, arr.data() + 5, sz2, offset2);
+            }
+            {
+                sparse_vector_u64 sv64;
+                CheckImportRange(sv64, arr64.data(), sz, offset);
+                CheckImportRange(sv64, arr64.data() + 1, sz / 3 + 1, offset);
+            }
+            {
+                bm::sparse_vector<unsigned short, bvect> sv16;
+                CheckImportRange(sv16, arr16.data(), sz, offset);
+            }
+        } // for k
+        {
+            // back insert iterator flushes via import_back
+            sparse_vector_u32 sv(bm::use_null);
+            sparse_vector_u32 sv_ref(bm::use_null);
+            {
+                sparse_vector_u32::back_insert_iterator bi =
+                                                sv.get_back_inserter();
+                for (unsigned i = 0; i < max_size; ++i)
+                {
+                    if (i % 1000 == 0)
+                        bi.add_null();
+                    else
+                        bi = arr[i];
+                }
+                bi.flush();
+            }
+            for (unsigned i = 0; i < max_size; ++i)
+            {
+                if (i % 1000)
+                    sv_ref.set(i, arr[i]);
+            }
+            sv_ref.resize(max_size);
+            assert(sv.equal(sv_ref));
+        }
+        cout << "\rwidth=" << width << flush;
+    } // for width
+    cout << endl;
+
+    cout << "---------------------------- Test sparse vector import (transpose) OK" << endl;
+}
+
+static
+void TestSparseVectorParallelImport()
+{
+    cout << "---------------------------- Test sparse vector parallel import" << endl;
+
+    {
+        const unsigned max_size = 65536 * 7 + 1234;
+        std::vector<unsigned> arr(max_size);
+        for (unsigned i = 0; i < max_size; ++i)
+        {
+            arr[i] = unsigned(rand()) & 0xFFFF;
+            if (i % 5 == 0)
+                arr[i] = 0;
+            if (i > 65536 && i < 65536 * 2)
+                arr[i] = 7;
+        }
+        const unsigned offs[] = { 0, 17, 65536 * 3 - 1 };
+        for (unsigned k = 0; k < sizeof(offs)/sizeof(offs[0]); ++k)
+        {
+            for (unsigned cb = 1; cb <= 3; cb += 2)
+            {
+                unsigned offset = offs[k];
+                sparse_vector_u32 sv(bm::use_null), sv_c(bm::use_null);
+                // pre-existing content (import over it)
+                for (unsigned i = 0; i < max_size; i += 3)
+                {
+                    sv.set(i, i);
+                    sv_c.set(i, i);
+                }
+                sv.optimize();
+                sv_c.import(arr.data(), max_size - 100, offset);
+
+                bm::import_plan_builder<sparse_vector_u32> pbuilder;
+                bm::import_plan_builder<sparse_vector_u32>::task_batch tbatch;
+                pbuilder.set_chunk_blocks(cb);
+                pbuilder.build_plan(tbatch, sv, arr.data(), max_size - 100,
+                                    offset);
+                assert(tbatch.size());
+                if (k == 0)
+                    bm::run_task_batch(tbatch);
+                else
+                    RunTaskBatchPool(tbatch, 4);
+
+                assert(sv.size() == sv_c.size());
+                bool eq = sv.equal(sv_c);
+                if (!eq)
+                {
+                    cerr << "Parallel import mismatch offset=" << offset
+                         << endl;
+                    assert(0); exit(1);
+                }
+            } // for cb
+        } // for k
+    }
+
+    {
+        typedef str_sparse_vector<char, bvect, 16> str_sv_type;
+        const unsigned max_size = 65536 * 3 + 100;
+        typedef bm::dynamic_heap_matrix<char, bvect::allocator_type> cmatr_type;
+        cmatr_type cmatr(max_size, 16);
+        cmatr.init(true);
+        const unsigned offset = 65536 - 10;
+        str_sv_type sv_src;
+        std::vector<std::string> strs;
+        for (unsigned i = 0; i < max_size; ++i)
+        {
+            std::string str = std::to_string(i * 7) + "x";
+            if (i % 11 == 0)
+                str = "abc";
+            ::strcpy(cmatr.row(i), str.c_str());
+            cmatr.row(i)[15] = 'z'; // garbage after 0 terminator
+            sv_src.set(i, str.c_str());
+            strs.push_back(str);
+        }
+
+        for (unsigned pass = 0; pass < 2; ++pass)
+        {
+            str_sv_type sv, sv_c;
+            if (pass) // remapped vectors, import over existing content
+            {
+                sv.remap_from(sv_src);
+                sv_c.remap_from(sv_src);
+            }
+            for (unsigned i = 0; i < max_size; ++i)
+                sv_c.set(offset + i, strs[i].c_str());
+
+            cmatr_type cm(cmatr);
+            bm::str_import_plan_builder<str_sv_type> pbuilder;
+            bm::str_import_plan_builder<str_sv_type>::task_batch rbatch, tbatch;
+            pbuilder.build_remap_plan(rbatch, sv, cm, max_size);
+            RunTaskBatchPool(rbatch, 3);
+            pbuilder.build_plan(tbatch, sv, cm, offset, max_size);
+            RunTaskBatchPool(tbatch, 3);
+
+            assert(sv.size() == sv_c.size());
+            bool eq = sv.equal(sv_c);
+            if (!eq)
+            {
+                cerr << "Parallel str import mismatch pass=" << pass << endl;
+                assert(0); exit(1);
+            }
+            char s1[32], s2[32];
+            for (unsigned i = 0; i < max_size; i += 101)
+            {
+                sv.get(offset + i, s1, sizeof(s1));
+                sv_src.get(i, s2, sizeof(s2));
+                assert(::strcmp(s1, s2) == 0);
+            }
+        } // for pass
+
+        {
+            // unknown character for the remapped vector
+            str_sv_type sv;
+            sv.remap_from(sv_src);
+            cmatr_type cm(cmatr);
+            ::strcpy(cm.row(100), "#");
+            bm::str_import_plan_builder<str_sv_type> pbuilder;
+            bm::str_import_plan_builder<str_sv_type>::task_batch tbatch;
+            bool caught = false;
+            try
+            {
+                pbuilder.build_plan(tbatch, sv, cm, 0, max_size);
+            }
+            catch (std::exception&)
+            {
+                caught = true;
+            }
+            assert(caught);
+        }
+    }
+
+    cout << "---------------------------- Test sparse vector parallel import OK" << endl;
+}
+
+template<class SV>
+void CheckInterleavedMatrix(const SV& sv)
+{
+    typedef typename SV::value_type value_type;
+    typedef typename SV::bvector_type bvector_type;
+    typedef typename SV::size_type size_type;
+    bm::interleaved_bmatrix<bvector_type> imatr;
+    imatr.build(sv.get_bmatrix(), sv.effective_planes(), sv.size());
+    assert(imatr.size() == sv.size());
+
+    // plane-wise view must match source planes
+    for (unsigned p = 0; p < imatr.planes(); ++p)
+    {
+        const bvector_type* bv = sv.get_plane(p);
+        for (size_type nb = 0; nb < imatr.groups(); ++nb)
+        {
+            const bm::word_t* blk = imatr.get_block(p, nb);
+            if (!bv)
+            {
+                assert(!blk);
+                continue;
+            }
+            unsigned i0, j0;
+            bm::get_block_coord(nb, i0, j0);
+            const bm::word_t* blk_src =
+                        bv->get_blocks_manager().get_block_ptr(i0, j0);
+            if (!blk_src || IS_FULL_BLOCK(blk_src))
+            {
+                assert(blk_src == 0 ? (blk == 0) : IS_FULL_BLOCK(blk));
+                continue;
+            }
+            assert(blk && !IS_FULL_BLOCK(blk));
+            for (unsigned k = 0; k < 65536; k += 7)
+            {
+                unsigned b = (blk[k >> 5] >> (k & 31)) & 1u;
+                size_type idx = nb * 65536 + k;
+                assert(b == unsigned(bv->test(idx)));
+            }
+        } // for nb
+    } // for p
+
+    // point access and gather
+    std::vector<size_type> idx;
+    std::vector<value_type> arr, arr_ref;
+    for (size_type i = 0; i < sv.size(); i += 1 + (i % 5))
+        idx.push_back(i);
+    std::random_shuffle(idx.begin(), idx.end());
+    arr.resize(idx.size()); arr_ref.resize(idx.size());
+    imatr.gather(arr.data(), idx.data(), size_type(idx.size()));
+    sv.gather(arr_ref.data(), idx.data(), size_type(idx.size()),
+              bm::BM_UNKNOWN);
+    for (size_t i = 0; i < idx.size(); ++i)
     {
-        unsigned vg = target_v[i];
-        unsigned vc = target_v_control[i];
-        if (vg != vc)
+        if (arr[i] != arr_ref[i] ||
+            imatr.template get<value_type>(idx[i]) != arr_ref[i])
         {
-            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
-                 << " at=" << i << endl;
-            cerr << control_value << endl;
-            exit(1);
+            cerr << "interleaved gather mismatch at=" << idx[i] << endl;
+            assert(0); exit(1);
         }
     }
-    
-    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNSORTED);
-    for (unsigned i = 0; i < gather_size; ++i)
+
+    // find_eq versus scanner
+    bm::sparse_vector_scanner<SV> scanner;
+    std::vector<value_type> vals;
+    vals.push_back(0);
+    vals.push_back(value_type(~value_type(0)));
+    for (unsigned i = 0; i < 16 && sv.size(); ++i)
+        vals.push_back(sv.get(size_type(rand()) % sv.size()));
+    for (size_t i = 0; i < vals.size(); ++i)
     {
-        unsigned vg = target_v[i];
-        unsigned vc = target_v_control[i];
-        if (vg != vc)
+        bvector_type bv_res, bv_ref;
+        imatr.find_eq(vals[i], bv_res);
+        scanner.find_eq(sv, vals[i], bv_ref);
+        if (sv.is_nullable())
+            bv_res &= *sv.get_null_bvector();
+        if (!bv_res.equal(bv_ref))
         {
-            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
-                 << " at=" << i << endl;
-            cerr << control_value << endl;
-            exit(1);
+            cerr << "interleaved find_eq mismatch v=" << vals[i]
+                 << " cnt=" << bv_res.count()
+                 << " ref=" << bv_ref.count() << endl;
+            assert(0); exit(1);
         }
     }
+}
+
+static
+void TestInterleavedMatrix()
+{
+    cout << "---------------------------- Test interleaved bit-matrix" << endl;
 
-    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNKNOWN);
-    for (unsigned i = 0; i < gather_size; ++i)
     {
-        unsigned vg = target_v[i];
-        unsigned vc = target_v_control[i];
-        if (vg != vc)
+        sparse_vector_u32 sv;
+        bm::interleaved_bmatrix<bvect> imatr;
+        imatr.build(sv.get_bmatrix(), sv.effective_planes(), sv.size());
+        assert(imatr.groups() == 0);
+        bvect bv_res;
+        imatr.find_eq(0u, bv_res);
+        assert(!bv_res.any());
+    }
+
+    const unsigned max_size = 65536 * 5 + 333;
+    for (unsigned pass = 0; pass < 4; ++pass)
+    {
+        sparse_vector_u32 sv(pass & 1 ? bm::use_null : bm::no_null);
+        sparse_vector_u64 sv64;
+        for (unsigned i = 0; i < max_size; ++i)
         {
-            cerr << "Error! gather/decode control mismatch " << vc << " " << vg
-                 << " at=" << i << endl;
-            cerr << control_value << endl;
-            exit(1);
+            if (pass & 1 && i % 11 == 0)
+                continue; // NULL
+            unsigned v = unsigned(rand()) & 0xFFF;
+            if (i < 65536)
+                v = (i % 3 == 0) ? 0u : 7u; // mix of zeros and low bits
+            else
+            if (i < 65536 * 2)
+                v = 0xF05; // full planes in block 1
+            else
+            if (i >= 65536 * 3 && i < 65536 * 4)
+                v = (i / 1000) & 1 ? 0x80001u : 0u; // GAP runs
+            sv.set(i, v);
+            sv64.set(i, (unsigned long long)(v) << 31 | v);
+        }
+        if (pass > 1)
+        {
+            sv.optimize();
+            sv64.optimize();
         }
+        CheckInterleavedMatrix(sv);
+        CheckInterleavedMatrix(sv64);
+        cout << "\rpass=" << pass << flush;
+    } // for pass
+    cout << endl;
+
+    // sparse: empty super-blocks between the values
+    {
+        sparse_vector_u32 sv;
+        sv.set(5, 3);
+        sv.set(65536 * 256 * 2 + 7, 0x11);
+        sv.set(65536 * 256 * 5 + 100, 1);
+        sv.optimize();
+        bm::interleaved_bmatrix<bvect> imatr;
+        imatr.build(sv.get_bmatrix(), sv.effective_planes(), sv.size());
+        assert(imatr.groups() == 256 * 5 + 1);
+        assert(imatr.get<unsigned>(5) == 3);
+        assert(imatr.get<unsigned>(65536 * 256 * 2 + 7) == 0x11);
+        assert(imatr.get<unsigned>(65536 * 256 * 5 + 100) == 1);
+        assert(imatr.get<unsigned>(65536 * 256 * 3) == 0);
+        assert(imatr.get_block(0, 256 * 3 + 1) == 0);
+        assert(imatr.get_group(256 * 4).plane_mask == 0);
+        assert(imatr.get_group(256 * 2).plane_mask == 0x11);
+        bvect bv_res;
+        imatr.find_eq(0x11u, bv_res);
+        assert(bv_res.count() == 1 && bv_res.test(65536 * 256 * 2 + 7));
+        imatr.find_eq(0u, bv_res);
+        assert(bv_res.count() == sv.size() - 3);
+        assert(!bv_res.test(5) && bv_res.test(65536 * 256 * 4));
     }
 
+    cout << "---------------------------- Test interleaved bit-matrix OK" << endl;
+}
 
-#if 0
-    // detailed check (very slow)
-    unsigned k = 0;
-    for (unsigned i = from; i <= to; ++i, ++k)
+template<class SV>
+void CheckXorPlanSerialization(const SV& sv, unsigned thread_cnt)
+{
+    typedef bm::xor_plan_builder<SV> builder_type;
+    bm::sparse_vector_serializer<SV> sv_ser;
+    sv_ser.enable_xor_compression();
+    bm::sparse_vector_serial_layout<SV> sv_lay0, sv_lay1, sv_lay2;
+    sv_ser.serialize(sv, sv_lay0);
+
+    typename builder_type::xor_plan_type plan;
+    for (unsigned pass = 0; pass < 2; ++pass)
     {
-        unsigned v1 = i;
-        unsigned v2 = target_v[k];
-        if (v1 != v2)
-        {
-            if (control_value)
-            {
-                if (v2 != control_value)
-                {
-                    cerr << "Error! gather control mismatch " << control_value << " " << v2
-                         << " at=" << i << endl;
-                    exit(1);
-                }
-            }
-            else
-            {
-                v1 = sv.get(i);
-                if (v1 != v2)
-                {
-                    cerr << "Error! gather mismatch " << v1 << " " << v2
-                         << " at=" << i << endl;
-                    exit(1);
-                }
-            }
+        builder_type pbuilder;
+        typename builder_type::task_batch tbatch;
+        pbuilder.set_pruning(pass == 0);
+        pbuilder.set_chunk_blocks(2);
+        pbuilder.build_plan(tbatch, sv, plan);
+        if (thread_cnt)
+            RunTaskBatchPool(tbatch, thread_cnt);
+        else
+            bm::run_task_batch(tbatch);
+        pbuilder.merge_plan();
+        sv_ser.set_xor_plan(&plan);
+        bm::sparse_vector_serial_layout<SV>& lay = pass ? sv_lay2 : sv_lay1;
+        sv_ser.serialize(sv, lay);
+        sv_ser.set_xor_plan(0);
+
+        // plan gives the same references as the serial search
+        // (compare after the header, header reserve is not initialized)
+        size_t h_size = 0;
+        for (unsigned i = 0; !h_size && i < sv.get_bmatrix().rows(); ++i)
+            if (lay.get_plane(i))
+                h_size = size_t(lay.get_plane(i) - lay.buf());
+        if (lay.size() != sv_lay0.size() ||
+            ::memcmp(lay.buf() + h_size, sv_lay0.buf() + h_size,
+                     lay.size() - h_size) != 0)
+        {
+            cerr << "XOR plan serialization mismatch: " << lay.size()
+                 << " " << sv_lay0.size() << endl;
+            assert(0); exit(1);
         }
-    } // for
-#endif
+    } // for pass
+    assert(plan.matches());
+
+    SV sv_o;
+    bm::sparse_vector_deserializer<SV> sv_deser;
+    sv_deser.deserialize(sv_o, sv_lay1.buf());
+    assert(sv.equal(sv_o));
 }
 
 static
-void CheckSparseVectorGatherRandom(const sparse_vector_u32& sv,
-                                   unsigned gather_size)
+void TestSparseVectorXorPlan()
 {
-    assert(sv.size());
-    
-    if (gather_size == 0)
-        gather_size = 1;
-    
-    std::vector<unsigned> target_v;
-    std::vector<unsigned> idx_v;
-    target_v.resize(gather_size);
-    idx_v.reserve(gather_size);
-    
-    for (unsigned i = 0; i < gather_size; ++i)
+    cout << "---------------------------- Test parallel XOR reference search" << endl;
+
     {
-        unsigned r_idx = unsigned(rand()) % (sv.size()-1);
-        idx_v.push_back(r_idx);
+        sparse_vector_u32 sv;
+        const unsigned max_size = 65536 * 6;
+        for (unsigned i = 0; i < max_size; ++i)
+        {
+            unsigned v = (i & 0xFF) * 0x01010101u; // correlated planes
+            if (i % 7 == 0)
+                v ^= unsigned(rand()) & 0xFFFF;
+            if (i > 65536 * 3 && i < 65536 * 4)
+                v = i & 0x3;
+            sv.set(i, v);
+        }
+        sv.optimize();
+        CheckXorPlanSerialization(sv, 0);
+        CheckXorPlanSerialization(sv, 4);
     }
-    
-    sv.gather(target_v.data(), idx_v.data(), gather_size, BM_UNSORTED);
 
-    unsigned k = 0;
-    for (unsigned i = 0; i < gather_size; ++i, ++k)
     {
-        unsigned v1 = sv.get(idx_v[k]);
-        unsigned v2 = target_v[k];
-        if (v1 != v2)
+        typedef str_sparse_vector<char, bvect, 16> str_sv_type;
+        str_sv_type sv;
+        for (unsigned i = 0; i < 65536 * 3; ++i)
         {
-            {
-                cerr << "Error! random gather mismatch " << v1 << " " << v2
-                     << " at=" << i << endl;
-                exit(1);
-            }
+            std::string str = "id" + std::to_string(i * 3) + "-" +
+                              std::to_string(i % 97);
+            sv.set(i, str.c_str());
         }
-    } // for
-}
+        sv.optimize();
+        CheckXorPlanSerialization(sv, 3);
+    }
 
+    cout << "---------------------------- Test parallel XOR reference search OK" << endl;
+}
 
 static
 void TestSparseVectorGatherDecode()
@@ -25126,6 +27532,136 @@ void StressTestStrSparseVector()
 }
 
 
+static
+void StrSortedSearchTest()
+{
+   cout << "---------------------------- STR sorted search test..." << endl;
+
+   // SIMD compare of padded strings vs generic compare
+   {
+       char s1[64], s2[64];
+       for (unsigned i = 0; i < 200000; ++i)
+       {
+           ::memset(s1, 0, sizeof(s1));
+           ::memset(s2, 0, sizeof(s2));
+           unsigned len1 = unsigned(rand()) % 65;
+           unsigned len2 = unsigned(rand()) % 65;
+           unsigned common = unsigned(rand()) % 65;
+           for (unsigned j = 0; j < len1; ++j)
+               s1[j] = (rand() % 16) ? char('a' + rand() % 3) : char(0xE9);
+           for (unsigned j = 0; j < len2; ++j)
+               s2[j] = (j < common && j < len1) ? s1[j] : char('a' + rand() % 3);
+           int r0 = bm::str_cmp_padded<char>(s1, s2, 64);
+           int r1 = bm::str_cmp_padded(s1, s2, 64);
+           assert((r0 < 0) == (r1 < 0) && (r0 > 0) == (r1 > 0));
+           r1 = bm::str_cmp_padded(s2, s1, 64);
+           assert((r0 < 0) == (r1 > 0) && (r0 > 0) == (r1 < 0));
+           if (!r0)
+               assert(::strncmp(s1, s2, 64) == 0);
+       } // for i
+   }
+
+   // sorted vector with duplicate runs crossing block boundaries
+   std::vector<string> str_coll;
+   {
+       char buf[64];
+       unsigned v = 0;
+       while (str_coll.size() < 300000)
+       {
+           unsigned run = (v % 1000 == 999) ? 70000 : (1 + v % 3);
+           snprintf(buf, sizeof(buf), "%c-%08u", char('a' + v / 40000), v);
+           for (unsigned j = 0; j < run; ++j)
+               str_coll.emplace_back(buf);
+           v += 2; // odd values are absent
+       }
+   }
+   str_svect_type str_sv;
+   {
+       str_svect_type::back_insert_iterator bi = str_sv.get_back_inserter();
+       for (const string& s : str_coll)
+           bi = s;
+       bi.flush();
+   }
+   str_sv.optimize();
+   str_svect_type str_sv_remap;
+   str_sv_remap.remap_from(str_sv);
+
+   for (unsigned pass = 0; pass < 2; ++pass)
+   {
+       const str_svect_type& sv = pass ? str_sv_remap : str_sv;
+       bm::sparse_vector_scanner<str_svect_type> scanner;
+       bm::sparse_vector_scanner<str_svect_type> scanner_b;
+       scanner_b.bind(sv, true);
+
+       char buf[64];
+       for (unsigned v = 0; v < 2 * 70000; v += 1 + unsigned(rand()) % 7)
+       {
+           snprintf(buf, sizeof(buf), "%c-%08u", char('a' + v / 40000), v);
+           auto it = std::lower_bound(str_coll.begin(), str_coll.end(),
+                                      string(buf));
+           unsigned pos0 = unsigned(it - str_coll.begin());
+           bool found0 = (it != str_coll.end() && *it == buf);
+
+           unsigned pos1, pos2, pos3, pos4;
+           bool found1 = scanner.lower_bound_str(sv, buf, pos1);
+           bool found2 = scanner_b.lower_bound_str(sv, buf, pos2);
+           assert(found1 == found0 && pos1 == pos0);
+           assert(found2 == found0 && pos2 == pos0);
+           bool found3 = scanner.bfind_eq_str(sv, buf, pos3);
+           bool found4 = scanner_b.bfind_eq_str(buf, pos4);
+           assert(found3 == found0 && found4 == found0);
+           if (found0)
+               assert(pos3 == pos0 && pos4 == pos0);
+
+           // compare with a known common prefix
+           if (pos0 < sv.size())
+           {
+               unsigned prefix_len = 0;
+               int cmp0 = sv.compare(pos0, buf);
+               int cmp1 = sv.compare(pos0, buf, prefix_len);
+               assert(cmp0 == cmp1 && (cmp0 == 0) == found0);
+               assert(prefix_len <= ::strlen(buf));
+               unsigned prefix_len2 = prefix_len / 2;
+               int cmp2 = sv.compare(pos0, buf, prefix_len2);
+               assert(cmp2 == cmp0 && prefix_len2 == prefix_len);
+               if (found0)
+                   assert(prefix_len == ::strlen(buf));
+           }
+       } // for v
+       // out of range: before the first, after the last element
+       unsigned pos;
+       bool found = scanner_b.lower_bound_str(sv, "0", pos);
+       assert(!found && pos == 0);
+       found = scanner_b.lower_bound_str(sv, "z", pos);
+       assert(!found && pos == sv.size());
+   } // for pass
+
+   // empty vector and re-binding must not keep stale samples
+   {
+       bm::sparse_vector_scanner<str_svect_type> scanner_b;
+       str_svect_type str_sv_e;
+       unsigned pos;
+       scanner_b.bind(str_sv_e, true);
+       bool found = scanner_b.lower_bound_str(str_sv_e, "a", pos);
+       assert(!found && pos == 0);
+
+       str_svect_type str_sv_m(str_sv);
+       scanner_b.bind(str_sv_m, true);
+       str_sv_m.clear_all(true);
+       str_sv_m.push_back("b-00000001");
+       scanner_b.bind(str_sv_m, false);
+       found = scanner_b.lower_bound_str(str_sv_m, "b-00000001", pos);
+       assert(found && pos == 0);
+       found = scanner_b.lower_bound_str(str_sv_m, "c", pos);
+       assert(!found && pos == 1);
+       scanner_b.reset_binding();
+       found = scanner_b.lower_bound_str(str_sv_m, "a", pos);
+       assert(!found && pos == 0);
+   }
+
+   cout << "---------------------------- STR sorted search test OK" << endl;
+}
+
 static
 void TestStrSparseSort()
 {
@@ -25538,6 +28074,117 @@ void TestSparseSort()
 
 }
 
+template<class SV>
+void CheckArgsort(const SV& sv, unsigned spill_size)
+{
+    typedef typename SV::size_type  size_type;
+    typedef typename SV::value_type value_type;
+
+    std::vector<size_type> perm_ref(sv.size());
+    for (size_type i = 0; i < sv.size(); ++i)
+        perm_ref[i] = i;
+    std::stable_sort(perm_ref.begin(), perm_ref.end(),
+        [&sv](size_type a, size_type b)
+        {
+            bool a_null = sv.is_null(a); bool b_null = sv.is_null(b);
+            if (a_null || b_null)
+                return !a_null && b_null; // NULLs last
+            value_type va = sv.get(a); value_type vb = sv.get(b);
+            return va < vb;
+        });
+
+    bm::sparse_vector_sorter<SV> sorter;
+    sorter.set_spill_size(spill_size);
+
+    std::vector<size_type> perm(sv.size());
+    size_type cnt = sv.size() ? sorter.argsort(sv, perm.data()) : 0;
+    assert(cnt == sv.size());
+    for (size_type i = 0; i < cnt; ++i)
+    {
+        if (perm[i] != perm_ref[i])
+        {
+            cerr << "argsort mismatch at " << i << " spill=" << spill_size
+                 << " " << perm[i] << "!=" << perm_ref[i] << endl;
+            assert(0); exit(1);
+        }
+    }
+
+    bm::sparse_vector<size_type, bvect> sv_perm;
+    sorter.argsort(sv, sv_perm);
+    assert(sv_perm.size() == cnt);
+    for (size_type i = 0; i < cnt; ++i)
+    {
+        size_type idx = sv_perm[i];
+        assert(idx == perm_ref[i]); (void)idx;
+    }
+}
+
+static
+void TestSparseVectorArgsort()
+{
+    cout << "---------------------------- sparse vector ARGSORT test" << endl;
+
+    {
+        sparse_vector_u32 sv;
+        CheckArgsort(sv, 16);
+        sv.push_back(5);
+        CheckArgsort(sv, 1);
+        sv.push_back(0);
+        sv.push_back(5);
+        sv.push_back(1);
+        CheckArgsort(sv, 1);
+        CheckArgsort(sv, 3);
+    }
+
+    {
+        sparse_vector_u32 sv(bm::use_null);
+        sv.set(1, 10);
+        sv.set(3, 0);
+        sv.set(7, 2);
+        sv.set(10, 10);
+        sv.set_null(12);
+        sv.resize(15);
+        CheckArgsort(sv, 1);
+        CheckArgsort(sv, 64);
+    }
+
+    cout << "argsort stress..." << endl;
+    {
+        const unsigned max_size = 250000;
+        const unsigned spill[] = { 1, 7, 256, 4096, 100000 };
+
+        for (unsigned pass = 0; pass < 3; ++pass)
+        {
+            sparse_vector_u32 sv(pass == 2 ? bm::use_null : bm::no_null);
+            sparse_vector_u64 sv64;
+            for (unsigned i = 0; i < max_size; ++i)
+            {
+                unsigned v;
+                switch (pass)
+                {
+                case 0: v = unsigned(rand()) % 17; break;  // low cardinality
+                case 1: v = unsigned(rand()) * 65537u; break; // wide range
+                default: v = unsigned(rand()) % 1024; break;
+                }
+                if (pass == 2 && (i % 5 == 0))
+                    continue; // leave NULL
+                sv.set(i, v);
+                sv64.set(i, (unsigned long long)(v) << 33 | (i & 7));
+            }
+            sv.optimize();
+            for (unsigned k = 0; k < sizeof(spill)/sizeof(spill[0]); ++k)
+            {
+                CheckArgsort(sv, spill[k]);
+                CheckArgsort(sv64, spill[k]);
+            }
+            cout << "\rpass " << pass << flush;
+        } // for pass
+        cout << endl;
+    }
+
+    cout << "---------------------------- sparse vector ARGSORT test OK" << endl;
+}
+
 
 
 inline
@@ -28515,6 +31162,96 @@ void DetailedCheckCompressedDecode(const rsc_sparse_vector_u32& csv)
 
 }
 
+static
+void CheckCompressedGather(const rsc_sparse_vector_u32& csv,
+                           const std::vector<bvect::size_type>& idx,
+                           bm::sort_order sorted_idx)
+{
+    std::vector<unsigned> vals(idx.size());
+    std::vector<bvect::size_type> idx_tmp(idx.size());
+    auto sz = csv.gather(vals.data(), idx.data(), idx_tmp.data(),
+                         bvect::size_type(idx.size()), sorted_idx);
+    assert(sz == idx.size());
+    for (size_t k = 0; k < idx.size(); ++k)
+    {
+        unsigned v = idx[k] < csv.size() ? csv.get(idx[k]) : 0;
+        if (v != vals[k])
+        {
+            cerr << "compressed vector gather mismatch k=" << k
+                 << " idx=" << idx[k] << " v=" << v << " vx=" << vals[k]
+                 << endl;
+            assert(0); exit(1);
+        }
+    }
+}
+
+static
+void TestCompressedSparseVectorGather()
+{
+    cout << " ------------------------------ Test Compressed Sparse Vector GATHER" << endl;
+
+    {
+        rsc_sparse_vector_u32 csv;
+        csv.sync();
+        std::vector<bvect::size_type> idx { 0, 1, 100 };
+        CheckCompressedGather(csv, idx, bm::BM_SORTED);
+    }
+
+    {
+        rsc_sparse_vector_u32 csv;
+        csv.push_back(1, 10);
+        csv.push_back(2, 20);
+        csv.push_back(65536*3+5, 30);
+        csv.sync();
+        std::vector<bvect::size_type> idx { 0, 1, 1, 2, 3, 65536*3+5, 65536*4 };
+        CheckCompressedGather(csv, idx, bm::BM_SORTED);
+        CheckCompressedGather(csv, idx, bm::BM_UNKNOWN);
+        std::vector<bvect::size_type> idx2 { 65536*3+5, 2, 0, 2, 1 };
+        CheckCompressedGather(csv, idx2, bm::BM_UNSORTED);
+        CheckCompressedGather(csv, idx2, bm::BM_UNKNOWN);
+    }
+
+    {
+        const unsigned max_size = 3 * 65536 * 4;
+        rsc_sparse_vector_u32 csv;
+        {
+            rsc_sparse_vector_u32::back_insert_iterator bit =
+                                                csv.get_back_inserter();
+            for (unsigned i = 0; i < max_size; ++i)
+            {
+                if ((i > 65536 && i < 65536 * 2) || (rand() % 3 == 0))
+                    bit.add_null();
+                else
+                    bit = i & 0xFFF;
+            }
+            bit.flush();
+        }
+        csv.set(65536*5 + 10, 1);
+        csv.optimize();
+        csv.sync();
+
+        std::vector<bvect::size_type> idx;
+        for (unsigned i = 0; i < max_size + 10; i += 1 + rand() % 7)
+            idx.push_back(i);
+        CheckCompressedGather(csv, idx, bm::BM_SORTED);
+        CheckCompressedGather(csv, idx, bm::BM_UNKNOWN);
+
+        std::random_device rd;
+        std::mt19937       g(rd());
+        std::shuffle(idx.begin(), idx.end(), g);
+        CheckCompressedGather(csv, idx, bm::BM_UNSORTED);
+        CheckCompressedGather(csv, idx, bm::BM_UNKNOWN);
+
+        // partially sorted: sorted runs with step backs
+        std::sort(idx.begin(), idx.end());
+        for (size_t k = 0; k + 4 < idx.size(); k += 16)
+            std::swap(idx[k], idx[k+3]);
+        CheckCompressedGather(csv, idx, bm::BM_UNKNOWN);
+    }
+
+    cout << " ------------------------------ Test Compressed Sparse Vector GATHER OK" << endl;
+}
+
 static
 void TestArraysAndBuffers()
 {
@@ -29980,8 +32717,10 @@ int main(int argc, char *argv[])
         BitEncoderTest();
     
         InterpolativeCodingTest();
+        InterpolativeCodingIterTest();
 
         GammaEncoderTest();
+        GammaDGapEncoderTest();
 
         GAPCheck();
         SerializationBufferTest();
@@ -30006,6 +32745,12 @@ int main(int argc, char *argv[])
 
          CountRangeTest();
 
+         RSIndexInterleavedTest();
+
+         RankSelectBatchTest();
+
+         SelectSampledTest();
+
          EnumeratorTest();
 
          BvectorFindReverseTest();
@@ -30014,6 +32759,10 @@ int main(int argc, char *argv[])
 
          IntervalEnumeratorTest();
 
+         IntervalListTest();
+
+         IntervalIndexTest();
+
          KeepRangeTest();
 
          BasicFunctionalityTest();
@@ -30030,6 +32779,10 @@ int main(int argc, char *argv[])
 
          BvectorBulkSetTest();
 
+         TestBulkSortedSetClear();
+
+         TestSortedBulkInsert();
+
         GAPTestStress();
         
         MaxSTest();
@@ -30060,6 +32813,10 @@ int main(int argc, char *argv[])
         SparseSerializationTest();
         SerializationTest();
         DesrializationTest2();
+        TestDeltaSerialization();
+        TestBlockFingerprint();
+        TestBlockDedupPool();
+        TestSerializerDecodeCost();
 
         RangeDeserializationTest();
     }
@@ -30085,6 +32842,10 @@ int main(int argc, char *argv[])
         XorOperationsTest(true);
         SubOperationsTest(true);
 
+        TestSimilarityMatrixBuilder();
+        TestSimilaritySearch();
+        TestMinHashSketch();
+
         StressTest(150, 0, false); // OR - detailed check disabled
         StressTest(150, 3, false); // AND
         StressTest(150, 1, false); // SUB
@@ -30116,6 +32877,16 @@ int main(int argc, char *argv[])
 
         TestSparseVectorGatherDecode();
 
+        TestSparseVectorDecodePlanes();
+
+        TestSparseVectorImport();
+
+        TestSparseVectorParallelImport();
+
+        TestInterleavedMatrix();
+
+        TestSparseVectorXorPlan();
+
         TestSparseVectorSerial();
 
         TestSparseVectorSerialization2();
@@ -30129,6 +32900,8 @@ int main(int argc, char *argv[])
         TestSparseVectorScan();
 
         TestSparseSort();
+
+        TestSparseVectorArgsort();
     }
 
     if (is_all || is_csv)
@@ -30138,6 +32911,8 @@ int main(int argc, char *argv[])
 
         TestCompressedSparseVectorAlgo();
 
+        TestCompressedSparseVectorGather();
+
         TestCompressSparseVectorSerial();
 
         TestCompressedSparseVectorScan();
@@ -30165,6 +32940,8 @@ int main(int argc, char *argv[])
          TestStrSparseSort();
 
          StressTestStrSparseVector();
+
+         StrSortedSearchTest();
     }
 
     if (is_all || is_bvops)
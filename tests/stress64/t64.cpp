@@ -1885,20 +1885,30 @@ void RSIndexTest()
     }
     
     {
+        const unsigned sub_n = bm::rs_sub_blocks - 1;
+        const unsigned sub_last = sub_n * bm::rs_sub_block_size;
+        const unsigned sub_mid = (sub_n / 2) * bm::rs_sub_block_size;
         unsigned bcount[bm::set_sub_array_size];
-        unsigned sub_count1[bm::set_sub_array_size];
-        unsigned sub_count2[bm::set_sub_array_size];
+        bm::gap_word_t sub_count1[bm::set_sub_array_size * sub_n];
+        bm::gap_word_t sub_count2[bm::set_sub_array_size * sub_n];
         for (unsigned i = 0; i < bm::set_sub_array_size; ++i)
-        {
-            bcount[i] = sub_count1[i] = sub_count2[i] = 0;
-        } // for
+            bcount[i] = 0;
+        for (unsigned i = 0; i < bm::set_sub_array_size * sub_n; ++i)
+            sub_count1[i] = sub_count2[i] = 0;
         bcount[0] = 1;
         bcount[255] = 2;
         
-        sub_count1[0] = 1;          // sub-range 0
-        sub_count1[255] = 0;        // sub-3
-        sub_count2[0] = 1 << 16;    // sub-2
-        sub_count2[255] = 1 << 16;  // sub 2,3
+        // running counts of sub-blocks
+        for (unsigned k = 0; k < sub_n; ++k)
+        {
+            sub_count1[k] = 1;                      // first sub-block
+            // block 255 of sb1: both bits in the last sub-block
+            if (k >= sub_n / 2)
+            {
+                sub_count2[k] = 1;                  // middle sub-block
+                sub_count2[255 * sub_n + k] = 1;    // middle and last
+            }
+        }
 
         
         rs_ind rsi;
@@ -2003,43 +2013,43 @@ void RSIndexTest()
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 1);
 
             rank = 3;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 2);
 
             rank = 4;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+255+1);
-            assert(sub_range == bm::rs3_border0 + 1);
+            assert(sub_range == sub_mid);
             assert(rank == 1);
 
             rank = 5;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+256+255);
-            assert(sub_range == bm::rs3_border0 + 1);
+            assert(sub_range == sub_mid);
             assert(rank == 1);
 
             rank = 6;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == bm::set_sub_array_size+256+255);
-            assert(sub_range == bm::rs3_border1 + 1);
+            assert(sub_range == sub_last);
             assert(rank == 1);
 
             rank = 65536;
             b = rsi.find(&rank, &nb, &sub_range);
             assert(b);
             assert(nb == 3*bm::set_sub_array_size+0);
-            assert(sub_range == bm::rs3_border1 + 1);
-            assert(rank == 65536 - 6 - bm::rs3_border1 - 1);
+            assert(sub_range == sub_last);
+            assert(rank == 65536 - 6 - sub_last);
 
             rank = 65536 + 7;
             b = rsi.find(&rank, &nb, &sub_range);
@@ -72,6 +72,7 @@ void show_help()
         << "-silent (-s)                -- no progress print or messages"          << std::endl
         << "-verify                     -- verify compressed version "             << std::endl
         << "-decode                     -- run decode test (in-memory)"            << std::endl
+        << "-bicbench                   -- BIC decoders benchmark (with -u32in)"   << std::endl
         << "-diag (-d)                  -- print statistics/diagnostics info"      << std::endl
         << "-timing (-t)                -- evaluate timing/duration of operations" << std::endl
       ;
@@ -95,6 +96,7 @@ bool         is_timing = false;
 bool         is_verify = false;
 bool         is_silent = false;
 bool         is_decode = false;
+bool         is_bic_bench = false;
 
 unsigned     c_level = bm::set_compression_default;
 
@@ -127,6 +129,11 @@ int parse_args(int argc, char *argv[])
             }
             continue;
         }
+        if (arg == "-bicbench" || arg == "--bicbench")
+        {
+            is_bic_bench = true;
+            continue;
+        }
         if (arg == "-l" || arg == "-level")
         {
             if (i + 1 < argc)
@@ -813,6 +820,109 @@ void decode_test_dump_file(const std::string& bv_in_fname)
 }
 
 
+/// Binary Interpolative Coding benchmark on the posting lists:
+/// lists are split into 16-bit blocks (as in the bit-vector), each block is
+/// BIC encoded, decoded by the recursive (reference) and iterative decoders
+///
+static
+void bic_bench_inv_file(const std::string& fname)
+{
+    std::ifstream fin(fname.c_str(), std::ios::in | std::ios::binary);
+    if (!fin.good())
+        throw std::runtime_error("Cannot open input file");
+    fin.seekg(0, std::ios::end);
+    std::streamsize fsize = fin.tellg();
+    fin.seekg(0, std::ios::beg);
+
+    const unsigned repeats = 5;
+    std::vector<unsigned> vec;
+    std::vector<bm::gap_word_t> arr, arr_r, arr_i;
+    std::vector<unsigned> blk_sz; // (lo, hi, size) of each encoded block
+    std::vector<unsigned char> buf;
+
+    double ns_rec = 0, ns_it = 0;
+    bm::id64_t total_ints = 0, total_bytes = 0;
+
+    for (bm::id64_t i = 0; true; ++i)
+    {
+        int ret = io_read_u32_coll(fin, vec);
+        if (ret != 0)
+            throw std::runtime_error("Error reading input file");
+
+        // encode all 16-bit blocks of the list into one stream
+        buf.resize(vec.size() * 4 + 1024);
+        blk_sz.resize(0);
+        {
+            bm::encoder enc(buf.data(), buf.size());
+            bm::bit_out<bm::encoder> bout(enc);
+            for (size_t j = 0; j < vec.size(); )
+            {
+                unsigned nb = vec[j] >> 16;
+                arr.resize(0);
+                for (; j < vec.size() && (vec[j] >> 16) == nb; ++j)
+                    arr.push_back(bm::gap_word_t(vec[j] & 0xFFFFu));
+                blk_sz.push_back(unsigned(arr.size()));
+                bout.bic_encode_u16(arr.data(), unsigned(arr.size()),
+                                    0, 65535);
+            } // for j
+            bout.flush();
+            total_bytes += enc.size();
+        }
+        total_ints += vec.size();
+        arr_r.resize(vec.size()); arr_i.resize(vec.size());
+
+        for (unsigned k = 0; k < repeats; ++k)
+        {
+            auto s = std::chrono::steady_clock::now();
+            {
+                bm::decoder dec(buf.data());
+                bm::bit_in<bm::decoder> bin(dec);
+                bm::gap_word_t* dst = arr_r.data();
+                for (size_t b = 0; b < blk_sz.size(); dst += blk_sz[b++])
+                    bin.bic_decode_u16_cm(dst, blk_sz[b], 0, 65535);
+            }
+            auto f = std::chrono::steady_clock::now();
+            {
+                bm::decoder dec(buf.data());
+                bm::bit_in<bm::decoder> bin(dec);
+                bm::gap_word_t* dst = arr_i.data();
+                for (size_t b = 0; b < blk_sz.size(); dst += blk_sz[b++])
+                    bin.bic_decode_u16(dst, blk_sz[b], 0, 65535);
+            }
+            auto f2 = std::chrono::steady_clock::now();
+            ns_rec += std::chrono::duration<double, std::nano>(f - s).count();
+            ns_it += std::chrono::duration<double, std::nano>(f2 - f).count();
+        } // for k
+        if (arr_r != arr_i)
+            throw std::runtime_error("BIC decode mismatch");
+        for (size_t j = 0; j < vec.size(); ++j)
+        {
+            if (arr_i[j] != bm::gap_word_t(vec[j] & 0xFFFFu))
+                throw std::runtime_error("BIC decode verification failed");
+        }
+
+        std::streamsize fpos_curr = fin.tellg();
+        if (fpos_curr == fsize)
+            break;
+        if (!is_silent)
+        {
+            cout << "\r" << fpos_curr << "/" << fsize
+                 << " ( size=" << vec.size() << " )              "
+                 << flush;
+        }
+    } // for i
+
+    cout << endl;
+    cout << "Total ints=" << total_ints << endl;
+    cout << "BIC bytes=" << total_bytes << endl;
+    if (total_ints)
+    {
+        double cnt = double(total_ints) * repeats;
+        cout << "BIC recursive decode: " << ns_rec / cnt << " ns/int" << endl;
+        cout << "BIC iterative decode: " << ns_it / cnt << " ns/int" << endl;
+    }
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -828,6 +938,14 @@ int main(int argc, char *argv[])
         if (ret != 0)
             return ret;
         
+        if (is_bic_bench)
+        {
+            if (u32_in_file.empty())
+                throw std::runtime_error("-bicbench requires -u32in");
+            cout << "BIC benchmark." << endl;
+            bic_bench_inv_file(u32_in_file);
+        }
+        else
         if (!u32_in_file.empty())
         {
             if (!is_verify)